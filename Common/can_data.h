@@ -53,10 +53,60 @@ typedef enum {
 
 #define CAN_DATA_MAX        8               //максимальный размер данных в одном пакете
 
+#define CAN_DATA_KEYFRAME   0x80000000UL    //признак передачи всех пакетов уст-ва (вне диапазона ID)
+#define CAN_DATA_PERIOD     0x40000000UL    //признак периодической передачи по подписке
+#define CAN_DATA_SUBSCR     0x20000000UL    //признак передачи всех пакетов подписки (подписка изменена)
+
+#define CAN_SUBSCR_CHANGE   0x01            //подписка: передача пакетов при изменении данных
+#define CAN_SUBSCR_DEFAULT  0x80            //подписка: восстановить подписку по умолчанию
+#define CAN_SUBSCR_ALL      0xFFFFFFFFUL    //маска всех пакетов уст-ва
+#define CAN_SUBSCR_BIT( pack )  ( 1UL << ( ( pack ) & 0x1F ) ) //бит пакета в маске подписки
+
+#define CAN_CONFIG_HASH     16              //ID пакета ID_CONFIG с версией и контрольной суммой настроек
+#define CAN_HMI_CONFIG      1               //ID параметра ID_DEV_HMI: контрольная сумма настроек в HMI
+
+//Счетчики передачи пакетов данных
+typedef enum {
+    CAN_DATA_SEND,                          //передано пакетов
+    CAN_DATA_SKIP,                          //пропущено пакетов без изменений
+    CAN_DATA_KEYS,                          //кол-во передач всех пакетов уст-ва
+    CAN_DATA_FAIL,                          //не передано пакетов (очередь передачи заполнена)
+    CAN_DATA_CNT                            //кол-во счетчиков
+ } CanDataCnt;
+
+#pragma pack( push, 1 )
+
+//Структура подписки HMI на данные уст-ва (команда ID_DEV_HMI)
+typedef struct {
+    uint8_t         dev_id;                 //ID уст-ва, ID_DEV_NULL - все уст-ва
+    uint8_t         flags;                  //признаки CAN_SUBSCR_*
+    uint16_t        period;                 //период передачи (msec), 0 - без периодической передачи
+    uint32_t        mask;                   //маска пакетов: бит N - пакет N, 0 - отписка от уст-ва
+ } CAN_SUBSCR;
+
+//Версия настроек: пакет ID_CONFIG/CAN_CONFIG_HASH, команда ID_DEV_HMI/CAN_HMI_CONFIG
+//При несовпадении контрольной суммы в команде HMI передаются все пакеты настроек
+typedef struct {
+    uint32_t        gen;                    //номер версии настроек
+    uint32_t        hash;                   //контрольная сумма настроек
+ } CAN_CONFIG16;
+
+#pragma pack( pop )
+
 //*************************************************************************************************
 // Функции управления
 //*************************************************************************************************
+void CanDataInit( void );
 void DevDataSend( uint32_t dev_id );
+void CanDataSubscr( CAN_SUBSCR *subscr );
+void CanDataPublish( void );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t CanDataStat( CanDataCnt type );
+uint32_t CanDataWait( void );
+bool CanDataSubscrGet( Device dev, CAN_SUBSCR *subscr );
 
 #pragma pack( push, 1 )
 
@@ -51,7 +51,66 @@ typedef struct {
 
 #define CAN_FILTER_RANGE        0x1FFFFFFFUL                    //максимальное значение фильтра
 
+#define CAN_RANGE_CMD           ( CAN_MASK_PACK_ID )            //диапазон ID пакетов команды уст-ва
+#define CAN_RANGE_DEV           ( CAN_MASK_PARAM_ID | CAN_MASK_PACK_ID ) //диапазон всех ID уст-ва
+
 #define CAN_CONFIG_SAVE         0xFF                            //сохранить параметры в EEPROM
 
+//*************************************************************************************************
+// Сегментированная передача блоков данных (ID_DEV_XFER), аналог ISO-TP (ISO 15765-2)
+// ID параметра - номер сессии, ID пакета - направление передачи, тип пакета - старшие 4 бита
+// первого байта данных. Размеры сообщений в пакетах SF/FF передаются старшим байтом вперед
+//*************************************************************************************************
+#define CAN_XFER_SESS           4                               //кол-во одновременных сессий
+#define CAN_XFER_TO_CTRL        0x00                            //ID пакета: HMI -> контроллер
+#define CAN_XFER_TO_HMI         0x01                            //ID пакета: контроллер -> HMI
+
+#define CAN_XFER_PCI            0xF0                            //маска типа пакета
+#define CAN_XFER_SF             0x00                            //одиночный: [0x0L][данные L байт]
+#define CAN_XFER_FF             0x10                            //первый: [0x1L][L] или [0x10][0x00][L 4 байта]
+#define CAN_XFER_CF             0x20                            //последующий: [0x2N][до 7 байт данных]
+#define CAN_XFER_FC             0x30                            //управление потоком: [0x3S][BS][STmin]
+
+#define CAN_XFER_FC_CTS         0x00                            //FC: продолжить передачу BS пакетов
+#define CAN_XFER_FC_WAIT        0x01                            //FC: ожидание следующего FC
+#define CAN_XFER_FC_OVFL        0x02                            //FC: сообщение не может быть принято
+
+#define CAN_XFER_ANSWER         0x40                            //признак ответа в коде сервиса
+
+//Сервисы сегментированной передачи, первый байт сообщения - код сервиса, числа передаются
+//младшим байтом вперед, имя файла завершается нулем
+typedef enum {
+    CAN_XFER_READ = 1,                      //чтение файла
+                                            //запрос: [код][смещение 4][размер 4, 0 - до конца][имя]
+                                            //ответ:  [код|0x40][статус][размер 4][данные]
+    CAN_XFER_WRITE,                         //запись файла
+                                            //запрос: [код][режим CAN_XFER_WR_*][имя]
+                                            //ответ:  [код|0x40][статус], следующее сообщение сессии -
+                                            //данные файла, ответ: [код|0x40][статус][размер 4]
+    CAN_XFER_PARAM,                         //чтение значений параметров уст-в
+                                            //запрос: [код][ID уст-ва][ID параметра]...
+                                            //ответ:  [код|0x40][статус][кол-во значений][значения]
+                                            //значения в двоичном виде по ParamGetType()/ParamPackVal(),
+                                            //значения не поместившиеся в ответ не передаются
+    CAN_XFER_ROLLUP                         //чтение итогов значений за период (rollup.h)
+                                            //запрос: [код][период][0 - завершенный, 1 - текущий]
+                                            //ответ:  [код|0x40][статус][кол-во][ROLL_REC]...
+ } CanXferSrv;
+
+#define CAN_XFER_WR_NEW         0x00                            //запись в новый файл
+#define CAN_XFER_WR_APPEND      0x01                            //добавление в конец файла
+
+#define CAN_XFER_PARAM_MAX      64                              //макс кол-во параметров в запросе CAN_XFER_PARAM
+
+//Статус выполнения сервиса
+typedef enum {
+    CAN_XFER_OK,                            //сервис выполнен
+    CAN_XFER_ERR_SRV,                       //неизвестный код сервиса
+    CAN_XFER_ERR_PARAM,                     //ошибка в параметрах запроса
+    CAN_XFER_ERR_SD,                        //SD карта не установлена/не смонтирована
+    CAN_XFER_ERR_FILE,                      //ошибка открытия файла
+    CAN_XFER_ERR_IO                         //ошибка чтения/записи файла
+ } CanXferResult;
+
 #endif
 
@@ -599,6 +599,21 @@ static char *DateToStr( DATE date );
 static char *TimeStart( uint8_t *ptr );
 static TrackerStat TrackerMode( uint16_t stat );
 
+static ValueParam ValPorts( Device dev, uint32_t param );
+static ValueParam ValAlt( Device dev, uint32_t param );
+static ValueParam ValMppt( Device dev, uint32_t param );
+static ValueParam ValCharger( Device dev, uint32_t param );
+static ValueParam ValBatmon( Device dev, uint32_t param );
+static ValueParam ValPv( Device dev, uint32_t param );
+static ValueParam ValVoice( Device dev, uint32_t param );
+static ValueParam ValSpa( Device dev, uint32_t param );
+static ValueParam ValTracker( Device dev, uint32_t param );
+static ValueParam ValRtc( Device dev, uint32_t param );
+static ValueParam ValGen( Device dev, uint32_t param );
+static ValueParam ValInv( Device dev, uint32_t param );
+static ValueParam ValConfig( Device dev, uint32_t param );
+static ValueParam ValHmi( Device dev, uint32_t param );
+
 //*************************************************************************************************
 // Возвращает ID устройства по имени уст-ва, имена уст-в хранятся в: dev_name[]
 // char *name           - имя уст-ва
@@ -785,48 +800,132 @@ char *ParamGetName( Device dev, uint32_t param ) {
 ValueParam ParamGetVal( Device dev, uint32_t param ) {
 
     ValueParam value;
+    ParamValFunc func;
     
     value.uint32 = 0;
-    //значение параметра
+    func = ParamGetFunc( dev );
+    if ( func != NULL )
+        value = func( dev, param );
+    return value;
+ }
+
+//*************************************************************************************************
+// Возвращает функцию получения значений параметров уст-ва, используется для однократного
+// определения функции при многократном чтении значений параметров (индекс параметров)
+// Device dev          - ID уст-ва
+// return ParamValFunc - функция получения значения, NULL - значения уст-ва не доступны
+//*************************************************************************************************
+ParamValFunc ParamGetFunc( Device dev ) {
+
     if ( dev == ID_DEV_PORTS )
-        value = PortsGetValue( (ParamPort)param );
+        return ValPorts;
     if ( dev == ID_DEV_ALT )
-        value = AltGetValue( (ParamAlt)param );
+        return ValAlt;
     if ( dev == ID_DEV_MPPT )
-        value = MpptGetValue( (ParamMppt)param );
+        return ValMppt;
     if ( dev == ID_DEV_CHARGER )
-        value = ChargeGetValue( (ParamCharger)param );
+        return ValCharger;
     if ( dev == ID_DEV_BATMON )
-        value = BatmonGetValue( (ParamBatMon)param );
+        return ValBatmon;
     if ( dev == ID_DEV_PV )
-        value = PvGetValue( (ParamPv)param );
+        return ValPv;
     if ( dev == ID_DEV_VOICE )
-        value = VoiceGetValue( (ParamVoice)param );
+        return ValVoice;
     if ( dev == ID_DEV_SPA )
-        value = SpaGetValue( (ParamSunPos)param );
+        return ValSpa;
     if ( dev == ID_DEV_TRC )
-        value = TrackerGetValue( (ParamTracker)param );
+        return ValTracker;
     if ( dev == ID_DEV_RTC )
-        value = RtcGetValue( (ParamRtc)param );
+        return ValRtc;
     if ( dev == ID_DEV_GEN )
-        value = GenGetValue( (ParamGen)param );
-    if ( dev == ID_DEV_INV1 )
-        value = InvGetValue( ID_DEV_INV1, (ParamInv)param );
-    if ( dev == ID_DEV_INV2 )
-        value = InvGetValue( ID_DEV_INV2, (ParamInv)param );
+        return ValGen;
+    if ( dev == ID_DEV_INV1 || dev == ID_DEV_INV2 )
+        return ValInv;
     if ( dev == ID_CONFIG )
-        value = ConfigValue( (ConfigParam)param );
-    if ( dev == ID_DEV_HMI ) {
-        #ifdef CONFIG_CONTROL
-        value = HmiGetValue( (ParamHmi)param );
-        #endif
-        #ifdef CONFIG_HMIDEV
-        value = LinkGetValue( (ParamHmi)param );
-        #endif
+        return ValConfig;
+    if ( dev == ID_DEV_HMI )
+        return ValHmi;
+    return NULL;
+ }
+
+//*************************************************************************************************
+// Возвращает тип значения параметра уст-ва при передаче в двоичном виде
+// Device dev       - ID уст-ва
+// uint32_t param   - ID параметра
+// return ValueType - тип значения, VALUE_NONE - параметра нет или значение не передается
+//*************************************************************************************************
+ValueType ParamGetType( Device dev, uint32_t param ) {
+
+    SubType subtype;
+    const DevParam *dpar;
+
+    dpar = DevParamPtr( dev );
+    if ( dpar == NULL || param >= DevParamCnt( dev, CNT_FULL ) )
+        return VALUE_NONE;
+    subtype = dpar[param].subtype;
+    if ( ( subtype >= BOOL1 && subtype <= BOOL_FUSE ) || subtype == GEN_ERROR || subtype == INVR_ERR_CTRL ||
+         subtype == INVR_ERROR || subtype == SPA_ERRDS || subtype == SYS_MODE )
+        return VALUE_UINT8;
+    if ( subtype == TIME_FULL || subtype == TIME_2SHORT )
+        return VALUE_UINT16;
+    if ( subtype == FLOAT || subtype == TIME_SUN )
+        return VALUE_FLOAT;
+    if ( subtype == DATES || subtype == SDATE )
+        return VALUE_DATE;
+    if ( subtype == STRING || subtype == STRINT )
+        return VALUE_STRING;
+    if ( subtype == TIMESTART )
+        return VALUE_ARRAY8;
+    if ( subtype == NOTYPE || subtype == DOUBLE )
+        return VALUE_NONE;
+    //целые числа, коды режимов и статусов
+    return VALUE_UINT32;
+ }
+
+//*************************************************************************************************
+// Запись значения параметра в буфер в двоичном виде, числа записываются младшим байтом вперед
+// ValueType type   - тип значения
+// ValueParam value - значение параметра
+// uint8_t *dst     - адрес для размещения значения
+// uint16_t size    - размер свободного места в буфере
+// return = 0       - значение не передается или не помещается в буфер
+//        > 0       - кол-во записанных байт
+// Отсутствующая строка (NULL) передается как пустая строка (размер 0),
+// отсутствующий массив - как массив из нулей, размер значения в ответе не меняется
+//*************************************************************************************************
+uint16_t ParamPackVal( ValueType type, ValueParam value, uint8_t *dst, uint16_t size ) {
+
+    uint16_t len = 0;
+
+    if ( type == VALUE_UINT8 )
+        len = sizeof( uint8_t );
+    if ( type == VALUE_UINT16 )
+        len = sizeof( uint16_t );
+    if ( type == VALUE_UINT32 || type == VALUE_FLOAT )
+        len = sizeof( uint32_t );
+    if ( type == VALUE_DATE )
+        len = sizeof( DATE );
+    if ( type == VALUE_ARRAY8 )
+        len = 8;
+    if ( type == VALUE_STRING ) {
+        //строка длиннее 255 символов передается не полностью
+        len = value.ptr != NULL ? strlen( (char *)value.ptr ) : 0;
+        len = ( len > UINT8_MAX ? UINT8_MAX : len ) + 1;
        }
-    if ( dev == ID_CONFIG )
-        value = ConfigValue( (ConfigParam)param );
-    return value;
+    if ( !len || len > size )
+        return 0;
+    if ( type == VALUE_STRING ) {
+        *dst = len - 1;
+        if ( len > 1 )
+            memcpy( dst + 1, value.ptr, len - 1 );
+       }
+    else if ( type == VALUE_ARRAY8 ) {
+        if ( value.ptr != NULL )
+            memcpy( dst, value.ptr, len );
+        else memset( dst, 0x00, len );
+       }
+    else memcpy( dst, &value, len );
+    return len;
  }
 
 //*************************************************************************************************
@@ -965,8 +1064,22 @@ char *ParamGetForm( Device dev, uint32_t param, ParamMode mode ) {
 //*************************************************************************************************
 char *ParamGetDesc( Device dev, uint32_t param ) {
 
+    if ( DevParamPtr( dev ) == NULL || param >= DevParamCnt( dev, CNT_FULL ) )
+        return NULL;
+    return ParamValDesc( dev, param, ParamGetVal( dev, param ) );
+ }
+
+//*************************************************************************************************
+// Возвращает расшифровку указанного значения параметра, только для полей имеющих текстовую
+// расшифровку, используется для вывода ранее сохраненных значений
+// Device dev       - ID уст-ва
+// uint8_t param    - ID параметра
+// ValueParam value - значение параметра
+// return           - указатель на строку с результатом
+//*************************************************************************************************
+char *ParamValDesc( Device dev, uint32_t param, ValueParam value ) {
+
     char *ptr = NULL;
-    ValueParam value;
     const DevParam *dpar;
 
     //указатель на список параметров
@@ -976,8 +1089,6 @@ char *ParamGetDesc( Device dev, uint32_t param ) {
     //проверка на превышение кол-ва параметров
     if ( param >= DevParamCnt( dev, CNT_FULL ) )
         return NULL;
-    //значение параметра уст-ва
-    value = ParamGetVal( dev, param );
     //вывод расшифровки логических значений статусов и режимов
     if ( dpar[param].subtype == BOOL1 )
         ptr = DescBool1( value.uint8 );
@@ -2142,3 +2253,89 @@ ValueParam GenGetValue( ParamGen id_param ) {
         value.uint8 = gen_ptr->cycle2;
     return value;
  }
+
+//*************************************************************************************************
+// Функции получения значений параметров уст-в для ParamGetFunc(), приводят ID параметра
+// к типу параметров уст-ва
+// Device dev        - ID уст-ва
+// uint32_t param    - ID параметра
+// return ValueParam - значение параметра
+//*************************************************************************************************
+static ValueParam ValPorts( Device dev, uint32_t param ) {
+
+    return PortsGetValue( (ParamPort)param );
+ }
+
+static ValueParam ValAlt( Device dev, uint32_t param ) {
+
+    return AltGetValue( (ParamAlt)param );
+ }
+
+static ValueParam ValMppt( Device dev, uint32_t param ) {
+
+    return MpptGetValue( (ParamMppt)param );
+ }
+
+static ValueParam ValCharger( Device dev, uint32_t param ) {
+
+    return ChargeGetValue( (ParamCharger)param );
+ }
+
+static ValueParam ValBatmon( Device dev, uint32_t param ) {
+
+    return BatmonGetValue( (ParamBatMon)param );
+ }
+
+static ValueParam ValPv( Device dev, uint32_t param ) {
+
+    return PvGetValue( (ParamPv)param );
+ }
+
+static ValueParam ValVoice( Device dev, uint32_t param ) {
+
+    return VoiceGetValue( (ParamVoice)param );
+ }
+
+static ValueParam ValSpa( Device dev, uint32_t param ) {
+
+    return SpaGetValue( (ParamSunPos)param );
+ }
+
+static ValueParam ValTracker( Device dev, uint32_t param ) {
+
+    return TrackerGetValue( (ParamTracker)param );
+ }
+
+static ValueParam ValRtc( Device dev, uint32_t param ) {
+
+    return RtcGetValue( (ParamRtc)param );
+ }
+
+static ValueParam ValGen( Device dev, uint32_t param ) {
+
+    return GenGetValue( (ParamGen)param );
+ }
+
+static ValueParam ValInv( Device dev, uint32_t param ) {
+
+    return InvGetValue( dev, (ParamInv)param );
+ }
+
+static ValueParam ValConfig( Device dev, uint32_t param ) {
+
+    return ConfigValue( (ConfigParam)param );
+ }
+
+static ValueParam ValHmi( Device dev, uint32_t param ) {
+
+    ValueParam value;
+
+    value.uint32 = 0;
+    #ifdef CONFIG_CONTROL
+    value = HmiGetValue( (ParamHmi)param );
+    #endif
+    #ifdef CONFIG_HMIDEV
+    value = LinkGetValue( (ParamHmi)param );
+    #endif
+    return value;
+ }
@@ -111,6 +111,23 @@ typedef union {
     DATE        date;
  } ValueParam;
 
+//*************************************************************************************************
+// Тип значения параметра при передаче в двоичном виде, определяется подтипом параметра
+//*************************************************************************************************
+typedef enum {
+    VALUE_NONE,                             //значение не передается
+    VALUE_UINT8,                            //uint8
+    VALUE_UINT16,                           //uint16
+    VALUE_UINT32,                           //uint32 (целые числа, коды режимов/статусов)
+    VALUE_FLOAT,                            //float
+    VALUE_DATE,                             //DATE
+    VALUE_STRING,                           //строка: [размер][символы без завершающего нуля]
+    VALUE_ARRAY8                            //массив uint8[8]
+ } ValueType;
+
+//Функция получения значения параметра уст-ва
+typedef ValueParam ( *ParamValFunc )( Device dev, uint32_t param );
+
 //*************************************************************************************************
 // Тип значения параметра настроек управляющего контроллера
 //*************************************************************************************************
@@ -138,8 +155,12 @@ uint8_t ParamGetInd( Device dev, char *name );
 const DevParam *DevParamPtr( Device dev );
 char *ParamGetName( Device dev, uint32_t param );
 ValueParam ParamGetVal( Device dev, uint32_t param );
+ParamValFunc ParamGetFunc( Device dev );
+ValueType ParamGetType( Device dev, uint32_t param );
+uint16_t ParamPackVal( ValueType type, ValueParam value, uint8_t *dst, uint16_t size );
 char *ParamGetForm( Device dev, uint32_t param, ParamMode mode );
 char *ParamGetDesc( Device dev, uint32_t param );
+char *ParamValDesc( Device dev, uint32_t param, ValueParam value );
 uint8_t AddDot( char *src, uint8_t aligment );
 char *ErrorDescr( Device dev, uint8_t err_dev, uint8_t err_ctrl );
 void StrToConfigVal( ConfigParam id_par, char *value, ConfigValSet *cfg_set );
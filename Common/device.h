@@ -33,7 +33,9 @@ typedef enum {
     ID_DEV_MODBUS_REQ,                      //11 обмен данными HMI -> контроллер -> MODBUS
     ID_DEV_MODBUS_ANS,                      //12 обмен данными MODBUS -> контроллер -> HMI 
     ID_CONFIG,                              //13 параметры настроек
-    ID_DEV_LOG                              //14 логирование событий
+    ID_DEV_LOG,                             //14 логирование событий
+    ID_DEV_XFER,                            //15 сегментированная передача блоков данных (файлы)
+    ID_DEV_SDCARD                           //16 SD карта (хранение протоколов)
  } Device;
  
 //*************************************************************************************************
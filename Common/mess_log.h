@@ -62,7 +62,11 @@ typedef enum {
     LOG_MSG_INV_OFF_CMD,                    //Выключаем командой
     LOG_MSG_INV_OFF_RMT,                    //Выключен удаленно
     LOG_MSG_INV_DC_OFF_ERR,                 //Инвертор выключен, контактор не выключился
-    LOG_MSG_INV_POWER_AC                    //На инверторе включена нагрузка
+    LOG_MSG_INV_POWER_AC,                   //На инверторе включена нагрузка
+    //SD карта
+    LOG_MSG_SD_LOW,                         //Мало свободного места на SD карте, удаление старых протоколов
+    LOG_MSG_SD_FULL,                        //SD карта заполнена, протоколов для удаления нет
+    LOG_MSG_SD_FREE                         //Свободное место на SD карте восстановлено
  } LogMessId;
 
 #endif
@@ -42,6 +42,9 @@
 // как маски, с помощью которых можно индивидуально сбросить или установить отдельные биты в регистре.
 // Конечный результат определяется формулой: Результат = (Текущее_значение AND Маска_И) OR (Маска_ИЛИ AND (NOT Маска_И))
 #define FUNC_WR_MASK_REG    0x16        //запись в один регистр хранения с использованием маски "И" и маски "ИЛИ" (Mask Write Register)
+// Запись и чтение нескольких регистров хранения одним запросом. Запись выполняется до чтения.
+// Ответ имеет формат ответа функции 0x03.
+#define FUNC_RDWR_MULT_REG  0x17        //(16-битная адресация) запись и чтение нескольких регистров (Read/Write Multiple registers)
 
 // Очереди данных. Функция предназначена для получения 16-битных слов из очереди, организованной
 // по принципу «первым пришёл — первым ушёл» (FIFO).
@@ -11,6 +11,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "cmsis_os2.h"
+
 #include "device.h"
 #include "dev_data.h"
 #include "dev_param.h"
@@ -20,11 +22,20 @@
 #include "can_def.h"
 
 #include "command.h"
+#include "config.h"
+#include "eeprom.h"
 #include "events.h"
 
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define CAN_KEYFRAME_TIME       ( _CAN_KEYFRAME_TIME * 1000 )   //интервал передачи всех пакетов (msec)
+
 //*************************************************************************************************
 // Прототипы локальных функций
 //*************************************************************************************************
+static bool CanDataChanged( uint8_t ind );
+static void SubscrDefault( Device dev );
 static void CanDataBatmon( uint8_t sub_id );
 static void CanDataMppt( uint8_t sub_id );
 static void CanDataCharger( uint8_t sub_id );
@@ -83,6 +94,7 @@ static CAN_CONFIG12    can_config12;
 static CAN_CONFIG13    can_config13;
 static CAN_CONFIG14    can_config14;
 static CAN_CONFIG15    can_config15;
+static CAN_CONFIG16    can_config16;
 
 //Структура описания передаваемых данных по CAN шине
 typedef struct {
@@ -91,82 +103,154 @@ typedef struct {
     void (*func)( uint8_t sub_id ); //функция заполняющая структуры данными
     uint8_t *ptr_data;              //указатель на структуру данных
     uint8_t len_data;               //размер блока данных
+    float deadband;                 //зона нечувствительности для пакетов из значений float,
+                                    //0 - пакет передается при изменении любого байта
  } CAN_DATA;
 
 //Описание передаваемых данных по CAN шине
 static const CAN_DATA can_data[] = {
-    //---------------------------------------------------------------------------------------
-    //ID уст-ва   номер     функция         структура данных            размер данных
-    //            пакета    данных
-    //---------------------------------------------------------------------------------------
+    //---------------------------------------------------------------------------------------------------
+    //ID уст-ва   номер     функция         структура данных            размер данных               зона
+    //            пакета    данных                                                                  нечувств.
+    //---------------------------------------------------------------------------------------------------
     //данные портов
-    ID_DEV_PORTS,   1,      NULL,           (uint8_t *)&ports,          sizeof( ports ),
+    ID_DEV_PORTS,   1,      NULL,           (uint8_t *)&ports,          sizeof( ports ),            0,
     //данные RTC
-    ID_DEV_RTC,     1,      NULL,           (uint8_t *)&rtc,            sizeof( rtc ),
+    ID_DEV_RTC,     1,      NULL,           (uint8_t *)&rtc,            sizeof( rtc ),              0,
     //данные монитора АКБ
-    ID_DEV_BATMON,  1,      CanDataBatmon,  (uint8_t *)&can_batmon1,    sizeof( can_batmon1 ),
-    ID_DEV_BATMON,  2,      CanDataBatmon,  (uint8_t *)&can_batmon2,    sizeof( can_batmon2 ),
-    ID_DEV_BATMON,  3,      CanDataBatmon,  (uint8_t *)&can_batmon3,    sizeof( can_batmon3 ),
-    ID_DEV_BATMON,  4,      CanDataBatmon,  (uint8_t *)&can_batmon4,    sizeof( can_batmon4 ),
-    ID_DEV_BATMON,  5,      CanDataBatmon,  (uint8_t *)&can_batmon5,    sizeof( can_batmon5 ),
-    ID_DEV_BATMON,  6,      CanDataBatmon,  (uint8_t *)&can_batmon6,    sizeof( can_batmon6 ),
-    ID_DEV_BATMON,  7,      CanDataBatmon,  (uint8_t *)&can_batmon7,    sizeof( can_batmon7 ),
+    ID_DEV_BATMON,  1,      CanDataBatmon,  (uint8_t *)&can_batmon1,    sizeof( can_batmon1 ),      0,
+    ID_DEV_BATMON,  2,      CanDataBatmon,  (uint8_t *)&can_batmon2,    sizeof( can_batmon2 ),      0.01,
+    ID_DEV_BATMON,  3,      CanDataBatmon,  (uint8_t *)&can_batmon3,    sizeof( can_batmon3 ),      0.1,
+    ID_DEV_BATMON,  4,      CanDataBatmon,  (uint8_t *)&can_batmon4,    sizeof( can_batmon4 ),      0.1,
+    ID_DEV_BATMON,  5,      CanDataBatmon,  (uint8_t *)&can_batmon5,    sizeof( can_batmon5 ),      0.1,
+    ID_DEV_BATMON,  6,      CanDataBatmon,  (uint8_t *)&can_batmon6,    sizeof( can_batmon6 ),      0.01,
+    ID_DEV_BATMON,  7,      CanDataBatmon,  (uint8_t *)&can_batmon7,    sizeof( can_batmon7 ),      0,
     //данные контроллера заряда MPPT
-    ID_DEV_MPPT,    1,      CanDataMppt,    (uint8_t *)&can_mppt1,      sizeof( can_mppt1 ),
-    ID_DEV_MPPT,    2,      CanDataMppt,    (uint8_t *)&can_mppt2,      sizeof( can_mppt2 ),
-    ID_DEV_MPPT,    3,      CanDataMppt,    (uint8_t *)&can_mppt3,      sizeof( can_mppt3 ),
-    ID_DEV_MPPT,    4,      CanDataMppt,    (uint8_t *)&can_mppt4,      sizeof( can_mppt4 ),
-    ID_DEV_MPPT,    5,      CanDataMppt,    (uint8_t *)&can_mppt5,      sizeof( can_mppt5 ),
-    ID_DEV_MPPT,    6,      CanDataMppt,    (uint8_t *)&can_mppt6,      sizeof( can_mppt6 ),
+    ID_DEV_MPPT,    1,      CanDataMppt,    (uint8_t *)&can_mppt1,      sizeof( can_mppt1 ),        0,
+    ID_DEV_MPPT,    2,      CanDataMppt,    (uint8_t *)&can_mppt2,      sizeof( can_mppt2 ),        0.1,
+    ID_DEV_MPPT,    3,      CanDataMppt,    (uint8_t *)&can_mppt3,      sizeof( can_mppt3 ),        0.1,
+    ID_DEV_MPPT,    4,      CanDataMppt,    (uint8_t *)&can_mppt4,      sizeof( can_mppt4 ),        0.1,
+    ID_DEV_MPPT,    5,      CanDataMppt,    (uint8_t *)&can_mppt5,      sizeof( can_mppt5 ),        0,
+    ID_DEV_MPPT,    6,      CanDataMppt,    (uint8_t *)&can_mppt6,      sizeof( can_mppt6 ),        0.5,
     //данные контроллера заряда PB-1000-224
-    ID_DEV_CHARGER, 1,      CanDataCharger, (uint8_t *)&can_charger1,   sizeof( can_charger1 ),
+    ID_DEV_CHARGER, 1,      CanDataCharger, (uint8_t *)&can_charger1,   sizeof( can_charger1 ),     0,
     //данные инвертора TS-1000-224
-    ID_DEV_INV1,    1,      CanDataInv1,    (uint8_t *)&can_1inv1,      sizeof( can_1inv1 ),
-    ID_DEV_INV1,    2,      CanDataInv1,    (uint8_t *)&can_1inv2,      sizeof( can_1inv2 ),
+    ID_DEV_INV1,    1,      CanDataInv1,    (uint8_t *)&can_1inv1,      sizeof( can_1inv1 ),        0,
+    ID_DEV_INV1,    2,      CanDataInv1,    (uint8_t *)&can_1inv2,      sizeof( can_1inv2 ),        0.1,
     //данные инвертора TS-3000-224
-    ID_DEV_INV2,    1,      CanDataInv2,    (uint8_t *)&can_2inv1,      sizeof( can_2inv1 ),
-    ID_DEV_INV2,    2,      CanDataInv2,    (uint8_t *)&can_2inv2,      sizeof( can_2inv2 ),
+    ID_DEV_INV2,    1,      CanDataInv2,    (uint8_t *)&can_2inv1,      sizeof( can_2inv1 ),        0,
+    ID_DEV_INV2,    2,      CanDataInv2,    (uint8_t *)&can_2inv2,      sizeof( can_2inv2 ),        0.1,
     //данные блока АВР
-    ID_DEV_ALT,     1,      NULL,           (uint8_t *)&alt,            sizeof( alt ),
+    ID_DEV_ALT,     1,      NULL,           (uint8_t *)&alt,            sizeof( alt ),              0,
     //данные генератора
-    ID_DEV_GEN,     1,      CanDataGen,     (uint8_t *)&can_gen1,       sizeof( can_gen1 ),
-    ID_DEV_GEN,     2,      CanDataGen,     (uint8_t *)&can_gen2,       sizeof( can_gen2 ),
+    ID_DEV_GEN,     1,      CanDataGen,     (uint8_t *)&can_gen1,       sizeof( can_gen1 ),         0,
+    ID_DEV_GEN,     2,      CanDataGen,     (uint8_t *)&can_gen2,       sizeof( can_gen2 ),         0,
     //данные контроллера трекера
-    ID_DEV_TRC,     1,      CanDataTrc,     (uint8_t *)&can_trc1,       sizeof( can_trc1 ),
-    ID_DEV_TRC,     2,      CanDataTrc,     (uint8_t *)&can_trc2,       sizeof( can_trc2 ),
+    ID_DEV_TRC,     1,      CanDataTrc,     (uint8_t *)&can_trc1,       sizeof( can_trc1 ),         0,
+    ID_DEV_TRC,     2,      CanDataTrc,     (uint8_t *)&can_trc2,       sizeof( can_trc2 ),         0,
     //данные положения солнца
-    ID_DEV_SPA,     1,      CanDataSpa,     (uint8_t *)&can_spa1,       sizeof( can_spa1 ),
-    ID_DEV_SPA,     2,      CanDataSpa,     (uint8_t *)&can_spa2,       sizeof( can_spa2 ),
-    ID_DEV_SPA,     3,      CanDataSpa,     (uint8_t *)&can_spa3,       sizeof( can_spa3 ),
+    ID_DEV_SPA,     1,      CanDataSpa,     (uint8_t *)&can_spa1,       sizeof( can_spa1 ),         0.01,
+    ID_DEV_SPA,     2,      CanDataSpa,     (uint8_t *)&can_spa2,       sizeof( can_spa2 ),         0.1,
+    ID_DEV_SPA,     3,      CanDataSpa,     (uint8_t *)&can_spa3,       sizeof( can_spa3 ),         0,
     //данные голосового информатора
-    ID_DEV_VOICE,   1,      NULL,           (uint8_t *)&voice,          sizeof( voice ),
+    ID_DEV_VOICE,   1,      NULL,           (uint8_t *)&voice,          sizeof( voice ),            0,
     //параметры конфигурации
-    ID_CONFIG,      1,      CanDataConfig,  (uint8_t *)&can_config1,    sizeof( can_config1 ),
-    ID_CONFIG,      2,      CanDataConfig,  (uint8_t *)&can_config2,    sizeof( can_config2 ),
-    ID_CONFIG,      3,      CanDataConfig,  (uint8_t *)&can_config3,    sizeof( can_config3 ),
-    ID_CONFIG,      4,      CanDataConfig,  (uint8_t *)&can_config4,    sizeof( can_config4 ),
-    ID_CONFIG,      5,      CanDataConfig,  (uint8_t *)&can_config5,    sizeof( can_config5 ),
-    ID_CONFIG,      6,      CanDataConfig,  (uint8_t *)&can_config6,    sizeof( can_config6 ),
-    ID_CONFIG,      7,      CanDataConfig,  (uint8_t *)&can_config7,    sizeof( can_config7 ),
-    ID_CONFIG,      8,      CanDataConfig,  (uint8_t *)&can_config8,    sizeof( can_config8 ),
-    ID_CONFIG,      9,      CanDataConfig,  (uint8_t *)&can_config9,    sizeof( can_config9 ),
-    ID_CONFIG,      10,     CanDataConfig,  (uint8_t *)&can_config10,   sizeof( can_config10 ),
-    ID_CONFIG,      11,     CanDataConfig,  (uint8_t *)&can_config11,   sizeof( can_config11 ),
-    ID_CONFIG,      12,     CanDataConfig,  (uint8_t *)&can_config12,   sizeof( can_config12 ),
-    ID_CONFIG,      13,     CanDataConfig,  (uint8_t *)&can_config13,   sizeof( can_config13 ),
-    ID_CONFIG,      14,     CanDataConfig,  (uint8_t *)&can_config14,   sizeof( can_config14 ),
-    ID_CONFIG,      15,     CanDataConfig,  (uint8_t *)&can_config15,   sizeof( can_config15 )
+    ID_CONFIG,      1,      CanDataConfig,  (uint8_t *)&can_config1,    sizeof( can_config1 ),      0,
+    ID_CONFIG,      2,      CanDataConfig,  (uint8_t *)&can_config2,    sizeof( can_config2 ),      0,
+    ID_CONFIG,      3,      CanDataConfig,  (uint8_t *)&can_config3,    sizeof( can_config3 ),      0,
+    ID_CONFIG,      4,      CanDataConfig,  (uint8_t *)&can_config4,    sizeof( can_config4 ),      0,
+    ID_CONFIG,      5,      CanDataConfig,  (uint8_t *)&can_config5,    sizeof( can_config5 ),      0,
+    ID_CONFIG,      6,      CanDataConfig,  (uint8_t *)&can_config6,    sizeof( can_config6 ),      0,
+    ID_CONFIG,      7,      CanDataConfig,  (uint8_t *)&can_config7,    sizeof( can_config7 ),      0,
+    ID_CONFIG,      8,      CanDataConfig,  (uint8_t *)&can_config8,    sizeof( can_config8 ),      0,
+    ID_CONFIG,      9,      CanDataConfig,  (uint8_t *)&can_config9,    sizeof( can_config9 ),      0,
+    ID_CONFIG,      10,     CanDataConfig,  (uint8_t *)&can_config10,   sizeof( can_config10 ),     0,
+    ID_CONFIG,      11,     CanDataConfig,  (uint8_t *)&can_config11,   sizeof( can_config11 ),     0,
+    ID_CONFIG,      12,     CanDataConfig,  (uint8_t *)&can_config12,   sizeof( can_config12 ),     0,
+    ID_CONFIG,      13,     CanDataConfig,  (uint8_t *)&can_config13,   sizeof( can_config13 ),     0,
+    ID_CONFIG,      14,     CanDataConfig,  (uint8_t *)&can_config14,   sizeof( can_config14 ),     0,
+    ID_CONFIG,      15,     CanDataConfig,  (uint8_t *)&can_config15,   sizeof( can_config15 ),     0,
+    ID_CONFIG,      16,     CanDataConfig,  (uint8_t *)&can_config16,   sizeof( can_config16 ),     0
+ };
+
+//Копия последних переданных данных пакета
+typedef struct {
+    bool     valid;                 //копия заполнена
+    uint8_t  data[CAN_DATA_MAX];    //данные пакета
+ } CAN_SHADOW;
+
+//Подписка HMI на данные уст-ва
+typedef struct {
+    uint32_t mask;                  //маска пакетов, 0 - данные уст-ва не передаются
+    uint16_t period;                //период передачи (msec), 0 - без периодической передачи
+    uint8_t  flags;                 //признаки CAN_SUBSCR_*
+    uint32_t time;                  //время последней периодической передачи
+ } SUBSCR;
+
+//Периодическая передача по умолчанию для уст-в данные которых не передаются задачами уст-в
+//При изменении периода для портов в модуле HMI необходимо изменить время отсутствия CAN пакетов
+static const struct {
+    Device   dev_id;
+    uint16_t period;
+    uint8_t  flags;
+ } subscr_def[] = {
+    //-----------------------------------------------
+    //ID уст-ва     период      признаки подписки
+    //              (msec)
+    //-----------------------------------------------
+    ID_DEV_PORTS,   200,        0,
+    ID_DEV_RTC,     1000,       0,
+    ID_DEV_VOICE,   1000,       0,
+    ID_CONFIG,      10000,      CAN_SUBSCR_CHANGE
  };
 
+static CAN_SHADOW can_shadow[SIZE_ARRAY( can_data )];
+static uint32_t key_time[ID_DEV_LOG + 1];               //время передачи всех пакетов уст-ва
+static uint32_t can_stat[CAN_DATA_CNT];                 //счетчики передачи пакетов
+static SUBSCR subscr[ID_DEV_LOG];                       //подписка HMI на данные уст-в
+static osMutexId_t mutex_subscr = NULL;
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osMutexAttr_t mutex_attr = { .name = "CanSubscr", .attr_bits = osMutexPrioInherit };
+
+//*************************************************************************************************
+// Инициализация подписки HMI на данные уст-в значениями по умолчанию
+//*************************************************************************************************
+void CanDataInit( void ) {
+
+    uint8_t dev;
+
+    mutex_subscr = osMutexNew( &mutex_attr );
+    for ( dev = ID_DEV_NULL; dev < SIZE_ARRAY( subscr ); dev++ )
+        SubscrDefault( (Device)dev );
+ }
+
 //*************************************************************************************************
 // Передача данных/событий уст-ва по CAN шине
-// uint32_t dev_id - ID уст-ва + PARAM_ID по которому будет выполняться передача данных
+// Передаются только пакеты уст-ва входящие в подписку HMI, данные которых изменились с момента
+// последней передачи. Все пакеты подписки передаются с интервалом _CAN_KEYFRAME_TIME, при
+// изменении подписки и периодически для подписки без признака CAN_SUBSCR_CHANGE. Запрос HMI
+// (признак CAN_DATA_KEYFRAME) выполняется для всех пакетов уст-ва независимо от подписки
+// Периодическая передача ID_DEV_PORTS выполняется всегда, пакет контролирует связь с HMI
+// Пакеты настроек передаются только при изменении значений и по запросу HMI для ID_CONFIG,
+// периодически и при запросе всех уст-в передается только пакет CAN_CONFIG_HASH
+// uint32_t dev_id - ID уст-ва + PARAM_ID по которому будет выполняться передача данных,
+//                   ID_DEV_NULL - передача данных всех уст-в
 //*************************************************************************************************
 void DevDataSend( uint32_t dev_id ) {
 
     uint32_t can_id;
     uint8_t i, id_mess;
+    bool full, masked, period, send, cfg_req;
     
+    //запрос HMI всех пакетов настроек
+    cfg_req = ( dev_id & CAN_DATA_KEYFRAME ) && ( dev_id & ~CAN_DATA_KEYFRAME ) == ID_CONFIG ? true : false;
+    full = ( dev_id & ( CAN_DATA_KEYFRAME | CAN_DATA_SUBSCR ) ) ? true : false;
+    period = ( dev_id & ( CAN_DATA_PERIOD | CAN_DATA_SUBSCR ) ) ? true : false;
+    masked = ( dev_id & CAN_DATA_KEYFRAME ) ? false : true;
+    dev_id &= ~( CAN_DATA_KEYFRAME | CAN_DATA_PERIOD | CAN_DATA_SUBSCR );
     //передача событий
     if ( CAN_GET_DEV_ID( dev_id ) == ID_DEV_LOG ) {
         //ID сообщения (без ID события)
@@ -175,21 +259,229 @@ void DevDataSend( uint32_t dev_id ) {
         id_mess = (uint8_t)( (uint32_t)CAN_MASK_MESS_ID & (uint32_t)dev_id );
         //передача пакета данных, для ID_DEV_GEN размер данных = 0
         if ( CAN_GET_PARAM_ID( ( dev_id & CAN_MASK_PARAM_ID ) ) == ID_DEV_GEN ) 
-            CANSendFrame( can_id, (uint8_t *)&id_mess, 0 );
-        else CANSendFrame( can_id, (uint8_t *)&id_mess, sizeof( id_mess ) );
+            CANSendFrame( CAN_TX_HIGH, can_id, (uint8_t *)&id_mess, 0 );
+        else CANSendFrame( CAN_TX_HIGH, can_id, (uint8_t *)&id_mess, sizeof( id_mess ) );
+        return;
+       }
+    if ( dev_id >= ID_DEV_LOG )
         return;
+    if ( dev_id == ID_DEV_NULL && full == false )
+        return; //только пересчет времени периодической передачи
+    if ( dev_id != ID_DEV_NULL && masked == true ) {
+        //передача по подписке
+        if ( !subscr[dev_id].mask )
+            return;
+        if ( !( subscr[dev_id].flags & CAN_SUBSCR_CHANGE ) ) {
+            if ( period == false )
+                return; //данные уст-ва передаются только периодически
+            full = true;
+           }
+       }
+    //пакет портов - признак наличия связи для HMI, периодическая передача без учета изменений
+    if ( dev_id == ID_DEV_PORTS && period == true )
+        full = true;
+    //периодическая передача всех пакетов уст-ва
+    if ( dev_id != ID_DEV_NULL && osKernelGetTickCount() - key_time[dev_id] >= CAN_KEYFRAME_TIME )
+        full = true;
+    if ( full == true ) {
+        can_stat[CAN_DATA_KEYS]++;
+        if ( dev_id == ID_DEV_NULL ) {
+            //запрос всех пакетов всех уст-в
+            for ( i = 0; i < SIZE_ARRAY( key_time ); i++ )
+                key_time[i] = osKernelGetTickCount();
+           }
+        else key_time[dev_id] = osKernelGetTickCount();
        }
     //передача данных
     for ( i = 0; i < SIZE_ARRAY( can_data ); i++ ) {
-        if ( can_data[i].dev_id != dev_id )
+        if ( dev_id != ID_DEV_NULL && can_data[i].dev_id != dev_id )
+            continue;
+        //пакеты не входящие в подписку не формируются и не передаются
+        if ( masked == true && !( subscr[can_data[i].dev_id].mask & CAN_SUBSCR_BIT( can_data[i].pack_id ) ) )
             continue;
         if ( can_data[i].func != 0 )
             can_data[i].func( can_data[i].pack_id ); //вызов функции - формируем данные
+        send = full;
+        if ( can_data[i].dev_id == ID_CONFIG )
+            send = can_data[i].pack_id == CAN_CONFIG_HASH ? ( full || period ) : cfg_req;
+        //пакет без изменений не передается
+        if ( send == false && CanDataChanged( i ) == false ) {
+            can_stat[CAN_DATA_SKIP]++;
+            continue;
+           }
         //параметры пакета
         can_id = CAN_DEV_ID( can_data[i].dev_id ) | CAN_PACK_SUB( can_data[i].pack_id );
-        //передача пакета данных
-        CANSendFrame( can_id, can_data[i].ptr_data, can_data[i].len_data );
+        //передача пакета данных, параметры настроек с низким приоритетом
+        if ( CANSendFrame( can_data[i].dev_id == ID_CONFIG ? CAN_TX_LOW : CAN_TX_NORMAL, can_id,
+                           can_data[i].ptr_data, can_data[i].len_data ) != SUCCESS ) {
+            //пакет не передан, копия не обновляется - пакет будет передан повторно
+            can_stat[CAN_DATA_FAIL]++;
+            continue;
+           }
+        memcpy( can_shadow[i].data, can_data[i].ptr_data, can_data[i].len_data );
+        can_shadow[i].valid = true;
+        can_stat[CAN_DATA_SEND]++;
+       }
+ }
+
+//*************************************************************************************************
+// Изменение подписки HMI на данные уст-ва, вызывается из задачи выполнения команд HMI
+// Все пакеты новой подписки передаются сразу
+// CAN_SUBSCR *sub - параметры подписки
+//*************************************************************************************************
+void CanDataSubscr( CAN_SUBSCR *sub ) {
+
+    uint8_t dev, first, last;
+    uint32_t send;
+
+    if ( sub->dev_id >= SIZE_ARRAY( subscr ) || mutex_subscr == NULL )
+        return;
+    first = last = sub->dev_id;
+    if ( sub->dev_id == ID_DEV_NULL ) {
+        first = ID_DEV_NULL + 1;
+        last = SIZE_ARRAY( subscr ) - 1;
+       }
+    osMutexAcquire( mutex_subscr, osWaitForever );
+    for ( dev = first; dev <= last; dev++ ) {
+        if ( sub->flags & CAN_SUBSCR_DEFAULT ) {
+            SubscrDefault( (Device)dev );
+            continue;
+           }
+        subscr[dev].mask = sub->mask;
+        subscr[dev].period = sub->period;
+        subscr[dev].flags = sub->flags & CAN_SUBSCR_CHANGE;
+        subscr[dev].time = osKernelGetTickCount();
+       }
+    osMutexRelease( mutex_subscr );
+    //передача пакетов подписки, задача передачи пересчитывает время ожидания
+    send = sub->dev_id | CAN_DATA_SUBSCR;
+    osMessageQueuePut( hmi_msg, &send, 0, 0 );
+ }
+
+//*************************************************************************************************
+// Передача данных уст-в для которых наступило время периодической передачи по подписке
+// Вызывается из задачи передачи данных HMI
+//*************************************************************************************************
+void CanDataPublish( void ) {
+
+    uint8_t dev;
+    uint32_t now, due = 0;
+
+    if ( mutex_subscr == NULL )
+        return;
+    now = osKernelGetTickCount();
+    osMutexAcquire( mutex_subscr, osWaitForever );
+    for ( dev = ID_DEV_NULL + 1; dev < SIZE_ARRAY( subscr ); dev++ ) {
+        if ( !subscr[dev].mask || !subscr[dev].period || now - subscr[dev].time < subscr[dev].period )
+            continue;
+        subscr[dev].time += subscr[dev].period;
+        if ( now - subscr[dev].time >= subscr[dev].period )
+            subscr[dev].time = now; //пропущенные периоды не передаются
+        due |= 1UL << dev;
+       }
+    osMutexRelease( mutex_subscr );
+    for ( dev = ID_DEV_NULL + 1; dev < SIZE_ARRAY( subscr ); dev++ )
+        if ( due & ( 1UL << dev ) )
+            DevDataSend( dev | CAN_DATA_PERIOD );
+ }
+
+//*************************************************************************************************
+// Возвращает время до ближайшей периодической передачи по подписке
+// return uint32_t - время ожидания (msec), osWaitForever - периодической передачи нет
+//*************************************************************************************************
+uint32_t CanDataWait( void ) {
+
+    uint8_t dev;
+    uint32_t now, left, wait = osWaitForever;
+
+    if ( mutex_subscr == NULL )
+        return wait;
+    now = osKernelGetTickCount();
+    osMutexAcquire( mutex_subscr, osWaitForever );
+    for ( dev = ID_DEV_NULL + 1; dev < SIZE_ARRAY( subscr ); dev++ ) {
+        if ( !subscr[dev].mask || !subscr[dev].period )
+            continue;
+        left = now - subscr[dev].time >= subscr[dev].period ? 0 : subscr[dev].period - ( now - subscr[dev].time );
+        if ( left < wait )
+            wait = left;
        }
+    osMutexRelease( mutex_subscr );
+    return wait;
+ }
+
+//*************************************************************************************************
+// Возвращает параметры подписки HMI на данные уст-ва
+// Device dev      - ID уст-ва
+// CAN_SUBSCR *sub - параметры подписки
+// return = true   - параметры подписки заполнены
+//*************************************************************************************************
+bool CanDataSubscrGet( Device dev, CAN_SUBSCR *sub ) {
+
+    if ( dev == ID_DEV_NULL || dev >= SIZE_ARRAY( subscr ) )
+        return false;
+    sub->dev_id = dev;
+    sub->flags = subscr[dev].flags;
+    sub->period = subscr[dev].period;
+    sub->mask = subscr[dev].mask;
+    return true;
+ }
+
+//*************************************************************************************************
+// Возвращает значение счетчика передачи пакетов данных
+// CanDataCnt type - тип счетчика
+// return uint32_t - значение счетчика
+//*************************************************************************************************
+uint32_t CanDataStat( CanDataCnt type ) {
+
+    if ( type >= CAN_DATA_CNT )
+        return 0;
+    return can_stat[type];
+ }
+
+//*************************************************************************************************
+// Проверка изменения данных пакета относительно последних переданных
+// Для пакетов из значений float пакет считается измененным если хотя бы одно значение
+// изменилось больше чем на величину зоны нечувствительности
+// uint8_t ind   - индекс пакета в can_data[]
+// return = true - данные изменились, пакет необходимо передать
+//*************************************************************************************************
+static bool CanDataChanged( uint8_t ind ) {
+
+    uint8_t i;
+    float value, prev;
+
+    if ( can_shadow[ind].valid == false )
+        return true;
+    if ( !can_data[ind].deadband )
+        return memcmp( can_shadow[ind].data, can_data[ind].ptr_data, can_data[ind].len_data ) ? true : false;
+    for ( i = 0; i < can_data[ind].len_data; i += sizeof( float ) ) {
+        //структуры упакованы, значения могут быть не выровнены
+        memcpy( &value, can_data[ind].ptr_data + i, sizeof( float ) );
+        memcpy( &prev, can_shadow[ind].data + i, sizeof( float ) );
+        if ( value - prev > can_data[ind].deadband || prev - value > can_data[ind].deadband )
+            return true;
+       }
+    return false;
+ }
+
+//*************************************************************************************************
+// Подписка по умолчанию: все пакеты уст-ва при изменении данных, для уст-в из subscr_def[]
+// периодическая передача с признаками из таблицы (без CAN_SUBSCR_CHANGE - все пакеты каждый период)
+// Device dev - ID уст-ва
+//*************************************************************************************************
+static void SubscrDefault( Device dev ) {
+
+    uint8_t i;
+
+    subscr[dev].mask = CAN_SUBSCR_ALL;
+    subscr[dev].flags = CAN_SUBSCR_CHANGE;
+    subscr[dev].period = 0;
+    subscr[dev].time = osKernelGetTickCount();
+    for ( i = 0; i < SIZE_ARRAY( subscr_def ); i++ )
+        if ( subscr_def[i].dev_id == dev ) {
+            subscr[dev].period = subscr_def[i].period;
+            subscr[dev].flags = subscr_def[i].flags;
+           }
  }
 
 //*************************************************************************************************
@@ -470,4 +762,8 @@ static void CanDataConfig( uint8_t sub_id ) {
         can_config14.spa_latitude = config.spa_latitude;
     if ( sub_id == 15 )
         can_config15.spa_longitude = config.spa_longitude;
+    if ( sub_id == CAN_CONFIG_HASH ) {
+        can_config16.gen = ConfigGen();
+        can_config16.hash = ConfigHash();
+       }
  }
@@ -0,0 +1,142 @@
+
+//*************************************************************************************************
+//
+// Таблица фильтра приема пакетов CAN (Acceptance Filter)
+// Модель секций "Explicit Extended" и "Group Extended" таблицы фильтра LPC177x: отдельные ID
+// и диапазоны ID хранятся по возрастанию, диапазоны не пересекаются, отдельные ID не входят
+// в диапазоны. Поиск выполняется так же как аппаратным блоком фильтра - двоичным поиском по
+// отдельным ID, затем по диапазонам. Модуль не зависит от RTOS и периферии
+//
+//*************************************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "can_filter.h"
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static bool GroupFind( CAN_AF_TABLE *af, uint32_t id );
+
+//*************************************************************************************************
+// Очистка таблицы фильтра
+// CAN_AF_TABLE *af - таблица фильтра
+//*************************************************************************************************
+void CanAfClear( CAN_AF_TABLE *af ) {
+
+    memset( af, 0x00, sizeof( CAN_AF_TABLE ) );
+ }
+
+//*************************************************************************************************
+// Добавление отдельного ID в таблицу с сохранением порядка по возрастанию
+// ID уже входящий в таблицу (в т.ч. в диапазон) повторно не добавляется
+// CAN_AF_TABLE *af - таблица фильтра
+// uint32_t id      - ID пакета
+// return = true    - ID добавлен или уже есть в таблице
+//        = false   - таблица заполнена
+//*************************************************************************************************
+bool CanAfAddExact( CAN_AF_TABLE *af, uint32_t id ) {
+
+    uint8_t ind;
+
+    if ( CanAfMatch( af, id ) == true )
+        return true;
+    if ( af->exact_cnt >= CAN_AF_EXACT_MAX )
+        return false;
+    for ( ind = af->exact_cnt; ind && af->exact[ind - 1] > id; ind-- )
+        af->exact[ind] = af->exact[ind - 1];
+    af->exact[ind] = id;
+    af->exact_cnt++;
+    return true;
+ }
+
+//*************************************************************************************************
+// Добавление диапазона ID в таблицу с сохранением порядка по возрастанию
+// Пересекающиеся и смежные диапазоны объединяются, отдельные ID входящие в диапазон удаляются
+// CAN_AF_TABLE *af - таблица фильтра
+// uint32_t lower   - нижняя граница диапазона
+// uint32_t upper   - верхняя граница диапазона
+// return = true    - диапазон добавлен
+//        = false   - таблица заполнена или неверные границы
+//*************************************************************************************************
+bool CanAfAddGroup( CAN_AF_TABLE *af, uint32_t lower, uint32_t upper ) {
+
+    uint8_t ind, dst;
+
+    if ( lower > upper )
+        return false;
+    //объединение с пересекающимися и смежными диапазонами
+    for ( ind = 0, dst = 0; ind < af->group_cnt; ind++ ) {
+        if ( ( af->upper[ind] == 0xFFFFFFFF || af->upper[ind] + 1 >= lower ) &&
+             ( upper == 0xFFFFFFFF || upper + 1 >= af->lower[ind] ) ) {
+            if ( af->lower[ind] < lower )
+                lower = af->lower[ind];
+            if ( af->upper[ind] > upper )
+                upper = af->upper[ind];
+            continue;
+           }
+        af->lower[dst] = af->lower[ind];
+        af->upper[dst++] = af->upper[ind];
+       }
+    af->group_cnt = dst;
+    if ( af->group_cnt >= CAN_AF_GROUP_MAX )
+        return false;
+    for ( ind = af->group_cnt; ind && af->lower[ind - 1] > lower; ind-- ) {
+        af->lower[ind] = af->lower[ind - 1];
+        af->upper[ind] = af->upper[ind - 1];
+       }
+    af->lower[ind] = lower;
+    af->upper[ind] = upper;
+    af->group_cnt++;
+    //удаление отдельных ID входящих в диапазон
+    for ( ind = 0, dst = 0; ind < af->exact_cnt; ind++ )
+        if ( af->exact[ind] < lower || af->exact[ind] > upper )
+            af->exact[dst++] = af->exact[ind];
+    af->exact_cnt = dst;
+    return true;
+ }
+
+//*************************************************************************************************
+// Проверка приема пакета фильтром
+// CAN_AF_TABLE *af - таблица фильтра
+// uint32_t id      - ID пакета
+// return = true    - пакет принимается
+//*************************************************************************************************
+bool CanAfMatch( CAN_AF_TABLE *af, uint32_t id ) {
+
+    uint8_t low, high, mid;
+
+    //двоичный поиск по отдельным ID
+    for ( low = 0, high = af->exact_cnt; low < high; ) {
+        mid = ( low + high ) / 2;
+        if ( af->exact[mid] == id )
+            return true;
+        if ( af->exact[mid] < id )
+            low = mid + 1;
+        else high = mid;
+       }
+    return GroupFind( af, id );
+ }
+
+//*************************************************************************************************
+// Двоичный поиск диапазона содержащего ID
+// CAN_AF_TABLE *af - таблица фильтра
+// uint32_t id      - ID пакета
+// return = true    - ID входит в один из диапазонов
+//*************************************************************************************************
+static bool GroupFind( CAN_AF_TABLE *af, uint32_t id ) {
+
+    uint8_t low, high, mid;
+
+    for ( low = 0, high = af->group_cnt; low < high; ) {
+        mid = ( low + high ) / 2;
+        if ( id < af->lower[mid] )
+            high = mid;
+        else if ( id > af->upper[mid] )
+            low = mid + 1;
+        else return true;
+       }
+    return false;
+ }
@@ -0,0 +1,32 @@
+
+#ifndef __CAN_FILTER_H
+#define __CAN_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CAN_AF_EXACT_MAX        32          //макс кол-во отдельных ID (Explicit Extended)
+#define CAN_AF_GROUP_MAX        16          //макс кол-во диапазонов ID (Group Extended)
+
+//Таблица фильтра приема (модель секций Extended таблицы фильтра LPC177x)
+typedef struct {
+    uint8_t  exact_cnt;                     //кол-во отдельных ID
+    uint8_t  group_cnt;                     //кол-во диапазонов ID
+    uint32_t exact[CAN_AF_EXACT_MAX];       //отдельные ID по возрастанию
+    uint32_t lower[CAN_AF_GROUP_MAX];       //нижние границы диапазонов по возрастанию
+    uint32_t upper[CAN_AF_GROUP_MAX];       //верхние границы диапазонов
+ } CAN_AF_TABLE;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void CanAfClear( CAN_AF_TABLE *af );
+bool CanAfAddExact( CAN_AF_TABLE *af, uint32_t id );
+bool CanAfAddGroup( CAN_AF_TABLE *af, uint32_t lower, uint32_t upper );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+bool CanAfMatch( CAN_AF_TABLE *af, uint32_t id );
+
+#endif
@@ -0,0 +1,779 @@
+
+//*************************************************************************************************
+//
+// Сегментированная передача блоков данных по CAN шине (аналог ISO-TP, ISO 15765-2)
+// Сообщения длиннее 7 байт передаются пакетами FF (первый) и CF (последующие), приемник
+// управляет потоком пакетами FC: кол-во пакетов до следующего FC (BS) и интервал между
+// пакетами (STmin). Одновременно обслуживается CAN_XFER_SESS независимых сессий.
+// Поверх транспорта выполняются сервисы чтения/записи файлов SD карты: данные файла читаются
+// и записываются блоками по мере передачи, размер сообщения не ограничен размером буфера.
+// Сервис чтения параметров возвращает значения списка параметров одним сообщением, индекс
+// параметров последнего запроса сохраняется и при повторе запроса не формируется.
+// Пакеты передаются в классе CAN_TX_LOW с резервом очереди для параметров настроек.
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "cmsis_os2.h"
+
+#include "device.h"
+#include "dev_param.h"
+#include "config.h"
+#include "can_data.h"
+#include "can_def.h"
+
+#include "sdcard.h"
+#include "logger.h"
+#include "rollup.h"
+#include "hmi_can.h"
+#include "can_xfer.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define XFER_BUF                512         //размер буфера сессии (сектор SD карты)
+#define XFER_QUEUE              64          //размер очереди принятых пакетов
+#define XFER_TIMEOUT            1000        //время ожидания пакетов CF/FC (msec)
+#define XFER_STREAM_TIMEOUT     5000        //время ожидания данных для записи в файл (msec)
+#define XFER_POLL               100         //период проверки таймаутов (msec)
+#define XFER_TX_RESERVE         16          //резерв очереди CAN_TX_LOW для пакетов ID_CONFIG
+#define XFER_SF_MAX             7           //макс размер данных пакета SF
+#define XFER_FF_MAX             0x0FFF      //макс размер сообщения в 12-битном поле пакета FF
+#define XFER_HDR_READ           6           //размер заголовка ответа сервиса CAN_XFER_READ
+#define XFER_HDR_WRITE          6           //размер ответа на прием данных сервиса CAN_XFER_WRITE
+#define XFER_HDR_PARAM          3           //размер заголовка ответа сервиса CAN_XFER_PARAM
+#define XFER_HDR_ROLLUP         3           //размер заголовка ответа сервиса CAN_XFER_ROLLUP
+
+//ID пакетов контроллер -> HMI
+#define XFER_ID( sess )         ( CAN_DEV_ID( (uint32_t)ID_DEV_XFER ) | CAN_PARAM_ID( (uint32_t)sess ) | CAN_PACK_SUB( CAN_XFER_TO_HMI ) )
+
+//Состояние сессии
+typedef enum {
+    XFER_IDLE,                              //ожидание запроса
+    XFER_RECV,                              //прием сообщения
+    XFER_SEND                               //передача сообщения
+ } XferState;
+
+//Принятый пакет
+typedef struct {
+    uint8_t  sess;                          //номер сессии
+    uint8_t  len;                           //размер данных
+    uint8_t  data[CAN_DATA_MAX];            //данные
+ } XFER_FRAME;
+
+//Сессия передачи
+typedef struct {
+    uint8_t   id;                           //номер сессии
+    XferState state;                        //состояние
+    uint8_t   seq;                          //номер следующего пакета CF
+    uint8_t   block;                        //кол-во пакетов CF до FC, 0 - без ограничения
+    uint8_t   st_min;                       //интервал между пакетами CF при передаче (msec)
+    bool      wait_fc;                      //передача: ожидание пакета FC
+    bool      stream;                       //данные принимаемого сообщения записываются в файл
+    bool      error;                        //ошибка записи в файл
+    FILE      *file;                        //открытый файл сервиса
+    uint32_t  size;                         //размер сообщения
+    uint32_t  done;                         //кол-во принятых/переданных байт сообщения
+    uint32_t  time;                         //время последнего пакета (для таймаутов)
+    uint16_t  len;                          //кол-во байт в буфере
+    uint16_t  pos;                          //позиция передачи в буфере
+    uint8_t   buf[XFER_BUF];                //буфер данных
+ } XFER_SESS;
+
+//Элемент индекса параметров сервиса CAN_XFER_PARAM
+typedef struct {
+    Device    dev;                          //ID уст-ва
+    uint8_t   param;                        //ID параметра
+    ValueType type;                         //тип значения
+    ParamValFunc func;                      //функция получения значения
+ } XFER_PARAM;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static osMessageQueueId_t xfer_msg = NULL;
+static XFER_SESS xfer_sess[CAN_XFER_SESS];
+static uint32_t xfer_stat[CAN_XFER_STAT_CNT];
+static XFER_PARAM par_ind[CAN_XFER_PARAM_MAX];             //индекс параметров последнего запроса
+static uint8_t par_req[CAN_XFER_PARAM_MAX * 2];             //список параметров последнего запроса
+static uint8_t par_cnt = 0;                                 //кол-во параметров в индексе
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osThreadAttr_t xfer_attr = {
+    .name = "HmiXfer",
+    .stack_size = 768,
+    .priority = osPriorityNormal
+ };
+
+static const osMessageQueueAttr_t que_attr = { .name = "HmiXfer" };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void TaskXfer( void *pvParameters );
+static bool XferBusy( void );
+static void XferFrame( XFER_SESS *sess, uint8_t *data, uint8_t len );
+static void XferFirst( XFER_SESS *sess, uint8_t *data, uint8_t len );
+static void XferNext( XFER_SESS *sess, uint8_t *data, uint8_t len );
+static void XferFlow( XFER_SESS *sess, uint8_t *data, uint8_t len );
+static void XferFlowSend( XFER_SESS *sess, uint8_t status );
+static void XferStore( XFER_SESS *sess, uint8_t *data, uint8_t cnt );
+static void XferFlush( XFER_SESS *sess );
+static void XferComplete( XFER_SESS *sess );
+static void XferStart( XFER_SESS *sess, uint32_t size );
+static void XferSend( XFER_SESS *sess );
+static uint8_t XferRead( XFER_SESS *sess, uint8_t *dst, uint8_t cnt );
+static void XferTimeout( XFER_SESS *sess );
+static void XferDone( XFER_SESS *sess );
+static void XferClose( XFER_SESS *sess );
+static void XferRequest( XFER_SESS *sess );
+static void XferAnswer( XFER_SESS *sess, uint8_t srv, CanXferResult stat );
+static CanXferResult SrvRead( XFER_SESS *sess );
+static CanXferResult SrvWrite( XFER_SESS *sess );
+static CanXferResult SrvParam( XFER_SESS *sess );
+static CanXferResult SrvRollup( XFER_SESS *sess );
+
+//*************************************************************************************************
+// Инициализация сессий, создание задачи
+//*************************************************************************************************
+void CanXferInit( void ) {
+
+    uint8_t ind;
+
+    memset( xfer_sess, 0x00, sizeof( xfer_sess ) );
+    for ( ind = 0; ind < CAN_XFER_SESS; ind++ )
+        xfer_sess[ind].id = ind;
+    xfer_msg = osMessageQueueNew( XFER_QUEUE, sizeof( XFER_FRAME ), &que_attr );
+    osThreadNew( TaskXfer, NULL, &xfer_attr );
+ }
+
+//*************************************************************************************************
+// Прием пакета ID_DEV_XFER, вызывается из прерывания CAN
+// uint32_t can_id - ID пакета
+// uint8_t *data   - данные пакета
+// uint8_t len     - размер данных
+//*************************************************************************************************
+void CanXferRecv( uint32_t can_id, uint8_t *data, uint8_t len ) {
+
+    XFER_FRAME frame;
+
+    if ( xfer_msg == NULL || !len || CAN_GET_PACK_ID( ( can_id & CAN_MASK_PACK_ID ) ) != CAN_XFER_TO_CTRL )
+        return;
+    frame.sess = CAN_GET_PARAM_ID( ( can_id & CAN_MASK_PARAM_ID ) );
+    if ( frame.sess >= CAN_XFER_SESS )
+        return;
+    frame.len = len > CAN_DATA_MAX ? CAN_DATA_MAX : len;
+    memcpy( frame.data, data, frame.len );
+    if ( osMessageQueuePut( xfer_msg, &frame, 0, 0 ) != osOK )
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+ }
+
+//*************************************************************************************************
+// Возвращает значение счетчика сегментированной передачи
+// CanXferCnt type - тип счетчика
+// return uint32_t - значение счетчика
+//*************************************************************************************************
+uint32_t CanXferStat( CanXferCnt type ) {
+
+    if ( type >= CAN_XFER_STAT_CNT )
+        return 0;
+    return xfer_stat[type];
+ }
+
+//*************************************************************************************************
+// Задача обработки принятых пакетов и передачи сообщений
+// Пока есть сессии с разрешенной передачей пакетов CF, очередь проверяется каждый тик
+//*************************************************************************************************
+static void TaskXfer( void *pvParameters ) {
+
+    uint8_t ind;
+    XFER_FRAME frame;
+
+    for ( ;; ) {
+        if ( osMessageQueueGet( xfer_msg, &frame, NULL, XferBusy() == true ? 1 : XFER_POLL ) == osOK )
+            XferFrame( &xfer_sess[frame.sess], frame.data, frame.len );
+        for ( ind = 0; ind < CAN_XFER_SESS; ind++ ) {
+            XferSend( &xfer_sess[ind] );
+            XferTimeout( &xfer_sess[ind] );
+           }
+       }
+ }
+
+//*************************************************************************************************
+// Проверка наличия сессий передающих пакеты CF
+// return = true - есть сессии с разрешенной передачей
+//*************************************************************************************************
+static bool XferBusy( void ) {
+
+    uint8_t ind;
+
+    for ( ind = 0; ind < CAN_XFER_SESS; ind++ )
+        if ( xfer_sess[ind].state == XFER_SEND && xfer_sess[ind].wait_fc == false )
+            return true;
+    return false;
+ }
+
+//*************************************************************************************************
+// Обработка принятого пакета сессии
+// XFER_SESS *sess - сессия
+// uint8_t *data   - данные пакета
+// uint8_t len     - размер данных
+//*************************************************************************************************
+static void XferFrame( XFER_SESS *sess, uint8_t *data, uint8_t len ) {
+
+    uint8_t pci;
+
+    pci = data[0] & CAN_XFER_PCI;
+    if ( pci == CAN_XFER_FC ) {
+        XferFlow( sess, data, len );
+        return;
+       }
+    if ( pci == CAN_XFER_CF ) {
+        XferNext( sess, data, len );
+        return;
+       }
+    if ( pci != CAN_XFER_SF && pci != CAN_XFER_FF ) {
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        return;
+       }
+    //новое сообщение прерывает прием/передачу текущего
+    if ( sess->state != XFER_IDLE ) {
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        XferClose( sess );
+       }
+    if ( pci == CAN_XFER_FF ) {
+        XferFirst( sess, data, len );
+        return;
+       }
+    //одиночный пакет
+    if ( !( data[0] & 0x0F ) || ( data[0] & 0x0F ) > len - 1 ) {
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        return;
+       }
+    sess->size = data[0] & 0x0F;
+    sess->done = 0;
+    sess->len = 0;
+    XferStore( sess, data + 1, sess->size );
+    XferComplete( sess );
+ }
+
+//*************************************************************************************************
+// Прием первого пакета (FF) сообщения, передача FC
+// XFER_SESS *sess - сессия
+// uint8_t *data   - данные пакета
+// uint8_t len     - размер данных
+//*************************************************************************************************
+static void XferFirst( XFER_SESS *sess, uint8_t *data, uint8_t len ) {
+
+    uint8_t hdr = 2;
+    uint32_t size;
+
+    if ( len < hdr ) {
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        return;
+       }
+    size = ( ( data[0] & 0x0F ) << 8 ) | data[1];
+    if ( !size ) {
+        //размер сообщения более 4095 байт
+        hdr = 6;
+        if ( len < hdr ) {
+            xfer_stat[CAN_XFER_STAT_ERROR]++;
+            return;
+           }
+        size = ( data[2] << 24 ) | ( data[3] << 16 ) | ( data[4] << 8 ) | data[5];
+       }
+    if ( size <= len - hdr || ( sess->stream == false && size > XFER_BUF ) ) {
+        //запросы принимаются целиком в буфер, данные без потоковой записи не принимаются
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        XferFlowSend( sess, CAN_XFER_FC_OVFL );
+        return;
+       }
+    sess->state = XFER_RECV;
+    sess->size = size;
+    sess->done = 0;
+    sess->len = 0;
+    sess->seq = 1;
+    sess->block = _CAN_XFER_BS;
+    sess->time = osKernelGetTickCount();
+    XferStore( sess, data + hdr, len - hdr );
+    XferFlowSend( sess, CAN_XFER_FC_CTS );
+ }
+
+//*************************************************************************************************
+// Прием последующего пакета (CF) сообщения
+// После приема блока из _CAN_XFER_BS пакетов данные записываются в файл, передается FC
+// XFER_SESS *sess - сессия
+// uint8_t *data   - данные пакета
+// uint8_t len     - размер данных
+//*************************************************************************************************
+static void XferNext( XFER_SESS *sess, uint8_t *data, uint8_t len ) {
+
+    if ( sess->state != XFER_RECV )
+        return; //пакет вне сообщения
+    if ( ( data[0] & 0x0F ) != sess->seq ) {
+        //нарушена последовательность пакетов, прием прерывается
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        XferClose( sess );
+        return;
+       }
+    sess->seq = ( sess->seq + 1 ) & 0x0F;
+    sess->time = osKernelGetTickCount();
+    XferStore( sess, data + 1, len - 1 );
+    if ( sess->done >= sess->size ) {
+        XferComplete( sess );
+        return;
+       }
+    if ( --sess->block )
+        return;
+    //блок принят
+    if ( sess->stream == true )
+        XferFlush( sess );
+    sess->block = _CAN_XFER_BS;
+    XferFlowSend( sess, CAN_XFER_FC_CTS );
+ }
+
+//*************************************************************************************************
+// Прием пакета управления потоком (FC) от HMI
+// XFER_SESS *sess - сессия
+// uint8_t *data   - данные пакета
+// uint8_t len     - размер данных
+//*************************************************************************************************
+static void XferFlow( XFER_SESS *sess, uint8_t *data, uint8_t len ) {
+
+    if ( sess->state != XFER_SEND || sess->wait_fc == false )
+        return;
+    sess->time = osKernelGetTickCount();
+    if ( ( data[0] & 0x0F ) == CAN_XFER_FC_WAIT )
+        return;
+    if ( ( data[0] & 0x0F ) != CAN_XFER_FC_CTS || len < 3 ) {
+        //HMI не может принять сообщение
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        XferClose( sess );
+        return;
+       }
+    sess->block = data[1];
+    //значения STmin 0xF1-0xF9 (100-900 мкс) и резервные округляются до 1 msec
+    sess->st_min = data[2] > 0x7F ? 1 : data[2];
+    sess->wait_fc = false;
+ }
+
+//*************************************************************************************************
+// Передача пакета управления потоком (FC)
+// XFER_SESS *sess - сессия
+// uint8_t status  - статус CAN_XFER_FC_*
+//*************************************************************************************************
+static void XferFlowSend( XFER_SESS *sess, uint8_t status ) {
+
+    uint8_t frame[3];
+
+    frame[0] = CAN_XFER_FC | status;
+    frame[1] = _CAN_XFER_BS;
+    frame[2] = _CAN_XFER_STMIN;
+    CANSendFrame( CAN_TX_LOW, XFER_ID( sess->id ), frame, sizeof( frame ) );
+ }
+
+//*************************************************************************************************
+// Сохранение принятых данных в буфере сессии, при записи в файл заполненный буфер
+// записывается в файл
+// XFER_SESS *sess - сессия
+// uint8_t *data   - данные
+// uint8_t cnt     - кол-во байт
+//*************************************************************************************************
+static void XferStore( XFER_SESS *sess, uint8_t *data, uint8_t cnt ) {
+
+    if ( cnt > sess->size - sess->done )
+        cnt = sess->size - sess->done;
+    if ( sess->len + cnt > XFER_BUF )
+        XferFlush( sess );
+    memcpy( sess->buf + sess->len, data, cnt );
+    sess->len += cnt;
+    sess->done += cnt;
+ }
+
+//*************************************************************************************************
+// Запись данных буфера сессии в файл
+// XFER_SESS *sess - сессия
+//*************************************************************************************************
+static void XferFlush( XFER_SESS *sess ) {
+
+    if ( sess->len && sess->file != NULL && fwrite( sess->buf, sizeof( uint8_t ), sess->len, sess->file ) != sess->len )
+        sess->error = true;
+    sess->len = 0;
+ }
+
+//*************************************************************************************************
+// Сообщение принято: выполнение запроса или завершение записи данных в файл
+// XFER_SESS *sess - сессия
+//*************************************************************************************************
+static void XferComplete( XFER_SESS *sess ) {
+
+    CanXferResult stat;
+
+    sess->state = XFER_IDLE;
+    xfer_stat[CAN_XFER_STAT_RECV]++;
+    if ( sess->stream == false ) {
+        XferRequest( sess );
+        return;
+       }
+    XferFlush( sess );
+    if ( fclose( sess->file ) )
+        sess->error = true;
+    sess->file = NULL;
+    sess->stream = false;
+    stat = sess->error == true ? CAN_XFER_ERR_IO : CAN_XFER_OK;
+    //ответ: [код][статус][размер]
+    sess->buf[0] = CAN_XFER_WRITE | CAN_XFER_ANSWER;
+    sess->buf[1] = stat;
+    memcpy( &sess->buf[2], &sess->size, sizeof( uint32_t ) );
+    sess->len = XFER_HDR_WRITE;
+    XferStart( sess, XFER_HDR_WRITE );
+ }
+
+//*************************************************************************************************
+// Начало передачи сообщения: начало сообщения в буфере сессии, остальные данные читаются
+// из открытого файла сессии
+// XFER_SESS *sess - сессия
+// uint32_t size   - размер сообщения
+//*************************************************************************************************
+static void XferStart( XFER_SESS *sess, uint32_t size ) {
+
+    uint8_t frame[CAN_DATA_MAX], hdr, cnt;
+
+    sess->size = size;
+    sess->done = 0;
+    sess->pos = 0;
+    if ( size <= XFER_SF_MAX ) {
+        //одиночный пакет
+        frame[0] = CAN_XFER_SF | size;
+        cnt = XferRead( sess, frame + 1, size );
+        if ( CANSendFrame( CAN_TX_LOW, XFER_ID( sess->id ), frame, cnt + 1 ) == SUCCESS ) {
+            xfer_stat[CAN_XFER_STAT_SEND]++;
+            xfer_stat[CAN_XFER_STAT_BYTES] += cnt;
+           }
+        else xfer_stat[CAN_XFER_STAT_ERROR]++;
+        XferDone( sess );
+        return;
+       }
+    if ( size <= XFER_FF_MAX ) {
+        frame[0] = CAN_XFER_FF | ( size >> 8 );
+        frame[1] = size;
+        hdr = 2;
+       }
+    else {
+        frame[0] = CAN_XFER_FF;
+        frame[1] = 0;
+        frame[2] = size >> 24;
+        frame[3] = size >> 16;
+        frame[4] = size >> 8;
+        frame[5] = size;
+        hdr = 6;
+       }
+    cnt = XferRead( sess, frame + hdr, CAN_DATA_MAX - hdr );
+    if ( cnt < CAN_DATA_MAX - hdr || CANSendFrame( CAN_TX_LOW, XFER_ID( sess->id ), frame, hdr + cnt ) == ERROR ) {
+        xfer_stat[CAN_XFER_STAT_ERROR]++;
+        XferClose( sess );
+        return;
+       }
+    sess->state = XFER_SEND;
+    sess->seq = 1;
+    sess->wait_fc = true;
+    sess->time = osKernelGetTickCount();
+ }
+
+//*************************************************************************************************
+// Передача пакетов CF сессии пока в очереди передачи есть место (с учетом резерва),
+// до исчерпания блока BS или с интервалом STmin
+// XFER_SESS *sess - сессия
+//*************************************************************************************************
+static void XferSend( XFER_SESS *sess ) {
+
+    uint8_t frame[CAN_DATA_MAX], cnt, need;
+
+    if ( sess->state != XFER_SEND || sess->wait_fc == true )
+        return;
+    while ( CANTxFree( CAN_TX_LOW ) > XFER_TX_RESERVE ) {
+        if ( sess->st_min && osKernelGetTickCount() - sess->time < sess->st_min )
+            return;
+        need = sess->size - sess->done > CAN_DATA_MAX - 1 ? CAN_DATA_MAX - 1 : sess->size - sess->done;
+        frame[0] = CAN_XFER_CF | sess->seq;
+        cnt = XferRead( sess, frame + 1, need );
+        if ( cnt < need || CANSendFrame( CAN_TX_LOW, XFER_ID( sess->id ), frame, cnt + 1 ) == ERROR ) {
+            //файл уменьшился или очередь занята, передача прерывается
+            xfer_stat[CAN_XFER_STAT_ERROR]++;
+            XferClose( sess );
+            return;
+           }
+        sess->seq = ( sess->seq + 1 ) & 0x0F;
+        sess->time = osKernelGetTickCount();
+        if ( sess->done >= sess->size ) {
+            xfer_stat[CAN_XFER_STAT_SEND]++;
+            xfer_stat[CAN_XFER_STAT_BYTES] += sess->size;
+            XferDone( sess );
+            return;
+           }
+        if ( sess->block && !--sess->block ) {
+            sess->wait_fc = true;
+            return;
+           }
+        if ( sess->st_min )
+            return;
+       }
+ }
+
+//*************************************************************************************************
+// Чтение данных передаваемого сообщения из буфера сессии, буфер заполняется из файла
+// XFER_SESS *sess - сессия
+// uint8_t *dst    - адрес для размещения данных
+// uint8_t cnt     - кол-во байт
+// return uint8_t  - кол-во прочитанных байт
+//*************************************************************************************************
+static uint8_t XferRead( XFER_SESS *sess, uint8_t *dst, uint8_t cnt ) {
+
+    uint8_t part, copy = 0;
+
+    if ( cnt > sess->size - sess->done )
+        cnt = sess->size - sess->done;
+    while ( copy < cnt ) {
+        if ( sess->pos >= sess->len ) {
+            sess->pos = sess->len = 0;
+            if ( sess->file != NULL )
+                sess->len = fread( sess->buf, sizeof( uint8_t ), XFER_BUF, sess->file );
+            if ( !sess->len )
+                break; //данных меньше заявленного размера
+           }
+        part = cnt - copy;
+        if ( part > sess->len - sess->pos )
+            part = sess->len - sess->pos;
+        memcpy( dst + copy, sess->buf + sess->pos, part );
+        sess->pos += part;
+        copy += part;
+       }
+    sess->done += copy;
+    return copy;
+ }
+
+//*************************************************************************************************
+// Контроль таймаутов: ожидание пакетов CF/FC, данных для записи в файл, свободного места
+// в очереди передачи
+// XFER_SESS *sess - сессия
+//*************************************************************************************************
+static void XferTimeout( XFER_SESS *sess ) {
+
+    uint32_t wait;
+
+    if ( sess->state == XFER_IDLE && sess->stream == false )
+        return;
+    wait = sess->state == XFER_IDLE ? XFER_STREAM_TIMEOUT : XFER_TIMEOUT;
+    if ( osKernelGetTickCount() - sess->time < wait )
+        return;
+    xfer_stat[CAN_XFER_STAT_TIMEOUT]++;
+    XferClose( sess );
+ }
+
+//*************************************************************************************************
+// Передача сообщения завершена, файл сервиса чтения закрывается, открытый для записи
+// файл остается открытым до приема данных
+// XFER_SESS *sess - сессия
+//*************************************************************************************************
+static void XferDone( XFER_SESS *sess ) {
+
+    if ( sess->stream == false ) {
+        XferClose( sess );
+        return;
+       }
+    sess->state = XFER_IDLE;
+    sess->wait_fc = false;
+    sess->len = sess->pos = 0;
+    sess->time = osKernelGetTickCount();
+ }
+
+//*************************************************************************************************
+// Завершение сессии, файл закрывается
+// XFER_SESS *sess - сессия
+//*************************************************************************************************
+static void XferClose( XFER_SESS *sess ) {
+
+    if ( sess->file != NULL )
+        fclose( sess->file );
+    sess->file = NULL;
+    sess->stream = false;
+    sess->state = XFER_IDLE;
+    sess->wait_fc = false;
+    sess->len = sess->pos = 0;
+ }
+
+//*************************************************************************************************
+// Выполнение запроса принятого в буфер сессии
+// XFER_SESS *sess - сессия
+//*************************************************************************************************
+static void XferRequest( XFER_SESS *sess ) {
+
+    uint8_t srv;
+    CanXferResult stat;
+
+    srv = sess->buf[0];
+    if ( srv == CAN_XFER_READ )
+        stat = SrvRead( sess );
+    else if ( srv == CAN_XFER_WRITE )
+        stat = SrvWrite( sess );
+    else if ( srv == CAN_XFER_PARAM )
+        stat = SrvParam( sess );
+    else if ( srv == CAN_XFER_ROLLUP )
+        stat = SrvRollup( sess );
+    else stat = CAN_XFER_ERR_SRV;
+    //при успешном чтении ответ с данными уже передается
+    if ( ( srv != CAN_XFER_READ && srv != CAN_XFER_PARAM && srv != CAN_XFER_ROLLUP ) || stat != CAN_XFER_OK )
+        XferAnswer( sess, srv, stat );
+ }
+
+//*************************************************************************************************
+// Передача ответа без данных: [код][статус]
+// XFER_SESS *sess  - сессия
+// uint8_t srv      - код сервиса
+// CanXferResult stat - статус выполнения
+//*************************************************************************************************
+static void XferAnswer( XFER_SESS *sess, uint8_t srv, CanXferResult stat ) {
+
+    sess->buf[0] = srv | CAN_XFER_ANSWER;
+    sess->buf[1] = stat;
+    sess->len = 2;
+    XferStart( sess, 2 );
+ }
+
+//*************************************************************************************************
+// Сервис чтения файла: [код][смещение 4][размер 4][имя файла]
+// Ответ: [код][статус][размер 4][данные], данные читаются из файла по мере передачи
+// XFER_SESS *sess    - сессия
+// return CanXferResult - статус выполнения
+//*************************************************************************************************
+static CanXferResult SrvRead( XFER_SESS *sess ) {
+
+    char *name;
+    uint32_t offset, size, fsize;
+
+    name = (char *)&sess->buf[9];
+    if ( sess->len < 10 || !*name || memchr( name, 0, sess->len - 9 ) == NULL )
+        return CAN_XFER_ERR_PARAM;
+    if ( SDStatus() == ERROR )
+        return CAN_XFER_ERR_SD;
+    memcpy( &offset, &sess->buf[1], sizeof( uint32_t ) );
+    memcpy( &size, &sess->buf[5], sizeof( uint32_t ) );
+    LogFlush(); //строки протоколов из буферов записываются в файлы
+    sess->file = fopen( name, "r" );
+    if ( sess->file == NULL )
+        return CAN_XFER_ERR_FILE;
+    fseek( sess->file, 0, SEEK_END );
+    fsize = ftell( sess->file );
+    if ( offset > fsize || fseek( sess->file, offset, SEEK_SET ) ) {
+        XferClose( sess );
+        return CAN_XFER_ERR_PARAM;
+       }
+    if ( !size || size > fsize - offset )
+        size = fsize - offset;
+    sess->buf[0] = CAN_XFER_READ | CAN_XFER_ANSWER;
+    sess->buf[1] = CAN_XFER_OK;
+    memcpy( &sess->buf[2], &size, sizeof( uint32_t ) );
+    sess->len = XFER_HDR_READ;
+    XferStart( sess, XFER_HDR_READ + size );
+    return CAN_XFER_OK;
+ }
+
+//*************************************************************************************************
+// Сервис записи файла: [код][режим][имя файла]
+// Файл открывается, данные следующего сообщения сессии записываются в файл по мере приема
+// XFER_SESS *sess    - сессия
+// return CanXferResult - статус выполнения
+//*************************************************************************************************
+static CanXferResult SrvWrite( XFER_SESS *sess ) {
+
+    char *name;
+
+    name = (char *)&sess->buf[2];
+    if ( sess->len < 3 || !*name || memchr( name, 0, sess->len - 2 ) == NULL || sess->buf[1] > CAN_XFER_WR_APPEND )
+        return CAN_XFER_ERR_PARAM;
+    if ( SDStatus() == ERROR )
+        return CAN_XFER_ERR_SD;
+    sess->file = fopen( name, sess->buf[1] == CAN_XFER_WR_APPEND ? "a" : "w" );
+    if ( sess->file == NULL )
+        return CAN_XFER_ERR_FILE;
+    sess->stream = true;
+    sess->error = false;
+    sess->time = osKernelGetTickCount();
+    return CAN_XFER_OK;
+ }
+
+//*************************************************************************************************
+// Сервис чтения значений параметров: [код][ID уст-ва][ID параметра]...
+// Ответ: [код][статус][кол-во значений][значения], значения передаются в порядке запроса
+// XFER_SESS *sess    - сессия
+// return CanXferResult - статус выполнения
+//*************************************************************************************************
+static CanXferResult SrvParam( XFER_SESS *sess ) {
+
+    uint8_t ind, cnt;
+    uint16_t pos, len;
+
+    cnt = ( sess->len - 1 ) / 2;
+    if ( sess->len < 3 || !( sess->len & 0x01 ) || cnt > CAN_XFER_PARAM_MAX )
+        return CAN_XFER_ERR_PARAM;
+    if ( cnt != par_cnt || memcmp( par_req, &sess->buf[1], cnt * 2 ) ) {
+        //новый список параметров, формируем индекс
+        memcpy( par_req, &sess->buf[1], cnt * 2 );
+        for ( ind = 0; ind < cnt; ind++ ) {
+            par_ind[ind].dev = (Device)par_req[ind * 2];
+            par_ind[ind].param = par_req[ind * 2 + 1];
+            par_ind[ind].type = ParamGetType( par_ind[ind].dev, par_ind[ind].param );
+            par_ind[ind].func = ParamGetFunc( par_ind[ind].dev );
+            if ( par_ind[ind].func == NULL )
+                par_ind[ind].type = VALUE_NONE;
+           }
+        par_cnt = cnt;
+       }
+    //значения параметров
+    for ( ind = 0, pos = XFER_HDR_PARAM; ind < par_cnt; ind++ ) {
+        if ( par_ind[ind].type == VALUE_NONE )
+            continue; //значение не передается
+        len = ParamPackVal( par_ind[ind].type, par_ind[ind].func( par_ind[ind].dev, par_ind[ind].param ), &sess->buf[pos], XFER_BUF - pos );
+        if ( !len )
+            break; //значение не помещается в ответ
+        pos += len;
+       }
+    sess->buf[0] = CAN_XFER_PARAM | CAN_XFER_ANSWER;
+    sess->buf[1] = CAN_XFER_OK;
+    sess->buf[2] = ind;
+    sess->len = pos;
+    XferStart( sess, pos );
+    return CAN_XFER_OK;
+ }
+
+//*************************************************************************************************
+// Сервис чтения итогов значений за период: [код][период][0 - завершенный, 1 - текущий]
+// Ответ: [код][статус][кол-во итогов][ROLL_REC]..., итоги передаются в порядке RollupId
+// XFER_SESS *sess    - сессия
+// return CanXferResult - статус выполнения
+//*************************************************************************************************
+static CanXferResult SrvRollup( XFER_SESS *sess ) {
+
+    uint8_t id;
+    uint16_t pos;
+    ROLL_REC rec;
+
+    if ( sess->len != 3 || sess->buf[1] >= ROLL_PERIODS || sess->buf[2] > 1 )
+        return CAN_XFER_ERR_PARAM;
+    for ( id = 0, pos = XFER_HDR_ROLLUP; id < ROLL_CNT && pos + sizeof( rec ) <= XFER_BUF; id++ ) {
+        RollupGet( (RollupPeriod)sess->buf[1], (RollupId)id, sess->buf[2] ? true : false, &rec );
+        memcpy( &sess->buf[pos], &rec, sizeof( rec ) );
+        pos += sizeof( rec );
+       }
+    sess->buf[0] = CAN_XFER_ROLLUP | CAN_XFER_ANSWER;
+    sess->buf[1] = CAN_XFER_OK;
+    sess->buf[2] = id;
+    sess->len = pos;
+    XferStart( sess, pos );
+    return CAN_XFER_OK;
+ }
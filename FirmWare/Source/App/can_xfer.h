@@ -0,0 +1,29 @@
+
+#ifndef __CAN_XFER_H
+#define __CAN_XFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//Счетчики сегментированной передачи
+typedef enum {
+    CAN_XFER_STAT_RECV,                     //принято сообщений
+    CAN_XFER_STAT_SEND,                     //передано сообщений
+    CAN_XFER_STAT_BYTES,                    //передано байт данных
+    CAN_XFER_STAT_TIMEOUT,                  //кол-во прерванных по таймауту сообщений
+    CAN_XFER_STAT_ERROR,                    //ошибки последовательности/переполнения
+    CAN_XFER_STAT_CNT                       //кол-во счетчиков
+ } CanXferCnt;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void CanXferInit( void );
+void CanXferRecv( uint32_t can_id, uint8_t *data, uint8_t len );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t CanXferStat( CanXferCnt type );
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "device.h"
 #include "dev_param.h"
+#include "config.h"
 
 #include "version.h"
 #include "vt100.h"
@@ -45,9 +46,22 @@
 #include "gen.h"
 #include "scheduler.h"
 #include "parse.h"
+#include "can_data.h"
+#include "can_def.h"
+#include "hmi_can.h"
+#include "can_xfer.h"
 #include "modbus.h"
 #include "modbus_def.h"
+#include "modbus_poll.h"
+#include "modbus_cache.h"
+#include "modbus_cap.h"
+#include "modbus_slave.h"
 #include "sdcard.h"
+#include "logger.h"
+#include "datalog.h"
+#include "rollup.h"
+#include "retain.h"
+#include "crc_hw.h"
 #include "message.h"
 #include "informing.h"
 #include "tracker.h"
@@ -148,17 +162,26 @@ static void CmdGen( uint8_t cnt_par, Source src );
 static void CmdModbus( uint8_t cnt_par, Source src );
 static void CmdModbusLog( uint8_t cnt_par, Source src );
 static void CmdModbusErr( uint8_t cnt_par, Source src );
+static void CmdModbusPoll( uint8_t cnt_par, Source src );
+static void CmdModbusCap( uint8_t cnt_par, Source src );
+static void CmdModbusSlave( uint8_t cnt_par, Source src );
 
 static void CmdMount( uint8_t cnt_par, Source src );
 static void CmdUnmount( uint8_t cnt_par, Source src );
 static void CmdDir( uint8_t cnt_par, Source src );
 static void CmdType( uint8_t cnt_par, Source src );
 static void CmdHex( uint8_t cnt_par, Source src );
+static void CmdCrc( uint8_t cnt_par, Source src );
 static void CmdDelete( uint8_t cnt_par, Source src );
 static void CmdDirDelete( uint8_t cnt_par, Source src );
 static void CmdRename( uint8_t cnt_par, Source src );
 static void CmdFile( uint8_t cnt_par, Source src );
 static void CmdCid( uint8_t cnt_par, Source src );
+static void CmdLog( uint8_t cnt_par, Source src );
+static void CmdExport( uint8_t cnt_par, Source src );
+static void CmdQuery( uint8_t cnt_par, Source src );
+static void CmdRollup( uint8_t cnt_par, Source src );
+static void CmdRetain( uint8_t cnt_par, Source src );
 static void CmdTask( uint8_t cnt_par, Source src );
 
 static void CmdVoice( uint8_t cnt_par, Source src );
@@ -188,11 +211,17 @@ static const COMMAND cmd[] = {
     "dir",      CmdDir,        0,
     "type",     CmdType,       0,
     "hex",      CmdHex,        0,
+    "crc",      CmdCrc,        0,
     "del",      CmdDelete,     0,
     "dirdel",   CmdDirDelete,  0,
     "ren",      CmdRename,     0,
     "file",     CmdFile,       0,
     "cid",      CmdCid,        0,
+    "log",      CmdLog,        0,
+    "export",   CmdExport,     0,
+    "query",    CmdQuery,      0,
+    "rollup",   CmdRollup,     0,
+    "retain",   CmdRetain,     0,
     "task",     CmdTask,       0,
     "eeprom",   CmdEeprom,     0,
     "statall",  CmdStatAll,    0,
@@ -212,6 +241,9 @@ static const COMMAND cmd[] = {
     "modbus",   CmdModbus,     EXEC_JOBS_ENABLE,
     "moderr",   CmdModbusErr,  0,
     "modlog",   CmdModbusLog,  0,
+    "modpoll",  CmdModbusPoll, 0,
+    "modcap",   CmdModbusCap,  0,
+    "modslave", CmdModbusSlave, 0,
     "voice",    CmdVoice,      EXEC_JOBS_ENABLE,
     "volume",   CmdVolume,     EXEC_JOBS_ENABLE,
     "sound",    CmdSound,      EXEC_JOBS_ENABLE,
@@ -549,9 +581,9 @@ static void CmdConfig( uint8_t cnt_par, Source src ) {
             //для параметров scr_file, job_file, job_test не выводим результат сообщения
             if ( id_par > 3 )
                 ConsoleSend( Message( CONS_MSG_OK ), src );
-            //значение параметра изменилось, передадим в модуль HMI новое значение
+            //значение параметра изменилось, передадим в модуль HMI новое значение и контрольную сумму
             ConfigSet( id_par, &cfg_set );
-            msg = ID_CONFIG;
+            msg = ID_CONFIG | CAN_DATA_PERIOD;
             osMessageQueuePut( hmi_msg, &msg, 0, 0 );
             return;
            }
@@ -625,6 +657,55 @@ static void CmdHex( uint8_t cnt_par, Source src ) {
     FileHex( GetParamVal( IND_PARAM1 ) );
 }
 
+//*************************************************************************************************
+// Расчет контрольной суммы файла или всей памяти EEPROM блоком CRC
+// Без параметров выводится статистика расчетов
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdCrc( uint8_t cnt_par, Source src ) {
+
+    char str[100];
+    CrcType type = CRC_TYPE_32;
+    uint32_t crc, size, time;
+
+    if ( cnt_par == 1 ) {
+        sprintf( str, "Engine: %u DMA blocks: %u software: %u DMA errors: %u\r\n", CrcHwStat( CRC_STAT_ENGINE ),
+                 CrcHwStat( CRC_STAT_DMA ), CrcHwStat( CRC_STAT_SOFT ), CrcHwStat( CRC_STAT_ERROR ) );
+        ConsoleSend( str, src );
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+        return;
+       }
+    if ( cnt_par == 3 )
+        for ( type = CRC_TYPE_CCITT; type < CRC_TYPE_CNT; type++ )
+            if ( !strcasecmp( GetParamVal( IND_PARAM2 ), CrcHwName( type ) ) )
+                break;
+    if ( cnt_par > 3 || type == CRC_TYPE_CNT ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    time = osKernelGetTickCount();
+    if ( !strcasecmp( GetParamVal( IND_PARAM1 ), "eeprom" ) ) {
+        size = EEPROM_PAGE_SIZE * EEPROM_PAGE_NUM;
+        crc = EepromCrc( type );
+       }
+    else {
+        if ( SDStatus() == ERROR ) {
+            ConsoleSend( MessageSd( MSG_SD_NO ), src );
+            return;
+           }
+        if ( FileCrc( GetParamVal( IND_PARAM1 ), type, &crc, &size ) == ERROR ) {
+            ConsoleSend( Message( CONS_MSG_ERR_FOPEN ), src );
+            return;
+           }
+       }
+    time = osKernelGetTickCount() - time;
+    if ( type == CRC_TYPE_32 )
+        sprintf( str, "%s: 0x%08X size: %u time: %u msec\r\n", CrcHwName( type ), crc, size, time );
+    else sprintf( str, "%s: 0x%04X size: %u time: %u msec\r\n", CrcHwName( type ), crc, size, time );
+    ConsoleSend( str, src );
+ }
+
 //*************************************************************************************************
 // Удаление файла
 // uint8_t cnt_par - кол-во параметров включая команду
@@ -693,6 +774,173 @@ static void CmdCid( uint8_t cnt_par, Source src ) {
     SDCid();
  }
 
+//*************************************************************************************************
+// Статистика записи протоколов, запись строк протоколов из буферов на SD карту
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdLog( uint8_t cnt_par, Source src ) {
+
+    char str[100];
+
+    if ( cnt_par == 2 && !strcasecmp( GetParamVal( IND_PARAM1 ), "flush" ) ) {
+        LogFlush();
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+        return;
+       }
+    if ( cnt_par > 1 ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    sprintf( str, "Rows: %u dropped: %u buffered: %u bytes\r\n", LogStat( LOG_STAT_ROWS ),
+             LogStat( LOG_STAT_DROP ), LogUsed() );
+    ConsoleSend( str, src );
+    sprintf( str, "Written: %u bytes writes: %u opens: %u errors: %u\r\n", LogStat( LOG_STAT_BYTES ),
+             LogStat( LOG_STAT_WRITE ), LogStat( LOG_STAT_OPEN ), LogStat( LOG_STAT_ERROR ) );
+    ConsoleSend( str, src );
+ }
+
+//*************************************************************************************************
+// Экспорт протокола данных уст-ва из двоичного формата в CSV за дату или период
+// EXPORT name dd.mm.yyyy [dd.mm.yyyy] [filename]
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdExport( uint8_t cnt_par, Source src ) {
+
+    DataLogId id;
+    DATE beg, end;
+    char *fname = NULL;
+
+    if ( SDStatus() == ERROR ) {
+        ConsoleSend( MessageSd( MSG_SD_NO ), src );
+        return;
+       }
+    if ( cnt_par < 3 || cnt_par > 5 ) {
+        ConsoleSend( Message( CONS_MSG_ERR_NOTENPAR ), src );
+        return;
+       }
+    id = DataLogGetId( GetParamVal( IND_PARAM1 ) );
+    if ( id == DLOG_CNT || CheckDate( GetParamVal( IND_PARAM2 ), &beg.day, &beg.month, &beg.year ) == ERROR ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    end = beg;
+    //вторая дата периода и/или имя файла CSV
+    if ( cnt_par > 3 && CheckDate( GetParamVal( IND_PARAM3 ), &end.day, &end.month, &end.year ) == ERROR ) {
+        if ( cnt_par == 5 ) {
+            ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+            return;
+           }
+        fname = GetParamVal( IND_PARAM3 );
+       }
+    if ( cnt_par == 5 )
+        fname = GetParamVal( IND_PARAM4 );
+    if ( DataLogExport( id, &beg, &end, fname, src ) == ERROR )
+        ConsoleSend( Message( CONS_MSG_ERR_FOPEN ), src );
+ }
+
+//*************************************************************************************************
+// Выборка записей протокола данных уст-ва за период времени по индексу протокола
+// с отбором записей по диапазону значений колонки (имя или номер колонки)
+// QUERY name dd.mm.yyyy hh:mm[:ss] dd.mm.yyyy hh:mm[:ss] [column min max]
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdQuery( uint8_t cnt_par, Source src ) {
+
+    DataLogId id;
+    DLOG_QUERY query;
+    uint8_t hour, min, sec;
+
+    if ( SDStatus() == ERROR ) {
+        ConsoleSend( MessageSd( MSG_SD_NO ), src );
+        return;
+       }
+    if ( cnt_par != 6 && cnt_par != 9 ) {
+        ConsoleSend( Message( CONS_MSG_ERR_NOTENPAR ), src );
+        return;
+       }
+    memset( &query, 0x00, sizeof( query ) );
+    id = DataLogGetId( GetParamVal( IND_PARAM1 ) );
+    if ( id == DLOG_CNT || CheckDate( GetParamVal( IND_PARAM2 ), &query.date_beg.day, &query.date_beg.month, &query.date_beg.year ) == ERROR ||
+         CheckDate( GetParamVal( IND_PARAM4 ), &query.date_end.day, &query.date_end.month, &query.date_end.year ) == ERROR ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    if ( CheckTime( GetParamVal( IND_PARAM3 ), &hour, &min, &sec ) == ERROR ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    query.time_beg = hour * 3600 + min * 60 + sec;
+    if ( CheckTime( GetParamVal( IND_PARAM5 ), &hour, &min, &sec ) == ERROR ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    query.time_end = hour * 3600 + min * 60 + sec;
+    if ( cnt_par == 9 ) {
+        //отбор по значению колонки
+        query.key = GetParamVal( IND_PARAM6 );
+        query.min = atof( GetParamVal( IND_PARAM7 ) );
+        query.max = atof( GetParamVal( IND_PARAM8 ) );
+       }
+    if ( DataLogQuery( id, &query, src ) == ERROR )
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+ }
+
+//*************************************************************************************************
+// Вывод итогов значений параметров уст-в за период: последний завершенный и текущий период
+// или записи файла итогов за дату
+// ROLLUP [min/hour/day] [dd.mm.yyyy]
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdRollup( uint8_t cnt_par, Source src ) {
+
+    DATE date;
+    RollupPeriod period = ROLL_HOUR;
+
+    if ( cnt_par > 3 ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    if ( cnt_par > 1 )
+        period = RollupGetPeriod( GetParamVal( IND_PARAM1 ) );
+    if ( period == ROLL_PERIODS ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    if ( cnt_par < 3 ) {
+        RollupShow( period, NULL, src );
+        return;
+       }
+    //итоги из файла за дату
+    if ( SDStatus() == ERROR ) {
+        ConsoleSend( MessageSd( MSG_SD_NO ), src );
+        return;
+       }
+    if ( CheckDate( GetParamVal( IND_PARAM2 ), &date.day, &date.month, &date.year ) == ERROR ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    if ( RollupShow( period, &date, src ) == ERROR )
+        ConsoleSend( Message( CONS_MSG_ERR_FOPEN ), src );
+ }
+
+//*************************************************************************************************
+// Вывод политик хранения протоколов на SD карте и состояния протоколов
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdRetain( uint8_t cnt_par, Source src ) {
+
+    if ( cnt_par > 1 ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    RetainShow( src );
+ }
+
 //*************************************************************************************************
 // Вывод дампа памяти EEPROM по 1 блоку (64 байта)
 // uint8_t cnt_par - кол-во параметров включая команду
@@ -1419,18 +1667,80 @@ static void CmdReset( uint8_t cnt_par, Source src ) {
  }
 
 //*************************************************************************************************
-// Вывод кол-ва ошибок обмена данными с HMI
+// Вывод кол-ва ошибок обмена данными с HMI, таблицы фильтра приема, подписки HMI на данные
+// уст-в, управление приемом команд
 // uint8_t cnt_par - кол-во параметров включая команду
 // Source src      - режим вывода информации в консоль
+// Формат команды: hmi [filter/subscr/dev on/off]
 //*************************************************************************************************
 static void CmdHmiStat( uint8_t cnt_par, Source src ) {
 
+    int dev;
     uint8_t ind;
+    char str[80];
+    CAN_AF_TABLE *af;
+    CAN_SUBSCR sub;
 
+    if ( cnt_par == 3 ) {
+        //включение/выключение приема команд уст-ва
+        if ( sscanf( GetParamVal( IND_PARAM1 ), "%x", &dev ) != 1 || dev <= ID_DEV_NULL || dev > ID_DEV_XFER ||
+           ( strcasecmp( GetParamVal( IND_PARAM2 ), "on" ) && strcasecmp( GetParamVal( IND_PARAM2 ), "off" ) ) ) {
+            ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+            return;
+           }
+        if ( CANFilterDev( (Device)dev, strcasecmp( GetParamVal( IND_PARAM2 ), "on" ) ? false : true ) == ERROR )
+            ConsoleSend( "Filter load error, all frames accepted.\r\n", src );
+        else ConsoleSend( Message( CONS_MSG_OK ), src );
+        return;
+       }
+    if ( cnt_par == 2 && !strcasecmp( GetParamVal( IND_PARAM1 ), "subscr" ) ) {
+        //подписка HMI на данные уст-в
+        for ( ind = ID_DEV_NULL + 1; CanDataSubscrGet( (Device)ind, &sub ) == true; ind++ ) {
+            sprintf( str, "0x%02X %-10s mask: 0x%08X period: %5u msec %s\r\n", ind, DevName( (Device)ind ), sub.mask,
+                     sub.period, sub.flags & CAN_SUBSCR_CHANGE ? "on change" : "" );
+            ConsoleSend( str, src );
+           }
+        return;
+       }
+    if ( cnt_par == 2 && !strcasecmp( GetParamVal( IND_PARAM1 ), "filter" ) ) {
+        //таблица фильтра приема
+        af = CANFilterTable();
+        if ( af == NULL ) {
+            ConsoleSend( "Filter not loaded, all frames accepted.\r\n", src );
+            return;
+           }
+        for ( ind = 0; ind < af->group_cnt; ind++ ) {
+            sprintf( str, "Range 0x%08X - 0x%08X 0x%02X\r\n", af->lower[ind], af->upper[ind], CAN_GET_DEV_ID( af->lower[ind] ) );
+            ConsoleSend( str, src );
+           }
+        for ( ind = 0; ind < af->exact_cnt; ind++ ) {
+            sprintf( str, "Exact 0x%08X 0x%02X\r\n", af->exact[ind], CAN_GET_DEV_ID( af->exact[ind] ) );
+            ConsoleSend( str, src );
+           }
+        for ( ind = ID_DEV_NULL + 1; ind <= ID_DEV_XFER; ind++ ) {
+            if ( CANFilterDevStat( (Device)ind ) == true )
+                continue;
+            sprintf( str, "Commands off 0x%02X\r\n", ind );
+            ConsoleSend( str, src );
+           }
+        return;
+       }
     for ( ind = 0; ind < DevParamCnt( ID_DEV_HMI, CNT_FULL ); ind++ ) {
         ConsoleSend( ParamGetForm( ID_DEV_HMI, ind, (ParamMode)( PARAM_DESC | PARAM_DOT | PARAM_VALUE ) ), src );
         ConsoleSend( Message( CONS_MSG_CRLF ), src );
        }
+    sprintf( str, "Data frames sent: %u unchanged: %u keyframes: %u failed: %u\r\n", CanDataStat( CAN_DATA_SEND ),
+             CanDataStat( CAN_DATA_SKIP ), CanDataStat( CAN_DATA_KEYS ), CanDataStat( CAN_DATA_FAIL ) );
+    ConsoleSend( str, src );
+    sprintf( str, "TX queue dropped: %u overflows: %u max depth: %u\r\n", CANTxStat( CAN_TXSTAT_DROP ),
+             CANTxStat( CAN_TXSTAT_OVERFLOW ), CANTxStat( CAN_TXSTAT_MAX ) );
+    ConsoleSend( str, src );
+    sprintf( str, "Transfer recv: %u send: %u bytes: %u timeouts: %u errors: %u\r\n", CanXferStat( CAN_XFER_STAT_RECV ),
+             CanXferStat( CAN_XFER_STAT_SEND ), CanXferStat( CAN_XFER_STAT_BYTES ), CanXferStat( CAN_XFER_STAT_TIMEOUT ),
+             CanXferStat( CAN_XFER_STAT_ERROR ) );
+    ConsoleSend( str, src );
+    sprintf( str, "Config version: %u hash: 0x%08X\r\n", ConfigGen(), ConfigHash() );
+    ConsoleSend( str, src );
  }
 
 //*************************************************************************************************
@@ -1497,13 +1807,13 @@ static void CmdModbus( uint8_t cnt_par, Source src ) {
            }
        }
     //вывод расшифровки введенных параметров
-    ConsoleSend( ModBusDecode( &reqst, DATA_LOG_REQUEST, DATA_LOG_NO_FILE ), src );
+    ConsoleSend( ModBusDecode( &reqst, DATA_LOG_REQUEST ), src );
     ConsoleSend( Message( CONS_MSG_CRLF ), src );
     //отправка запроса
     cnt_rpt = CNT_REPEAT_REQST;
     do {
         len = sizeof( reg_data );
-        stat = ModBusRequest( &reqst );
+        stat = ModBusRequestCache( &reqst, MBUS_PRIO_NORMAL, MBUS_CACHE_USE );
        } while ( cnt_rpt-- && ( stat == MBUS_ANSWER_CRC || stat == MBUS_ANSWER_TIMEOUT ) );
     if ( stat != MBUS_ANSWER_OK ) {
         //Вывод расшифровки ошибки
@@ -1511,7 +1821,7 @@ static void CmdModbus( uint8_t cnt_par, Source src ) {
         ConsoleSend( Message( CONS_MSG_CRLF ), src );
         return;
        }
-    ConsoleSend( ModBusDecode( &reqst, DATA_LOG_ANSWER, DATA_LOG_NO_FILE ), src );
+    ConsoleSend( ModBusDecode( &reqst, DATA_LOG_ANSWER ), src );
     ConsoleSend( Message( CONS_MSG_OK ), src );
  }
 
@@ -1533,16 +1843,152 @@ static void CmdModbusErr( uint8_t cnt_par, Source src ) {
             ConsoleSend( str, src );
            }
         ConsoleSend( Message( CONS_MSG_HEADER ), src );
+        //время ответа и состояние связи с уст-вами
+        for ( i = 0; i < MBUS_LINK_CNT; i++ ) {
+            sprintf( str, "%s\r\n", ModBusLinkDesc( (MBusLinkStat)i, str ) );
+            ConsoleSend( str, src );
+           }
+        ConsoleSend( Message( CONS_MSG_HEADER ), src );
         //вывод кол-ва отправленных пакетов
         ConsoleSend( ModBusErrCntDesc( MBUS_ANSWER_OK, str ), src );
+        //среднее кол-во байт принятых за одно прерывание MAX3100
+        sprintf( str, "RS485 bytes per IRQ: %u.%02u\r\n", RS485RecvBurst() / 100, RS485RecvBurst() % 100 );
+        ConsoleSend( str, src );
+        //время переключения RTS от начала передачи последнего байта
+        sprintf( str, "RS485 RTS turnaround (usec): last %u min %u max %u char %u\r\n", RS485Turnaround( RS485_TURN_LAST ), 
+                 RS485Turnaround( RS485_TURN_MIN ), RS485Turnaround( RS485_TURN_MAX ), RS485Turnaround( RS485_TURN_CHAR ) );
+        ConsoleSend( str, src );
+        //способ определения окончания принятых пакетов
+        sprintf( str, "RS485 frames: by size %u by silence %u gap errors %u\r\n", RS485FrameStat( RS485_FRAME_HINT ), 
+                 RS485FrameStat( RS485_FRAME_SILENCE ), RS485FrameStat( RS485_FRAME_GAP15 ) );
+        ConsoleSend( str, src );
+        //обращения к кэшу регистров
+        sprintf( str, "Register cache: hit %u miss %u stale %u\r\n", ModBusCacheStat( MBUS_CACHE_HIT ), 
+                 ModBusCacheStat( MBUS_CACHE_MISS ), ModBusCacheStat( MBUS_CACHE_STALE ) );
+        ConsoleSend( str, src );
         ConsoleSend( Message( CONS_MSG_OK ), src );
        }
     if ( cnt_par == 2 && atoi( GetParamVal( IND_PARAM1 ) ) == 0 ) {
         ModBusErrClr();
+        ModBusCacheClr();
+        RS485StatClr();
         ConsoleSend( Message( CONS_MSG_OK ), src );
        }
  }
 
+//*************************************************************************************************
+// Вывод записей и статистики циклического опроса уст-в по MODBUS
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdModbusPoll( uint8_t cnt_par, Source src ) {
+
+    uint8_t i;
+    uint32_t load_calc, load_meas;
+    char str[120];
+
+    if ( cnt_par == 1 ) {
+        ConsoleSend( "Dev  Reg    Cnt  Period  Deadl Prio     Runs Errors Missed   Avg   Max\r\n", src );
+        for ( i = 0; i < ModBusPollCnt(); i++ )
+            ConsoleSend( ModBusPollDesc( i, str ), src );
+        //загрузка шины циклическим опросом
+        load_calc = ModBusPollLoad( MBUS_POLL_LOAD_CALC );
+        load_meas = ModBusPollLoad( MBUS_POLL_LOAD_MEAS );
+        sprintf( str, "Bus load: calculated %u.%u%% measured %u.%u%%\r\n", load_calc / 10, load_calc % 10, load_meas / 10, load_meas % 10 );
+        ConsoleSend( str, src );
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+       }
+    if ( cnt_par == 2 && atoi( GetParamVal( IND_PARAM1 ) ) == 0 ) {
+        ModBusPollClr();
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+       }
+ }
+
+//*************************************************************************************************
+// Вывод расшифровки последних захваченных кадров MODBUS из буфера или файла на SD карте
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdModbusCap( uint8_t cnt_par, Source src ) {
+
+    uint16_t i, back;
+    uint32_t cnt = 16;
+    MBusCapSrc cap_src = MBUS_CAP_RAM;
+    MBUS_CAP_REC rec[4];
+    char str[MBUS_CAP_STR];
+
+    if ( cnt_par > 1 && !strcasecmp( GetParamVal( IND_PARAM1 ), "file" ) ) {
+        cap_src = MBUS_CAP_FILE;
+        if ( cnt_par == 3 )
+            cnt = atoi( GetParamVal( IND_PARAM2 ) );
+       }
+    else if ( cnt_par == 2 )
+        cnt = atoi( GetParamVal( IND_PARAM1 ) );
+    if ( !cnt || cnt_par > 3 ) {
+        ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+        return;
+       }
+    //записей может быть меньше запрошенного кол-ва
+    if ( cnt > ModBusCapCnt( cap_src ) )
+        cnt = ModBusCapCnt( cap_src );
+    ConsoleSend( "      Tick Dir Dev Func Len   Lat  Frame\r\n", src );
+    //вывод по несколько записей, начиная с самой ранней
+    for ( back = cnt; back; back -= i ) {
+        i = ModBusCapRead( cap_src, back, rec, SIZE_ARRAY( rec ) );
+        if ( !i )
+            break;
+        for ( cnt = 0; cnt < i; cnt++ )
+            ConsoleSend( ModBusCapDecode( &rec[cnt], str ), src );
+       }
+    sprintf( str, "Records not saved: %u\r\n", ModBusCapLost() );
+    ConsoleSend( str, src );
+    ConsoleSend( Message( CONS_MSG_OK ), src );
+ }
+
+//*************************************************************************************************
+// Статистика и таблица адресов ведомого уст-ва MODBUS RTU, перевод консоли в режим MODBUS
+// uint8_t cnt_par - кол-во параметров включая команду
+// Source src      - режим вывода информации в консоль
+//*************************************************************************************************
+static void CmdModbusSlave( uint8_t cnt_par, Source src ) {
+
+    uint16_t i;
+    char str[100];
+
+    if ( cnt_par == 1 ) {
+        sprintf( str, "Slave address: %u input params: %u holding params: %u\r\n", _MBUS_SLAVE_ADDR,
+                 ModBusSlaveCnt( MBUS_SLAVE_INPUT ), ModBusSlaveCnt( MBUS_SLAVE_HOLD ) );
+        ConsoleSend( str, src );
+        sprintf( str, "Requests: %u CRC errors: %u exceptions: %u\r\n", ModBusSlaveStat( MBUS_SLAVE_FRAMES ),
+                 ModBusSlaveStat( MBUS_SLAVE_CRC ), ModBusSlaveStat( MBUS_SLAVE_EXCEPT ) );
+        ConsoleSend( str, src );
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+        return;
+       }
+    if ( cnt_par == 2 && !strcasecmp( GetParamVal( IND_PARAM1 ), "map" ) ) {
+        //регистры ввода (0x04), затем регистры хранения (0x03)
+        ConsoleSend( "Input registers (0x04)\r\nAddr    Dev      Param                    Type  Scale\r\n", src );
+        for ( i = 0; i < ModBusSlaveCnt( MBUS_SLAVE_INPUT ); i++ )
+            ConsoleSend( ModBusSlaveDesc( MBUS_SLAVE_INPUT, i, str ), src );
+        ConsoleSend( "Holding registers (0x03)\r\nAddr    Dev      Param                    Type  Scale\r\n", src );
+        for ( i = 0; i < ModBusSlaveCnt( MBUS_SLAVE_HOLD ); i++ )
+            ConsoleSend( ModBusSlaveDesc( MBUS_SLAVE_HOLD, i, str ), src );
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+        return;
+       }
+    if ( cnt_par == 2 && !strcasecmp( GetParamVal( IND_PARAM1 ), "on" ) ) {
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+        ModBusSlaveStart();
+        return;
+       }
+    if ( cnt_par == 2 && atoi( GetParamVal( IND_PARAM1 ) ) == 0 ) {
+        ModBusSlaveClr();
+        ConsoleSend( Message( CONS_MSG_OK ), src );
+        return;
+       }
+    ConsoleSend( Message( CONS_MSG_ERR_PARAM ), src );
+ }
+
 //*************************************************************************************************
 // Вкл/выкл режима логирования обмена данными по MODBUS
 // uint8_t cnt_par - кол-во параметров включая команду
@@ -1725,22 +2171,12 @@ static void FileClose( void ) {
 //*************************************************************************************************
 static void ExecLog( char *str, LogModeCmd mode ) {
 
-    FILE *log;
-    char name[80];
-
     if ( str == NULL || !strlen( str ) )
         return; //данных нет
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    sprintf( name, "\\execute\\cmd_%s.log", RTCFileName() );
-    log = fopen( name, "a" );
-    if ( log != NULL ) {
-        //запишем в лог файл
-        if ( mode == LOG_NEW_CMND )
-            fprintf( log, "%s > %s\r\n", RTCGetLog(), str );
-        else fprintf( log, "%s", str );
-        fclose( log );
-       }
+    //запишем в лог файл
+    if ( mode == LOG_NEW_CMND )
+        LogPrintf( LOG_EXEC, "%s > %s\r\n", RTCGetLog(), str );
+    else LogPrintf( LOG_EXEC, "%s", str );
  }
 
 //*************************************************************************************************
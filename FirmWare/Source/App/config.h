@@ -76,6 +76,159 @@
 
 //  </h>
 
+//  <h>Интерфейс RS485 (MODBUS)
+//  =======================
+
+//  <o>Скорость обмена (bps) <9600=>9600 <19200=>19200 <38400=>38400 <57600=>57600 <115200=>115200
+//  <i>Значение по умолчанию: 19200
+#ifndef _RS485_BAUD
+#define _RS485_BAUD             19200
+#endif
+
+//  <o>Задержка выключения RTS после начала передачи последнего байта (бит) <10-20>
+//  <i>Время в битовых интервалах: 10 бит байта данных + 1 бит запаса
+//  <i>Значение по умолчанию: 11
+#ifndef _RS485_RTS_BITS
+#define _RS485_RTS_BITS         11
+#endif
+
+//  </h>
+
+//  <h>Ведомое уст-во MODBUS RTU (консоль UART0)
+//  =======================
+
+//  <o>Адрес контроллера как ведомого уст-ва MODBUS <1-247>
+//  <i>Значение по умолчанию: 1
+#ifndef _MBUS_SLAVE_ADDR
+#define _MBUS_SLAVE_ADDR        1
+#endif
+
+//  </h>
+
+//  <h>Обмен данными с HMI (CAN)
+//  =======================
+
+//  <o>Интервал передачи всех пакетов данных уст-ва (сек) <10-600>
+//  <i>Между полными передачами передаются только пакеты данные которых изменились
+//  <i>Значение по умолчанию: 60
+#ifndef _CAN_KEYFRAME_TIME
+#define _CAN_KEYFRAME_TIME      60
+#endif
+
+//  <o>Кол-во пакетов блока при приеме сообщений (BS) <1-48>
+//  <i>После приема блока пакетов данные записываются в файл, затем передается пакет FC
+//  <i>Значение по умолчанию: 32
+#ifndef _CAN_XFER_BS
+#define _CAN_XFER_BS            32
+#endif
+
+//  <o>Интервал между пакетами при приеме сообщений (STmin, msec) <0-127>
+//  <i>Значение по умолчанию: 0
+#ifndef _CAN_XFER_STMIN
+#define _CAN_XFER_STMIN         0
+#endif
+
+//  </h>
+
+//  <h>Запись протоколов на SD карту
+//  =======================
+
+//  <o>Максимальное время хранения строк протокола до записи на SD карту (msec) <500-60000>
+//  <i>Строки накапливаются в буфере файла, запись выполняется блоками по 512 байт
+//  <i>или по истечении этого времени
+//  <i>Значение по умолчанию: 2000
+#ifndef _LOG_COMMIT_TIME
+#define _LOG_COMMIT_TIME        2000
+#endif
+
+//  <o>Кол-во одновременно открытых файлов протоколов <1-6>
+//  <i>Учитывать общее кол-во открытых файлов в настройках файловой системы (FS_Config)
+//  <i>Значение по умолчанию: 3
+#ifndef _LOG_FILES
+#define _LOG_FILES              3
+#endif
+
+//  <o>Сброс буферов файловой системы на SD карту <0=>При закрытии файла <1=>После каждой записи
+//  <i>При сбросе после каждой записи данные сохраняются при внезапном отключении питания
+//  <i>Значение по умолчанию: 1
+#ifndef _LOG_SYNC
+#define _LOG_SYNC               1
+#endif
+
+//  <o>Формат протоколов данных уст-в (монитор АКБ, MPPT, инверторы, контроллер заряда) <0=>CSV <1=>Двоичный
+//  <i>Двоичные протоколы (*.bin) конвертируются в CSV командой EXPORT
+//  <i>Значение по умолчанию: 1
+#ifndef _LOG_BINARY
+#define _LOG_BINARY             1
+#endif
+
+//  <o>Макс кол-во записей в блоке двоичного протокола <1-32>
+//  <i>Каждый блок записей содержит контрольную сумму CRC-32
+//  <i>Значение по умолчанию: 8
+#ifndef _DLOG_BLOCK_REC
+#define _DLOG_BLOCK_REC         8
+#endif
+
+//  <o>Максимальное время накопления записей блока двоичного протокола (msec) <1000-600000>
+//  <i>Незавершенный блок передается на запись по истечении этого времени
+//  <i>Значение по умолчанию: 60000
+#ifndef _DLOG_BLOCK_TIME
+#define _DLOG_BLOCK_TIME        60000
+#endif
+
+//  <o>Запись индекса двоичных протоколов (*.idx) <0=>Выключена <1=>Включена
+//  <i>Индекс содержит смещение, время и мин/макс значения ключевых колонок каждого блока,
+//  <i>по индексу команда QUERY читает только блоки запрошенного периода. При выключенной
+//  <i>записи индекс формируется командой QUERY по файлу протокола
+//  <i>Значение по умолчанию: 1
+#ifndef _DLOG_INDEX
+#define _DLOG_INDEX             1
+#endif
+
+//  <o>Запись итогов за периоды (\rollup\*.bin) <0=>Выключена <1=>Часы и сутки <2=>Минуты, часы и сутки
+//  <i>Итоги (кол-во, мин, макс, среднее, интеграл) рассчитываются в RAM, завершенные периоды
+//  <i>записываются по одной записи на значение. Итоги выводятся командой ROLLUP
+//  <i>Значение по умолчанию: 1
+#ifndef _ROLLUP_LOG
+#define _ROLLUP_LOG             1
+#endif
+
+//  </h>
+
+//  <h>Хранение протоколов на SD карте
+//  =======================
+
+//  <o>Срок хранения протоколов данных уст-в (дней) <0-3650>
+//  <i>Протоколы монитора АКБ, MPPT, инверторов, контроллера заряда. 0 - без ограничения
+//  <i>Значение по умолчанию: 365
+#ifndef _RETAIN_DATA_DAYS
+#define _RETAIN_DATA_DAYS       365
+#endif
+
+//  <o>Максимальный объем протоколов данных одного уст-ва (Мбайт) <0-16384>
+//  <i>При превышении удаляются самые старые файлы. 0 - без ограничения
+//  <i>Значение по умолчанию: 1024
+#ifndef _RETAIN_DATA_SIZE
+#define _RETAIN_DATA_SIZE       1024
+#endif
+
+//  <o>Срок хранения протоколов событий (дней) <0-3650>
+//  <i>Протоколы генератора, АВР, трекера, информатора, команд, HMI, SD карты. 0 - без ограничения
+//  <i>Значение по умолчанию: 730
+#ifndef _RETAIN_EVENT_DAYS
+#define _RETAIN_EVENT_DAYS      730
+#endif
+
+//  <o>Минимальный объем свободного места на SD карте (Мбайт) <8-4096>
+//  <i>При меньшем объеме удаляются самые старые протоколы: протоколы данных уст-в удаляются
+//  <i>при объеме меньше двойного значения, итоги за периоды - при объеме меньше половины
+//  <i>Значение по умолчанию: 64
+#ifndef _RETAIN_FREE_MIN
+#define _RETAIN_FREE_MIN        64
+#endif
+
+//  </h>
+
 //------------- <<< end of configuration section >>> ---------------------------
 
 #endif
@@ -0,0 +1,1218 @@
+
+//*************************************************************************************************
+//
+// Протоколы данных уст-в в двоичном формате
+// Значения параметров уст-в записываются записями фиксированного размера, записи объединяются
+// в блоки с контрольной суммой CRC-32. Состав колонок (уст-во, параметр, тип, множитель, формат
+// вывода) записывается в заголовок файла, по заголовку выполняется экспорт в формат CSV
+// Для каждого файла ведется индекс (*.idx): смещение, время и мин/макс значения ключевых колонок
+// каждого блока. Выборка записей за период читает индекс и только блоки, попадающие в период,
+// отсутствующий или не соответствующий файлу протокола индекс формируется заново
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "rl_fs.h"
+#include "cmsis_os2.h"
+
+#include "lpc177x_8x_rtc.h"
+
+#include "device.h"
+#include "dev_param.h"
+
+#include "config.h"
+#include "command.h"
+#include "crc_hw.h"
+#include "datalog.h"
+#include "logger.h"
+#include "message.h"
+#include "sdcard.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define DLOG_TIME_SIZE          sizeof( uint32_t )                  //размер времени записи
+#define DLOG_BLOCK_DATA         ( LOG_ROW - sizeof( DLOG_BLOCK ) )  //макс размер записей блока
+#define DLOG_COL_BUFF           64                                  //макс размер описания колонки
+#define DLOG_CSV_ROW            256                                 //размер строки CSV
+
+//*************************************************************************************************
+// Локальные типы данных
+//*************************************************************************************************
+//Описание колонки протокола
+typedef struct {
+    Device      dev;                        //ID уст-ва
+    uint8_t     param;                      //ID параметра
+    uint8_t     size;                       //размер значения в записи (1, 2, 4)
+    uint8_t     scale;                      //кол-во десятичных знаков значения VALUE_FLOAT
+    DataLogOut  out;                        //вид вывода значения при экспорте
+    char        *frm;                       //формат вывода значения в CSV
+ } DLOG_DEF;
+
+//Описание протокола
+typedef struct {
+    char            *name;                  //имя протокола для команды EXPORT
+    LogId           log;                    //ID протокола для записи на SD карту
+    LogId           idx;                    //ID индекса протокола
+    uint8_t         schema;                 //версия состава колонок, увеличивается при изменении
+    ConsMessage     head;                   //заголовок CSV файла
+    const DLOG_DEF  *col;                   //описание колонок
+    uint8_t         col_cnt;                //кол-во колонок
+    uint8_t         key[DLOG_IDX_KEY];      //номера ключевых колонок индекса
+ } DLOG_DESC;
+
+//Расположение значения колонки в записи
+typedef struct {
+    uint16_t    pos;                        //смещение значения в записи
+    uint8_t     size;                       //размер значения
+    bool        sign;                       //значение со знаком (VALUE_FLOAT)
+ } DLOG_KEY;
+
+//Условия отбора записей
+typedef struct {
+    uint32_t    time_beg;                   //период времени записей (сек от начала суток)
+    uint32_t    time_end;
+    bool        key;                        //отбор по значению колонки
+    DLOG_KEY    col;                        //колонка отбора
+    int32_t     min;                        //диапазон значений колонки (как в записи)
+    int32_t     max;
+ } DLOG_FILTER;
+
+//Блок записей протокола
+typedef struct {
+    DATE        date;                       //дата записей блока
+    uint32_t    time;                       //время добавления первой записи блока
+    uint16_t    rec_len;                    //размер записи
+    uint8_t     rec_max;                    //макс кол-во записей в блоке
+    uint8_t     cnt;                        //кол-во записей в блоке
+    DLOG_KEY    key[DLOG_IDX_KEY];          //ключевые колонки индекса
+    uint8_t     data[LOG_ROW];              //[DLOG_BLOCK][записи]
+ } DLOG_BUFF;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+//Монитор АКБ, формат CSV: CONS_MSG_LOG_BATMON
+static const DLOG_DEF col_batmon[] = {
+    //уст-во        параметр            байт    знаков  вывод           формат
+    ID_DEV_BATMON,  MON_VOLTAGE,        2,      2,      DLOG_OUT_FLOAT, "%.2f",
+    ID_DEV_BATMON,  MON_CURRENT,        2,      2,      DLOG_OUT_FLOAT, "%+.2f",
+    ID_DEV_BATMON,  MON_CONSUMENERGY,   4,      2,      DLOG_OUT_FLOAT, "%+.2f",
+    ID_DEV_BATMON,  MON_SOC,            2,      1,      DLOG_OUT_FLOAT, "%.1f",
+    ID_DEV_BATMON,  MON_TTG,            2,      0,      DLOG_OUT_HM,    "%3d:%02d",
+    ID_DEV_BATMON,  MON_H6,             4,      2,      DLOG_OUT_FLOAT, "%.2f",
+    ID_DEV_BATMON,  MON_ALARM,          1,      0,      DLOG_OUT_INT,   "%u",
+    ID_DEV_BATMON,  MON_RELAY,          1,      0,      DLOG_OUT_INT,   "%u",
+    ID_DEV_BATMON,  MON_H2,             4,      2,      DLOG_OUT_FLOAT, "%5.2f",
+    ID_DEV_BATMON,  MON_H3,             4,      2,      DLOG_OUT_FLOAT, "%5.2f"
+ };
+
+//Контроллер MPPT, формат CSV: CONS_MSG_LOG_MPPT
+static const DLOG_DEF col_mppt[] = {
+    //уст-во        параметр            байт    знаков  вывод           формат
+    ID_DEV_MPPT,    MPPT_IN_VOLTAGE,    2,      1,      DLOG_OUT_FLOAT, "%.1f",
+    ID_DEV_MPPT,    MPPT_IN_CURRENT,    2,      1,      DLOG_OUT_FLOAT, "%.1f",
+    ID_DEV_MPPT,    MPPT_OUT_VOLTAGE,   2,      1,      DLOG_OUT_FLOAT, "%.1f",
+    ID_DEV_MPPT,    MPPT_OUT_CURRENT,   2,      1,      DLOG_OUT_FLOAT, "%.1f",
+    ID_DEV_MPPT,    MPPT_ENERGY1,       4,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_MPPT,    MPPT_ENERGY2,       4,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_MPPT,    MPPT_TIME_FLOAT,    2,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_MPPT,    MPPT_CHARGE_MODE,   1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_MPPT,    MPPT_SOC,           1,      0,      DLOG_OUT_INT,   "%03d",
+    ID_DEV_MPPT,    MPPT_BAT_CURRENT,   2,      1,      DLOG_OUT_FLOAT, "%+.1f",
+    ID_DEV_MPPT,    MPPT_PVON,          1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_MPPT,    MPPT_PVMODE,        1,      0,      DLOG_OUT_DESC,  "%s"
+ };
+
+//Инверторы, формат CSV: CONS_MSG_LOG_INV
+static const DLOG_DEF col_inv[] = {
+    //уст-во        параметр            байт    знаков  вывод           формат
+    ID_DEV_INV1,    INV_POWER_PERC,     1,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_INV1,    INV_POWER_WATT,     2,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_INV1,    INV_TEMPERATURE,    2,      1,      DLOG_OUT_FLOAT, "%4.1f",
+    ID_DEV_INV1,    INV_DC_CONNECT,     1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_INV1,    INV_MODE,           1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_INV1,    INV_ERROR,          1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_INV2,    INV_POWER_PERC,     1,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_INV2,    INV_POWER_WATT,     2,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_INV2,    INV_TEMPERATURE,    2,      1,      DLOG_OUT_FLOAT, "%4.1f",
+    ID_DEV_INV2,    INV_DC_CONNECT,     1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_INV2,    INV_MODE,           1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_INV2,    INV_ERROR,          1,      0,      DLOG_OUT_DESC,  "%s"
+ };
+
+//Контроллер заряда, формат CSV: CONS_MSG_LOG_CHARGER
+static const DLOG_DEF col_charger[] = {
+    //уст-во        параметр            байт    знаков  вывод           формат
+    ID_DEV_CHARGER, CHARGE_CONN_AC,     1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_CHARGER, CHARGE_DEV_STAT,    1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_CHARGER, CHARGE_MODE,        1,      0,      DLOG_OUT_INT,   "%d",
+    ID_DEV_CHARGER, CHARGE_BANK_STAT,   1,      0,      DLOG_OUT_DESC,  "%s",
+    ID_DEV_BATMON,  MON_SOC,            2,      1,      DLOG_OUT_FLOAT, "%.1f",
+    ID_DEV_CHARGER, CHARGE_CURRENT,     2,      1,      DLOG_OUT_FLOAT, "%4.1f",
+    ID_DEV_BATMON,  MON_VOLTAGE,        2,      2,      DLOG_OUT_FLOAT, "%.2f"
+ };
+
+//Протоколы в порядке DataLogId
+static const DLOG_DESC dlog_desc[] = {
+    //имя       протокол            индекс              версия  заголовок CSV           колонки         кол-во колонок              ключевые колонки
+    "batmon",   LOG_BATMON_BIN,     LOG_BATMON_IDX,     1,      CONS_MSG_LOG_BATMON,    col_batmon,     SIZE_ARRAY( col_batmon ),   0,  1,
+    "mppt",     LOG_MPPT_BIN,       LOG_MPPT_IDX,       1,      CONS_MSG_LOG_MPPT,      col_mppt,       SIZE_ARRAY( col_mppt ),     0,  3,
+    "inv",      LOG_INV_BIN,        LOG_INV_IDX,        1,      CONS_MSG_LOG_INV,       col_inv,        SIZE_ARRAY( col_inv ),      1,  7,
+    "charger",  LOG_CHARGER_BIN,    LOG_CHARGER_IDX,    1,      CONS_MSG_LOG_CHARGER,   col_charger,    SIZE_ARRAY( col_charger ),  5,  6
+ };
+
+static const uint32_t scale_mult[] = { 1, 10, 100, 1000, 10000 };
+
+static DLOG_BUFF dlog_buff[DLOG_CNT];                   //блоки записей протоколов
+static osMutexId_t mutex_dlog = NULL;
+
+//буферы экспорта, используются только из задачи консоли
+static DLOG_HEAD exp_head;
+static DLOG_COL exp_col[DLOG_COL_MAX];
+static uint8_t exp_data[DLOG_BLOCK_DATA];
+static char exp_row[DLOG_CSV_ROW];
+static DLOG_IDX_HEAD idx_head;
+static DLOG_KEY exp_key[DLOG_IDX_KEY];
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osMutexAttr_t mutex_attr = { .name = "DataLog", .attr_bits = osMutexPrioInherit };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void BlockPut( DataLogId id );
+static uint16_t HeadMake( DataLogId id, DATE *date, uint8_t *buff, uint16_t size );
+static void IndexHead( DataLogId id, uint32_t head_crc, bool keys, DLOG_IDX_HEAD *head );
+static void IndexFill( DLOG_IDX *idx, uint32_t offset, DLOG_BLOCK *block, uint8_t *data, uint16_t rec_len, DLOG_KEY *key, uint8_t key_cnt );
+static FILE *IndexOpen( DataLogId id, DATE *date, FILE *fin );
+static bool IndexCheck( FILE *fidx, DataLogId id, uint32_t size, uint32_t *pos );
+static Status IndexBuild( DataLogId id, char *name, FILE *fin, uint32_t pos, uint32_t size );
+static bool IndexSkip( FILE *fidx, uint32_t offset, uint32_t len );
+static void KeyCol( DLOG_KEY *key, uint8_t col );
+static bool DateEqual( DATE *date1, DATE *date2 );
+static void DateNext( DATE *date );
+static uint32_t DateNum( DATE *date );
+static bool FileHead( FILE *fin, DataLogId id );
+static uint32_t FileRecords( FILE *fin, FILE *fout, Source src, DLOG_FILTER *flt, uint32_t *errors );
+static bool FileFilter( DLOG_QUERY *query, DATE *date, DLOG_FILTER *flt );
+static bool BlockNext( FILE *fin, uint32_t *pos, DLOG_BLOCK *block );
+static bool BlockData( FILE *fin, DLOG_BLOCK *block );
+static uint32_t BlockRows( DLOG_BLOCK *block, FILE *fout, Source src, DLOG_FILTER *flt );
+static uint16_t ColValue( DLOG_COL *col, uint8_t *data, char *str, uint16_t size );
+static int32_t ValueRaw( uint8_t *data, uint8_t size, bool sign );
+static int32_t FloatRaw( float value, uint8_t scale );
+static uint8_t FrmCheck( char *frm, DataLogOut out );
+static void CsvOut( FILE *fout, char *str, Source src );
+
+//*************************************************************************************************
+// Инициализация протоколов в двоичном формате, расчет размера записей
+//*************************************************************************************************
+void DataLogInit( void ) {
+
+    uint8_t id, col, key;
+    DLOG_BUFF *buff;
+    const DLOG_DEF *def;
+
+    memset( dlog_buff, 0x00, sizeof( dlog_buff ) );
+    for ( id = 0; id < SIZE_ARRAY( dlog_desc ); id++ ) {
+        buff = &dlog_buff[id];
+        buff->rec_len = DLOG_TIME_SIZE;
+        for ( col = 0; col < dlog_desc[id].col_cnt; col++ ) {
+            def = &dlog_desc[id].col[col];
+            //расположение ключевых колонок индекса в записи
+            for ( key = 0; key < DLOG_IDX_KEY; key++ ) {
+                if ( dlog_desc[id].key[key] != col )
+                    continue;
+                buff->key[key].pos = buff->rec_len;
+                buff->key[key].size = def->size;
+                buff->key[key].sign = ParamGetType( def->dev, def->param ) == VALUE_FLOAT ? true : false;
+               }
+            buff->rec_len += def->size;
+           }
+        buff->rec_max = DLOG_BLOCK_DATA / buff->rec_len;
+        if ( buff->rec_max > _DLOG_BLOCK_REC )
+            buff->rec_max = _DLOG_BLOCK_REC;
+       }
+    mutex_dlog = osMutexNew( &mutex_attr );
+ }
+
+//*************************************************************************************************
+// Добавление записи с текущими значениями параметров уст-в в блок протокола
+// Блок передается на запись при заполнении, смене суток или по истечении _DLOG_BLOCK_TIME
+// DataLogId id - ID протокола
+//*************************************************************************************************
+void DataLogSave( DataLogId id ) {
+
+    DATE date;
+    int32_t sval;
+    uint32_t time;
+    uint8_t col, *dst;
+    ValueParam value;
+    DLOG_BUFF *buff;
+    const DLOG_DEF *def;
+    RTC_TIME_Type Time;
+
+    if ( id >= DLOG_CNT || mutex_dlog == NULL )
+        return;
+    if ( SDStatus() == ERROR )
+        return; //карты нет
+    RTC_GetFullTime( LPC_RTC, &Time );
+    date.day = Time.DOM;
+    date.month = Time.MONTH;
+    date.year = Time.YEAR;
+    time = Time.HOUR * 3600 + Time.MIN * 60 + Time.SEC;
+    buff = &dlog_buff[id];
+    osMutexAcquire( mutex_dlog, osWaitForever );
+    if ( buff->cnt && DateEqual( &buff->date, &date ) == false )
+        BlockPut( id ); //записи прошедших суток
+    if ( !buff->cnt ) {
+        buff->date = date;
+        buff->time = osKernelGetTickCount();
+       }
+    //время и значения параметров, числа младшим байтом вперед
+    dst = buff->data + sizeof( DLOG_BLOCK ) + buff->cnt * buff->rec_len;
+    memcpy( dst, &time, DLOG_TIME_SIZE );
+    dst += DLOG_TIME_SIZE;
+    for ( col = 0; col < dlog_desc[id].col_cnt; col++ ) {
+        def = &dlog_desc[id].col[col];
+        value = ParamGetVal( def->dev, def->param );
+        if ( ParamGetType( def->dev, def->param ) == VALUE_FLOAT ) {
+            //число float записывается целым со знаком
+            sval = FloatRaw( value.flt, def->scale );
+            memcpy( dst, &sval, def->size );
+           }
+        else memcpy( dst, &value.uint32, def->size );
+        dst += def->size;
+       }
+    buff->cnt++;
+    if ( buff->cnt >= buff->rec_max )
+        BlockPut( id );
+    osMutexRelease( mutex_dlog );
+ }
+
+//*************************************************************************************************
+// Передача на запись блоков с истекшим временем хранения и блоков прошедших суток
+// Вызывается из задачи записи протоколов
+//*************************************************************************************************
+void DataLogCommit( void ) {
+
+    uint8_t id;
+    DATE date;
+    RTC_TIME_Type Time;
+
+    if ( mutex_dlog == NULL )
+        return;
+    RTC_GetFullTime( LPC_RTC, &Time );
+    date.day = Time.DOM;
+    date.month = Time.MONTH;
+    date.year = Time.YEAR;
+    osMutexAcquire( mutex_dlog, osWaitForever );
+    for ( id = 0; id < SIZE_ARRAY( dlog_buff ); id++ ) {
+        if ( !dlog_buff[id].cnt )
+            continue;
+        if ( osKernelGetTickCount() - dlog_buff[id].time >= _DLOG_BLOCK_TIME || DateEqual( &dlog_buff[id].date, &date ) == false )
+            BlockPut( (DataLogId)id );
+       }
+    osMutexRelease( mutex_dlog );
+ }
+
+//*************************************************************************************************
+// Передача на запись всех незавершенных блоков, вызывается из LogFlush()
+//*************************************************************************************************
+void DataLogFlush( void ) {
+
+    uint8_t id;
+
+    if ( mutex_dlog == NULL )
+        return;
+    osMutexAcquire( mutex_dlog, osWaitForever );
+    for ( id = 0; id < SIZE_ARRAY( dlog_buff ); id++ )
+        BlockPut( (DataLogId)id );
+    osMutexRelease( mutex_dlog );
+ }
+
+//*************************************************************************************************
+// Формирование заголовка нового файла протокола или индекса, вызывается из задачи записи
+// протоколов. Индекс связывается с файлом протокола по CRC заголовка протокола той же даты
+// LogId log        - ID протокола
+// DATE *date       - дата файла
+// uint8_t *buff    - буфер для заголовка
+// uint16_t size    - размер буфера
+// return uint16_t  - размер заголовка, 0 - протокол не в двоичном формате
+//*************************************************************************************************
+uint16_t DataLogHead( LogId log, DATE *date, uint8_t *buff, uint16_t size ) {
+
+    uint8_t id;
+    uint32_t crc;
+
+    for ( id = 0; id < SIZE_ARRAY( dlog_desc ); id++ )
+        if ( dlog_desc[id].log == log || dlog_desc[id].idx == log )
+            break;
+    if ( id == SIZE_ARRAY( dlog_desc ) )
+        return 0;
+    if ( dlog_desc[id].log == log )
+        return HeadMake( (DataLogId)id, date, buff, size );
+    //заголовок индекса, заголовок протокола формируется в том же буфере
+    if ( HeadMake( (DataLogId)id, date, buff, size ) < sizeof( DLOG_IDX_HEAD ) )
+        return 0;
+    crc = ( (DLOG_HEAD *)buff )->crc;
+    IndexHead( (DataLogId)id, crc, true, (DLOG_IDX_HEAD *)buff );
+    return sizeof( DLOG_IDX_HEAD );
+ }
+
+//*************************************************************************************************
+// Экспорт протокола за период в формат CSV, вывод в консоль или в файл
+// Файлы обрабатываются последовательно по блокам, блоки с ошибкой CRC пропускаются
+// DataLogId id - ID протокола
+// DATE *beg    - начальная дата
+// DATE *end    - конечная дата
+// char *fname  - имя файла CSV, NULL - вывод в консоль
+// Source src   - режим вывода информации в консоль
+// return = ERROR - файл CSV не открылся
+//*************************************************************************************************
+Status DataLogExport( DataLogId id, DATE *beg, DATE *end, char *fname, Source src ) {
+
+    DATE date;
+    char name[LOG_NAME];
+    FILE *fin, *fout = NULL;
+    uint8_t schema = 0, col_cnt = 0;
+    uint32_t files = 0, rows = 0, errors = 0;
+
+    if ( id >= DLOG_CNT )
+        return ERROR;
+    LogFlush(); //блоки протоколов из буферов записываются в файлы
+    if ( fname != NULL ) {
+        fout = fopen( fname, "w" );
+        if ( fout == NULL )
+            return ERROR;
+       }
+    for ( date = *beg; DateNum( &date ) <= DateNum( end ); DateNext( &date ) ) {
+        LogFileName( dlog_desc[id].log, &date, name );
+        fin = fopen( name, "rb" );
+        if ( fin == NULL )
+            continue;
+        if ( FileHead( fin, id ) == false ) {
+            errors++;
+            fclose( fin );
+            continue;
+           }
+        files++;
+        //заголовок CSV выводится в начале и при изменении состава колонок
+        if ( files == 1 || exp_head.schema != schema || exp_head.col_cnt != col_cnt ) {
+            schema = exp_head.schema;
+            col_cnt = exp_head.col_cnt;
+            CsvOut( fout, exp_row, src );
+           }
+        rows += FileRecords( fin, fout, src, NULL, &errors );
+        fclose( fin );
+       }
+    if ( fout != NULL )
+        fclose( fout );
+    sprintf( exp_row, "Files: %u records: %u errors: %u\r\n", files, rows, errors );
+    ConsoleSend( exp_row, src );
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Выборка записей протокола за период с отбором по значению колонки, вывод в консоль в формате
+// CSV. По индексу файла читаются только блоки, время и диапазон значений ключевой колонки
+// которых пересекаются с условиями выборки. Индекс проверяется и при необходимости формируется
+// при остановленной записи протоколов, при ошибке формирования индекса файл читается полностью
+// DataLogId id       - ID протокола
+// DLOG_QUERY *query  - параметры выборки
+// Source src         - режим вывода информации в консоль
+// return = ERROR     - недопустимые параметры
+//*************************************************************************************************
+Status DataLogQuery( DataLogId id, DLOG_QUERY *query, Source src ) {
+
+    DATE date;
+    int8_t key;
+    bool head;
+    DLOG_IDX idx;
+    DLOG_BLOCK block;
+    DLOG_FILTER flt;
+    char name[LOG_NAME];
+    FILE *fin, *fidx;
+    uint8_t schema = 0, col_cnt = 0;
+    uint32_t files = 0, blocks = 0, skip = 0, rows = 0, errors = 0;
+
+    if ( id >= DLOG_CNT || DateNum( &query->date_beg ) > DateNum( &query->date_end ) )
+        return ERROR;
+    if ( query->time_beg >= DLOG_DAY_SEC || query->time_end >= DLOG_DAY_SEC )
+        return ERROR;
+    for ( date = query->date_beg; DateNum( &date ) <= DateNum( &query->date_end ); DateNext( &date ) ) {
+        LogFileName( dlog_desc[id].log, &date, name );
+        //индекс текущих суток проверяется при остановленной записи протоколов
+        head = false;
+        fidx = NULL;
+        LogLock();
+        fin = fopen( name, "rb" );
+        if ( fin != NULL )
+            head = FileHead( fin, id );
+        if ( head == true )
+            fidx = IndexOpen( id, &date, fin );
+        LogUnlock();
+        if ( fin == NULL )
+            continue;
+        if ( head == false || FileFilter( query, &date, &flt ) == false ) {
+            if ( head == false )
+                errors++;
+            if ( fidx != NULL )
+                fclose( fidx );
+            fclose( fin );
+            continue;
+           }
+        files++;
+        if ( files == 1 || exp_head.schema != schema || exp_head.col_cnt != col_cnt ) {
+            schema = exp_head.schema;
+            col_cnt = exp_head.col_cnt;
+            CsvOut( NULL, exp_row, src );
+           }
+        if ( fidx == NULL ) {
+            //индекса нет, чтение всех блоков
+            rows += FileRecords( fin, NULL, src, &flt, &errors );
+            fclose( fin );
+            continue;
+           }
+        //ключевая колонка индекса для отбора блоков по значению
+        for ( key = idx_head.key_cnt - 1; key >= 0 && flt.key == true; key-- )
+            if ( exp_key[key].pos == flt.col.pos )
+                break;
+        if ( flt.key == false )
+            key = -1;
+        while ( fread( &idx, 1, sizeof( idx ), fidx ) == sizeof( idx ) ) {
+            if ( !idx.cnt ) {
+                errors++; //поврежденный участок файла
+                continue;
+               }
+            if ( idx.time_end < flt.time_beg || idx.time_beg > flt.time_end ||
+                 ( key >= 0 && ( idx.max[key] < flt.min || idx.min[key] > flt.max ) ) ) {
+                skip++;
+                continue;
+               }
+            if ( fseek( fin, idx.offset, SEEK_SET ) || fread( &block, 1, sizeof( block ), fin ) != sizeof( block ) ||
+                 block.cnt != idx.cnt || BlockData( fin, &block ) == false ) {
+                errors++;
+                continue;
+               }
+            blocks++;
+            rows += BlockRows( &block, NULL, src, &flt );
+           }
+        fclose( fidx );
+        fclose( fin );
+       }
+    sprintf( exp_row, "Files: %u blocks: %u skipped: %u records: %u errors: %u\r\n", files, blocks, skip, rows, errors );
+    ConsoleSend( exp_row, src );
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Добавление записи в индекс протокола при записи блока в файл протокола
+// Вызывается из задачи записи протоколов для каждого блока двоичного протокола
+// LogId log       - ID протокола
+// DATE *date      - дата файла протокола
+// uint32_t offset - смещение блока в файле протокола
+// uint8_t *data   - блок записей [DLOG_BLOCK][записи]
+// uint16_t len    - размер блока
+//*************************************************************************************************
+void DataLogIndex( LogId log, DATE *date, uint32_t offset, uint8_t *data, uint16_t len ) {
+
+    #if _DLOG_INDEX
+    uint8_t id;
+    DLOG_IDX idx;
+    DLOG_BLOCK *block;
+
+    for ( id = 0; id < SIZE_ARRAY( dlog_desc ); id++ )
+        if ( dlog_desc[id].log == log )
+            break;
+    if ( id == SIZE_ARRAY( dlog_desc ) || len < sizeof( DLOG_BLOCK ) )
+        return; //индекс или заголовок файла
+    block = (DLOG_BLOCK *)data;
+    if ( block->sign != DLOG_BLOCK_SIGN || len != sizeof( DLOG_BLOCK ) + block->cnt * dlog_buff[id].rec_len )
+        return;
+    IndexFill( &idx, offset, block, data + sizeof( DLOG_BLOCK ), dlog_buff[id].rec_len, dlog_buff[id].key, DLOG_IDX_KEY );
+    LogPut( dlog_desc[id].idx, date, &idx, sizeof( idx ) );
+    #endif
+ }
+
+//*************************************************************************************************
+// Возвращает ID протокола по имени
+// char *name       - имя протокола
+// return DataLogId - ID протокола, DLOG_CNT - протокол не найден
+//*************************************************************************************************
+DataLogId DataLogGetId( char *name ) {
+
+    uint8_t id;
+
+    for ( id = 0; id < SIZE_ARRAY( dlog_desc ); id++ )
+        if ( !strcasecmp( name, dlog_desc[id].name ) )
+            return (DataLogId)id;
+    return DLOG_CNT;
+ }
+
+//*************************************************************************************************
+// Передача блока записей на запись в файл протокола, вызывается при заблокированных блоках
+// DataLogId id - ID протокола
+//*************************************************************************************************
+static void BlockPut( DataLogId id ) {
+
+    DLOG_BLOCK *block;
+    DLOG_BUFF *buff;
+
+    buff = &dlog_buff[id];
+    if ( !buff->cnt )
+        return;
+    block = (DLOG_BLOCK *)buff->data;
+    block->sign = DLOG_BLOCK_SIGN;
+    block->cnt = buff->cnt;
+    block->reserv = 0;
+    block->crc = CrcHwCalc( CRC_TYPE_32, buff->data + sizeof( DLOG_BLOCK ), buff->cnt * buff->rec_len );
+    LogPut( dlog_desc[id].log, &buff->date, buff->data, sizeof( DLOG_BLOCK ) + buff->cnt * buff->rec_len );
+    buff->cnt = 0;
+ }
+
+//*************************************************************************************************
+// Формирование заголовка файла протокола
+// Описание колонок формируется по описанию параметров уст-в (имя, тип значения)
+// DataLogId id     - ID протокола
+// DATE *date       - дата файла
+// uint8_t *buff    - буфер для заголовка
+// uint16_t size    - размер буфера
+// return uint16_t  - размер заголовка, 0 - недостаточный размер буфера
+//*************************************************************************************************
+static uint16_t HeadMake( DataLogId id, DATE *date, uint8_t *buff, uint16_t size ) {
+
+    uint8_t col;
+    char *name;
+    DLOG_HEAD *head;
+    DLOG_COL *dcol;
+    const DLOG_DEF *def;
+
+    if ( sizeof( DLOG_HEAD ) + dlog_desc[id].col_cnt * sizeof( DLOG_COL ) > size )
+        return 0;
+    memset( buff, 0x00, sizeof( DLOG_HEAD ) + dlog_desc[id].col_cnt * sizeof( DLOG_COL ) );
+    head = (DLOG_HEAD *)buff;
+    head->sign = DLOG_SIGN;
+    head->version = DLOG_VERSION;
+    head->log = id;
+    head->schema = dlog_desc[id].schema;
+    head->col_cnt = dlog_desc[id].col_cnt;
+    head->col_len = sizeof( DLOG_COL );
+    head->head_len = sizeof( DLOG_HEAD ) + dlog_desc[id].col_cnt * sizeof( DLOG_COL );
+    head->rec_len = dlog_buff[id].rec_len;
+    head->day = date->day;
+    head->month = date->month;
+    head->year = date->year;
+    //описание колонок
+    dcol = (DLOG_COL *)( buff + sizeof( DLOG_HEAD ) );
+    for ( col = 0; col < dlog_desc[id].col_cnt; col++, dcol++ ) {
+        def = &dlog_desc[id].col[col];
+        dcol->dev = def->dev;
+        dcol->param = def->param;
+        dcol->type = ParamGetType( def->dev, def->param );
+        dcol->size = def->size;
+        dcol->scale = def->scale;
+        dcol->out = def->out;
+        name = ParamGetName( def->dev, def->param );
+        if ( name != NULL )
+            strncpy( dcol->name, name, sizeof( dcol->name ) - 1 );
+        strncpy( dcol->frm, def->frm, sizeof( dcol->frm ) - 1 );
+       }
+    head->crc = CrcHwCalc( CRC_TYPE_32, buff, head->head_len );
+    return head->head_len;
+ }
+
+//*************************************************************************************************
+// Формирование заголовка файла индекса
+// DataLogId id         - ID протокола
+// uint32_t head_crc    - CRC заголовка файла протокола
+// bool keys            - true - ключевые колонки по текущему описанию протокола, false - без них
+// DLOG_IDX_HEAD *head  - заголовок индекса
+//*************************************************************************************************
+static void IndexHead( DataLogId id, uint32_t head_crc, bool keys, DLOG_IDX_HEAD *head ) {
+
+    memset( head, 0x00, sizeof( DLOG_IDX_HEAD ) );
+    head->sign = DLOG_IDX_SIGN;
+    head->version = DLOG_IDX_VERSION;
+    head->log = id;
+    if ( keys == true ) {
+        head->key_cnt = DLOG_IDX_KEY;
+        memcpy( head->key, dlog_desc[id].key, sizeof( head->key ) );
+       }
+    head->idx_len = sizeof( DLOG_IDX );
+    head->head_crc = head_crc;
+    head->crc = CrcHwCalc( CRC_TYPE_32, (uint8_t *)head, sizeof( DLOG_IDX_HEAD ) );
+ }
+
+//*************************************************************************************************
+// Заполнение записи индекса по блоку записей протокола
+// DLOG_IDX *idx     - запись индекса
+// uint32_t offset   - смещение блока в файле протокола
+// DLOG_BLOCK *block - заголовок блока
+// uint8_t *data     - записи блока
+// uint16_t rec_len  - размер записи
+// DLOG_KEY *key     - ключевые колонки
+// uint8_t key_cnt   - кол-во ключевых колонок
+//*************************************************************************************************
+static void IndexFill( DLOG_IDX *idx, uint32_t offset, DLOG_BLOCK *block, uint8_t *data, uint16_t rec_len, DLOG_KEY *key, uint8_t key_cnt ) {
+
+    uint8_t rec, k;
+    int32_t value;
+    uint32_t time;
+
+    memset( idx, 0x00, sizeof( DLOG_IDX ) );
+    idx->offset = offset;
+    idx->len = sizeof( DLOG_BLOCK ) + block->cnt * rec_len;
+    idx->cnt = block->cnt;
+    for ( rec = 0; rec < block->cnt; rec++, data += rec_len ) {
+        memcpy( &time, data, DLOG_TIME_SIZE );
+        if ( !rec || time < idx->time_beg )
+            idx->time_beg = time;
+        if ( !rec || time > idx->time_end )
+            idx->time_end = time;
+        for ( k = 0; k < key_cnt; k++ ) {
+            value = ValueRaw( data + key[k].pos, key[k].size, key[k].sign );
+            if ( !rec || value < idx->min[k] )
+                idx->min[k] = value;
+            if ( !rec || value > idx->max[k] )
+                idx->max[k] = value;
+           }
+       }
+ }
+
+//*************************************************************************************************
+// Открытие индекса файла протокола для чтения, отсутствующий или не соответствующий файлу
+// протокола индекс формируется заново, индекс без последних блоков файла дополняется
+// Вызывается при остановленной записи протоколов
+// DataLogId id  - ID протокола
+// DATE *date    - дата файла
+// FILE *fin     - файл протокола, заголовок прочитан в exp_head
+// return FILE * - файл индекса, указатель установлен на первую запись, NULL - индекса нет
+//*************************************************************************************************
+static FILE *IndexOpen( DataLogId id, DATE *date, FILE *fin ) {
+
+    FILE *fidx;
+    char name[LOG_NAME];
+    uint32_t size, pos = 0;
+
+    if ( fseek( fin, 0, SEEK_END ) )
+        return NULL;
+    size = ftell( fin );
+    LogFileName( dlog_desc[id].idx, date, name );
+    fidx = fopen( name, "rb" );
+    if ( fidx != NULL ) {
+        if ( IndexCheck( fidx, id, size, &pos ) == false )
+            pos = 0;
+        fclose( fidx );
+       }
+    if ( pos != size && IndexBuild( id, name, fin, pos, size ) == ERROR )
+        return NULL;
+    fidx = fopen( name, "rb" );
+    if ( fidx == NULL )
+        return NULL;
+    if ( fseek( fidx, sizeof( DLOG_IDX_HEAD ), SEEK_SET ) ) {
+        fclose( fidx );
+        return NULL;
+       }
+    return fidx;
+ }
+
+//*************************************************************************************************
+// Проверка индекса: заголовок соответствует файлу протокола, записи следуют без пропусков и
+// не выходят за размер файла протокола
+// FILE *fidx      - файл индекса
+// DataLogId id    - ID протокола
+// uint32_t size   - размер файла протокола
+// uint32_t *pos   - смещение в файле протокола, до которого сформирован индекс
+// return = true   - индекс соответствует файлу протокола, заголовок прочитан в idx_head
+//*************************************************************************************************
+static bool IndexCheck( FILE *fidx, DataLogId id, uint32_t size, uint32_t *pos ) {
+
+    uint8_t key;
+    uint32_t crc;
+    size_t len;
+    DLOG_IDX idx;
+
+    if ( fread( &idx_head, 1, sizeof( idx_head ), fidx ) != sizeof( idx_head ) )
+        return false;
+    crc = idx_head.crc;
+    idx_head.crc = 0;
+    if ( CrcHwCalc( CRC_TYPE_32, (uint8_t *)&idx_head, sizeof( idx_head ) ) != crc )
+        return false;
+    idx_head.crc = crc;
+    if ( idx_head.sign != DLOG_IDX_SIGN || idx_head.version != DLOG_IDX_VERSION || idx_head.log != id ||
+         idx_head.idx_len != sizeof( DLOG_IDX ) || idx_head.key_cnt > DLOG_IDX_KEY || idx_head.head_crc != exp_head.crc )
+        return false;
+    for ( key = 0; key < idx_head.key_cnt; key++ ) {
+        if ( idx_head.key[key] >= exp_head.col_cnt )
+            return false;
+        KeyCol( &exp_key[key], idx_head.key[key] );
+       }
+    //непрерывность записей индекса
+    *pos = exp_head.head_len;
+    while ( ( len = fread( &idx, 1, sizeof( idx ), fidx ) ) != 0 ) {
+        if ( len != sizeof( idx ) || idx.offset != *pos || !idx.len )
+            return false;
+        if ( idx.cnt && idx.len != sizeof( DLOG_BLOCK ) + idx.cnt * exp_head.rec_len )
+            return false;
+        *pos += idx.len;
+       }
+    return *pos <= size ? true : false;
+ }
+
+//*************************************************************************************************
+// Формирование индекса по блокам файла протокола, поврежденные участки файла протокола
+// записываются в индекс записями с cnt = 0
+// DataLogId id   - ID протокола
+// char *name     - имя файла индекса
+// FILE *fin      - файл протокола, заголовок прочитан в exp_head
+// uint32_t pos   - смещение в файле протокола, с которого дополняется индекс, 0 - новый индекс
+// uint32_t size  - размер файла протокола
+// return = ERROR - ошибка записи индекса
+//*************************************************************************************************
+static Status IndexBuild( DataLogId id, char *name, FILE *fin, uint32_t pos, uint32_t size ) {
+
+    FILE *fidx;
+    bool found;
+    uint8_t key;
+    uint32_t next;
+    Status result = SUCCESS;
+    DLOG_IDX idx;
+    DLOG_BLOCK block;
+
+    fidx = fopen( name, pos ? "ab" : "wb" );
+    if ( fidx == NULL )
+        return ERROR;
+    if ( !pos ) {
+        //ключевые колонки только для той же версии состава колонок
+        IndexHead( id, exp_head.crc, exp_head.schema == dlog_desc[id].schema ? true : false, &idx_head );
+        for ( key = 0; key < idx_head.key_cnt; key++ )
+            KeyCol( &exp_key[key], idx_head.key[key] );
+        if ( fwrite( &idx_head, 1, sizeof( idx_head ), fidx ) != sizeof( idx_head ) )
+            result = ERROR;
+        pos = exp_head.head_len;
+       }
+    do {
+        next = pos;
+        found = BlockNext( fin, &next, &block );
+        if ( found == false )
+            next = size; //поврежденный участок до конца файла
+        if ( IndexSkip( fidx, pos, next - pos ) == false )
+            result = ERROR;
+        if ( found == true ) {
+            IndexFill( &idx, next, &block, exp_data, exp_head.rec_len, exp_key, idx_head.key_cnt );
+            if ( fwrite( &idx, 1, sizeof( idx ), fidx ) != sizeof( idx ) )
+                result = ERROR;
+            next += idx.len;
+           }
+        pos = next;
+       } while ( found == true && result == SUCCESS );
+    fclose( fidx );
+    return result;
+ }
+
+//*************************************************************************************************
+// Запись в индекс поврежденного участка файла протокола записями с cnt = 0
+// FILE *fidx      - файл индекса
+// uint32_t offset - смещение участка в файле протокола
+// uint32_t len    - размер участка
+// return = false  - ошибка записи
+//*************************************************************************************************
+static bool IndexSkip( FILE *fidx, uint32_t offset, uint32_t len ) {
+
+    DLOG_IDX idx;
+
+    memset( &idx, 0x00, sizeof( idx ) );
+    while ( len ) {
+        idx.offset = offset;
+        idx.len = len > UINT16_MAX ? UINT16_MAX : len;
+        if ( fwrite( &idx, 1, sizeof( idx ), fidx ) != sizeof( idx ) )
+            return false;
+        offset += idx.len;
+        len -= idx.len;
+       }
+    return true;
+ }
+
+//*************************************************************************************************
+// Расположение значения колонки в записи файла протокола по описанию колонок exp_col
+// DLOG_KEY *key - расположение значения
+// uint8_t col   - номер колонки
+//*************************************************************************************************
+static void KeyCol( DLOG_KEY *key, uint8_t col ) {
+
+    uint8_t i;
+
+    key->pos = DLOG_TIME_SIZE;
+    for ( i = 0; i < col; i++ )
+        key->pos += exp_col[i].size;
+    key->size = exp_col[col].size;
+    key->sign = exp_col[col].type == VALUE_FLOAT ? true : false;
+ }
+
+//*************************************************************************************************
+// Сравнение дат
+// DATE *date1, DATE *date2 - даты
+// return = true            - даты совпадают
+//*************************************************************************************************
+static bool DateEqual( DATE *date1, DATE *date2 ) {
+
+    if ( date1->day == date2->day && date1->month == date2->month && date1->year == date2->year )
+        return true;
+    return false;
+ }
+
+//*************************************************************************************************
+// Переход к следующей дате, несуществующие даты (31.02) не пропускаются, файлы за эти даты
+// не открываются
+// DATE *date - дата
+//*************************************************************************************************
+static void DateNext( DATE *date ) {
+
+    if ( ++date->day <= 31 )
+        return;
+    date->day = 1;
+    if ( ++date->month <= 12 )
+        return;
+    date->month = 1;
+    date->year++;
+ }
+
+//*************************************************************************************************
+// Возвращает дату в виде числа YYYYMMDD для сравнения дат
+// DATE *date - дата
+//*************************************************************************************************
+static uint32_t DateNum( DATE *date ) {
+
+    return date->year * 10000 + date->month * 100 + date->day;
+ }
+
+//*************************************************************************************************
+// Чтение и проверка заголовка файла протокола, формирование заголовка CSV в exp_row
+// Описания колонок большего размера (более поздние версии) читаются без дополнительных полей
+// FILE *fin     - файл протокола
+// DataLogId id  - ID протокола
+// return = true - заголовок прочитан, указатель файла установлен на первый блок
+//*************************************************************************************************
+static bool FileHead( FILE *fin, DataLogId id ) {
+
+    uint8_t col;
+    uint32_t crc;
+    uint16_t len;
+    CRC_HW_CTX ctx;
+    uint8_t data[DLOG_COL_BUFF];
+
+    if ( fread( &exp_head, 1, sizeof( exp_head ), fin ) != sizeof( exp_head ) )
+        return false;
+    if ( exp_head.sign != DLOG_SIGN || !exp_head.version || exp_head.log != id )
+        return false;
+    if ( !exp_head.col_cnt || exp_head.col_cnt > DLOG_COL_MAX || exp_head.col_len > sizeof( data ) ||
+         exp_head.col_len < sizeof( DLOG_COL ) || exp_head.rec_len > DLOG_BLOCK_DATA )
+        return false;
+    //контрольная сумма заголовка и описания колонок
+    crc = exp_head.crc;
+    exp_head.crc = 0;
+    CrcHwStart( &ctx, CRC_TYPE_32 );
+    CrcHwAdd( &ctx, (uint8_t *)&exp_head, sizeof( exp_head ) );
+    exp_head.crc = crc;
+    len = DLOG_TIME_SIZE;
+    for ( col = 0; col < exp_head.col_cnt; col++ ) {
+        if ( fread( data, 1, exp_head.col_len, fin ) != exp_head.col_len )
+            break;
+        CrcHwAdd( &ctx, data, exp_head.col_len );
+        memcpy( &exp_col[col], data, sizeof( DLOG_COL ) );
+        exp_col[col].name[DLOG_COL_NAME - 1] = '\0';
+        exp_col[col].frm[DLOG_COL_FRM - 1] = '\0';
+        len += exp_col[col].size;
+       }
+    if ( CrcHwEnd( &ctx, &crc ) == ERROR || crc != exp_head.crc || col != exp_head.col_cnt )
+        return false;
+    if ( len != exp_head.rec_len || fseek( fin, exp_head.head_len, SEEK_SET ) )
+        return false;
+    //проверка колонок, формат вывода используется в sprintf()
+    for ( col = 0; col < exp_head.col_cnt; col++ ) {
+        if ( exp_col[col].size != 1 && exp_col[col].size != 2 && exp_col[col].size != 4 )
+            return false;
+        if ( exp_col[col].scale >= SIZE_ARRAY( scale_mult ) )
+            return false;
+        if ( FrmCheck( exp_col[col].frm, (DataLogOut)exp_col[col].out ) != ( exp_col[col].out == DLOG_OUT_HM ? 2 : 1 ) )
+            return false;
+       }
+    //заголовок CSV: текущий для той же версии состава колонок, иначе по именам колонок
+    if ( exp_head.schema == dlog_desc[id].schema ) {
+        strcpy( exp_row, Message( dlog_desc[id].head ) );
+        return true;
+       }
+    strcpy( exp_row, "Date;Time" );
+    for ( col = 0; col < exp_head.col_cnt; col++ ) {
+        strcat( exp_row, ";" );
+        strcat( exp_row, exp_col[col].name );
+       }
+    strcat( exp_row, Message( CONS_MSG_CRLF ) );
+    return true;
+ }
+
+//*************************************************************************************************
+// Чтение блоков записей файла протокола и вывод записей в формате CSV
+// При ошибке в блоке выполняется поиск следующего блока со смещением на один байт
+// FILE *fin         - файл протокола
+// FILE *fout        - файл CSV, NULL - вывод в консоль
+// Source src        - режим вывода информации в консоль
+// DLOG_FILTER *flt  - условия отбора записей, NULL - все записи
+// uint32_t *errors  - счетчик ошибок
+// return uint32_t   - кол-во выведенных записей
+//*************************************************************************************************
+static uint32_t FileRecords( FILE *fin, FILE *fout, Source src, DLOG_FILTER *flt, uint32_t *errors ) {
+
+    bool found;
+    uint32_t pos, next, rows = 0;
+    DLOG_BLOCK block;
+
+    pos = exp_head.head_len;
+    do {
+        next = pos;
+        found = BlockNext( fin, &next, &block );
+        if ( next != pos )
+            (*errors)++; //поврежденный участок файла
+        if ( found == true ) {
+            rows += BlockRows( &block, fout, src, flt );
+            next += sizeof( block ) + block.cnt * exp_head.rec_len;
+           }
+        pos = next;
+       } while ( found == true );
+    return rows;
+ }
+
+//*************************************************************************************************
+// Формирование условий отбора записей файла протокола по параметрам выборки
+// Колонка отбора определяется по имени или номеру в описании колонок exp_col
+// DLOG_QUERY *query - параметры выборки
+// DATE *date        - дата файла
+// DLOG_FILTER *flt  - условия отбора
+// return = false    - колонки отбора в файле нет
+//*************************************************************************************************
+static bool FileFilter( DLOG_QUERY *query, DATE *date, DLOG_FILTER *flt ) {
+
+    char *end;
+    uint32_t col;
+
+    memset( flt, 0x00, sizeof( DLOG_FILTER ) );
+    flt->time_beg = DateEqual( date, &query->date_beg ) == true ? query->time_beg : 0;
+    flt->time_end = DateEqual( date, &query->date_end ) == true ? query->time_end : DLOG_DAY_SEC - 1;
+    if ( query->key == NULL )
+        return true;
+    //колонка по номеру или по имени
+    col = strtoul( query->key, &end, 10 );
+    if ( end == query->key || *end != '\0' ) {
+        for ( col = 0; col < exp_head.col_cnt; col++ )
+            if ( !strcasecmp( query->key, exp_col[col].name ) )
+                break;
+       }
+    else col--;
+    if ( col >= exp_head.col_cnt )
+        return false;
+    flt->key = true;
+    KeyCol( &flt->col, col );
+    if ( exp_col[col].type == VALUE_FLOAT ) {
+        flt->min = FloatRaw( query->min, exp_col[col].scale );
+        flt->max = FloatRaw( query->max, exp_col[col].scale );
+       }
+    else {
+        flt->min = (int32_t)query->min;
+        flt->max = (int32_t)query->max;
+       }
+    return true;
+ }
+
+//*************************************************************************************************
+// Поиск следующего блока записей, начиная с указанного смещения со сдвигом на один байт
+// Записи найденного блока читаются в exp_data
+// FILE *fin         - файл протокола
+// uint32_t *pos     - смещение начала поиска, возвращается смещение найденного блока
+//                     или смещение, с которого заголовок блока не читается (конец файла)
+// DLOG_BLOCK *block - заголовок блока
+// return = true     - блок найден
+//*************************************************************************************************
+static bool BlockNext( FILE *fin, uint32_t *pos, DLOG_BLOCK *block ) {
+
+    for ( ;; (*pos)++ ) {
+        if ( fseek( fin, *pos, SEEK_SET ) || fread( block, 1, sizeof( DLOG_BLOCK ), fin ) != sizeof( DLOG_BLOCK ) )
+            return false;
+        if ( BlockData( fin, block ) == true )
+            return true;
+       }
+ }
+
+//*************************************************************************************************
+// Проверка заголовка блока, чтение записей блока в exp_data и проверка CRC
+// FILE *fin         - файл протокола, указатель установлен на записи блока
+// DLOG_BLOCK *block - заголовок блока
+// return = true     - блок без ошибок
+//*************************************************************************************************
+static bool BlockData( FILE *fin, DLOG_BLOCK *block ) {
+
+    uint16_t len;
+
+    len = block->cnt * exp_head.rec_len;
+    if ( block->sign != DLOG_BLOCK_SIGN || !block->cnt || len > sizeof( exp_data ) )
+        return false;
+    if ( fread( exp_data, 1, len, fin ) != len || CrcHwCalc( CRC_TYPE_32, exp_data, len ) != block->crc )
+        return false;
+    return true;
+ }
+
+//*************************************************************************************************
+// Вывод записей блока из exp_data в формате CSV
+// DLOG_BLOCK *block - заголовок блока
+// FILE *fout        - файл CSV, NULL - вывод в консоль
+// Source src        - режим вывода информации в консоль
+// DLOG_FILTER *flt  - условия отбора записей, NULL - все записи
+// return uint32_t   - кол-во выведенных записей
+//*************************************************************************************************
+static uint32_t BlockRows( DLOG_BLOCK *block, FILE *fout, Source src, DLOG_FILTER *flt ) {
+
+    int32_t value;
+    uint8_t rec, col, *ptr;
+    uint16_t len;
+    uint32_t time, rows = 0;
+
+    for ( rec = 0; rec < block->cnt; rec++ ) {
+        ptr = exp_data + rec * exp_head.rec_len;
+        memcpy( &time, ptr, DLOG_TIME_SIZE );
+        if ( flt != NULL ) {
+            if ( time < flt->time_beg || time > flt->time_end )
+                continue;
+            if ( flt->key == true ) {
+                value = ValueRaw( ptr + flt->col.pos, flt->col.size, flt->col.sign );
+                if ( value < flt->min || value > flt->max )
+                    continue;
+               }
+           }
+        ptr += DLOG_TIME_SIZE;
+        len = sprintf( exp_row, "%02u.%02u.%04u;%02u:%02u:%02u", exp_head.day, exp_head.month, exp_head.year,
+                       time / 3600, time / 60 % 60, time % 60 );
+        for ( col = 0; col < exp_head.col_cnt; col++ ) {
+            exp_row[len++] = ';';
+            len += ColValue( &exp_col[col], ptr, exp_row + len, sizeof( exp_row ) - len - 3 );
+            ptr += exp_col[col].size;
+           }
+        strcpy( exp_row + len, Message( CONS_MSG_CRLF ) );
+        CsvOut( fout, exp_row, src );
+        rows++;
+       }
+    return rows;
+ }
+
+//*************************************************************************************************
+// Вывод значения колонки по формату колонки
+// DLOG_COL *col   - описание колонки
+// uint8_t *data   - значение в записи
+// char *str       - буфер для результата
+// uint16_t size   - размер буфера
+// return uint16_t - кол-во символов результата
+//*************************************************************************************************
+static uint16_t ColValue( DLOG_COL *col, uint8_t *data, char *str, uint16_t size ) {
+
+    int len = 0;
+    char *desc;
+    ValueParam value;
+
+    value.uint32 = 0;
+    memcpy( &value.uint32, data, col->size );
+    if ( col->out == DLOG_OUT_INT )
+        len = snprintf( str, size, col->frm, value.uint32 );
+    if ( col->out == DLOG_OUT_HM )
+        len = snprintf( str, size, col->frm, value.uint32 / 60, value.uint32 % 60 );
+    if ( col->out == DLOG_OUT_FLOAT )
+        len = snprintf( str, size, col->frm, (float)ValueRaw( data, col->size, true ) / scale_mult[col->scale] );
+    if ( col->out == DLOG_OUT_DESC ) {
+        desc = ParamValDesc( (Device)col->dev, col->param, value );
+        len = snprintf( str, size, col->frm, desc != NULL ? desc : "" );
+       }
+    if ( len < 0 )
+        return 0;
+    return len < size ? len : size - 1;
+ }
+
+//*************************************************************************************************
+// Возвращает значение колонки из записи с расширением знака для значений со знаком
+// uint8_t *data   - значение в записи
+// uint8_t size    - размер значения (1, 2, 4)
+// bool sign       - значение со знаком
+// return int32_t  - значение
+//*************************************************************************************************
+static int32_t ValueRaw( uint8_t *data, uint8_t size, bool sign ) {
+
+    uint32_t value = 0;
+
+    memcpy( &value, data, size );
+    if ( sign == true && size < sizeof( value ) && ( value & ( 1UL << ( size * 8 - 1 ) ) ) )
+        value |= ~0UL << ( size * 8 );
+    return (int32_t)value;
+ }
+
+//*************************************************************************************************
+// Преобразование числа float в целое со знаком, умноженное на 10^scale, с округлением
+// float value    - значение
+// uint8_t scale  - кол-во десятичных знаков
+// return int32_t - значение для записи
+//*************************************************************************************************
+static int32_t FloatRaw( float value, uint8_t scale ) {
+
+    value *= scale_mult[scale];
+    return (int32_t)( value < 0 ? value - 0.5f : value + 0.5f );
+ }
+
+//*************************************************************************************************
+// Возвращает кол-во значений в формате вывода, "%%" не учитывается
+// char *frm       - формат вывода
+// DataLogOut out  - вид вывода значения, определяет допустимые преобразования
+// return uint8_t  - кол-во значений, 0 - недопустимый формат
+//*************************************************************************************************
+static uint8_t FrmCheck( char *frm, DataLogOut out ) {
+
+    uint8_t cnt = 0;
+    char *conv = "duxX";
+
+    if ( out == DLOG_OUT_FLOAT )
+        conv = "f";
+    if ( out == DLOG_OUT_DESC )
+        conv = "s";
+    if ( out > DLOG_OUT_HM )
+        return 0;
+
+    for ( ; *frm; frm++ ) {
+        if ( *frm != '%' )
+            continue;
+        if ( *( frm + 1 ) == '%' ) {
+            frm++;
+            continue;
+           }
+        //флаги, ширина и точность
+        for ( frm++; *frm && strchr( "+-0 #.123456789", *frm ) != NULL; frm++ );
+        if ( !*frm || strchr( conv, *frm ) == NULL )
+            return 0;
+        cnt++;
+       }
+    return cnt;
+ }
+
+//*************************************************************************************************
+// Вывод строки CSV в консоль или в файл
+// FILE *fout - файл CSV, NULL - вывод в консоль
+// char *str  - строка
+// Source src - режим вывода информации в консоль
+//*************************************************************************************************
+static void CsvOut( FILE *fout, char *str, Source src ) {
+
+    if ( fout != NULL )
+        fputs( str, fout );
+    else ConsoleSend( str, src );
+ }
@@ -0,0 +1,160 @@
+
+#ifndef __DATALOG_H
+#define __DATALOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lpc_types.h>
+
+#include "device.h"
+#include "dev_data.h"
+#include "command.h"
+#include "logger.h"
+
+//*************************************************************************************************
+// Двоичный формат протоколов данных уст-в (*.bin)
+// Файл: [DLOG_HEAD][DLOG_COL x col_cnt][DLOG_BLOCK][запись x cnt][DLOG_BLOCK][запись x cnt]...
+// Запись: [время от начала суток (сек) 4 байта][значения колонок по size байт]
+// Числа записываются младшим байтом вперед, значения VALUE_FLOAT - целые со знаком,
+// умноженные на 10^scale, остальные значения - целые без знака
+//*************************************************************************************************
+#define DLOG_SIGN               0x474F4C44  //сигнатура файла "DLOG"
+#define DLOG_VERSION            1           //версия формата файла
+#define DLOG_BLOCK_SIGN         0xB10C      //сигнатура блока записей
+#define DLOG_COL_NAME           12          //размер имени колонки
+#define DLOG_COL_FRM            14          //размер формата вывода колонки
+#define DLOG_COL_MAX            16          //максимальное кол-во колонок протокола
+
+//*************************************************************************************************
+// Индекс протокола (*.idx), файл в том же каталоге с тем же именем
+// Файл: [DLOG_IDX_HEAD][DLOG_IDX][DLOG_IDX]...
+// Записи индекса следуют без пропусков: смещение каждой записи равно смещению предыдущей плюс
+// ее размер, поврежденные участки файла протокола описываются записями с cnt = 0
+//*************************************************************************************************
+#define DLOG_IDX_SIGN           0x58444944  //сигнатура файла индекса "DIDX"
+#define DLOG_IDX_VERSION        1           //версия формата файла индекса
+#define DLOG_IDX_KEY            2           //кол-во ключевых колонок индекса
+#define DLOG_DAY_SEC            86400       //кол-во секунд в сутках
+
+//Протоколы данных уст-в в двоичном формате
+typedef enum {
+    DLOG_BATMON,                            //монитор АКБ: \batmon\bm_YYYYMMDD.bin
+    DLOG_MPPT,                              //контроллер MPPT: \mppt\mppt_YYYYMMDD.bin
+    DLOG_INV,                               //инверторы: \inv\inv_YYYYMMDD.bin
+    DLOG_CHARGER,                           //контроллер заряда: \charger\pb_YYYYMMDD.bin
+    DLOG_CNT                                //кол-во протоколов
+ } DataLogId;
+
+//Вид вывода значения колонки при экспорте в CSV
+typedef enum {
+    DLOG_OUT_INT,                           //целое число по формату
+    DLOG_OUT_FLOAT,                         //число float по формату, значение / 10^scale
+    DLOG_OUT_DESC,                          //расшифровка значения ParamValDesc()
+    DLOG_OUT_HM                             //минуты в формате "часы:минуты" по формату
+ } DataLogOut;
+
+#pragma pack( push, 1 )                     //выравнивание структуры по границе 1 байта
+
+//*************************************************************************************************
+// Заголовок файла (24 байта)
+//*************************************************************************************************
+typedef struct {
+    uint32_t sign;                          //сигнатура файла DLOG_SIGN
+    uint8_t  version;                       //версия формата файла DLOG_VERSION
+    uint8_t  log;                           //ID протокола DataLogId
+    uint8_t  schema;                        //версия состава колонок протокола
+    uint8_t  col_cnt;                       //кол-во колонок
+    uint16_t col_len;                       //размер описания колонки
+    uint16_t head_len;                      //размер заголовка вместе с описанием колонок
+    uint16_t rec_len;                       //размер записи
+    uint8_t  day;                           //дата файла
+    uint8_t  month;
+    uint16_t year;
+    uint16_t reserv;                        //резерв
+    uint32_t crc;                           //CRC-32 заголовка (поле crc = 0) и описания колонок
+ } DLOG_HEAD;
+
+//*************************************************************************************************
+// Описание колонки (32 байта), формируется по описанию параметра уст-ва DevParam
+//*************************************************************************************************
+typedef struct {
+    uint8_t  dev;                           //ID уст-ва
+    uint8_t  param;                         //ID параметра
+    uint8_t  type;                          //тип значения параметра ValueType
+    uint8_t  size;                          //размер значения в записи (1, 2, 4)
+    uint8_t  scale;                         //десятичный множитель значения VALUE_FLOAT
+    uint8_t  out;                           //вид вывода значения DataLogOut
+    char     name[DLOG_COL_NAME];           //имя параметра
+    char     frm[DLOG_COL_FRM];             //формат вывода значения в CSV
+ } DLOG_COL;
+
+//*************************************************************************************************
+// Заголовок блока записей (8 байт)
+//*************************************************************************************************
+typedef struct {
+    uint16_t sign;                          //сигнатура блока DLOG_BLOCK_SIGN
+    uint8_t  cnt;                           //кол-во записей в блоке
+    uint8_t  reserv;                        //резерв
+    uint32_t crc;                           //CRC-32 записей блока
+ } DLOG_BLOCK;
+
+//*************************************************************************************************
+// Заголовок файла индекса (20 байт)
+//*************************************************************************************************
+typedef struct {
+    uint32_t sign;                          //сигнатура файла DLOG_IDX_SIGN
+    uint8_t  version;                       //версия формата файла DLOG_IDX_VERSION
+    uint8_t  log;                           //ID протокола DataLogId
+    uint8_t  key_cnt;                       //кол-во ключевых колонок
+    uint8_t  key[DLOG_IDX_KEY];             //номера ключевых колонок
+    uint8_t  reserv;                        //резерв
+    uint16_t idx_len;                       //размер записи индекса
+    uint32_t head_crc;                      //CRC-32 заголовка файла протокола DLOG_HEAD.crc
+    uint32_t crc;                           //CRC-32 заголовка индекса (поле crc = 0)
+ } DLOG_IDX_HEAD;
+
+//*************************************************************************************************
+// Запись индекса (32 байта) для одного блока записей протокола
+//*************************************************************************************************
+typedef struct {
+    uint32_t offset;                        //смещение блока в файле протокола
+    uint16_t len;                           //размер блока вместе с заголовком
+    uint8_t  cnt;                           //кол-во записей, 0 - поврежденный участок файла
+    uint8_t  reserv;                        //резерв
+    uint32_t time_beg;                      //мин время записей блока (сек от начала суток)
+    uint32_t time_end;                      //макс время записей блока
+    int32_t  min[DLOG_IDX_KEY];             //мин значения ключевых колонок (как в записи)
+    int32_t  max[DLOG_IDX_KEY];             //макс значения ключевых колонок
+ } DLOG_IDX;
+
+#pragma pack( pop )
+
+//Параметры выборки записей протокола
+typedef struct {
+    DATE     date_beg;                      //дата начала периода
+    uint32_t time_beg;                      //время начала периода (сек от начала суток)
+    DATE     date_end;                      //дата окончания периода
+    uint32_t time_end;                      //время окончания периода (включительно)
+    char     *key;                          //имя или номер (1...) колонки отбора, NULL - все записи
+    float    min;                           //диапазон значений колонки отбора
+    float    max;
+ } DLOG_QUERY;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void DataLogInit( void );
+void DataLogSave( DataLogId id );
+void DataLogCommit( void );
+void DataLogFlush( void );
+uint16_t DataLogHead( LogId log, DATE *date, uint8_t *buff, uint16_t size );
+Status DataLogExport( DataLogId id, DATE *beg, DATE *end, char *fname, Source src );
+Status DataLogQuery( DataLogId id, DLOG_QUERY *query, Source src );
+void DataLogIndex( LogId log, DATE *date, uint32_t offset, uint8_t *data, uint16_t len );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+DataLogId DataLogGetId( char *name );
+
+#endif
@@ -77,14 +77,17 @@ extern osEventFlagsId_t command_event, soc_event, charge_event, trc_event, gen_e
 //*************************************************************************************************
 //события обрабатываемые в задаче "Rs485"
 #define EVN_RS485_IRQ           0x00000001  //событие прерывания от MAX3100
-#define EVN_RS485_MASK          EVN_RS485_IRQ
+#define EVN_RS485_RTS           0x00000002  //вышло время задержки переключения RTS
+#define EVN_RS485_SEND          0x00000004  //запуск передачи пакета
+#define EVN_RS485_MASK          EVN_RS485_IRQ | EVN_RS485_RTS | EVN_RS485_SEND
 
 //*************************************************************************************************
 //события обрабатываемые в задаче "Informing"
 #define EVN_INFO_BAT            0x00000001  //событие сообщения о уровне заряда
 #define EVN_INFO_INV            0x00000002  //событие сообщения о мощности нагрузки
 #define EVN_INFO_TTG            0x00000004  //событие сообщения о продолжительности работы
-#define EVN_INFO_MASK           EVN_RTC_SECONDS | EVN_RTC_5MINUTES | EVN_INFO_BAT | EVN_INFO_INV | EVN_INFO_TTG
+#define EVN_INFO_POLL           0x00000008  //состояние информатора прочитано планировщиком опроса
+#define EVN_INFO_MASK           EVN_RTC_5MINUTES | EVN_INFO_BAT | EVN_INFO_INV | EVN_INFO_TTG | EVN_INFO_POLL
 
 //*************************************************************************************************
 //события обрабатываемые в задаче "Soc"
@@ -93,12 +96,12 @@ extern osEventFlagsId_t command_event, soc_event, charge_event, trc_event, gen_e
 
 //*************************************************************************************************
 //события обрабатываемые в задаче "Modbus"
-#define MSG_MODBUS_SEND         0x00010000  //передача пакета, младший два байт содержит размер 
-                                            //передаваемого блока
+#define MSG_MODBUS_QUEUE        0x00010000  //в очередь уст-ва добавлен новый запрос
 #define MSG_MODBUS_RECV         0x00020000  //весь пакет от уст-ва получен
 #define MSG_MODBUS_CHECK        0x00040000  //предварительная проверка принимаемого пакета данных
 #define MSG_MODBUS_TIMEOUT      0x00080000  //вышло время ожидания ответа
-#define MSG_MODBUS_MASK_DATA    0x0000FFFF  //маска для выделения размера передаваемого блока
+#define MSG_MODBUS_MASK         0xFFFF0000  //маска кода сообщения
+#define MSG_MODBUS_SEQ          0x0000FFFF  //маска номера запроса в сообщениях RECV/CHECK/TIMEOUT
 
 //*************************************************************************************************
 //события обрабатываемые в задаче "Tracker"
@@ -106,7 +109,8 @@ extern osEventFlagsId_t command_event, soc_event, charge_event, trc_event, gen_e
 #define EVN_TRC_SUN_OFF         0x00000002  //пропала освещенность
 #define EVN_TRC_SUN_POS         0x00000004  //позиционирование по данным SPA
 #define EVN_TRC_LOG             0x00000008  //интервальное логирование
-#define EVN_TRC_MASK            EVN_RTC_1MINUTES | EVN_RTC_5MINUTES | EVN_TRC_SUN_ON | EVN_TRC_SUN_OFF | EVN_TRC_SUN_POS | EVN_TRC_LOG
+#define EVN_TRC_POLL            0x00000010  //состояние контроллера прочитано планировщиком опроса
+#define EVN_TRC_MASK            EVN_RTC_1MINUTES | EVN_RTC_5MINUTES | EVN_TRC_SUN_ON | EVN_TRC_SUN_OFF | EVN_TRC_SUN_POS | EVN_TRC_LOG | EVN_TRC_POLL
 
 //*************************************************************************************************
 //события обрабатываемые в задаче "Generator"
@@ -114,7 +118,8 @@ extern osEventFlagsId_t command_event, soc_event, charge_event, trc_event, gen_e
 #define EVN_GEN_CONSOLE         0x00020000  //вывод в консоль результата выполнения команды
 #define EVN_GEN_CHECK_OFF       0x00040000  //выключение схемы контроля
 #define EVN_GEN_CYCLE_NEXT      0x00080000  //следующий шаг циклограммы
-#define EVN_GEN_MASK            EVN_RTC_SECONDS | EVN_GEN_LOG | EVN_GEN_CONSOLE | EVN_GEN_CHECK_OFF | EVN_GEN_CYCLE_NEXT | EVN_ALT_AC_LOST | EVN_ALT_AC_REST
+#define EVN_GEN_POLL            0x00100000  //состояние генератора прочитано планировщиком опроса
+#define EVN_GEN_MASK            EVN_RTC_SECONDS | EVN_GEN_LOG | EVN_GEN_CONSOLE | EVN_GEN_CHECK_OFF | EVN_GEN_CYCLE_NEXT | EVN_ALT_AC_LOST | EVN_ALT_AC_REST | EVN_GEN_POLL
 
 //*************************************************************************************************
 //события обрабатываемые в задаче "Invertor"
@@ -24,6 +24,8 @@
 #include "priority.h"
 #include "command.h"
 #include "hmi_can.h"
+#include "can_filter.h"
+#include "can_xfer.h"
 
 #include "charger.h"
 #include "message.h"
@@ -31,6 +33,7 @@
 #include "outinfo.h"
 #include "inverter.h"
 #include "sdcard.h"
+#include "logger.h"
 #include "pv.h"
 #include "alt.h"
 #include "rtc.h"
@@ -53,6 +56,39 @@ osMessageQueueId_t hmi_msg = NULL;
 //*************************************************************************************************
 #define CAN_BITRATE_NOMINAL     125000      //скорость обмена (125 kbit/s)
 
+#define CAN_TX_RING             48          //кол-во пакетов в очереди передачи одного класса
+#define CAN_TX_OBJ              3           //макс кол-во буферов передачи (TX1-TX3 LPC177x)
+#define CAN_TX_FREE             0xFFFFFFFFU //буфер передачи свободен
+#define CAN_EVN_TX_IDLE         0x00000001  //очереди и буферы передачи пусты
+
+//Пакет в очереди передачи
+typedef struct {
+    uint32_t can_id;                        //ID пакета
+    uint8_t  len;                           //размер данных
+    uint8_t  data[CAN_DATA_MAX];            //данные
+ } CAN_TX_FRAME;
+
+//Очередь передачи одного класса приоритета
+typedef struct {
+    volatile uint32_t head;                 //кол-во добавленных пакетов (изменяет задача)
+    volatile uint32_t tail;                 //кол-во переданных пакетов (изменяет прерывание)
+    CAN_TX_FRAME frame[CAN_TX_RING];
+ } CAN_TX_QUEUE;
+
+#define CAN_CMD_ANY             0xFF        //команда принимается с любым ID параметра
+#define CAN_CMD_PARAM           4           //кол-во ID параметров (0...N-1) с отдельными обработчиками
+
+//Обработчик команды
+typedef void (*CanCmdExec)( MSGQUEUE_CAN *que_cmd );
+
+//Описание команды принимаемой от HMI
+typedef struct {
+    Device     dev_id;                      //ID уст-ва
+    uint8_t    param_id;                    //ID параметра (0...CAN_CMD_PARAM-1) или CAN_CMD_ANY
+    uint8_t    len_min;                     //минимальный размер данных пакета
+    CanCmdExec exec;                        //обработчик, NULL - пакеты обрабатываются в прерывании
+ } CAN_CMD;
+
 //*************************************************************************************************
 // Внешние переменные
 //*************************************************************************************************
@@ -65,7 +101,7 @@ ARM_DRIVER_CAN *CanDrv;
 
 static char str_val[16];
 static uint8_t rx_data[8], *can_mbus_addr;
-static uint32_t rx_obj_idx, tx_obj_idx;
+static uint32_t rx_obj_idx, tx_obj_idx[CAN_TX_OBJ], tx_obj_cnt = 0;
 static int32_t send_stat = 0, send_pack = 0, error_send = 0;
 static uint16_t len_mbus_data, can_mbus_rest;
 
@@ -73,7 +109,18 @@ static MBUS_REQUEST reqst;
 static CAN_MODBUS can_modbus;
 static ARM_CAN_MSG_INFO rx_msg_info, tx_msg_info;
 static osMessageQueueId_t cmd_msg = NULL;
-static osSemaphoreId_t can_semaph;
+static osMutexId_t mutex_tx;
+static osEventFlagsId_t can_event;
+
+static CAN_TX_QUEUE tx_queue[CAN_TX_CLASS];             //очереди передачи по классам приоритета
+static volatile uint32_t tx_pend[CAN_TX_OBJ];           //ID уст-ва пакета в буфере передачи
+static bool tx_full[CAN_TX_CLASS];                      //признак переполнения очереди
+static uint32_t tx_stat[CAN_TXSTAT_CNT];                //счетчики очереди передачи
+
+static osMutexId_t mutex_flt;
+static CAN_AF_TABLE af_table;                           //загруженная таблица фильтра
+static bool af_bypass = false;                          //фильтр не загружен, прием всех пакетов
+static bool rx_off[ID_DEV_XFER + 1];                     //прием команд уст-ва отключен
 
 //*************************************************************************************************
 // Атрибуты объектов RTOS
@@ -92,31 +139,89 @@ static const osThreadAttr_t cmd_attr = {
 
 static const osMessageQueueAttr_t que1_attr = { .name = "HmiLink" };
 static const osMessageQueueAttr_t que2_attr = { .name = "HmiCmd" };
-static const osSemaphoreAttr_t sem_attr = { .name = "HmiLink" };
+static const osMutexAttr_t mutex_attr = { .name = "HmiLinkTx", .attr_bits = osMutexPrioInherit };
+static const osEventFlagsAttr_t evn_attr = { .name = "HmiLinkTx" };
+static const osMutexAttr_t mutex_flt_attr = { .name = "HmiFilter", .attr_bits = osMutexPrioInherit };
 
 //*************************************************************************************************
 // Прототипы локальных функций
 //*************************************************************************************************
 static void CANMbusAnswer( void );
+static void CanTxDrain( void );
+static CAN_TX_FRAME *CanTxNext( CanTxPrio *prio );
+static Status CanFilterApply( void );
+static void CanFilterBuild( CAN_AF_TABLE *af );
+static Status CanFilterLoad( CAN_AF_TABLE *af );
+static void CanFilterUnload( CAN_AF_TABLE *af );
+static bool AfExact( CAN_AF_TABLE *af, uint32_t id );
+static bool AfGroup( CAN_AF_TABLE *af, uint32_t lower, uint32_t upper );
 static void TaskHmi( void *pvParameters );
 static void TaskCmd( void *pvParameters );
 void CAN_SignalObjectEvent( uint32_t obj_idx, uint32_t event );
+static void CanCmdBuild( void );
 static void ExecCommand( MSGQUEUE_CAN *que_cmd );
+static void CanCmdRtc( MSGQUEUE_CAN *que_cmd );
+static void CanCmdSubscr( MSGQUEUE_CAN *que_cmd );
+static void CanCmdCfgHash( MSGQUEUE_CAN *que_cmd );
+static void CanCmdPv( MSGQUEUE_CAN *que_cmd );
+static void CanCmdCharger( MSGQUEUE_CAN *que_cmd );
+static void CanCmdInv( MSGQUEUE_CAN *que_cmd );
+static void CanCmdAlt( MSGQUEUE_CAN *que_cmd );
+static void CanCmdGen( MSGQUEUE_CAN *que_cmd );
+static void CanCmdTrc( MSGQUEUE_CAN *que_cmd );
+static void CanCmdVoice( MSGQUEUE_CAN *que_cmd );
+static void CanCmdReserv( MSGQUEUE_CAN *que_cmd );
+static void CanCmdExtOut( MSGQUEUE_CAN *que_cmd );
+static void CanCmdModbus( MSGQUEUE_CAN *que_cmd );
+static void CanCmdConfig( MSGQUEUE_CAN *que_cmd );
 static void CmdSaveLog( MSGQUEUE_CAN *que_cmd );
 static void ConfigSaveLog( ConfigParam id_par, ConfigValSet cfg_set, Status check );
 
+//*************************************************************************************************
+// Команды принимаемые от HMI, по описанию формируются таблица выбора обработчика команды
+// и таблица фильтра приема пакетов
+//*************************************************************************************************
+static const CAN_CMD can_cmd[] = {
+    //ID уст-ва         ID параметра    размер данных               обработчик
+    ID_DEV_RTC,         0,              sizeof( RTC ),              CanCmdRtc,
+    ID_DEV_PV,          0,              sizeof( CAN_PV ),           CanCmdPv,
+    ID_DEV_CHARGER,     0,              sizeof( uint8_t ),          CanCmdCharger,
+    ID_DEV_INV1,        0,              sizeof( uint8_t ),          CanCmdInv,
+    ID_DEV_INV2,        0,              sizeof( uint8_t ),          CanCmdInv,
+    ID_DEV_ALT,         0,              sizeof( uint8_t ),          CanCmdAlt,
+    ID_DEV_GEN,         0,              sizeof( uint8_t ),          CanCmdGen,
+    ID_DEV_TRC,         0,              sizeof( CAN_TRC ),          CanCmdTrc,
+    ID_DEV_VOICE,       0,              sizeof( CAN_INFO ),         CanCmdVoice,
+    ID_DEV_HMI,         0,              sizeof( CAN_SUBSCR ),       CanCmdSubscr,
+    ID_DEV_HMI,         CAN_HMI_CONFIG, sizeof( CAN_CONFIG16 ),     CanCmdCfgHash,
+    ID_DEV_RESERV,      0,              sizeof( CAN_RELAY ),        CanCmdReserv,
+    ID_DEV_EXTOUT,      0,              sizeof( CAN_EXT ),          CanCmdExtOut,
+    ID_DEV_MODBUS_REQ,  CAN_CMD_ANY,    0,                          CanCmdModbus,
+    ID_CONFIG,          CAN_CMD_ANY,    0,                          CanCmdConfig,
+    ID_DEV_XFER,        CAN_CMD_ANY,    0,                          NULL
+ };
+
+//Индекс описания команды + 1 по ID уст-ва и ID параметра, последний столбец - остальные ID параметров
+static uint8_t cmd_tab[ID_DEV_XFER + 1][CAN_CMD_PARAM + 1];
+
 //*************************************************************************************************
 // Инициализация CAN2 для обмена данными с внешним контроллером "Human-machine interface"
 //*************************************************************************************************
 void CANInit( void ) {
 
-    int32_t status;
+    int32_t status = ARM_DRIVER_ERROR;
     uint32_t i, clock;
     ARM_CAN_CAPABILITIES can_cap;
     ARM_CAN_OBJ_CAPABILITIES can_obj_cap;
     
-    //семафор ожидания завершения передачи одного фрэйма
-    can_semaph = osSemaphoreNew( 1, 0, &sem_attr );
+    //очередь передачи пакетов
+    mutex_tx = osMutexNew( &mutex_attr );
+    can_event = osEventFlagsNew( &evn_attr );
+    mutex_flt = osMutexNew( &mutex_flt_attr );
+    //таблица выбора обработчиков команд
+    CanCmdBuild();
+    //подписка HMI на данные уст-в
+    CanDataInit();
     //очередь сообщений
     hmi_msg = osMessageQueueNew( 128, sizeof( uint32_t ), &que1_attr );
     cmd_msg = osMessageQueueNew( 64, sizeof( MSGQUEUE_CAN ), &que2_attr );
@@ -163,25 +268,25 @@ void CANInit( void ) {
         return; //инициализация не выполнена
     //определение ID объектов сообщений
     rx_obj_idx = 0xFFFFFFFFU;
-    tx_obj_idx = 0xFFFFFFFFU;
     for ( i = 0; i < can_cap.num_objects; i++ ) {
         //поиск первого доступного объекта для приема
         can_obj_cap = CanDrv->ObjectGetCapabilities( i );
         if ( ( rx_obj_idx == 0xFFFFFFFFU ) && ( can_obj_cap.rx == 1 ) )
             rx_obj_idx = i;
-        //поиск первого доступного объекта для передачи
-        else if ( ( tx_obj_idx == 0xFFFFFFFFU ) && ( can_obj_cap.tx == 1 ) ) { 
-                tx_obj_idx = i; 
-                break; 
-               }
+        //все доступные объекты для передачи (буферы TX1-TX3)
+        else if ( ( tx_obj_cnt < CAN_TX_OBJ ) && ( can_obj_cap.tx == 1 ) )
+            tx_obj_idx[tx_obj_cnt++] = i; 
        }
-    if ( ( rx_obj_idx == 0xFFFFFFFFU ) || ( tx_obj_idx == 0xFFFFFFFFU ) )
+    if ( ( rx_obj_idx == 0xFFFFFFFFU ) || !tx_obj_cnt )
         return; //доступных объектов нет
     //конфигурация найденых объектов прием/передача/фильт
-    CanDrv->ObjectConfigure( tx_obj_idx, ARM_CAN_OBJ_TX );
+    for ( i = 0; i < tx_obj_cnt; i++ ) {
+        tx_pend[i] = CAN_TX_FREE;
+        CanDrv->ObjectConfigure( tx_obj_idx[i], ARM_CAN_OBJ_TX );
+       }
     CanDrv->ObjectConfigure( rx_obj_idx, ARM_CAN_OBJ_RX );
-    //для установки фильтра с учетом 29-битного идентификаторов необходимо добавить атрибут ARM_CAN_ID_IDE_Msk 
-    CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_RANGE_ADD, 0 | ARM_CAN_ID_IDE_Msk, CAN_FILTER_RANGE );
+    //таблица фильтра: принимаются только обрабатываемые команды и запросы данных
+    CanFilterApply();
     CanDrv->SetMode( ARM_CAN_MODE_NORMAL ); 
     //настройка прерывания
     NVIC_SetPriority( CAN_IRQn, NVIC_EncodePriority( NVIC_GetPriorityGrouping(), PRIORITY_SSP, SUB_PRIORITY_CAN ) );
@@ -189,6 +294,7 @@ void CANInit( void ) {
 
 //*************************************************************************************************
 // Задача управления передачи данных контроллеру HMI по протоколу CAN
+// Данные уст-в передаются по готовности (сообщения задач уст-в) и периодически по подписке HMI
 //*************************************************************************************************
 static void TaskHmi( void *pvParameters ) {
 
@@ -196,12 +302,13 @@ static void TaskHmi( void *pvParameters ) {
     osStatus_t status;
     
     for ( ;; ) {
-        status = osMessageQueueGet( hmi_msg, &msg, NULL, osWaitForever );
+        status = osMessageQueueGet( hmi_msg, &msg, NULL, CanDataWait() );
         if ( status == osOK ) {
             if ( msg == ID_DEV_MODBUS_ANS )
                 CANMbusAnswer(); //передача ответа на запрос по MODBUS
             else DevDataSend( msg ); //передача данных по уст-м
            }
+        CanDataPublish(); //периодическая передача по подписке
        }
  }
 
@@ -225,6 +332,7 @@ static void TaskCmd( void *pvParameters ) {
 //*************************************************************************************************
 void CAN_SignalObjectEvent( uint32_t obj_idx, uint32_t event ) {
 
+    uint8_t i;
     uint32_t send, id;
     MSGQUEUE_CAN que_cmd;
     
@@ -233,13 +341,18 @@ void CAN_SignalObjectEvent( uint32_t obj_idx, uint32_t event ) {
             //принятые данные помещаем в очередь на исполнение
             CanDrv->MessageRead( rx_obj_idx, &rx_msg_info, rx_data, sizeof( rx_data ) );
             id = CAN_GET_DEV_ID( ( rx_msg_info.id & CAN_MASK_DEV_ID ) );
-            if ( id == ID_CONFIG && rx_msg_info.rtr == 1 ) {
-                //запрос на передачу параметров настроек в HMI
-                send = ID_CONFIG; 
+            if ( rx_msg_info.rtr == 1 ) {
+                //запрос на передачу всех пакетов уст-ва (ID_DEV_NULL - всех уст-в) в HMI
+                send = id | CAN_DATA_KEYFRAME; 
                 osMessageQueuePut( hmi_msg, &send, 0, 0 );
                 return;
                }
-            if ( id ) {
+            if ( id == ID_DEV_XFER && rx_off[id] == false ) {
+                //сегментированная передача блоков данных
+                CanXferRecv( rx_msg_info.id, rx_data, rx_msg_info.dlc );
+                return;
+               }
+            if ( id && ( id > ID_DEV_XFER || rx_off[id] == false ) ) {
                 //команды для выполнения
                 que_cmd.dev_id = (Device)CAN_GET_DEV_ID( ( rx_msg_info.id & CAN_MASK_DEV_ID ) );
                 que_cmd.param_id = (ConfigParam)CAN_GET_PARAM_ID( ( rx_msg_info.id & CAN_MASK_PARAM_ID ) );
@@ -252,140 +365,570 @@ void CAN_SignalObjectEvent( uint32_t obj_idx, uint32_t event ) {
            }
        }
     if ( event == ARM_CAN_EVENT_SEND_COMPLETE ) {
-        if ( obj_idx == tx_obj_idx ) {
-            //снимаем семафор ожидания для отправки следующего блока данных
-            osSemaphoreRelease( can_semaph );
-           }
+        //буфер передачи освободился, загружаем следующий пакет из очереди
+        for ( i = 0; i < tx_obj_cnt; i++ )
+            if ( obj_idx == tx_obj_idx[i] )
+                tx_pend[i] = CAN_TX_FREE;
+        CanTxDrain();
        }
  }
 
 //*************************************************************************************************
-// Запуск передачи одного сообщения по CAN шине
+// Добавление пакета в очередь передачи по CAN шине, вызывающая задача не блокируется
+// Пакеты одного уст-ва передаются в порядке добавления, при заполненной очереди пакет
+// не добавляется (счетчик CAN_TXSTAT_DROP)
+// CanTxPrio prio    - класс приоритета
 // uint32_t can_id   - ID сообщения
 // uint8_t *ptr_data - указатель на блок данных
 // uint8_t len_data  - размер блока данных для передачи
+// return = SUCCESS  - пакет добавлен в очередь
+//        = ERROR    - очередь заполнена, пакет не передается
 //*************************************************************************************************
-void CANSendFrame( uint32_t can_id, uint8_t *ptr_data, uint8_t len_data ) {
+Status CANSendFrame( CanTxPrio prio, uint32_t can_id, uint8_t *ptr_data, uint8_t len_data ) {
+
+    CAN_TX_FRAME *frame;
+    CAN_TX_QUEUE *queue;
 
-    //установим семафор ожидания завершения передачи
-    osSemaphoreAcquire( can_semaph, 0 );
-    memset( &tx_msg_info, 0x00, sizeof( ARM_CAN_MSG_INFO ) );
-    tx_msg_info.id = ARM_CAN_EXTENDED_ID( can_id );
-    send_stat = CanDrv->MessageSend( tx_obj_idx, &tx_msg_info, ptr_data, len_data );
-    send_pack++;
-    if ( send_stat < 0 )
-        error_send++;
-    //ждем семафор - завершение передачи предыдущего блока
-    osSemaphoreAcquire( can_semaph, osWaitForever );
+    if ( prio >= CAN_TX_CLASS || len_data > CAN_DATA_MAX )
+        return ERROR;
+    queue = &tx_queue[prio];
+    osMutexAcquire( mutex_tx, osWaitForever );
+    if ( queue->head - queue->tail >= CAN_TX_RING ) {
+        //очередь заполнена
+        if ( tx_full[prio] == false )
+            tx_stat[CAN_TXSTAT_OVERFLOW]++;
+        tx_full[prio] = true;
+        tx_stat[CAN_TXSTAT_DROP]++;
+        osMutexRelease( mutex_tx );
+        return ERROR;
+       }
+    tx_full[prio] = false;
+    frame = &queue->frame[queue->head % CAN_TX_RING];
+    frame->can_id = can_id;
+    frame->len = len_data;
+    memcpy( frame->data, ptr_data, len_data );
+    queue->head++;
+    if ( queue->head - queue->tail > tx_stat[CAN_TXSTAT_MAX] )
+        tx_stat[CAN_TXSTAT_MAX] = queue->head - queue->tail;
+    //запуск передачи, если есть свободные буферы
+    NVIC_DisableIRQ( CAN_IRQn );
+    CanTxDrain();
+    NVIC_EnableIRQ( CAN_IRQn );
+    osMutexRelease( mutex_tx );
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Ожидание завершения передачи всех пакетов из очереди
+// uint32_t timeout - время ожидания (msec)
+// return = SUCCESS - все пакеты переданы
+//        = ERROR   - время ожидания истекло
+//*************************************************************************************************
+Status CANFlush( uint32_t timeout ) {
+
+    osEventFlagsClear( can_event, CAN_EVN_TX_IDLE );
+    osMutexAcquire( mutex_tx, osWaitForever );
+    NVIC_DisableIRQ( CAN_IRQn );
+    CanTxDrain();
+    NVIC_EnableIRQ( CAN_IRQn );
+    osMutexRelease( mutex_tx );
+    if ( osEventFlagsWait( can_event, CAN_EVN_TX_IDLE, osFlagsWaitAny, timeout ) & osFlagsError )
+        return ERROR;
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Загрузка пакетов из очереди во все свободные буферы передачи
+// Вызывается из прерывания CAN или из задачи при захваченном mutex_tx и запрещенном прерывании CAN,
+// mutex_tx исключает разрешение прерывания другой задачей до завершения загрузки
+//*************************************************************************************************
+static void CanTxDrain( void ) {
+
+    uint8_t obj;
+    CanTxPrio prio;
+    CAN_TX_FRAME *frame;
+
+    for ( obj = 0; obj < tx_obj_cnt; obj++ ) {
+        if ( tx_pend[obj] != CAN_TX_FREE )
+            continue;
+        frame = CanTxNext( &prio );
+        if ( frame == NULL )
+            break;
+        tx_pend[obj] = CAN_GET_DEV_ID( frame->can_id );
+        memset( &tx_msg_info, 0x00, sizeof( ARM_CAN_MSG_INFO ) );
+        tx_msg_info.id = ARM_CAN_EXTENDED_ID( frame->can_id );
+        send_stat = CanDrv->MessageSend( tx_obj_idx[obj], &tx_msg_info, frame->data, frame->len );
+        tx_queue[prio].tail++;
+        send_pack++;
+        if ( send_stat < 0 ) {
+            error_send++;
+            tx_pend[obj] = CAN_TX_FREE;
+           }
+       }
+    //проверка завершения передачи всех пакетов
+    for ( obj = 0; obj < tx_obj_cnt; obj++ )
+        if ( tx_pend[obj] != CAN_TX_FREE )
+            return;
+    for ( prio = CAN_TX_HIGH; prio < CAN_TX_CLASS; prio++ )
+        if ( tx_queue[prio].head != tx_queue[prio].tail )
+            return;
+    osEventFlagsSet( can_event, CAN_EVN_TX_IDLE );
+ }
+
+//*************************************************************************************************
+// Выбор следующего пакета для передачи: первый пакет очереди с наибольшим приоритетом, уст-во
+// которого не имеет пакета в буферах передачи. Контроллер CAN выбирает для передачи буфер с
+// меньшим ID пакета, поэтому в буферах одновременно находится не более одного пакета уст-ва
+// CanTxPrio *prio      - класс приоритета выбранного пакета
+// return CAN_TX_FRAME* - указатель на пакет, NULL - пакетов для передачи нет
+//*************************************************************************************************
+static CAN_TX_FRAME *CanTxNext( CanTxPrio *prio ) {
+
+    uint8_t obj;
+    uint32_t dev_id;
+    CAN_TX_FRAME *frame;
+
+    for ( *prio = CAN_TX_HIGH; *prio < CAN_TX_CLASS; (*prio)++ ) {
+        if ( tx_queue[*prio].head == tx_queue[*prio].tail )
+            continue;
+        frame = &tx_queue[*prio].frame[tx_queue[*prio].tail % CAN_TX_RING];
+        dev_id = CAN_GET_DEV_ID( frame->can_id );
+        for ( obj = 0; obj < tx_obj_cnt; obj++ )
+            if ( tx_pend[obj] == dev_id )
+                break;
+        if ( obj == tx_obj_cnt )
+            return frame;
+       }
+    return NULL;
+ }
+
+//*************************************************************************************************
+// Возвращает значение счетчика очереди передачи
+// CanTxStat type  - тип счетчика
+// return uint32_t - значение счетчика
+//*************************************************************************************************
+uint32_t CANTxStat( CanTxStat type ) {
+
+    if ( type >= CAN_TXSTAT_CNT )
+        return 0;
+    return tx_stat[type];
+ }
+
+//*************************************************************************************************
+// Возвращает кол-во свободных мест в очереди передачи класса приоритета
+// CanTxPrio prio  - класс приоритета
+// return uint32_t - кол-во пакетов которые можно добавить в очередь
+//*************************************************************************************************
+uint32_t CANTxFree( CanTxPrio prio ) {
+
+    if ( prio >= CAN_TX_CLASS )
+        return 0;
+    return CAN_TX_RING - ( tx_queue[prio].head - tx_queue[prio].tail );
+ }
+
+//*************************************************************************************************
+// Включение/выключение приема команд уст-ва, таблица фильтра загружается повторно
+// Device dev       - ID уст-ва
+// bool enable      - true - команды уст-ва принимаются
+// return = SUCCESS - таблица фильтра загружена
+//        = ERROR   - ошибка загрузки таблицы, принимаются все пакеты
+//*************************************************************************************************
+Status CANFilterDev( Device dev, bool enable ) {
+
+    Status stat;
+
+    if ( dev > ID_DEV_XFER || mutex_flt == NULL )
+        return ERROR;
+    osMutexAcquire( mutex_flt, osWaitForever );
+    rx_off[dev] = enable == true ? false : true;
+    stat = CanFilterApply();
+    osMutexRelease( mutex_flt );
+    return stat;
+ }
+
+//*************************************************************************************************
+// Возвращает состояние приема команд уст-ва
+// Device dev    - ID уст-ва
+// return = true - команды уст-ва принимаются
+//*************************************************************************************************
+bool CANFilterDevStat( Device dev ) {
+
+    if ( dev > ID_DEV_XFER )
+        return false;
+    return rx_off[dev] == true ? false : true;
+ }
+
+//*************************************************************************************************
+// Возвращает указатель на загруженную таблицу фильтра
+// return = NULL - таблица не загружена, принимаются все пакеты
+//*************************************************************************************************
+CAN_AF_TABLE *CANFilterTable( void ) {
+
+    if ( af_bypass == true )
+        return NULL;
+    return &af_table;
+ }
+
+//*************************************************************************************************
+// Формирование и загрузка таблицы фильтра приема
+// При ошибке загрузки фильтр настраивается на прием всех пакетов, отбор команд выполняется
+// программно в ExecCommand()
+// return = SUCCESS - таблица фильтра загружена
+//        = ERROR   - ошибка загрузки таблицы
+//*************************************************************************************************
+static Status CanFilterApply( void ) {
+
+    CAN_AF_TABLE af;
+
+    CanFilterBuild( &af );
+    if ( af_bypass == true ) {
+        CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_RANGE_REMOVE, ARM_CAN_EXTENDED_ID( 0 ), CAN_FILTER_RANGE );
+        CanAfClear( &af_table );
+        af_bypass = false;
+       }
+    if ( CanFilterLoad( &af ) == SUCCESS ) {
+        memcpy( &af_table, &af, sizeof( af_table ) );
+        return SUCCESS;
+       }
+    //состояние таблицы фильтра неизвестно, удаляем все записи
+    CanFilterUnload( &af );
+    CanFilterUnload( &af_table );
+    CanAfClear( &af_table );
+    CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_RANGE_ADD, ARM_CAN_EXTENDED_ID( 0 ), CAN_FILTER_RANGE );
+    af_bypass = true;
+    return ERROR;
+ }
+
+//*************************************************************************************************
+// Формирование таблицы фильтра по описанию команд принимаемых от HMI
+// Для каждого уст-ва принимается ID без параметра и пакета - запрос RTR передачи данных уст-ва
+// (ID_DEV_NULL - данных всех уст-в), аппаратный фильтр тип пакета (RTR/данные) не различает
+// CAN_AF_TABLE *af - таблица фильтра
+//*************************************************************************************************
+static void CanFilterBuild( CAN_AF_TABLE *af ) {
+
+    uint8_t ind;
+    uint32_t lower;
+
+    CanAfClear( af );
+    for ( ind = 0; ind < SIZE_ARRAY( can_cmd ); ind++ ) {
+        if ( rx_off[can_cmd[ind].dev_id] == true )
+            continue;
+        lower = CAN_DEV_ID( (uint32_t)can_cmd[ind].dev_id );
+        if ( can_cmd[ind].param_id == CAN_CMD_ANY )
+            CanAfAddGroup( af, lower, lower | CAN_RANGE_DEV );
+        else {
+            lower |= CAN_PARAM_ID( (uint32_t)can_cmd[ind].param_id );
+            CanAfAddGroup( af, lower, lower | CAN_RANGE_CMD );
+           }
+       }
+    for ( ind = ID_DEV_NULL; ind <= ID_DEV_LOG; ind++ )
+        CanAfAddExact( af, CAN_DEV_ID( (uint32_t)ind ) );
+ }
+
+//*************************************************************************************************
+// Загрузка таблицы в аппаратный фильтр, изменяются только отличающиеся записи
+// CAN_AF_TABLE *af - новая таблица фильтра
+// return = SUCCESS - таблица загружена
+//        = ERROR   - ошибка драйвера
+//*************************************************************************************************
+static Status CanFilterLoad( CAN_AF_TABLE *af ) {
+
+    uint8_t ind;
+    Status stat = SUCCESS;
+
+    //удаление записей отсутствующих в новой таблице
+    for ( ind = 0; ind < af_table.exact_cnt; ind++ )
+        if ( AfExact( af, af_table.exact[ind] ) == false && 
+             CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_EXACT_REMOVE, ARM_CAN_EXTENDED_ID( af_table.exact[ind] ), 0 ) != ARM_DRIVER_OK )
+            stat = ERROR;
+    for ( ind = 0; ind < af_table.group_cnt; ind++ )
+        if ( AfGroup( af, af_table.lower[ind], af_table.upper[ind] ) == false && 
+             CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_RANGE_REMOVE, ARM_CAN_EXTENDED_ID( af_table.lower[ind] ), af_table.upper[ind] ) != ARM_DRIVER_OK )
+            stat = ERROR;
+    //добавление новых записей
+    for ( ind = 0; ind < af->exact_cnt; ind++ )
+        if ( AfExact( &af_table, af->exact[ind] ) == false && 
+             CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_EXACT_ADD, ARM_CAN_EXTENDED_ID( af->exact[ind] ), 0 ) != ARM_DRIVER_OK )
+            stat = ERROR;
+    for ( ind = 0; ind < af->group_cnt; ind++ )
+        if ( AfGroup( &af_table, af->lower[ind], af->upper[ind] ) == false && 
+             CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_RANGE_ADD, ARM_CAN_EXTENDED_ID( af->lower[ind] ), af->upper[ind] ) != ARM_DRIVER_OK )
+            stat = ERROR;
+    return stat;
+ }
+
+//*************************************************************************************************
+// Удаление всех записей таблицы из аппаратного фильтра, ошибки драйвера не учитываются
+// CAN_AF_TABLE *af - таблица фильтра
+//*************************************************************************************************
+static void CanFilterUnload( CAN_AF_TABLE *af ) {
+
+    uint8_t ind;
+
+    for ( ind = 0; ind < af->exact_cnt; ind++ )
+        CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_EXACT_REMOVE, ARM_CAN_EXTENDED_ID( af->exact[ind] ), 0 );
+    for ( ind = 0; ind < af->group_cnt; ind++ )
+        CanDrv->ObjectSetFilter( rx_obj_idx, ARM_CAN_FILTER_ID_RANGE_REMOVE, ARM_CAN_EXTENDED_ID( af->lower[ind] ), af->upper[ind] );
+ }
+
+//*************************************************************************************************
+// Проверка наличия отдельного ID в таблице фильтра
+// CAN_AF_TABLE *af - таблица фильтра
+// uint32_t id      - ID пакета
+// return = true    - ID есть в таблице
+//*************************************************************************************************
+static bool AfExact( CAN_AF_TABLE *af, uint32_t id ) {
+
+    uint8_t ind;
+
+    for ( ind = 0; ind < af->exact_cnt; ind++ )
+        if ( af->exact[ind] == id )
+            return true;
+    return false;
+ }
+
+//*************************************************************************************************
+// Проверка наличия диапазона ID в таблице фильтра
+// CAN_AF_TABLE *af - таблица фильтра
+// uint32_t lower   - нижняя граница диапазона
+// uint32_t upper   - верхняя граница диапазона
+// return = true    - диапазон есть в таблице
+//*************************************************************************************************
+static bool AfGroup( CAN_AF_TABLE *af, uint32_t lower, uint32_t upper ) {
+
+    uint8_t ind;
+
+    for ( ind = 0; ind < af->group_cnt; ind++ )
+        if ( af->lower[ind] == lower && af->upper[ind] == upper )
+            return true;
+    return false;
+ }
+
+//*************************************************************************************************
+// Формирование таблицы выбора обработчика команды по описанию команд
+// Обработчик отдельного ID параметра имеет приоритет над обработчиком CAN_CMD_ANY
+//*************************************************************************************************
+static void CanCmdBuild( void ) {
+
+    uint8_t ind, param;
+
+    memset( cmd_tab, 0x00, sizeof( cmd_tab ) );
+    for ( ind = 0; ind < SIZE_ARRAY( can_cmd ); ind++ ) {
+        if ( can_cmd[ind].dev_id > ID_DEV_XFER )
+            continue;
+        if ( can_cmd[ind].param_id < CAN_CMD_PARAM ) {
+            cmd_tab[can_cmd[ind].dev_id][can_cmd[ind].param_id] = ind + 1;
+            continue;
+           }
+        if ( can_cmd[ind].param_id != CAN_CMD_ANY )
+            continue;
+        for ( param = 0; param <= CAN_CMD_PARAM; param++ )
+            if ( !cmd_tab[can_cmd[ind].dev_id][param] )
+                cmd_tab[can_cmd[ind].dev_id][param] = ind + 1;
+       }
  }
 
 //*************************************************************************************************
 // Обработка команды полученной по CAN шине
+// Обработчик выбирается по таблице cmd_tab, команды с размером данных меньше заданного
+// в описании не выполняются, все команды сохраняются в логе
 // MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
 //*************************************************************************************************
 static void ExecCommand( MSGQUEUE_CAN *que_cmd ) {
 
+    uint8_t ind = 0;
+
+    if ( que_cmd->dev_id <= ID_DEV_XFER )
+        ind = cmd_tab[que_cmd->dev_id][que_cmd->param_id < CAN_CMD_PARAM ? que_cmd->param_id : CAN_CMD_PARAM];
+    if ( ind && can_cmd[ind - 1].exec != NULL && que_cmd->len_data >= can_cmd[ind - 1].len_min )
+        can_cmd[ind - 1].exec( que_cmd );
+    //сохраним команду в лог файле
+    CmdSaveLog( que_cmd );
+ }
+
+//*************************************************************************************************
+// Установка часов/календаря
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdRtc( MSGQUEUE_CAN *que_cmd ) {
+
+    RTCSet( (RTC *)que_cmd->data );
+ }
+
+//*************************************************************************************************
+// Подписка HMI на данные уст-в
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdSubscr( MSGQUEUE_CAN *que_cmd ) {
+
+    CanDataSubscr( (CAN_SUBSCR *)que_cmd->data );
+ }
+
+//*************************************************************************************************
+// Проверка контрольной суммы настроек в HMI, при несовпадении передаются все пакеты настроек
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdCfgHash( MSGQUEUE_CAN *que_cmd ) {
+
     uint32_t msg;
+    CAN_CONFIG16 cfg_hmi;
+
+    memcpy( &cfg_hmi, que_cmd->data, sizeof( cfg_hmi ) );
+    if ( cfg_hmi.hash == ConfigHash() )
+        return;
+    msg = ID_CONFIG | CAN_DATA_KEYFRAME;
+    osMessageQueuePut( hmi_msg, &msg, 0, 0 );
+ }
+
+//*************************************************************************************************
+// Управление коммутацией солнечных панелей
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdPv( MSGQUEUE_CAN *que_cmd ) {
+
     CAN_PV *can_pv;
-    uint8_t cnt_rpt;
+
+    can_pv = (CAN_PV *)que_cmd->data;
+    if ( can_pv->ctrl & CAN_PV_CTRL )
+        PvControl( can_pv->ctrl, EEPROM_SAVE );
+    if ( can_pv->ctrl & CAN_PV_MODE )
+        PvSetMode( can_pv->mode, EEPROM_SAVE );
+ }
+
+//*************************************************************************************************
+// Управление контроллером заряда PB-1000-224
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdCharger( MSGQUEUE_CAN *que_cmd ) {
+
+    Charger( (ChargeMode)*que_cmd->data, EEPROM_SAVE );
+ }
+
+//*************************************************************************************************
+// Управление инверторами TS-1000-224, TS-3000-224
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdInv( MSGQUEUE_CAN *que_cmd ) {
+
+    InvCtrl( que_cmd->dev_id, (InvCtrlCmnd)*que_cmd->data );
+ }
+
+//*************************************************************************************************
+// Управление блоком АВР
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdAlt( MSGQUEUE_CAN *que_cmd ) {
+
+    if ( (CanCtrlAlt)*que_cmd->data == CAN_ALT_DC )
+        AltPowerDC();
+    if ( (CanCtrlAlt)*que_cmd->data == CAN_ALT_AC )
+        AltPowerAC();
+ }
+
+//*************************************************************************************************
+// Управление генератором
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdGen( MSGQUEUE_CAN *que_cmd ) {
+
+    if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_STOP )
+        GenStop();
+    if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_START )
+        GenStart();
+    if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_TEST )
+        GenTest();
+ }
+
+//*************************************************************************************************
+// Управление контроллером солнечного трекера
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdTrc( MSGQUEUE_CAN *que_cmd ) {
+
+    CAN_TRC *can_trc;
+
+    can_trc = (CAN_TRC *)que_cmd->data;
+    //Управление реле питания актуаторов трекера
+    if ( can_trc->ctrl == CAN_TRC_POWER )
+        TRCMode( can_trc->power_act, EEPROM_SAVE );
+    //Управление позиционированием трекера
+    if ( can_trc->ctrl == CAN_TRC_POS )
+        TrackerSetPos( can_trc->type_act, can_trc->type_value, can_trc->value );
+    //Прервать позиционирование
+    if ( can_trc->ctrl == CAN_TRC_STOP )
+        TrackerCmd( EXTRC_STOP, 0, 0 );
+    //Переход в командный режим
+    if ( can_trc->ctrl == CAN_TRC_CMD )
+        TrackerCmd( EXTRC_CMD_ON, 0, 0 );
+    //Позиционирование по солнечному сенсору
+    if ( can_trc->ctrl == CAN_TRC_INT )
+        TrackerCmd( EXTRC_CMD_OFF, 0, 0 );
+    //Инициалзация контроллера трекера
+    if ( can_trc->ctrl == CAN_TRC_INIT )
+        TrackerCmd( EXTRC_VERT | EXTRC_HORZ, 0, 0 );
+    //Сохранить текущие значения позиционирования в EEPROM контроллера трекера
+    if ( can_trc->ctrl == CAN_TRC_SAVE )
+        TrackerCmd( EXTRC_SEEP, 0, 0 );
+    //Восстановить значения позиционирования из EEPROM контроллера трекера
+    if ( can_trc->ctrl == CAN_TRC_REST )
+        TrackerCmd( EXTRC_REEP, 0, 0 );
+    //Перезапуск контроллера трекера
+    if ( can_trc->ctrl == CAN_TRC_RESET )
+        TrackerCmd( EXTRC_RESET, 0, 0 );
+ }
+
+//*************************************************************************************************
+// Управление голосовым/звуковым информатором
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdVoice( MSGQUEUE_CAN *que_cmd ) {
+
     CAN_INFO *can_info;
+
+    can_info = (CAN_INFO *)que_cmd->data;
+    if ( can_info->ctrl & CAN_VOICE )
+        Informing( can_info->voice, NULL );
+    if ( can_info->ctrl & CAN_VOLUME )
+        SetVolume( can_info->volume );
+    if ( can_info->ctrl & CAN_SOUND )
+        SoundPlay( can_info->sound, NULL );
+ }
+
+//*************************************************************************************************
+// Управление дополнительными реле
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdReserv( MSGQUEUE_CAN *que_cmd ) {
+
     CAN_RELAY *can_rel;
+
+    can_rel = (CAN_RELAY *)que_cmd->data;
+    ReservCmnd( can_rel->relay, can_rel->mode );
+ }
+
+//*************************************************************************************************
+// Управление дополнительными выходами
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdExtOut( MSGQUEUE_CAN *que_cmd ) {
+
     CAN_EXT *can_ext;
-    RTC *datetime;
-    CAN_TRC *can_trc;
-    ConfigValSet cfg_set;
 
-    //Установка часов/календаря
-    if ( que_cmd->dev_id == ID_DEV_RTC && !que_cmd->param_id ) {
-        datetime = (RTC *)que_cmd->data;
-        RTCSet( datetime );
-       }
-    //Управление коммутацией солнечных панелей
-    if ( que_cmd->dev_id == ID_DEV_PV && !que_cmd->param_id ) {
-        can_pv = (CAN_PV *)que_cmd->data;
-        if ( can_pv->ctrl & CAN_PV_CTRL )
-            PvControl( can_pv->ctrl, EEPROM_SAVE );
-        if ( can_pv->ctrl & CAN_PV_MODE )
-            PvSetMode( can_pv->mode, EEPROM_SAVE );
-       }
-    //Управление контроллером заряда PB-1000-224
-    if ( que_cmd->dev_id == ID_DEV_CHARGER && !que_cmd->param_id )
-        Charger( (ChargeMode)*que_cmd->data, EEPROM_SAVE );
-    //Управление инверторами TS-1000-224, TS-3000-224
-    if ( que_cmd->dev_id == ID_DEV_INV1 && !que_cmd->param_id )
-        InvCtrl( ID_DEV_INV1, (InvCtrlCmnd)*que_cmd->data );
-    if ( que_cmd->dev_id == ID_DEV_INV2 && !que_cmd->param_id )
-        InvCtrl( ID_DEV_INV2, (InvCtrlCmnd)*que_cmd->data );
-    //Управление блоком АВР
-    if ( que_cmd->dev_id == ID_DEV_ALT && !que_cmd->param_id ) {
-        if ( (CanCtrlAlt)*que_cmd->data == CAN_ALT_DC )
-            AltPowerDC();
-        if ( (CanCtrlAlt)*que_cmd->data == CAN_ALT_AC )
-            AltPowerAC();
-       }
-    //Управление генератором
-    if ( que_cmd->dev_id == ID_DEV_GEN && !que_cmd->param_id ) {
-        if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_STOP )
-            GenStop();
-        if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_START )
-            GenStart();
-        if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_TEST )
-            GenTest();
-       }
-    //Управление контроллером солнечного трекера 
-    if ( que_cmd->dev_id == ID_DEV_TRC && !que_cmd->param_id ) {
-        can_trc = (CAN_TRC *)que_cmd->data;
-        //Управление реле питания актуаторов трекера
-        if ( can_trc->ctrl == CAN_TRC_POWER )
-            TRCMode( can_trc->power_act, EEPROM_SAVE );
-        //Управление позиционированием трекера
-        if ( can_trc->ctrl == CAN_TRC_POS )
-            TrackerSetPos( can_trc->type_act, can_trc->type_value, can_trc->value );
-        //Прервать позиционирование
-        if ( can_trc->ctrl == CAN_TRC_STOP )
-            TrackerCmd( EXTRC_STOP, 0, 0 );
-        //Переход в командный режим
-        if ( can_trc->ctrl == CAN_TRC_CMD )
-            TrackerCmd( EXTRC_CMD_ON, 0, 0 );
-        //Позиционирование по солнечному сенсору
-        if ( can_trc->ctrl == CAN_TRC_INT )
-            TrackerCmd( EXTRC_CMD_OFF, 0, 0 );
-        //Инициалзация контроллера трекера
-        if ( can_trc->ctrl == CAN_TRC_INIT )
-            TrackerCmd( EXTRC_VERT | EXTRC_HORZ, 0, 0 );
-        //Сохранить текущие значения позиционирования в EEPROM контроллера трекера
-        if ( can_trc->ctrl == CAN_TRC_SAVE )
-            TrackerCmd( EXTRC_SEEP, 0, 0 );
-        //Восстановить значения позиционирования из EEPROM контроллера трекера
-        if ( can_trc->ctrl == CAN_TRC_REST )
-            TrackerCmd( EXTRC_REEP, 0, 0 );
-        //Перезапуск контроллера трекера
-        if ( can_trc->ctrl == CAN_TRC_RESET )
-            TrackerCmd( EXTRC_RESET, 0, 0 );
-       }
-    //Управление голосовым/звуковым информатором
-    if ( que_cmd->dev_id == ID_DEV_VOICE && !que_cmd->param_id ) {
-        can_info = (CAN_INFO *)que_cmd->data;
-        if ( can_info->ctrl & CAN_VOICE )
-            Informing( can_info->voice, NULL );
-        if ( can_info->ctrl & CAN_VOLUME )
-            SetVolume( can_info->volume );
-        if ( can_info->ctrl & CAN_SOUND )
-            SoundPlay( can_info->sound, NULL );
-       }
-    //Управление дополнительными реле
-    if ( que_cmd->dev_id == ID_DEV_RESERV && !que_cmd->param_id ) {
-        can_rel = (CAN_RELAY *)que_cmd->data;
-        ReservCmnd( can_rel->relay, can_rel->mode );
-       }
-    //Управление дополнительными выходами
-    if ( que_cmd->dev_id == ID_DEV_EXTOUT && !que_cmd->param_id ) {
-        can_ext = (CAN_EXT *)que_cmd->data;
-        ExtOut( can_ext->relay, can_ext->mode );
-       }
-    //Обмен CAN -> MODBUS
-    //Прием первого пакета с данными
-    if ( que_cmd->dev_id == ID_DEV_MODBUS_REQ && !que_cmd->sub_pack_id ) {
+    can_ext = (CAN_EXT *)que_cmd->data;
+    ExtOut( can_ext->relay, can_ext->mode );
+ }
+
+//*************************************************************************************************
+// Обмен CAN -> MODBUS, сборка запроса из пакетов и выполнение запроса
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdModbus( MSGQUEUE_CAN *que_cmd ) {
+
+    uint32_t msg;
+    uint8_t cnt_rpt;
+
+    if ( !que_cmd->sub_pack_id ) {
         //первый пакет с MODBUS
         can_mbus_addr = (uint8_t *)&can_modbus;
         memset( (uint8_t *)&can_modbus, 0x00, sizeof( CAN_MODBUS ) );
@@ -393,76 +936,86 @@ static void ExecCommand( MSGQUEUE_CAN *que_cmd ) {
         memcpy( (uint8_t *)&can_modbus, que_cmd->data, CAN_DATA_MAX );
         if ( can_modbus.length )
             can_mbus_rest = can_modbus.length - que_cmd->len_data; //остаток байтов для приема
-        if ( !can_mbus_rest )
-            que_cmd->sub_pack_id = 1; //только один пакет, переходим на отправку запроса
-        else can_mbus_addr += que_cmd->len_data; //смещение для следующего блока
-       }
-    //Прием следующих пакетов с данными
-    if ( que_cmd->dev_id == ID_DEV_MODBUS_REQ && que_cmd->sub_pack_id ) {
-        if ( can_mbus_rest ) {
-            //принят следующий пакет
-            memcpy( can_mbus_addr, que_cmd->data, que_cmd->len_data );
-            can_mbus_rest -= que_cmd->len_data; //остаток байт для приема
+        if ( can_mbus_rest )
             can_mbus_addr += que_cmd->len_data; //смещение для следующего блока
-           }
-        if ( !can_mbus_rest ) {
-            //все пакеты приняты, формируем запрос
-            reqst.dev_addr = can_modbus.dev_addr;
-            reqst.function = can_modbus.function;
-            reqst.addr_reg = can_modbus.addr_reg;
-            reqst.cnt_reg = can_modbus.cnt_reg;
-            reqst.ptr_data = can_modbus.mbus_data;
-            reqst.ptr_lendata = &len_mbus_data;
-            cnt_rpt = CNT_REPEAT_REQST;
-            do {
-                len_mbus_data = sizeof( can_modbus.mbus_data );
-                can_modbus.answer = ModBusRequest( &reqst );
-               } while ( cnt_rpt-- && ( can_modbus.answer == MBUS_ANSWER_CRC || can_modbus.answer == MBUS_ANSWER_TIMEOUT ) );
-            //к размеру принятых данных добавим минимальный размер пакета с ответом
-            can_modbus.length = len_mbus_data + CAN_DATA_MBUS_MIN;
-            //отправка ответа на запрос MODBUS
-            msg = ID_DEV_MODBUS_ANS;
-            osMessageQueuePut( hmi_msg, &msg, 0, 0 );               
-           }
        }
-    //сохраним команду в лог файле
-    CmdSaveLog( que_cmd );
-    //Установка значения параметра настройки
-    if ( que_cmd->dev_id == ID_CONFIG ) {
-        memset( &cfg_set, 0x00, sizeof( cfg_set ) );
-        memcpy( &cfg_set, que_cmd->data, que_cmd->len_data );
-        //обработка значения параметра содержащегося в двух пакетах
-        if ( ( que_cmd->param_id == CFG_SCR_FILE || que_cmd->param_id == CFG_JOB_FILE || que_cmd->param_id == CFG_JOB_TEST ) && que_cmd->sub_pack_id == 0 ) {
-            //первый пакет
-            memset( str_val, 0x00, sizeof( str_val ) );
-            memcpy( str_val, cfg_set.uint8_array, sizeof( cfg_set.uint8_array ) );
-            return;
-           }
-        if ( ( que_cmd->param_id == CFG_SCR_FILE || que_cmd->param_id == CFG_JOB_FILE || que_cmd->param_id == CFG_JOB_TEST ) && que_cmd->sub_pack_id == 1 ) {
-            //второй пакет
-            memcpy( str_val + 8, cfg_set.uint8_array, sizeof( cfg_set.uint8_array ) );
-            cfg_set.ptr = str_val;
-            //проверка данных на корректность
-            if ( ConfigChkVal( que_cmd->param_id, cfg_set ) == SUCCESS ) {
-                ConfigSaveLog( que_cmd->param_id, cfg_set, SUCCESS );
-                //сохранение параметров: CFG_SCR_FILE/CFG_JOB_FILE/CFG_JOB_TEST
-                ConfigSet( que_cmd->param_id, &cfg_set );
-               }
-            else ConfigSaveLog( que_cmd->param_id, cfg_set, ERROR );
-            return;
+    else if ( can_mbus_rest ) {
+        //принят следующий пакет
+        memcpy( can_mbus_addr, que_cmd->data, que_cmd->len_data );
+        can_mbus_rest -= que_cmd->len_data; //остаток байт для приема
+        can_mbus_addr += que_cmd->len_data; //смещение для следующего блока
+       }
+    if ( can_mbus_rest )
+        return;
+    //все пакеты приняты, формируем запрос
+    reqst.dev_addr = can_modbus.dev_addr;
+    reqst.function = can_modbus.function;
+    reqst.addr_reg = can_modbus.addr_reg;
+    reqst.cnt_reg = can_modbus.cnt_reg;
+    reqst.ptr_data = can_modbus.mbus_data;
+    reqst.ptr_lendata = &len_mbus_data;
+    cnt_rpt = CNT_REPEAT_REQST;
+    do {
+        len_mbus_data = sizeof( can_modbus.mbus_data );
+        can_modbus.answer = ModBusRequestCache( &reqst, MBUS_PRIO_NORMAL, MBUS_CACHE_USE );
+       } while ( cnt_rpt-- && ( can_modbus.answer == MBUS_ANSWER_CRC || can_modbus.answer == MBUS_ANSWER_TIMEOUT ) );
+    //к размеру принятых данных добавим минимальный размер пакета с ответом
+    can_modbus.length = len_mbus_data + CAN_DATA_MBUS_MIN;
+    //отправка ответа на запрос MODBUS
+    msg = ID_DEV_MODBUS_ANS;
+    osMessageQueuePut( hmi_msg, &msg, 0, 0 );
+ }
+
+//*************************************************************************************************
+// Установка значения параметра настройки
+// MSGQUEUE_CMD *que_cmd - указатель на команду в очереди сообщений
+//*************************************************************************************************
+static void CanCmdConfig( MSGQUEUE_CAN *que_cmd ) {
+
+    uint32_t msg;
+    ConfigValSet cfg_set;
+
+    memset( &cfg_set, 0x00, sizeof( cfg_set ) );
+    memcpy( &cfg_set, que_cmd->data, que_cmd->len_data );
+    //обработка значения параметра содержащегося в двух пакетах
+    if ( ( que_cmd->param_id == CFG_SCR_FILE || que_cmd->param_id == CFG_JOB_FILE || que_cmd->param_id == CFG_JOB_TEST ) && que_cmd->sub_pack_id == 0 ) {
+        //первый пакет
+        memset( str_val, 0x00, sizeof( str_val ) );
+        memcpy( str_val, cfg_set.uint8_array, sizeof( cfg_set.uint8_array ) );
+        return;
+       }
+    if ( ( que_cmd->param_id == CFG_SCR_FILE || que_cmd->param_id == CFG_JOB_FILE || que_cmd->param_id == CFG_JOB_TEST ) && que_cmd->sub_pack_id == 1 ) {
+        //второй пакет
+        memcpy( str_val + 8, cfg_set.uint8_array, sizeof( cfg_set.uint8_array ) );
+        cfg_set.ptr = str_val;
+        //проверка данных на корректность
+        if ( ConfigChkVal( que_cmd->param_id, cfg_set ) == SUCCESS ) {
+            ConfigSaveLog( que_cmd->param_id, cfg_set, SUCCESS );
+            //сохранение параметров: CFG_SCR_FILE/CFG_JOB_FILE/CFG_JOB_TEST
+            ConfigSet( que_cmd->param_id, &cfg_set );
            }
-        if ( !que_cmd->sub_pack_id && que_cmd->len_data ) {
-            //сохранение значения параметров кроме: CFG_SCR_FILE/CFG_JOB_FILE/CFG_JOB_TEST
-            if ( ConfigChkVal( que_cmd->param_id, cfg_set ) == SUCCESS ) {
-                ConfigSaveLog( que_cmd->param_id, cfg_set, SUCCESS );
-                //сохранение параметров
-                ConfigSet( que_cmd->param_id, &cfg_set );
-               }
-            else ConfigSaveLog( que_cmd->param_id, cfg_set, ERROR );
+        else ConfigSaveLog( que_cmd->param_id, cfg_set, ERROR );
+        //передача в HMI измененных пакетов настроек и контрольной суммы
+        msg = ID_CONFIG | CAN_DATA_PERIOD;
+        osMessageQueuePut( hmi_msg, &msg, 0, 0 );
+        return;
+       }
+    if ( !que_cmd->sub_pack_id && que_cmd->len_data ) {
+        //сохранение значения параметров кроме: CFG_SCR_FILE/CFG_JOB_FILE/CFG_JOB_TEST
+        if ( ConfigChkVal( que_cmd->param_id, cfg_set ) == SUCCESS ) {
+            ConfigSaveLog( que_cmd->param_id, cfg_set, SUCCESS );
+            //сохранение параметров
+            ConfigSet( que_cmd->param_id, &cfg_set );
            }
-        if ( que_cmd->sub_pack_id == CAN_CONFIG_SAVE )
-            ConfigSave(); //сохраним параметры в EEPROM
+        else ConfigSaveLog( que_cmd->param_id, cfg_set, ERROR );
        }
+    if ( que_cmd->sub_pack_id == CAN_CONFIG_SAVE )
+        ConfigSave(); //сохраним параметры в EEPROM
+    if ( que_cmd->sub_pack_id && que_cmd->sub_pack_id != CAN_CONFIG_SAVE )
+        return;
+    //передача в HMI измененных пакетов настроек и контрольной суммы
+    msg = ID_CONFIG | CAN_DATA_PERIOD;
+    osMessageQueuePut( hmi_msg, &msg, 0, 0 );
  }
 
 //*************************************************************************************************
@@ -481,7 +1034,7 @@ static void CANMbusAnswer( void ) {
                 data_len = CAN_DATA_MAX;
             else data_len = rest;
             //отправка пакета
-            CANSendFrame( CAN_DEV_ID( ID_DEV_MODBUS_ANS ) | CAN_PACK_SUB( idx++ ), offset, data_len );
+            CANSendFrame( CAN_TX_HIGH, CAN_DEV_ID( ID_DEV_MODBUS_ANS ) | CAN_PACK_SUB( idx++ ), offset, data_len );
             //следующий блок данных для передачи
             offset += data_len;
             //остаток байт для передачи
@@ -491,7 +1044,7 @@ static void CANMbusAnswer( void ) {
     else {
         //ответ с ошибкой, отправим только код ошибки, адрес, кол-во регистров
         can_modbus.length = CAN_DATA_MBUS_MIN;
-        CANSendFrame( CAN_DEV_ID( ID_DEV_MODBUS_ANS ), (uint8_t *)&can_modbus, can_modbus.length );
+        CANSendFrame( CAN_TX_HIGH, CAN_DEV_ID( ID_DEV_MODBUS_ANS ), (uint8_t *)&can_modbus, can_modbus.length );
        }
  }
 
@@ -505,7 +1058,7 @@ ValueParam HmiGetValue( ParamHmi id_param ) {
     ValueParam value;
     ARM_CAN_STATUS can_status;
     
-    value.uint32 = NULL;
+    value.uint32 = 0;
     can_status = CanDrv->GetStatus();
     if ( id_param == HMI_LINK ) {
         if ( error_send || can_status.tx_error_count || can_status.rx_error_count )
@@ -529,23 +1082,14 @@ ValueParam HmiGetValue( ParamHmi id_param ) {
 static void CmdSaveLog( MSGQUEUE_CAN *que_cmd ) {
 
     uint8_t i;
-    FILE *cmd_log;
-    char name[40];
-
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    //открываем файл
-    sprintf( name, "\\hmi\\cmd_%s.log", RTCFileName() );
-    cmd_log = fopen( name, "a" );
-    if ( cmd_log == NULL )
-        return; //файл не открылся
-    //запишем данные
-    fprintf( cmd_log, "%s ID=0x%03X %s PAR=0x%02X %s SUB=0x%02X LEN=%u DATA=", RTCGetLog(), que_cmd->dev_id, DevName( que_cmd->dev_id ), 
-             que_cmd->param_id, ConfigName( que_cmd->param_id ), que_cmd->sub_pack_id, que_cmd->len_data );
-    for ( i = 0; i < que_cmd->len_data; i++ )
-        fprintf( cmd_log, "0x%02X ", *( que_cmd->data + i ) );
-    fprintf( cmd_log, "\r\n" );
-    fclose( cmd_log );
+    char data[sizeof( que_cmd->data ) * 5 + 1];
+
+    //данные команды
+    data[0] = '\0';
+    for ( i = 0; i < que_cmd->len_data && i < sizeof( que_cmd->data ); i++ )
+        sprintf( data + i * 5, "0x%02X ", *( que_cmd->data + i ) );
+    LogPrintf( LOG_HMI_CMD, "%s ID=0x%03X %s PAR=0x%02X %s SUB=0x%02X LEN=%u DATA=%s\r\n", RTCGetLog(), que_cmd->dev_id, DevName( que_cmd->dev_id ), 
+               que_cmd->param_id, ConfigName( que_cmd->param_id ), que_cmd->sub_pack_id, que_cmd->len_data, data );
  }
 
 //*************************************************************************************************
@@ -553,17 +1097,9 @@ static void CmdSaveLog( MSGQUEUE_CAN *que_cmd ) {
 //*************************************************************************************************
 static void ConfigSaveLog( ConfigParam id_par, ConfigValSet cfg_set, Status check ) {
 
-    FILE *cfg_log;
     const DevParam *dev_ptr;
-    char name[40], buff[40], old[40];
-
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    //открываем файл
-    sprintf( name, "\\hmi\\cfg_%s.log", RTCFileName() );
-    cfg_log = fopen( name, "a" );
-    if ( cfg_log == NULL )
-        return; //файл не открылся
+    char buff[40], old[40];
+
     dev_ptr = DevParamPtr( ID_CONFIG );
     if ( dev_ptr[id_par].subtype == STRING )
         sprintf( buff, "%s", cfg_set.ptr );
@@ -579,7 +1115,6 @@ static void ConfigSaveLog( ConfigParam id_par, ConfigValSet cfg_set, Status chec
         cfg_set.uint8_array[4], cfg_set.uint8_array[5], cfg_set.uint8_array[6], cfg_set.uint8_array[7] );
     strcpy( old, ParamGetForm( ID_CONFIG, id_par, PARAM_VALUE ) );
     if ( check == SUCCESS )
-        fprintf( cfg_log, "%s %s: новый: %s, текущий: %s\r\n", RTCGetLog(), ParamGetForm( ID_CONFIG, id_par, PARAM_DESC ), buff, old );
-    else fprintf( cfg_log, "%s %s: %s - %s", RTCGetLog(), ParamGetForm( ID_CONFIG, id_par, PARAM_DESC ), buff, Message( CONS_MSG_ERR_PARAM ) );
-    fclose( cfg_log );
+        LogPrintf( LOG_HMI_CFG, "%s %s: новый: %s, текущий: %s\r\n", RTCGetLog(), ParamGetForm( ID_CONFIG, id_par, PARAM_DESC ), buff, old );
+    else LogPrintf( LOG_HMI_CFG, "%s %s: %s - %s", RTCGetLog(), ParamGetForm( ID_CONFIG, id_par, PARAM_DESC ), buff, Message( CONS_MSG_ERR_PARAM ) );
  }
@@ -4,19 +4,43 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <lpc_types.h>
 
 #include "device.h"
 #include "dev_param.h"
+#include "can_filter.h"
+
+//Классы приоритета передачи пакетов, пакеты уст-ва всегда передаются в одном классе
+typedef enum {
+    CAN_TX_HIGH,                            //события, ответы на запросы MODBUS
+    CAN_TX_NORMAL,                          //данные уст-в
+    CAN_TX_LOW,                             //параметры настроек
+    CAN_TX_CLASS                            //кол-во классов
+ } CanTxPrio;
+
+//Счетчики очереди передачи
+typedef enum {
+    CAN_TXSTAT_DROP,                        //пакетов не добавлено в заполненную очередь
+    CAN_TXSTAT_OVERFLOW,                    //кол-во переполнений очереди
+    CAN_TXSTAT_MAX,                         //макс кол-во пакетов в очереди одного класса
+    CAN_TXSTAT_CNT                          //кол-во счетчиков
+ } CanTxStat;
 
 //*************************************************************************************************
 // Функции управления
 //*************************************************************************************************
 void CANInit( void );
-void CANSendFrame( uint32_t can_id, uint8_t *ptr_data, uint8_t len_data );
+Status CANSendFrame( CanTxPrio prio, uint32_t can_id, uint8_t *ptr_data, uint8_t len_data );
+Status CANFlush( uint32_t timeout );
+Status CANFilterDev( Device dev, bool enable );
 
 //*************************************************************************************************
 // Функции статуса/состояния
 //*************************************************************************************************
 ValueParam HmiGetValue( ParamHmi id_param );
+uint32_t CANTxStat( CanTxStat type );
+uint32_t CANTxFree( CanTxPrio prio );
+bool CANFilterDevStat( Device dev );
+CAN_AF_TABLE *CANFilterTable( void );
 
 #endif
@@ -27,10 +27,13 @@
 #include "charger.h"
 #include "modbus.h"
 #include "sdcard.h"
+#include "logger.h"
 #include "outinfo.h"
 #include "command.h"
 #include "informing.h"
 #include "modbus_def.h"
+#include "modbus_poll.h"
+#include "modbus_plan.h"
 #include "events.h"
 #include "voice_ext.h"
 
@@ -43,6 +46,8 @@ osEventFlagsId_t info_event = NULL;
 //*************************************************************************************************
 // Локальные константы
 //*************************************************************************************************
+#define VOICE_POLL_PERIOD       1000        //период опроса состояния голосового информатора (msec)
+
 typedef struct {               
     VoiceId id_info;                        //ID сообщения
     char    name_info[20];                  //имя сообщения
@@ -89,6 +94,8 @@ static const INFO info[] = {
 //*************************************************************************************************
 static uint8_t level_vol = 1;
 static osTimerId_t timer1_info, timer2_info, timer3_info;
+static ModBusError voice_poll_stat = MBUS_ANSWER_OK;
+static uint16_t voice_poll_data[EXVOI_REG_RD_MAX];
 
 //*************************************************************************************************
 // Атрибуты объектов RTOS
@@ -115,6 +122,11 @@ static void TaskInforming( void *pvParameters );
 static void Timer1Callback( void *arg );
 static void Timer2Callback( void *arg );
 static void Timer3Callback( void *arg );
+static void VoicePollDone( ModBusError status, void *arg );
+
+//запись циклического опроса состояния голосового информатора
+static const MBUS_POLL voice_poll = { MB_ID_DEV_VOICE, EXVOI_REG_RD_STAT, EXVOI_REG_RD_MAX, voice_poll_data, 
+                                      VOICE_POLL_PERIOD, VOICE_POLL_PERIOD, MBUS_PRIO_LOW, VoicePollDone, NULL };
 
 //*************************************************************************************************
 // Инициализация
@@ -129,6 +141,8 @@ void VoiceInit( void ) {
     timer3_info = osTimerNew( Timer3Callback, osTimerPeriodic, NULL, &timer3_attr );
     //создаем задачу
     osThreadNew( TaskInforming, NULL, &info_attr );
+    //циклический опрос состояния информатора
+    ModBusPollAdd( &voice_poll );
  }
 
 //*************************************************************************************************
@@ -147,8 +161,8 @@ static void TaskInforming( void *pvParameters ) {
         if ( !osTimerIsRunning( timer3_info ) )
             osTimerStart( timer3_info, _TIME_INFO_TTGO * MIN_TO_TICK );
         event = osEventFlagsWait( info_event, EVN_INFO_MASK, osFlagsWaitAny, osWaitForever );
-        if ( event & EVN_RTC_SECONDS )
-            DevVoice(); //запрос состояния голосового информатора
+        if ( event & EVN_INFO_POLL )
+            DevVoice(); //обработка состояния голосового информатора
         if ( event & EVN_RTC_5MINUTES )
             MainSetVolume(); //установка громкости
         if ( event & EVN_INFO_BAT ) {
@@ -196,6 +210,15 @@ static void Timer3Callback( void *arg ) {
     osEventFlagsSet( info_event, EVN_INFO_TTG );
  }
 
+//*************************************************************************************************
+// Функция обратного вызова планировщика опроса - состояние информатора прочитано
+//*************************************************************************************************
+static void VoicePollDone( ModBusError status, void *arg ) {
+
+    voice_poll_stat = status;
+    osEventFlagsSet( info_event, EVN_INFO_POLL );
+ }
+
 //*************************************************************************************************
 // Формируем список воспроизведения для голосового информатора
 // VoiceId id_info    - ID сообщения, если ID > 0 - параметр name_info игнорируется
@@ -204,12 +227,12 @@ static void Timer3Callback( void *arg ) {
 //*************************************************************************************************
 ModBusError Informing( VoiceId id_info, char *name_info ) {
 
-    uint8_t i, cnt_rpt;
+    uint8_t i;
     bool limit = false;
+    MBUS_PLAN plan;
+    uint16_t cnt_reg = 4;
     uint16_t voice_data[EXVOI_REG_WR_MAX];
-    uint16_t len = sizeof( voice_data );
     ModBusError status = MBUS_ERROR_PARAM;
-    MBUS_REQUEST reqst = { MB_ID_DEV_VOICE, FUNC_WR_MULT_REG, EXVOI_REG_WR_CMD, 4, &voice_data, &len };
 
     if ( !id_info && strlen( name_info ) < 3 && name_info == NULL )
         return MBUS_ERROR_PARAM;
@@ -242,14 +265,14 @@ ModBusError Informing( VoiceId id_info, char *name_info ) {
     voice_data[EXVOI_REG_WR_PAR2] = info[i].id_info; //основное сообщение
     //определение значения параметров для голосового информатора
     if ( info[i].id_info == VOICE_LOW_CHARGE || info[i].id_info == VOICE_LEVEL_CHARGE ) {
-        reqst.cnt_reg = 5; //количество регистров данных для уровня зарядки
+        cnt_reg = 5; //количество регистров данных для уровня зарядки
         //проверка на допустимые значения SOC <= 100%
         if ( batmon.soc > 100 )
             limit = true;
         voice_data[EXVOI_REG_WR_PAR3] = EXVOI_PAR_PERCENT | (uint16_t)batmon.soc;
        }
     if ( info[i].id_info == VOICE_POWER_INV ) { 
-        reqst.cnt_reg = 6; //количество регистров данных для мощности нагрузки
+        cnt_reg = 6; //количество регистров данных для мощности нагрузки
         //проверка на допустимые значения, нагрузка инверторов <= 100%
         if ( inv1.power_perc > 100 || inv2.power_perc > 100 )
             limit = true;
@@ -257,7 +280,7 @@ ModBusError Informing( VoiceId id_info, char *name_info ) {
         voice_data[EXVOI_REG_WR_PAR4] = EXVOI_PAR_PERCENT | (uint16_t)inv2.power_perc;
        }
     if ( info[i].id_info == VOICE_TTGO ) {
-        reqst.cnt_reg = 6; //количество регистров данных для продолжительности работы
+        cnt_reg = 6; //количество регистров данных для продолжительности работы
         //проверка на допустимые значения продолжительности работы <= 100%
         if ( BatMonTTG( BATMON_TTG_HOUR ) > 100 )
             limit = true;
@@ -266,41 +289,33 @@ ModBusError Informing( VoiceId id_info, char *name_info ) {
         voice_data[EXVOI_REG_WR_PAR4] = EXVOI_PAR_MINUTES | (uint16_t)BatMonTTG( BATMON_TTG_HOUR );
        }
     if ( info[i].id_info == VOICE_TS_START ) {
-        reqst.cnt_reg = 5; //количество регистров данных для времени вкл инверторов
+        cnt_reg = 5; //количество регистров данных для времени вкл инверторов
         voice_data[EXVOI_REG_WR_PAR3] = EXVOI_PAR_MINUTES | SecToIntMinutes( alt.timer_delay );
        }
     EventLog( voice_data, limit );
-    if ( limit == false ) //воспроизвести сообщение если значение не превышает допустимые пределы
-        cnt_rpt = CNT_REPEAT_REQST;
-        do {
-            reqst.ptr_lendata = &len;
-            status = ModBusRequest( &reqst );
-           } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+    if ( limit == false ) {
+        //воспроизвести сообщение если значение не превышает допустимые пределы
+        ModBusPlanInit( &plan, MB_ID_DEV_VOICE );
+        ModBusPlanWrite( &plan, EXVOI_REG_WR_CMD, cnt_reg, voice_data );
+        status = ModBusPlanExec( &plan, MBUS_PRIO_NORMAL );
+       }
     return status;
  }
 
 //*************************************************************************************************
-// Запрос состояния голосового информатора
-// Выполняется с интервалом 1 секунда
+// Обработка состояния голосового информатора прочитанного планировщиком опроса
+// Выполняется с интервалом VOICE_POLL_PERIOD
 //*************************************************************************************************
 static void DevVoice( void ) {
 
-    uint8_t cnt_rpt;
-    ModBusError status;
-    uint16_t reg_data[2];
-    uint16_t len = sizeof( reg_data );
-    MBUS_REQUEST reqst = { MB_ID_DEV_VOICE, FUNC_RD_HOLD_REG, EXVOI_REG_RD_STAT, 2, &reg_data, &len };
-
-    cnt_rpt = CNT_REPEAT_REQST;
-    do {
-        len = sizeof( reg_data );
-        status = ModBusRequest( &reqst );
-       } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
-    if ( status == MBUS_ANSWER_OK ) {
+    uint16_t voice_data[EXVOI_REG_RD_MAX];
+
+    if ( voice_poll_stat == MBUS_ANSWER_OK ) {
         //голосовой информатор подключен
+        ModBusPollData( &voice_poll, voice_data );
         voice.link = LINK_CONN_OK;
-        voice.stat = reg_data[EXVOI_REG_RD_STAT];
-        voice.volume = (Volume)reg_data[EXVOI_REG_RD_VOLUME];
+        voice.stat = voice_data[EXVOI_REG_RD_STAT];
+        voice.volume = (Volume)voice_data[EXVOI_REG_RD_VOLUME];
        }
     else {
         //голосовой информатор не отвечает
@@ -318,11 +333,8 @@ static void DevVoice( void ) {
 //*************************************************************************************************
 ModBusError SetVolume( Volume volume ) {
 
-    uint8_t cnt_rpt;
+    MBUS_PLAN plan;
     uint16_t reg_data[2];
-    ModBusError status;
-    uint16_t len = sizeof( reg_data );
-    MBUS_REQUEST reqst = { MB_ID_DEV_VOICE, FUNC_WR_MULT_REG, EXVOI_REG_WR_CMD, 2, &reg_data, &len };
 
     if ( voice.link == LINK_CONN_NO )
         return MBUS_CONNECT_LOST; //уст-ва нет в сети
@@ -331,12 +343,9 @@ ModBusError SetVolume( Volume volume ) {
     reg_data[EXVOI_REG_WR_CMD] = EXVOI_CMD_VOLUME;      //команда установки громкости
     reg_data[EXVOI_REG_WR_VOLUME] = level_vol = volume; //значение уровня громкости
     //отправка команды установки громкости
-    cnt_rpt = CNT_REPEAT_REQST;
-    do {
-        len = sizeof( reg_data );
-        status = ModBusRequest( &reqst );
-       } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
-    return status;
+    ModBusPlanInit( &plan, MB_ID_DEV_VOICE );
+    ModBusPlanWrite( &plan, EXVOI_REG_WR_CMD, 2, reg_data );
+    return ModBusPlanExec( &plan, MBUS_PRIO_NORMAL );
  }
 
 //*************************************************************************************************
@@ -389,20 +398,8 @@ static Volume GetVolume( void ) {
 //*************************************************************************************************
 static void EventLog( uint16_t *data, bool limit ) {
 
-    char name[40];
-    FILE *log;
-    
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    if ( !config.mode_logging )
-        sprintf( name, "\\voice\\voice_%s.log", RTCFileName() );
-    else sprintf( name, "\\voice\\%s\\voice_%s.log", RTCFileShort(), RTCFileName() );
-    log = fopen( name, "a" );
-    if ( log == NULL )
-        return; //файл не открылся
-    fprintf( log, "%s LINK = %s, CMD = 0x%04X, PAR = %u %u %u 0x%04X/%u 0x%04X/%u %s\r\n", RTCGetLog(), voice.link ? "YES":"NO", 
+    LogPrintf( LOG_VOICE, "%s LINK = %s, CMD = 0x%04X, PAR = %u %u %u 0x%04X/%u 0x%04X/%u %s\r\n", RTCGetLog(), voice.link ? "YES":"NO", 
             data[EXVOI_REG_WR_CMD], data[EXVOI_REG_WR_VOLUME], data[EXVOI_REG_WR_PAR1], data[EXVOI_REG_WR_PAR2], 
             data[EXVOI_REG_WR_PAR3] & EXVOI_PAR_TYPE, data[EXVOI_REG_WR_PAR3] & EXVOI_PAR_VALUE,
             data[EXVOI_REG_WR_PAR4] & EXVOI_PAR_TYPE, data[EXVOI_REG_WR_PAR4] & EXVOI_PAR_VALUE, limit ? "LIMIT PARAM":"" ); 
-    fclose( log );
  }
@@ -0,0 +1,574 @@
+
+//*************************************************************************************************
+//
+// Запись протоколов на SD карту
+// Строки протоколов помещаются в кольцевой буфер без обращения к SD карте, задача с низким
+// приоритетом переносит строки в буферы открытых файлов и записывает на SD карту блоками до
+// границы сектора или по истечении времени _LOG_COMMIT_TIME. Файлы текущих суток остаются
+// открытыми, при смене суток файлы закрываются. Протоколы в двоичном формате (LOG_BIN) передаются
+// блоками данных через LogPut(), заголовок нового файла формирует DataLogHead(), при записи блока
+// DataLogIndex() добавляет запись в индекс протокола по смещению блока в файле
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+
+#include "rl_fs.h"
+#include "cmsis_os2.h"
+
+#include "lpc177x_8x_rtc.h"
+
+#include "device.h"
+#include "dev_param.h"
+
+#include "config.h"
+#include "eeprom.h"
+#include "logger.h"
+#include "datalog.h"
+#include "message.h"
+#include "sdcard.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define LOG_RING                4096        //размер кольцевого буфера строк (байт)
+#define LOG_SECTOR              512         //размер сектора SD карты (байт)
+#define LOG_POLL_TIME           250         //интервал проверки буферов (msec)
+#define LOG_FLAG_DATA           0x00000001  //флаг задачи: буфер заполнен наполовину
+
+#define LOG_DAY                 0x01        //файл за сутки, иначе файл за месяц
+#define LOG_SUBDIR              0x02        //файл в каталоге YYYYMM при включенном mode_logging
+#define LOG_BIN                 0x04        //файл в двоичном формате, заголовок - DataLogHead()
+
+//*************************************************************************************************
+// Локальные типы данных
+//*************************************************************************************************
+//Описание файла протокола
+typedef struct {
+    char        *dir;                       //каталог
+    char        *name;                      //префикс имени файла
+    char        *ext;                       //расширение файла
+    uint8_t     flags;                      //признаки LOG_DAY, LOG_SUBDIR
+    ConsMessage head;                       //первая строка заголовка файла
+    uint8_t     head_cnt;                   //кол-во строк заголовка, 0 - без заголовка
+ } LOG_DESC;
+
+#pragma pack( push, 1 )
+
+//Заголовок строки в кольцевом буфере
+typedef struct {
+    uint8_t     id;                         //ID протокола LogId
+    uint8_t     day;                        //дата формирования строки, для файлов
+    uint8_t     month;                      //за месяц день = 0
+    uint16_t    year;
+    uint16_t    len;                        //размер строки
+ } LOG_REC;
+
+#pragma pack( pop )
+
+//Открытый файл протокола
+typedef struct {
+    FILE        *file;                      //NULL - файл не открыт
+    LOG_REC     date;                       //ID протокола и дата файла
+    uint32_t    pos;                        //размер файла без данных буфера
+    uint32_t    time;                       //время добавления первой не записанной строки
+    uint32_t    used;                       //время последнего обращения к файлу
+    uint16_t    len;                        //кол-во байт в буфере
+    uint8_t     buff[LOG_SECTOR];           //данные для записи
+ } LOG_FILE;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static const LOG_DESC log_desc[] = {
+    //каталог       имя         расширение  признаки                    заголовок              строк
+    "\\batmon",     "bm_",      "csv",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_LOG_BATMON,    1,
+    "\\batmon",     "bm_",      "csv",      0,                          CONS_MSG_LOG_BATDAY,    1,
+    "\\mppt",       "mppt_",    "csv",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_LOG_MPPT,      1,
+    "\\mppt",       "mppt_",    "hex",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_MPPT_HEADER1,  5,
+    "\\mppt",       "pv_",      "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\inv",        "inv_",     "csv",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_LOG_INV,       1,
+    "\\inv",        "inv1_",    "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\inv",        "inv2_",    "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\charger",    "pb_",      "csv",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_LOG_CHARGER,   1,
+    "\\charger",    "pb_",      "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\gen",        "gen_",     "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\alt",        "alt_",     "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\trc",        "trc_",     "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\voice",      "voice_",   "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0,
+    "\\execute",    "job_",     "log",      LOG_DAY,                    CONS_MSG_PROMPT,        0,
+    "\\execute",    "cmd_",     "log",      LOG_DAY,                    CONS_MSG_PROMPT,        0,
+    "\\hmi",        "cmd_",     "log",      LOG_DAY,                    CONS_MSG_PROMPT,        0,
+    "\\hmi",        "cfg_",     "log",      LOG_DAY,                    CONS_MSG_PROMPT,        0,
+    "\\batmon",     "bm_",      "bin",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\mppt",       "mppt_",    "bin",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\inv",        "inv_",     "bin",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\charger",    "pb_",      "bin",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\batmon",     "bm_",      "idx",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\mppt",       "mppt_",    "idx",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\inv",        "inv_",     "idx",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\charger",    "pb_",      "idx",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\rollup",     "rm_",      "bin",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\rollup",     "rh_",      "bin",      LOG_DAY | LOG_SUBDIR | LOG_BIN, CONS_MSG_PROMPT,    0,
+    "\\rollup",     "rd_",      "bin",      LOG_BIN,                    CONS_MSG_PROMPT,        0,
+    "\\sdcard",     "sd_",      "log",      LOG_DAY | LOG_SUBDIR,       CONS_MSG_PROMPT,        0
+ };
+
+static uint8_t log_ring[LOG_RING];                      //кольцевой буфер строк
+static uint32_t ring_head = 0;                          //кол-во добавленных байт
+static uint32_t ring_tail = 0;                          //кол-во извлеченных байт
+static char row_put[LOG_ROW];                           //буфер формирования строки
+static char row_get[LOG_ROW];                           //буфер извлечения строки
+static uint8_t head_buff[LOG_SECTOR];                   //буфер заголовка двоичного файла
+static LOG_FILE log_file[_LOG_FILES];                   //открытые файлы протоколов
+static uint32_t log_stat[LOG_STAT_CNT];                 //счетчики записи протоколов
+
+static osMutexId_t mutex_ring = NULL, mutex_file = NULL;
+static osThreadId_t log_thread;
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osThreadAttr_t log_attr = {
+    .name = "Logger",
+    .stack_size = 1024,
+    .priority = osPriorityBelowNormal
+ };
+
+static const osMutexAttr_t mutex_rattr = { .name = "LogRing", .attr_bits = osMutexPrioInherit };
+static const osMutexAttr_t mutex_fattr = { .name = "LogFile", .attr_bits = osMutexPrioInherit };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void TaskLog( void *pvParameters );
+static void LogRing( LogId id, DATE *date, void *data, uint16_t len );
+static void RingPut( void *data, uint16_t len );
+static void RingGet( void *data, uint16_t len );
+static void LogDrain( void );
+static void LogCommit( void );
+static LOG_FILE *LogOpen( LOG_REC *rec );
+static void LogAppend( LOG_FILE *lf, uint8_t *data, uint16_t len );
+static void LogWrite( LOG_FILE *lf );
+static void LogClose( LOG_FILE *lf );
+static bool LogToday( LOG_REC *rec );
+
+//*************************************************************************************************
+// Инициализация записи протоколов
+//*************************************************************************************************
+void LogInit( void ) {
+
+    memset( log_file, 0x00, sizeof( log_file ) );
+    mutex_ring = osMutexNew( &mutex_rattr );
+    mutex_file = osMutexNew( &mutex_fattr );
+    log_thread = osThreadNew( TaskLog, NULL, &log_attr );
+ }
+
+//*************************************************************************************************
+// Задача записи протоколов на SD карту
+//*************************************************************************************************
+static void TaskLog( void *pvParameters ) {
+
+    for ( ;; ) {
+        osThreadFlagsWait( LOG_FLAG_DATA, osFlagsWaitAny, LOG_POLL_TIME );
+        DataLogCommit();
+        osMutexAcquire( mutex_file, osWaitForever );
+        LogDrain();
+        LogCommit();
+        osMutexRelease( mutex_file );
+       }
+ }
+
+//*************************************************************************************************
+// Добавление строки в протокол, вызывающая задача не блокируется на время записи на SD карту
+// Строка формируется по формату printf(), имя файла определяется по ID протокола и текущей дате
+// LogId id           - ID протокола
+// const char *format - формат строки
+//*************************************************************************************************
+void LogPrintf( LogId id, const char *format, ... ) {
+
+    int len;
+    va_list args;
+
+    if ( id >= LOG_CNT || mutex_ring == NULL )
+        return;
+    if ( SDStatus() == ERROR )
+        return; //карты нет
+    osMutexAcquire( mutex_ring, osWaitForever );
+    va_start( args, format );
+    len = vsnprintf( row_put, sizeof( row_put ), format, args );
+    va_end( args );
+    //строка длиннее буфера записывается не полностью
+    if ( len > 0 )
+        LogRing( id, NULL, row_put, len < sizeof( row_put ) ? len : sizeof( row_put ) - 1 );
+    osMutexRelease( mutex_ring );
+ }
+
+//*************************************************************************************************
+// Добавление блока данных в протокол, вызывающая задача не блокируется на время записи на SD
+// карту. Блок записывается в файл без изменений, блок длиннее LOG_ROW не записывается
+// LogId id     - ID протокола
+// DATE *date   - дата данных блока (определяет имя файла), NULL - текущая дата
+// void *data   - данные
+// uint16_t len - кол-во байт
+//*************************************************************************************************
+void LogPut( LogId id, DATE *date, void *data, uint16_t len ) {
+
+    if ( id >= LOG_CNT || mutex_ring == NULL || !len )
+        return;
+    if ( SDStatus() == ERROR )
+        return; //карты нет
+    osMutexAcquire( mutex_ring, osWaitForever );
+    if ( len <= LOG_ROW )
+        LogRing( id, date, data, len );
+    else log_stat[LOG_STAT_DROP]++;
+    osMutexRelease( mutex_ring );
+ }
+
+//*************************************************************************************************
+// Размещение строки/блока в кольцевом буфере с датой формирования, вызывается при
+// заблокированном буфере. При недостатке места строка не записывается
+// LogId id     - ID протокола
+// DATE *date   - дата строки/блока, NULL - текущая дата
+// void *data   - данные
+// uint16_t len - кол-во байт
+//*************************************************************************************************
+static void LogRing( LogId id, DATE *date, void *data, uint16_t len ) {
+
+    LOG_REC rec;
+    RTC_TIME_Type Time;
+
+    if ( date == NULL ) {
+        RTC_GetFullTime( LPC_RTC, &Time );
+        rec.day = Time.DOM;
+        rec.month = Time.MONTH;
+        rec.year = Time.YEAR;
+       }
+    else {
+        rec.day = date->day;
+        rec.month = date->month;
+        rec.year = date->year;
+       }
+    rec.id = id;
+    if ( !( log_desc[id].flags & LOG_DAY ) )
+        rec.day = 0;
+    rec.len = len;
+    if ( LOG_RING - ( ring_head - ring_tail ) >= sizeof( rec ) + rec.len ) {
+        RingPut( &rec, sizeof( rec ) );
+        RingPut( data, rec.len );
+        log_stat[LOG_STAT_ROWS]++;
+       }
+    else log_stat[LOG_STAT_DROP]++;
+    if ( ring_head - ring_tail >= LOG_RING / 2 )
+        osThreadFlagsSet( log_thread, LOG_FLAG_DATA );
+ }
+
+//*************************************************************************************************
+// Запись всех строк протоколов на SD карту и закрытие файлов
+// Вызывается перед операциями с файлами и размонтированием SD карты
+//*************************************************************************************************
+void LogFlush( void ) {
+
+    if ( mutex_file == NULL )
+        return;
+    LogLock();
+    LogUnlock();
+ }
+
+//*************************************************************************************************
+// Запись всех строк протоколов на SD карту, закрытие файлов и блокировка записи протоколов
+// Строки протоколов продолжают накапливаться в кольцевом буфере, блокировка снимается LogUnlock()
+// Используется для изменения файлов протоколов из других задач (формирование индекса)
+//*************************************************************************************************
+void LogLock( void ) {
+
+    uint8_t i;
+
+    if ( mutex_file == NULL )
+        return;
+    DataLogFlush(); //незавершенные блоки двоичных протоколов
+    osMutexAcquire( mutex_file, osWaitForever );
+    LogDrain();
+    for ( i = 0; i < SIZE_ARRAY( log_file ); i++ )
+        LogClose( &log_file[i] );
+ }
+
+//*************************************************************************************************
+// Снятие блокировки записи протоколов
+//*************************************************************************************************
+void LogUnlock( void ) {
+
+    if ( mutex_file == NULL )
+        return;
+    osMutexRelease( mutex_file );
+ }
+
+//*************************************************************************************************
+// Возвращает значение счетчика записи протоколов
+// LogCnt type     - тип счетчика
+// return uint32_t - значение счетчика
+//*************************************************************************************************
+uint32_t LogStat( LogCnt type ) {
+
+    if ( type >= LOG_STAT_CNT )
+        return 0;
+    return log_stat[type];
+ }
+
+//*************************************************************************************************
+// Возвращает кол-во байт в кольцевом буфере строк
+//*************************************************************************************************
+uint32_t LogUsed( void ) {
+
+    return ring_head - ring_tail;
+ }
+
+//*************************************************************************************************
+// Формирует имя файла протокола по ID протокола и дате
+// LogId id   - ID протокола
+// DATE *date - дата файла, для файлов за месяц день не используется
+// char *name - буфер для имени файла размером не менее LOG_NAME
+//*************************************************************************************************
+void LogFileName( LogId id, DATE *date, char *name ) {
+
+    const LOG_DESC *desc;
+
+    *name = '\0';
+    if ( id >= LOG_CNT )
+        return;
+    desc = &log_desc[id];
+    if ( !( desc->flags & LOG_DAY ) )
+        sprintf( name, "%s\\%s%04u%02u.%s", desc->dir, desc->name, date->year, date->month, desc->ext );
+    else if ( ( desc->flags & LOG_SUBDIR ) && config.mode_logging )
+        sprintf( name, "%s\\%04u%02u\\%s%04u%02u%02u.%s", desc->dir, date->year, date->month, desc->name,
+                 date->year, date->month, date->day, desc->ext );
+    else sprintf( name, "%s\\%s%04u%02u%02u.%s", desc->dir, desc->name, date->year, date->month, date->day, desc->ext );
+ }
+
+//*************************************************************************************************
+// Добавление данных в кольцевой буфер, вызывается при заблокированном буфере
+// void *data   - данные
+// uint16_t len - кол-во байт
+//*************************************************************************************************
+static void RingPut( void *data, uint16_t len ) {
+
+    uint16_t pos, part;
+
+    pos = ring_head % LOG_RING;
+    part = LOG_RING - pos < len ? LOG_RING - pos : len;
+    memcpy( &log_ring[pos], data, part );
+    memcpy( log_ring, (uint8_t *)data + part, len - part );
+    ring_head += len;
+ }
+
+//*************************************************************************************************
+// Извлечение данных из кольцевого буфера, вызывается при заблокированном буфере
+// void *data   - буфер для данных
+// uint16_t len - кол-во байт
+//*************************************************************************************************
+static void RingGet( void *data, uint16_t len ) {
+
+    uint16_t pos, part;
+
+    pos = ring_tail % LOG_RING;
+    part = LOG_RING - pos < len ? LOG_RING - pos : len;
+    memcpy( data, &log_ring[pos], part );
+    memcpy( (uint8_t *)data + part, log_ring, len - part );
+    ring_tail += len;
+ }
+
+//*************************************************************************************************
+// Перенос строк из кольцевого буфера в буферы файлов, вызывается при заблокированных файлах
+// Кольцевой буфер блокируется только на время копирования одной строки
+//*************************************************************************************************
+static void LogDrain( void ) {
+
+    DATE date;
+    LOG_REC rec;
+    LOG_FILE *lf;
+
+    for ( ;; ) {
+        osMutexAcquire( mutex_ring, osWaitForever );
+        if ( ring_head == ring_tail ) {
+            osMutexRelease( mutex_ring );
+            return;
+           }
+        RingGet( &rec, sizeof( rec ) );
+        RingGet( row_get, rec.len );
+        osMutexRelease( mutex_ring );
+        lf = LogOpen( &rec );
+        if ( lf == NULL ) {
+            log_stat[LOG_STAT_ERROR]++;
+            continue; //строка не записывается
+           }
+        if ( log_desc[rec.id].flags & LOG_BIN ) {
+            //запись индекса по смещению блока в файле
+            date.day = rec.day;
+            date.month = rec.month;
+            date.year = rec.year;
+            DataLogIndex( (LogId)rec.id, &date, lf->pos + lf->len, (uint8_t *)row_get, rec.len );
+           }
+        LogAppend( lf, (uint8_t *)row_get, rec.len );
+       }
+ }
+
+//*************************************************************************************************
+// Запись на SD карту буферов файлов с истекшим временем хранения, закрытие файлов прошедших
+// суток, при отсутствии SD карты файлы закрываются без записи
+//*************************************************************************************************
+static void LogCommit( void ) {
+
+    uint8_t i;
+    LOG_FILE *lf;
+
+    for ( i = 0; i < SIZE_ARRAY( log_file ); i++ ) {
+        lf = &log_file[i];
+        if ( lf->file == NULL )
+            continue;
+        if ( SDStatus() == ERROR ) {
+            fclose( lf->file );
+            lf->file = NULL;
+            lf->len = 0;
+            continue;
+           }
+        if ( lf->len && osKernelGetTickCount() - lf->time >= _LOG_COMMIT_TIME )
+            LogWrite( lf );
+        if ( LogToday( &lf->date ) == false )
+            LogClose( lf ); //смена суток
+       }
+ }
+
+//*************************************************************************************************
+// Возвращает открытый файл протокола для строки, при необходимости открывает файл
+// Если свободных файлов нет, закрывается файл с самым давним обращением
+// LOG_REC *rec      - заголовок строки
+// return LOG_FILE * - открытый файл, NULL - файл не открылся
+//*************************************************************************************************
+static LOG_FILE *LogOpen( LOG_REC *rec ) {
+
+    uint8_t i;
+    DATE date;
+    uint16_t len;
+    char name[LOG_NAME];
+    const LOG_DESC *desc;
+    LOG_FILE *lf = NULL;
+
+    for ( i = 0; i < SIZE_ARRAY( log_file ); i++ ) {
+        if ( log_file[i].file == NULL || log_file[i].date.id != rec->id )
+            continue;
+        if ( log_file[i].date.day == rec->day && log_file[i].date.month == rec->month && log_file[i].date.year == rec->year ) {
+            log_file[i].used = osKernelGetTickCount();
+            return &log_file[i];
+           }
+        LogClose( &log_file[i] ); //строка другой даты
+       }
+    for ( i = 0; i < SIZE_ARRAY( log_file ); i++ ) {
+        if ( log_file[i].file == NULL ) {
+            lf = &log_file[i];
+            break;
+           }
+        if ( lf == NULL || osKernelGetTickCount() - log_file[i].used > osKernelGetTickCount() - lf->used )
+            lf = &log_file[i];
+       }
+    LogClose( lf );
+    //имя файла по дате строки
+    desc = &log_desc[rec->id];
+    date.day = rec->day;
+    date.month = rec->month;
+    date.year = rec->year;
+    LogFileName( (LogId)rec->id, &date, name );
+    lf->file = fopen( name, ( desc->flags & LOG_BIN ) ? "ab" : "a" );
+    if ( lf->file == NULL )
+        return NULL;
+    log_stat[LOG_STAT_OPEN]++;
+    memcpy( &lf->date, rec, sizeof( lf->date ) );
+    lf->pos = ftell( lf->file );
+    lf->len = 0;
+    lf->used = osKernelGetTickCount();
+    //заголовок нового файла
+    if ( !lf->pos && ( desc->flags & LOG_BIN ) ) {
+        len = DataLogHead( (LogId)rec->id, &date, head_buff, sizeof( head_buff ) );
+        LogAppend( lf, head_buff, len );
+       }
+    if ( !lf->pos )
+        for ( i = 0; i < desc->head_cnt; i++ )
+            LogAppend( lf, (uint8_t *)Message( (ConsMessage)( desc->head + i ) ), strlen( Message( (ConsMessage)( desc->head + i ) ) ) );
+    return lf;
+ }
+
+//*************************************************************************************************
+// Добавление данных в буфер файла, при заполнении буфера до границы сектора - запись
+// LOG_FILE *lf  - открытый файл
+// uint8_t *data - данные
+// uint16_t len  - кол-во байт
+//*************************************************************************************************
+static void LogAppend( LOG_FILE *lf, uint8_t *data, uint16_t len ) {
+
+    uint16_t size, part;
+
+    while ( len ) {
+        if ( !lf->len )
+            lf->time = osKernelGetTickCount();
+        //кол-во байт до границы сектора
+        size = LOG_SECTOR - ( lf->pos + lf->len ) % LOG_SECTOR;
+        part = len < size ? len : size;
+        memcpy( lf->buff + lf->len, data, part );
+        lf->len += part;
+        data += part;
+        len -= part;
+        if ( part == size )
+            LogWrite( lf );
+       }
+ }
+
+//*************************************************************************************************
+// Запись буфера файла на SD карту, при _LOG_SYNC = 1 - сброс буферов файловой системы
+// LOG_FILE *lf - открытый файл
+//*************************************************************************************************
+static void LogWrite( LOG_FILE *lf ) {
+
+    if ( !lf->len )
+        return;
+    log_stat[LOG_STAT_WRITE]++;
+    if ( fwrite( lf->buff, 1, lf->len, lf->file ) == lf->len )
+        log_stat[LOG_STAT_BYTES] += lf->len;
+    else log_stat[LOG_STAT_ERROR]++;
+    #if _LOG_SYNC
+    fflush( lf->file );
+    #endif
+    lf->pos += lf->len;
+    lf->len = 0;
+ }
+
+//*************************************************************************************************
+// Запись буфера и закрытие файла
+// LOG_FILE *lf - открытый файл
+//*************************************************************************************************
+static void LogClose( LOG_FILE *lf ) {
+
+    if ( lf->file == NULL )
+        return;
+    LogWrite( lf );
+    fclose( lf->file );
+    lf->file = NULL;
+ }
+
+//*************************************************************************************************
+// Проверка соответствия даты файла текущей дате
+// LOG_REC *rec  - ID протокола и дата файла
+// return = true - файл текущих суток/месяца
+//*************************************************************************************************
+static bool LogToday( LOG_REC *rec ) {
+
+    RTC_TIME_Type Time;
+
+    RTC_GetFullTime( LPC_RTC, &Time );
+    if ( rec->year != Time.YEAR || rec->month != Time.MONTH )
+        return false;
+    if ( rec->day && rec->day != Time.DOM )
+        return false;
+    return true;
+ }
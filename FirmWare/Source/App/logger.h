@@ -0,0 +1,76 @@
+
+#ifndef __LOGGER_H
+#define __LOGGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dev_data.h"
+
+#define LOG_ROW                 256         //максимальный размер строки/блока данных (байт)
+#define LOG_NAME                48          //максимальный размер имени файла
+
+//Протоколы на SD карте, имена файлов формируются по описанию в log_desc[]
+typedef enum {
+    LOG_BATMON,                             //\batmon\bm_YYYYMMDD.csv
+    LOG_BATDAY,                             //\batmon\bm_YYYYMM.csv
+    LOG_MPPT,                               //\mppt\mppt_YYYYMMDD.csv
+    LOG_MPPT_HEX,                           //\mppt\mppt_YYYYMMDD.hex
+    LOG_PV,                                 //\mppt\pv_YYYYMMDD.log
+    LOG_INV,                                //\inv\inv_YYYYMMDD.csv
+    LOG_INV1,                               //\inv\inv1_YYYYMMDD.log
+    LOG_INV2,                               //\inv\inv2_YYYYMMDD.log
+    LOG_CHARGER,                            //\charger\pb_YYYYMMDD.csv
+    LOG_CHARGER_EVN,                        //\charger\pb_YYYYMMDD.log
+    LOG_GEN,                                //\gen\gen_YYYYMMDD.log
+    LOG_ALT,                                //\alt\alt_YYYYMMDD.log
+    LOG_TRC,                                //\trc\trc_YYYYMMDD.log
+    LOG_VOICE,                              //\voice\voice_YYYYMMDD.log
+    LOG_JOB,                                //\execute\job_YYYYMMDD.log
+    LOG_EXEC,                               //\execute\cmd_YYYYMMDD.log
+    LOG_HMI_CMD,                            //\hmi\cmd_YYYYMMDD.log
+    LOG_HMI_CFG,                            //\hmi\cfg_YYYYMMDD.log
+    LOG_BATMON_BIN,                         //\batmon\bm_YYYYMMDD.bin
+    LOG_MPPT_BIN,                           //\mppt\mppt_YYYYMMDD.bin
+    LOG_INV_BIN,                            //\inv\inv_YYYYMMDD.bin
+    LOG_CHARGER_BIN,                        //\charger\pb_YYYYMMDD.bin
+    LOG_BATMON_IDX,                         //\batmon\bm_YYYYMMDD.idx
+    LOG_MPPT_IDX,                           //\mppt\mppt_YYYYMMDD.idx
+    LOG_INV_IDX,                            //\inv\inv_YYYYMMDD.idx
+    LOG_CHARGER_IDX,                        //\charger\pb_YYYYMMDD.idx
+    LOG_ROLL_MIN,                           //\rollup\rm_YYYYMMDD.bin
+    LOG_ROLL_HOUR,                          //\rollup\rh_YYYYMMDD.bin
+    LOG_ROLL_DAY,                           //\rollup\rd_YYYYMM.bin
+    LOG_SDCARD,                             //\sdcard\sd_YYYYMMDD.log
+    LOG_CNT                                 //кол-во протоколов
+ } LogId;
+
+//Счетчики записи протоколов
+typedef enum {
+    LOG_STAT_ROWS,                          //принято строк
+    LOG_STAT_DROP,                          //строк не принято (переполнение буфера)
+    LOG_STAT_BYTES,                         //записано байт
+    LOG_STAT_WRITE,                         //кол-во операций записи
+    LOG_STAT_OPEN,                          //кол-во открытий файлов
+    LOG_STAT_ERROR,                         //ошибки открытия/записи файлов
+    LOG_STAT_CNT                            //кол-во счетчиков
+ } LogCnt;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void LogInit( void );
+void LogPrintf( LogId id, const char *format, ... );
+void LogPut( LogId id, DATE *date, void *data, uint16_t len );
+void LogFlush( void );
+void LogLock( void );
+void LogUnlock( void );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t LogStat( LogCnt type );
+uint32_t LogUsed( void );
+void LogFileName( LogId id, DATE *date, char *name );
+
+#endif
@@ -40,9 +40,17 @@
 #include "spa_calc.h"
 #include "rs485.h"
 #include "sdcard.h"
+#include "logger.h"
+#include "datalog.h"
+#include "rollup.h"
+#include "retain.h"
+#include "crc_hw.h"
 #include "hmi_can.h"
+#include "can_xfer.h"
 #include "scheduler.h"
 #include "modbus.h"
+#include "modbus_poll.h"
+#include "modbus_slave.h"
 #include "message.h"
 #include "informing.h"
 
@@ -97,6 +105,7 @@ static void TaskInit( void *pvParameters ) {
 
     WDTInit();          //включим WDT
     EepromInit();       //инициализация EEPROM, загрузка параметров настроек
+    CrcHwInit();        //расчет контрольных сумм блоком CRC (GPDMA)
     PortsInit();        //порты управления/состояния
     ReservInit();       //порты управления дополнительными реле/выходами
 
@@ -105,10 +114,17 @@ static void TaskInit( void *pvParameters ) {
     ScreenInit();       //инициализация экран консоли
     CommandInit();      //командный интерфейс
     SDMount();          //монтирование SD карты
+    LogInit();          //запись протоколов на SD карту
+    DataLogInit();      //протоколы данных уст-в в двоичном формате
+    RollupInit();       //итоги значений параметров уст-в
+    RetainInit();       //хранение протоколов на SD карте
     ResetLog();         //логирование источника сброса контроллера
     CANInit();          //инициализация CAN интерфейса
+    CanXferInit();      //сегментированная передача блоков данных/файлов по CAN
     RS485Init();        //интерфейс RS-485 (MODBUS) SSP1
     ModBusInit();       //управление MODBUS
+    ModBusPollInit();   //планировщик циклического опроса уст-в MODBUS
+    ModBusSlaveInit();  //ведомое уст-во MODBUS RTU (консоль UART0)
 
     AltInit();          //управление блоком АВР
     PvInit();           //управление коммутацией солнечных панелей
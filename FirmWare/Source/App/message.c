@@ -65,6 +65,14 @@ static char * const cons_msg[] = {
     "                                00003 00001 00004 00013 12 00015 00011                   Time     08 00014                         000000005_2 000000005_1 00007 00017            \r\n",
                                                                 //CONS_MSG_MPPT_HEADER5
     "                    ==============================================================================================================================================================\r\n",
+                                                                //CONS_MSG_LOG_BATMON
+    "Date;Time;Bat_V(V);Bat_I(A);Energy from BAT(Ah);SOC(%);TTGo;Total energy from BAT(Ah);Alarm;Relay;Last discharge(Ah);Medium discharge(Ah)\r\n",
+    "Date;Bat_V(V);Energy(Ah);SOC(%);H6(Ah)\r\n",              //CONS_MSG_LOG_BATDAY
+                                                                //CONS_MSG_LOG_MPPT
+    "Date;Time;PV_V(V);PV_I(A);OUT_V(V);OUT_I(A);WHr;AHr;Float;ModeCharge;SOC(%);Bat_I(A);PVOn;PVMode\r\n",
+                                                                //CONS_MSG_LOG_INV
+    "Date;Time;Pwr1(%);Pwr1(W);Temp1(C);Conn1;Mode1;Error1;Pwr3(%);Pwr3(W);Temp3(C);Conn3;Mode3;Error3;\r\n",
+    "Date;Time;AC;Dev;Mode;Stat;SOC(%);I(A);V\r\n",             //CONS_MSG_LOG_CHARGER
     "Application version ......... %s\r\n",                     //CONS_MSG_APP_VER
     "Build version ............... %s %s\r\n",                  //CONS_MSG_BUILD_VER
     "CPU clock ................... %s Hz\r\n",                  //CONS_MSG_CPU_CLOCK
@@ -193,7 +201,11 @@ static char * const log_msg[] = {
     "Выключаем командой",                                       //LOG_MSG_INV_OFF_CMD
     "Выключен удаленно",                                        //LOG_MSG_INV_OFF_RMT
     "Инвертор выключен, контактор не выключился",               //LOG_MSG_INV_DC_OFF_ERR
-    "На инверторе включена нагрузка"                            //LOG_MSG_INV_POWER_AC
+    "На инверторе включена нагрузка",                           //LOG_MSG_INV_POWER_AC
+    //SD карта
+    "Мало свободного места на SD карте, удаление старых протоколов", //LOG_MSG_SD_LOW
+    "SD карта заполнена, протоколов для удаления нет",          //LOG_MSG_SD_FULL
+    "Свободное место на SD карте восстановлено"                 //LOG_MSG_SD_FREE
  };                                                               
 
 //*************************************************************************************************
@@ -211,14 +223,20 @@ const static char help[] = {
     "DIR [*.*]                              - вывод списка фалов SD карты\r\n"
     "TYPE filename                          - просмотр текстового файла\r\n"
     "HEX filename                           - просмотр файла в формате HEX\r\n"
+    "CRC [filename/EEPROM] [type]           - контрольная сумма файла/EEPROM: CCITT/CRC16/MODBUS/CRC32 (по умолчанию)\r\n"
     "DEL name                               - удаление файла\r\n"
     "DIRDEL name                            - удаление каталога\r\n"
     "REN name new_name                      - переименование файла\r\n"
     "FILE name                              - создание текстового файла с данными введенными из консоли, ESC-конец ввода\r\n"
     "CID                                    - информация о SD карте\r\n"
+    "LOG [flush]                            - статистика записи протоколов/запись буферов протоколов на SD карту\r\n"
+    "EXPORT batmon/mppt/inv/charger dd.mm.yyyy [dd.mm.yyyy] [filename] - экспорт двоичного протокола в CSV\r\n"
+    "QUERY batmon/mppt/inv/charger dd.mm.yyyy hh:mm dd.mm.yyyy hh:mm [column min max] - выборка записей протокола по индексу\r\n"
+    "ROLLUP [min/hour/day] [dd.mm.yyyy] - итоги значений уст-в за период (мин/макс/среднее/интеграл)\r\n"
+    "RETAIN                                 - политики хранения протоколов, объем протоколов на SD карте\r\n"
     "EEPROM [n 0-63/clr 0-63]               - дамп памяти EEPROM/очистка блока памяти\r\n"
     "STATALL                                - состояние входов\r\n\r\n"
-    "HMI                                    - вывод состояния интерфейса обмена данными с HMI\r\n"
+    "HMI [filter/subscr/dev on/off]         - состояние обмена с HMI/фильтр/подписка/прием команд уст-ва\r\n"
     "CMD filename                           - выполнение пакетного файла с командами\r\n"
     "JOBS [add/del/on/off/run/load n [all]] - просмотр/управление заданиями\r\n"
     "\r\n"
@@ -242,7 +260,10 @@ const static char help[] = {
     "SOUND 1...N [name]                     - воспроизведение звукового сообщения\r\n"
     "MODBUS dev func reg cnt data1..5       - отправка команды по MODBUS (формат параметров: HEX без 0x))\r\n"
     "MODERR                                 - вывод статистики ошибок MODBUS\r\n"
-    "MODLOG 0/1                             - логирование запрос/ответ MODBUS\r\n"
+    "MODLOG 0/1                             - сохранение захвата кадров MODBUS на SD карту\r\n"
+    "MODCAP [FILE] [N]                      - расшифровка последних N кадров MODBUS из буфера/файла\r\n"
+    "MODPOLL [0]                            - вывод/сброс статистики циклического опроса MODBUS\r\n"
+    "MODSLAVE [0/MAP/ON]                    - ведомое уст-во MODBUS: статистика/таблица адресов/вкл (выход - ESC)\r\n"
     "RESET                                  - перезапуск контроллера\r\n"
     "TASK                                   - вывод списка задач\r\n"
     "SYSTEM                                 - вывод системной информации\r\n"
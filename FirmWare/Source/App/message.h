@@ -49,6 +49,11 @@ typedef enum {
     CONS_MSG_MPPT_HEADER3,                  //xx xx xx xx ----- ----- ----- ...
     CONS_MSG_MPPT_HEADER4,                  //            00003 00001 00004 ...
     CONS_MSG_MPPT_HEADER5,                  //============================= ...
+    CONS_MSG_LOG_BATMON,                    //Date;Time;Bat_V(V);Bat_I(A);Energy from BAT(Ah);SOC(%);...
+    CONS_MSG_LOG_BATDAY,                    //Date;Bat_V(V);Energy(Ah);SOC(%);H6(Ah)
+    CONS_MSG_LOG_MPPT,                      //Date;Time;PV_V(V);PV_I(A);OUT_V(V);OUT_I(A);WHr;AHr;...
+    CONS_MSG_LOG_INV,                       //Date;Time;Pwr1(%);Pwr1(W);Temp1(C);Conn1;Mode1;Error1;...
+    CONS_MSG_LOG_CHARGER,                   //Date;Time;AC;Dev;Mode;Stat;SOC(%);I(A);V
     CONS_MSG_APP_VER,                       //Application version ......... %s
     CONS_MSG_BUILD_VER,                     //Build version ............... %s %s
     CONS_MSG_CPU_CLOCK,                     //CPU clock ................... %s Hz
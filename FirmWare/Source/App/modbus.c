@@ -14,6 +14,7 @@
 
 #include "cmsis_os2.h"
 
+#include "config.h"
 #include "ports.h"
 #include "command.h"    //////////
 
@@ -24,9 +25,10 @@
 #include "modbus.h"
 #include "events.h"
 #include "crc16.h"
-#include "sdcard.h"
 
 #include "modbus_def.h"
+#include "modbus_cache.h"
+#include "modbus_cap.h"
 #include "tracker_ext.h"
 #include "voice_ext.h"
 #include "gen_ext.h"
@@ -49,6 +51,22 @@ osMessageQueueId_t modbus_queue = NULL;
                                             //размер буфера str_log[128]
 
 #define TIMEOUT_ANSWER          100         //время ожидания ответа от уст-ва (msec)
+#define TIMEOUT_PAUSE           5           //пауза между пакетами (msec)
+#define TIMEOUT_FRAME_GAP       10          //запас времени приема оставшейся части ответа (msec)
+#define MBUS_CHAR_TIME          ( ( 10 * 1000000UL ) / _RS485_BAUD ) //время передачи одного байта (usec)
+
+#define LINK_RTO_MIN            20          //минимальное время ожидания ответа (msec)
+#define LINK_RTO_MAX            400         //максимальное время ожидания ответа с учетом удвоения (msec)
+#define LINK_BACKOFF_MAX        2           //максимальная степень удвоения времени ожидания после таймаута
+#define LINK_FAIL_OFFLINE       3           //кол-во таймаутов подряд для перевода уст-ва в состояние "нет связи"
+#define LINK_PROBE_MIN          1000        //начальный интервал проверки связи с уст-вом (msec)
+#define LINK_PROBE_MAX          32000       //максимальный интервал проверки связи с уст-вом (msec)
+
+#define MBUS_TRANS_MAX          16          //размер пула запросов
+#define MBUS_TRANS_NONE         0xFF        //признак отсутствия запроса
+#define MBUS_QUEUE_CNT          ( DEV_ERROR_CNT + 1 ) //кол-во очередей запросов: по одной на уст-во
+                                            //с адресом 1...DEV_ERROR_CNT + общая для остальных
+#define MBUS_FLAG_DONE          0x00000001  //флаг задачи: запрос выполнен
 
 #define MB_ANSWER_DEV           0           //индекс ID уст-ва ответа
 #define MB_ANSWER_FUNC          1           //индекс кода функции ответа
@@ -66,6 +84,17 @@ osMessageQueueId_t modbus_queue = NULL;
 
 #define IND_BYTE_CMD01_04       2           //позиция в пакете кол-ва байт данных для функций 01,02,03,04
 
+//расшифровка параметров состояния связи с уст-вами
+static char * const link_descr[] = {
+    "Average response time (msec)",                 //MBUS_LINK_SRTT
+    "Response time deviation (msec)",               //MBUS_LINK_RTTVAR
+    "Response timeout (msec)",                      //MBUS_LINK_RTO
+    "Maximum response time (msec)",                 //MBUS_LINK_RTT_MAX
+    "Communication lost (times)",                   //MBUS_LINK_OFFLINE
+    "Requests skipped (no link)",                   //MBUS_LINK_SKIP
+    "Link state (1 - no link)"                      //MBUS_LINK_STATE
+ };
+
 //расшифровка ошибок протокола MODBUS
 static char * const modbus_error_descr[] = {
     "OK",                                           //MBUS_ANSWER_OK
@@ -113,18 +142,67 @@ typedef struct {
     //далее идут данные и КС
  } MBUS_WRT_REGS;
 
+//Структура для записи и чтения нескольких регистров (17)
+typedef struct {
+    uint8_t  dev_addr;                  //Адрес устройства
+    uint8_t  function;                  //Функциональный код
+    uint16_t rd_addr;                   //Адрес первого регистра чтения HI/LO байт
+    uint16_t rd_cnt;                    //Количество регистров чтения HI/LO байт
+    uint16_t wr_addr;                   //Адрес первого регистра записи HI/LO байт
+    uint16_t wr_cnt;                    //Количество регистров записи HI/LO байт
+    uint8_t  cnt_byte;                  //Количество байт данных регистров записи
+    //далее идут данные и КС
+ } MBUS_RDWR_REGS;
+
 #pragma pack( pop )
 
+//Элемент пула запросов
+typedef struct {
+    MBUS_REQUEST reqst;                 //параметры запроса
+    MBusCallback callback;              //функция вызываемая по завершению запроса
+    void         *arg;                  //параметр функции callback
+    ModBusError  *ptr_status;           //адрес переменной для результата (блокирующий вызов)
+    osThreadId_t thread;                //задача ожидающая результат (блокирующий вызов)
+    uint8_t      next;                  //индекс следующего элемента в очереди/списке свободных
+ } MBUS_TRANS;
+
+//Состояние связи с уст-вом, оценка времени ответа (RTT) по алгоритму Джекобсона (RFC 6298)
+typedef struct {
+    uint32_t srtt;                      //сглаженное время ответа (msec * 8)
+    uint32_t rttvar;                    //сглаженное отклонение времени ответа (msec * 4)
+    uint32_t rto;                       //расчетное время ожидания ответа (msec)
+    uint32_t rtt_max;                   //максимальное время ответа (msec)
+    uint32_t probe_tick;                //время следующей проверки связи
+    uint32_t probe_int;                 //интервал проверки связи (msec)
+    uint32_t cnt_offline;               //кол-во переходов в состояние "нет связи"
+    uint32_t cnt_skip;                  //кол-во запросов отклоненных без передачи
+    uint8_t  backoff;                   //степень удвоения времени ожидания
+    uint8_t  fail;                      //кол-во таймаутов подряд
+    bool     offline;                   //нет связи с уст-вом
+ } MBUS_LINK;
+
 //*************************************************************************************************
 // Локальные переменные
 //*************************************************************************************************
-FILE *modbus_log = NULL;
 
 static char str_log[128];
 static uint8_t send_buff[256];
 static uint32_t send_total = 0, error_cnt[SIZE_ARRAY( modbus_error_descr )]; //счетчики ошибок протокола
 static uint32_t error_dev[DEV_ERROR_CNT][SIZE_ARRAY( modbus_error_descr )];  //счетчики ошибок протокола по устройствам
 
+static MBUS_TRANS trans[MBUS_TRANS_MAX];                //пул запросов
+static uint8_t trans_free;                              //индекс первого свободного элемента пула
+static uint8_t trans_curr = MBUS_TRANS_NONE;            //индекс выполняемого запроса
+static uint16_t trans_seq = 0;                          //номер выполняемого запроса
+static uint8_t que_head[MBUS_QUEUE_CNT][MBUS_PRIO_CNT]; //начало очередей запросов уст-в
+static uint8_t que_tail[MBUS_QUEUE_CNT][MBUS_PRIO_CNT]; //окончание очередей запросов уст-в
+static uint8_t que_last = 0;                            //очередь из которой выбран последний запрос
+static uint32_t tick_end = 0;                           //время завершения последнего запроса
+static uint32_t tick_send = 0;                          //время передачи текущего запроса
+static uint32_t timeout_curr = TIMEOUT_ANSWER;          //время ожидания ответа на текущий запрос
+static uint16_t send_len = 0;                           //размер пакета текущего запроса
+static MBUS_LINK dev_link[DEV_ERROR_CNT];               //состояние связи с уст-вами
+
 static osMutexId_t mutex_mbus;
 static osTimerId_t timer_mbus;
 static osSemaphoreId_t mbus_semaphore;
@@ -134,7 +212,7 @@ static osSemaphoreId_t mbus_semaphore;
 //*************************************************************************************************
 static const osThreadAttr_t mbus_attr = {
     .name = "Modbus", 
-    .stack_size = 512,
+    .stack_size = 1024,
     .priority = osPriorityHigh
  };
  
@@ -146,9 +224,20 @@ static const osMessageQueueAttr_t que_attr = { .name = "Modbus" };
 //*************************************************************************************************
 // Прототипы локальных функций
 //*************************************************************************************************
-static void DataLog( uint8_t *data, uint16_t len, DataLogMode mode );
 static uint8_t CreateFrame( MBUS_REQUEST *reqst );
 static ModBusError AnswerData( uint8_t *data, uint8_t pack_len );
+static ModBusError TransAdd( MBUS_REQUEST *reqst, MBusPrio prio, MBusCallback callback, void *arg, ModBusError *ptr_status, uint32_t timeout );
+static bool TransNext( void );
+static void TransComplete( void );
+static void TransDone( uint8_t idx, ModBusError status );
+static uint8_t SlaveQueue( uint8_t dev_addr );
+static MBUS_LINK *SlaveLink( uint8_t dev_addr );
+static bool LinkSkip( MBUS_LINK *ptr );
+static uint32_t LinkTimeout( MBUS_LINK *ptr );
+static void LinkUpdate( MBUS_LINK *ptr, ModBusError status, uint32_t rtt );
+static uint16_t AnswerSize( MBUS_REQUEST *reqst );
+static uint32_t FrameTime( uint16_t size );
+static uint32_t RecvTimeout( void );
 
 static void Timer1Callback( void *arg );
 static void TaskModbus( void *pvParameters );
@@ -158,13 +247,27 @@ static void TaskModbus( void *pvParameters );
 //*************************************************************************************************
 void ModBusInit( void ) {
 
+    uint8_t idx;
+
     ModBusErrClr();
+    ModBusCacheInit();
+    ModBusCapInit();
+    //начальное время ожидания ответа для всех уст-в
+    memset( dev_link, 0x00, sizeof( dev_link ) );
+    for ( idx = 0; idx < DEV_ERROR_CNT; idx++ )
+        dev_link[idx].rto = TIMEOUT_ANSWER;
+    //пул запросов - все элементы в списке свободных
+    for ( idx = 0; idx < MBUS_TRANS_MAX; idx++ )
+        trans[idx].next = idx + 1 < MBUS_TRANS_MAX ? idx + 1 : MBUS_TRANS_NONE;
+    trans_free = 0;
+    memset( que_head, MBUS_TRANS_NONE, sizeof( que_head ) );
+    memset( que_tail, MBUS_TRANS_NONE, sizeof( que_tail ) );
     //таймер ожидания ответа
     timer_mbus = osTimerNew( Timer1Callback, osTimerOnce, NULL, &timer_attr );
-    //мьютех блокировки порта RS485
+    //мьютех блокировки очередей запросов
     mutex_mbus = osMutexNew( &mutex_attr );
-    //семафор ожидания ответа
-    mbus_semaphore = osSemaphoreNew( 1, 0, &sem_attr );
+    //семафор свободных элементов пула запросов
+    mbus_semaphore = osSemaphoreNew( MBUS_TRANS_MAX, MBUS_TRANS_MAX, &sem_attr );
     //очередь сообщений
     modbus_queue = osMessageQueueNew( 8, sizeof( uint32_t ), &que_attr );
     //создаем задачу управления обменом по MODBUS
@@ -173,42 +276,43 @@ void ModBusInit( void ) {
 
 //*************************************************************************************************
 // Задача управления обменом по протоколу MODBUS
+// Задача является единственным владельцем порта RS485: выбирает запросы из очередей уст-в,
+// передает их и завершает по приему ответа или таймауту
+// Сообщения о приеме и таймауте содержат номер запроса, сообщения предыдущих запросов (ответ
+// полученный после таймаута, таймаут после приема ответа) не обрабатываются
 //*************************************************************************************************
 static void TaskModbus( void *pvParameters ) {
 
     uint32_t msg;
     osStatus_t status;
-    uint16_t len_pack;
 
     for ( ;; ) {
         status = osMessageQueueGet( modbus_queue, &msg, NULL, osWaitForever );
-        if ( status == osOK ) {
-            //отправка сообщения
-            if ( msg & MSG_MODBUS_SEND ) {
-                //выделим размер передаваемого блока
-                len_pack = msg & MSG_MODBUS_MASK_DATA;
-                RS485Send( send_buff, len_pack, RS485_SEND_RTU );
-                osTimerStart( timer_mbus, TIMEOUT_ANSWER );
-               }
+        if ( status == osOK && trans_curr != MBUS_TRANS_NONE && ( msg & MSG_MODBUS_SEQ ) == trans_seq ) {
+            msg &= MSG_MODBUS_MASK;
             //проверка заголовка пакета
             if ( msg == MSG_MODBUS_CHECK )
-               osTimerStart( timer_mbus, TIMEOUT_ANSWER );
+               osTimerStart( timer_mbus, RecvTimeout() );
             //весь пакет получен
             if ( msg == MSG_MODBUS_RECV ) {
                 osTimerStop( timer_mbus );
-                osSemaphoreRelease( mbus_semaphore );
+                TransComplete();
                }
             //вышло время ожидания ответа
             if ( msg == MSG_MODBUS_TIMEOUT ) {
                 ClearRecv();
-                osSemaphoreRelease( mbus_semaphore );
+                TransComplete();
                }
           }
+        //порт свободен, запуск следующего запроса из очередей
+        while ( trans_curr == MBUS_TRANS_NONE && TransNext() == true );
       }
  }
 
 //*************************************************************************************************
 // Функция возвращает рассчитанный размер пакета ожидаемого к приему от уст-ва
+// Используется для завершения приема без ожидания интервала тишины 3.5 байта, если размер 
+// не определен (return = 0), окончание пакета определяется по интервалу тишины
 // uint8_t *data   - указатель на буфер с данными ответа, для расчета необходимо первые 3 байта
 // return uint16_t - размер пакета
 //*************************************************************************************************
@@ -221,7 +325,7 @@ uint16_t PackSize( uint8_t *data ) {
    else {
        //расчет размера пакета
        func = *( data + MB_ANSWER_FUNC );
-       if ( func == FUNC_RD_COIL_STAT || func == FUNC_RD_DISC_INP || func == FUNC_RD_HOLD_REG || func == FUNC_RD_INP_REG )
+       if ( func == FUNC_RD_COIL_STAT || func == FUNC_RD_DISC_INP || func == FUNC_RD_HOLD_REG || func == FUNC_RD_INP_REG || func == FUNC_RDWR_MULT_REG )
            return SIZE_PACK_HEADER + *( data + IND_BYTE_CMD01_04 ) + SIZE_CRC;
        if ( func == FUNC_WR_SING_COIL || func == FUNC_WR_SING_REG )
            return SIZE_PACK_0506;
@@ -232,95 +336,446 @@ uint16_t PackSize( uint8_t *data ) {
  }
 
 //*************************************************************************************************
-// Функция обратного вызова таймера - пауза между пакетами данных
+// Функция обратного вызова таймера - ожидание ответа от уст-ва
 //*************************************************************************************************
 static void Timer1Callback( void *arg ) {
 
     uint32_t msg;
     
-    msg = MSG_MODBUS_TIMEOUT;
+    msg = MSG_MODBUS_TIMEOUT | trans_seq;
     osMessageQueuePut( modbus_queue, &msg, 0, 0 );
  }
 
 //*************************************************************************************************
-// Отправка команды по MODBUS
+// Отправка команды по MODBUS с ожиданием результата, приоритет запроса MBUS_PRIO_NORMAL
 // MBUS_REQUEST *reqst - указатель на структуры с параметрами запроса
 // return ModBusError  - результат выполнения запроса
 //*************************************************************************************************
 ModBusError ModBusRequest( MBUS_REQUEST *reqst ) {
 
+    return ModBusRequestPrio( reqst, MBUS_PRIO_NORMAL );
+ }
+
+//*************************************************************************************************
+// Отправка команды по MODBUS с указанием приоритета и ожиданием результата
+// Запросы чтения регистров выполняются без использования кэша (MBUS_CACHE_FRESH), чтение
+// из кэша выполняется только через ModBusRequestCache() с режимом MBUS_CACHE_USE
+// MBUS_REQUEST *reqst - указатель на структуры с параметрами запроса
+// MBusPrio prio       - приоритет запроса в очереди уст-ва
+// return ModBusError  - результат выполнения запроса
+//*************************************************************************************************
+ModBusError ModBusRequestPrio( MBUS_REQUEST *reqst, MBusPrio prio ) {
+
+    return ModBusRequestCache( reqst, prio, MBUS_CACHE_FRESH );
+ }
+
+//*************************************************************************************************
+// Отправка команды по MODBUS с указанием приоритета, режима использования кэша и ожиданием
+// результата. Вызывающая задача блокируется только на время выполнения своего запроса
+// MBUS_REQUEST *reqst - указатель на структуры с параметрами запроса
+// MBusPrio prio       - приоритет запроса в очереди уст-ва
+// MBusCache cache     - MBUS_CACHE_USE - допускается значение из кэша, 
+//                       MBUS_CACHE_FRESH - только чтение из уст-ва
+// return ModBusError  - результат выполнения запроса
+//*************************************************************************************************
+ModBusError ModBusRequestCache( MBUS_REQUEST *reqst, MBusPrio prio, MBusCache cache ) {
+
+    ModBusError status, result;
+
+    if ( cache == MBUS_CACHE_USE && ModBusCacheRead( reqst ) == true )
+        return MBUS_ANSWER_OK; //значения регистров получены из кэша
+    osThreadFlagsClear( MBUS_FLAG_DONE );
+    result = TransAdd( reqst, prio, NULL, NULL, &status, osWaitForever );
+    if ( result != MBUS_ANSWER_OK )
+        return result;
+    //ждем завершения запроса
+    osThreadFlagsWait( MBUS_FLAG_DONE, osFlagsWaitAny, osWaitForever );
+    return status;
+ }
+
+//*************************************************************************************************
+// Постановка запроса в очередь уст-ва без ожидания результата
+// Параметры запроса копируются, буферы ptr_data, ptr_lendata должны оставаться доступными
+// до вызова функции callback
+// MBUS_REQUEST *reqst   - указатель на структуры с параметрами запроса
+// MBusPrio prio         - приоритет запроса в очереди уст-ва
+// MBusCallback callback - функция вызываемая по завершению запроса, может быть NULL
+// void *arg             - параметр передаваемый в функцию callback
+// return ModBusError    - MBUS_ANSWER_OK  - запрос добавлен в очередь
+//                       - MBUS_ERROR_BUSY - нет свободных элементов пула запросов
+//                       - MBUS_ERROR_PARAM - ошибка в параметрах запроса
+//*************************************************************************************************
+ModBusError ModBusSubmit( MBUS_REQUEST *reqst, MBusPrio prio, MBusCallback callback, void *arg ) {
+
+    return TransAdd( reqst, prio, callback, arg, NULL, 0 );
+ }
+
+//*************************************************************************************************
+// Добавление запроса в очередь уст-ва
+// MBUS_REQUEST *reqst     - указатель на структуры с параметрами запроса
+// MBusPrio prio           - приоритет запроса в очереди уст-ва
+// MBusCallback callback   - функция вызываемая по завершению запроса
+// void *arg               - параметр передаваемый в функцию callback
+// ModBusError *ptr_status - адрес переменной для результата (блокирующий вызов) или NULL
+// uint32_t timeout        - время ожидания свободного элемента пула
+// return ModBusError      - результат постановки запроса в очередь
+//*************************************************************************************************
+static ModBusError TransAdd( MBUS_REQUEST *reqst, MBusPrio prio, MBusCallback callback, void *arg, ModBusError *ptr_status, uint32_t timeout ) {
+
     uint32_t msg;
-    uint8_t *recv_buff;
-    uint16_t len_pack, recv_ind, len_data = 0, data_ind;
-    ModBusError status = MBUS_ERROR_PARAM;
+    uint8_t idx, que;
 
     if ( reqst->ptr_data == NULL || reqst->ptr_lendata == NULL || *reqst->ptr_lendata == 0 || ModBusFunc( reqst->function ) == MBUS_FUNC_UNKNOW )
         return MBUS_ERROR_PARAM;
-    //устанавливаем блокировку
+    if ( prio >= MBUS_PRIO_CNT )
+        return MBUS_ERROR_PARAM;
+    //резервируем элемент пула запросов
+    if ( osSemaphoreAcquire( mbus_semaphore, timeout ) != osOK )
+        return MBUS_ERROR_BUSY;
+    osMutexAcquire( mutex_mbus, osWaitForever );
+    idx = trans_free;
+    trans_free = trans[idx].next;
+    memcpy( (uint8_t *)&trans[idx].reqst, (uint8_t *)reqst, sizeof( MBUS_REQUEST ) );
+    trans[idx].callback = callback;
+    trans[idx].arg = arg;
+    trans[idx].ptr_status = ptr_status;
+    trans[idx].thread = ptr_status != NULL ? osThreadGetId() : NULL;
+    trans[idx].next = MBUS_TRANS_NONE;
+    //добавляем в конец очереди уст-ва с указанным приоритетом
+    que = SlaveQueue( reqst->dev_addr );
+    if ( que_head[que][prio] == MBUS_TRANS_NONE )
+        que_head[que][prio] = idx;
+    else trans[que_tail[que][prio]].next = idx;
+    que_tail[que][prio] = idx;
+    osMutexRelease( mutex_mbus );
+    //сообщение для задачи, если очередь сообщений заполнена, запрос будет
+    //выбран по завершению текущего
+    msg = MSG_MODBUS_QUEUE;
+    osMessageQueuePut( modbus_queue, &msg, 0, 0 );
+    return MBUS_ANSWER_OK;
+ }
+
+//*************************************************************************************************
+// Выбор следующего запроса и его передача. Запросы выбираются по уровню приоритета, 
+// для одного уровня приоритета - по очереди из очередей каждого уст-ва
+// return = true  - запрос выбран
+//        = false - очереди запросов пустые
+//*************************************************************************************************
+static bool TransNext( void ) {
+
+    uint8_t idx, que, prio, cnt;
+    uint16_t len_pack;
+    uint32_t pause;
+
     osMutexAcquire( mutex_mbus, osWaitForever );
-    //логирование данных запроса с расшифровкой
-    ModBusDecode( reqst, DATA_LOG_REQUEST, DATA_LOG_FILE );
+    for ( prio = 0, idx = MBUS_TRANS_NONE; prio < MBUS_PRIO_CNT && idx == MBUS_TRANS_NONE; prio++ ) {
+        for ( cnt = 0; cnt < MBUS_QUEUE_CNT; cnt++ ) {
+            que = ( que_last + 1 + cnt ) % MBUS_QUEUE_CNT;
+            idx = que_head[que][prio];
+            if ( idx == MBUS_TRANS_NONE )
+                continue;
+            //извлекаем запрос из очереди уст-ва
+            que_head[que][prio] = trans[idx].next;
+            if ( que_head[que][prio] == MBUS_TRANS_NONE )
+                que_tail[que][prio] = MBUS_TRANS_NONE;
+            que_last = que;
+            break;
+           }
+       }
+    osMutexRelease( mutex_mbus );
+    if ( idx == MBUS_TRANS_NONE )
+        return false;
+    trans_curr = idx;
+    //нет связи с уст-вом, запрос завершается без передачи до наступления времени проверки
+    if ( LinkSkip( SlaveLink( trans[idx].reqst.dev_addr ) ) == true ) {
+        TransDone( idx, MBUS_CONNECT_LOST );
+        return true;
+       }
+    //пауза между пакетами
+    pause = osKernelGetTickCount() - tick_end;
+    if ( pause < TIMEOUT_PAUSE )
+        osDelay( TIMEOUT_PAUSE - pause );
+    //запись регистров, значения в кэше становятся недействительными
+    if ( trans[idx].reqst.function == FUNC_WR_SING_REG )
+        ModBusCacheInvalid( trans[idx].reqst.dev_addr, trans[idx].reqst.addr_reg, 1 );
+    if ( trans[idx].reqst.function == FUNC_WR_MULT_REG )
+        ModBusCacheInvalid( trans[idx].reqst.dev_addr, trans[idx].reqst.addr_reg, trans[idx].reqst.cnt_reg );
+    if ( trans[idx].reqst.function == FUNC_RDWR_MULT_REG )
+        ModBusCacheInvalid( trans[idx].reqst.dev_addr, trans[idx].reqst.wr_addr, trans[idx].reqst.wr_cnt );
     //формируем пакет для передачи
-    len_pack = CreateFrame( reqst );
-    //логирование данных
-    DataLog( send_buff, len_pack, DATA_LOG_REQUEST );
-    if ( len_pack ) {
-        //установим семафор ожидания ответа уст-ва
-        osSemaphoreAcquire( mbus_semaphore, 0 );
-        send_total++;
-        //отправка запроса с указанием размера пакета
-        msg = MSG_MODBUS_SEND | len_pack;
-        osMessageQueuePut( modbus_queue, &msg, 0, osWaitForever );
-        //ждем ответа от устройства
-        osSemaphoreAcquire( mbus_semaphore, osWaitForever );
-        //получаем адрес приемного буфера и размер принятого ответа
-        recv_buff = RS485Recv( &recv_ind );
-        //логирование HEX данных ответа
-        DataLog( recv_buff, recv_ind, DATA_LOG_ANSWER );
-        //обработка ответа, после обработки в 16-битных данных байты будут переставлены местами
-        status = AnswerData( recv_buff, recv_ind );
-        if ( status == MBUS_ANSWER_OK ) {
-            //только чтение регистров
-            if ( ModBusFunc( reqst->function ) == MBUS_REGS_READ ) {
-                data_ind = MB_ANSWER_DATA_RD;         //смещение начала данных
-                len_data = recv_buff[MB_ANSWER_COUNT];//размер фактически принятых данных
-               }
-            //запись одного/нескольких регистров
-            if ( ModBusFunc( reqst->function ) == MBUS_REG1_WRITE || ModBusFunc( reqst->function ) == MBUS_REGS_WRITE ) {
-                data_ind = MB_ANSWER_DATA_WR; //смещение начала данных ответа
-                len_data = MB_ANSWER_WRREG;   //размер принятых данных
-               }
-            //скопируем принятые данные ответа в MBUS_REQUEST->ptr_data
-            if ( len_data <= *reqst->ptr_lendata ) {
-                //размер принятых данных меньше размера выделенной памяти, копируем все
-                *reqst->ptr_lendata = len_data;
-                memcpy( (uint8_t *)reqst->ptr_data, recv_buff + data_ind, len_data );
-               }
-            //размер принятых данных больше размера выделенной памяти, копируем только часть
-            else memcpy( (uint8_t *)reqst->ptr_data, recv_buff + data_ind, *reqst->ptr_lendata );
+    len_pack = CreateFrame( &trans[idx].reqst );
+    if ( !len_pack ) {
+        TransDone( idx, MBUS_ERROR_PARAM );
+        return true;
+       }
+    //захват кадра запроса
+    ModBusCapture( MBUS_CAP_REQST, &trans[idx].reqst, send_buff, len_pack, 0 );
+    send_total++;
+    //время ожидания: время ответа уст-ва + время передачи запроса и ответа
+    send_len = len_pack;
+    timeout_curr = LinkTimeout( SlaveLink( trans[idx].reqst.dev_addr ) ) + FrameTime( len_pack + AnswerSize( &trans[idx].reqst ) );
+    tick_send = osKernelGetTickCount();
+    trans_seq = ( trans_seq + 1 ) & MSG_MODBUS_SEQ;
+    RS485Send( send_buff, len_pack, RS485_SEND_RTU, trans_seq );
+    osTimerStart( timer_mbus, timeout_curr );
+    return true;
+ }
 
-            /*if ( *reqst->ptr_lendata == 0 ) {
-                len_data++;
-                len_data--;
-               } */
+//*************************************************************************************************
+// Обработка ответа на текущий запрос: копирование данных, подсчет ошибок, завершение запроса
+//*************************************************************************************************
+static void TransComplete( void ) {
 
-            //логирование данных ответа с расшифровкой
-            ModBusDecode( reqst, DATA_LOG_ANSWER, DATA_LOG_FILE );
+    uint8_t *recv_buff;
+    uint16_t recv_ind, len_data = 0, data_ind = 0;
+    uint32_t rtt, wire;
+    MBUS_REQUEST *reqst;
+    ModBusError status;
+
+    reqst = &trans[trans_curr].reqst;
+    //получаем адрес приемного буфера и размер принятого ответа
+    recv_buff = RS485Recv( &recv_ind );
+    //захват кадра ответа до перестановки байт
+    ModBusCapture( MBUS_CAP_ANSWER, reqst, recv_buff, recv_ind, osKernelGetTickCount() - tick_send );
+    //обработка ответа, после обработки в 16-битных данных байты будут переставлены местами
+    status = AnswerData( recv_buff, recv_ind );
+    ModBusCapStatus( status );
+    if ( status == MBUS_ANSWER_OK ) {
+        //только чтение регистров
+        if ( ModBusFunc( reqst->function ) == MBUS_REGS_READ ) {
+            data_ind = MB_ANSWER_DATA_RD;         //смещение начала данных
+            len_data = recv_buff[MB_ANSWER_COUNT];//размер фактически принятых данных
            }
-        else {
-            *reqst->ptr_lendata = 0;
-            //подсчет ошибок обмена
-            if ( status < SIZE_ARRAY( error_cnt ) ) {
-                error_cnt[status]++;
-                if ( ( reqst->dev_addr - 1 ) < DEV_ERROR_CNT ) 
-                    error_dev[reqst->dev_addr-1][status]++;
-               }
+        //запись одного/нескольких регистров
+        if ( ModBusFunc( reqst->function ) == MBUS_REG1_WRITE || ModBusFunc( reqst->function ) == MBUS_REGS_WRITE ) {
+            data_ind = MB_ANSWER_DATA_WR; //смещение начала данных ответа
+            len_data = MB_ANSWER_WRREG;   //размер принятых данных
+           }
+        //скопируем принятые данные ответа в MBUS_REQUEST->ptr_data
+        if ( len_data <= *reqst->ptr_lendata ) {
+            //размер принятых данных меньше размера выделенной памяти, копируем все
+            *reqst->ptr_lendata = len_data;
+            memcpy( (uint8_t *)reqst->ptr_data, recv_buff + data_ind, len_data );
+           }
+        //размер принятых данных больше размера выделенной памяти, копируем только часть
+        else memcpy( (uint8_t *)reqst->ptr_data, recv_buff + data_ind, *reqst->ptr_lendata );
+        //сохраним прочитанные значения регистров в кэше
+        ModBusCacheStore( reqst );
+       }
+    else {
+        *reqst->ptr_lendata = 0;
+        //подсчет ошибок обмена
+        if ( status < SIZE_ARRAY( error_cnt ) ) {
+            error_cnt[status]++;
+            if ( ( reqst->dev_addr - 1 ) < DEV_ERROR_CNT ) 
+                error_dev[reqst->dev_addr-1][status]++;
            }
-        osDelay( 5 ); //пауза между пакетами
        }
-    //снимаем блокировку
+    tick_end = osKernelGetTickCount();
+    //время ответа уст-ва без времени передачи запроса и ответа
+    rtt = tick_end - tick_send;
+    wire = FrameTime( send_len + recv_ind );
+    LinkUpdate( SlaveLink( reqst->dev_addr ), status, rtt > wire ? rtt - wire : 0 );
+    TransDone( trans_curr, status );
+ }
+
+//*************************************************************************************************
+// Завершение запроса: передача результата, освобождение элемента пула
+// uint8_t idx        - индекс запроса в пуле
+// ModBusError status - результат выполнения запроса
+//*************************************************************************************************
+static void TransDone( uint8_t idx, ModBusError status ) {
+
+    osThreadId_t thread;
+
+    if ( trans[idx].callback != NULL )
+        trans[idx].callback( &trans[idx].reqst, status, trans[idx].arg );
+    if ( trans[idx].ptr_status != NULL )
+        *trans[idx].ptr_status = status;
+    thread = trans[idx].thread;
+    //возвращаем элемент в список свободных
+    osMutexAcquire( mutex_mbus, osWaitForever );
+    trans[idx].next = trans_free;
+    trans_free = idx;
     osMutexRelease( mutex_mbus );
-    return status;
+    trans_curr = MBUS_TRANS_NONE;
+    osSemaphoreRelease( mbus_semaphore );
+    //разблокируем задачу ожидающую результат
+    if ( thread != NULL )
+        osThreadFlagsSet( thread, MBUS_FLAG_DONE );
+ }
+
+//*************************************************************************************************
+// Возвращает индекс очереди запросов по адресу уст-ва
+// uint8_t dev_addr - адрес уст-ва
+// return uint8_t   - индекс очереди
+//*************************************************************************************************
+static uint8_t SlaveQueue( uint8_t dev_addr ) {
+
+    if ( dev_addr && ( dev_addr - 1 ) < DEV_ERROR_CNT )
+        return dev_addr - 1;
+    return MBUS_QUEUE_CNT - 1; //общая очередь для остальных адресов
+ }
+
+//*************************************************************************************************
+// Возвращает указатель на состояние связи с уст-вом по адресу уст-ва
+// uint8_t dev_addr   - адрес уст-ва
+// return MBUS_LINK * - состояние связи, NULL - для адреса учет не ведется
+//*************************************************************************************************
+static MBUS_LINK *SlaveLink( uint8_t dev_addr ) {
+
+    if ( dev_addr && ( dev_addr - 1 ) < DEV_ERROR_CNT )
+        return &dev_link[dev_addr-1];
+    return NULL;
+ }
+
+//*************************************************************************************************
+// Проверка необходимости отклонить запрос без передачи: связи с уст-вом нет и время следующей
+// проверки связи не наступило. Если время проверки наступило, запрос передается как пробный.
+// MBUS_LINK *ptr - состояние связи с уст-вом
+// return = true  - запрос не передавать
+//*************************************************************************************************
+static bool LinkSkip( MBUS_LINK *ptr ) {
+
+    if ( ptr == NULL || ptr->offline == false )
+        return false;
+    if ( (int32_t)( osKernelGetTickCount() - ptr->probe_tick ) >= 0 )
+        return false; //пробный запрос
+    ptr->cnt_skip++;
+    error_cnt[MBUS_CONNECT_LOST]++;
+    error_dev[ptr - dev_link][MBUS_CONNECT_LOST]++;
+    return true;
+ }
+
+//*************************************************************************************************
+// Расчет времени ожидания ответа от уст-ва с учетом удвоения после таймаутов
+// MBUS_LINK *ptr  - состояние связи с уст-вом
+// return uint32_t - время ожидания ответа (msec)
+//*************************************************************************************************
+static uint32_t LinkTimeout( MBUS_LINK *ptr ) {
+
+    uint32_t timeout;
+
+    if ( ptr == NULL )
+        return TIMEOUT_ANSWER;
+    if ( ptr->offline == true )
+        return LINK_RTO_MAX; //пробный запрос
+    timeout = ptr->rto << ptr->backoff;
+    if ( timeout > LINK_RTO_MAX )
+        timeout = LINK_RTO_MAX;
+    return timeout;
+ }
+
+//*************************************************************************************************
+// Возвращает ожидаемый размер ответа на запрос без ошибки
+// MBUS_REQUEST *reqst - параметры запроса
+// return uint16_t     - размер пакета ответа (байт)
+//*************************************************************************************************
+static uint16_t AnswerSize( MBUS_REQUEST *reqst ) {
+
+    uint16_t size;
+
+    if ( ModBusFunc( reqst->function ) == MBUS_REG1_WRITE )
+        return SIZE_PACK_0506;
+    if ( ModBusFunc( reqst->function ) == MBUS_REGS_WRITE )
+        return SIZE_PACK_0F10;
+    if ( ModBusFunc( reqst->function ) != MBUS_REGS_READ )
+        return sizeof( send_buff ); //размер не определен
+    if ( ModBusAddr( reqst->function ) == MBUS_REG_8BIT )
+        size = ( reqst->cnt_reg + 7 ) / 8;
+    else size = reqst->cnt_reg * sizeof( uint16_t );
+    size += SIZE_PACK_HEADER + SIZE_CRC;
+    return size > sizeof( send_buff ) ? sizeof( send_buff ) : size;
+ }
+
+//*************************************************************************************************
+// Возвращает время передачи пакета
+// uint16_t size   - размер пакета (байт)
+// return uint32_t - время передачи (msec)
+//*************************************************************************************************
+static uint32_t FrameTime( uint16_t size ) {
+
+    return ( size * MBUS_CHAR_TIME + 999 ) / 1000;
+ }
+
+//*************************************************************************************************
+// Возвращает время ожидания оставшейся части ответа после приема заголовка пакета
+// Размер ответа определяется по заголовку, если размер не определен - по параметрам запроса
+// return uint32_t - время ожидания (msec)
+//*************************************************************************************************
+static uint32_t RecvTimeout( void ) {
+
+    uint8_t *recv_buff;
+    uint16_t recv_ind, size = 0;
+
+    recv_buff = RS485Recv( &recv_ind );
+    if ( recv_buff != NULL )
+        size = PackSize( recv_buff );
+    if ( !size )
+        size = AnswerSize( &trans[trans_curr].reqst );
+    return FrameTime( size > recv_ind ? size - recv_ind : 0 ) + TIMEOUT_FRAME_GAP;
+ }
+
+//*************************************************************************************************
+// Обновление состояния связи с уст-вом по результату выполнения запроса
+// Время ответа учитывается только для успешных запросов, любой принятый ответ (в т.ч. с ошибкой)
+// подтверждает наличие связи, таймаут увеличивает время ожидания следующего ответа в 2 раза.
+// MBUS_LINK *ptr     - состояние связи с уст-вом
+// ModBusError status - результат выполнения запроса
+// uint32_t rtt       - время ответа уст-ва без времени передачи запроса и ответа (msec)
+//*************************************************************************************************
+static void LinkUpdate( MBUS_LINK *ptr, ModBusError status, uint32_t rtt ) {
+
+    int32_t delta;
+
+    if ( ptr == NULL )
+        return;
+    if ( status == MBUS_ANSWER_TIMEOUT ) {
+        if ( ptr->offline == true ) {
+            //пробный запрос без ответа, увеличиваем интервал проверки
+            ptr->probe_int *= 2;
+            if ( ptr->probe_int > LINK_PROBE_MAX )
+                ptr->probe_int = LINK_PROBE_MAX;
+            ptr->probe_tick = osKernelGetTickCount() + ptr->probe_int;
+            return;
+           }
+        if ( ptr->backoff < LINK_BACKOFF_MAX )
+            ptr->backoff++;
+        if ( ++ptr->fail >= LINK_FAIL_OFFLINE ) {
+            ptr->offline = true;
+            ptr->cnt_offline++;
+            ptr->probe_int = LINK_PROBE_MIN;
+            ptr->probe_tick = osKernelGetTickCount() + ptr->probe_int;
+           }
+        return;
+       }
+    //ответ получен, связь есть
+    ptr->fail = 0;
+    ptr->backoff = 0;
+    ptr->offline = false;
+    if ( status != MBUS_ANSWER_OK )
+        return;
+    if ( rtt > ptr->rtt_max )
+        ptr->rtt_max = rtt;
+    if ( !ptr->srtt ) {
+        //первое измерение
+        ptr->srtt = rtt << 3;
+        ptr->rttvar = rtt << 1;
+       }
+    else {
+        //srtt = 7/8 * srtt + 1/8 * rtt, rttvar = 3/4 * rttvar + 1/4 * |srtt - rtt|
+        delta = (int32_t)rtt - (int32_t)( ptr->srtt >> 3 );
+        ptr->srtt += delta;
+        if ( delta < 0 )
+            delta = -delta;
+        ptr->rttvar += delta - ( ptr->rttvar >> 2 );
+       }
+    //rto = srtt + 4 * rttvar
+    ptr->rto = ( ptr->srtt >> 3 ) + ptr->rttvar;
+    if ( ptr->rto < LINK_RTO_MIN )
+        ptr->rto = LINK_RTO_MIN;
+    if ( ptr->rto > LINK_RTO_MAX )
+        ptr->rto = LINK_RTO_MAX;
  }
 
 //*************************************************************************************************
@@ -335,7 +790,32 @@ static uint8_t CreateFrame( MBUS_REQUEST *reqst ) {
     MBUS_REQ_REG mbus_req;
     MBUS_WRT_REG mbus_reg;
     MBUS_WRT_REGS mbus_regs;
-
+    MBUS_RDWR_REGS mbus_rdwr;
+
+    //запись и чтение нескольких регистров (17), запись выполняется до чтения
+    if ( reqst->function == FUNC_RDWR_MULT_REG ) {
+        if ( reqst->ptr_wrdata == NULL || !reqst->wr_cnt || reqst->wr_cnt > MBUS_MAX_RDWR_REGS )
+            return 0;
+        mbus_rdwr.dev_addr = reqst->dev_addr;
+        mbus_rdwr.function = reqst->function;
+        mbus_rdwr.rd_addr = __REVSH( reqst->addr_reg );
+        mbus_rdwr.rd_cnt = __REVSH( reqst->cnt_reg );
+        mbus_rdwr.wr_addr = __REVSH( reqst->wr_addr );
+        mbus_rdwr.wr_cnt = __REVSH( reqst->wr_cnt );
+        mbus_rdwr.cnt_byte = reqst->wr_cnt * sizeof( uint16_t );
+        data_len = sizeof( MBUS_RDWR_REGS );
+        memset( send_buff, 0x00, sizeof( send_buff ) );
+        memcpy( send_buff, &mbus_rdwr, data_len );
+        //данные регистров записи
+        src = (uint16_t *)reqst->ptr_wrdata;
+        dst = (uint16_t *)( send_buff + data_len );
+        for ( idx = 0; idx < reqst->wr_cnt; idx++, src++, dst++ )
+            *dst = __REVSH( *src );
+        data_len += idx * sizeof( uint16_t );
+        value = CalcCRC16( send_buff, data_len );
+        memcpy( send_buff + data_len, (uint8_t *)&value, sizeof( uint16_t ) );
+        return data_len + sizeof( uint16_t );
+       }
     //только чтение регистров
     if ( ModBusFunc( reqst->function ) == MBUS_REGS_READ ) {
         mbus_req.dev_addr = reqst->dev_addr;
@@ -416,14 +896,12 @@ static uint8_t CreateFrame( MBUS_REQUEST *reqst ) {
 static ModBusError AnswerData( uint8_t *data, uint8_t pack_len ) {
 
     uint8_t func, len_data, idx, cnt_word;
-    uint16_t crc_calc, crc_data, offset, *ptr_uint16;
+    uint16_t offset, *ptr_uint16;
 
     if ( data == NULL || !pack_len )
         return MBUS_ANSWER_TIMEOUT;
-    //проверим КС всего пакета
-    crc_calc = CalcCRC16( data, pack_len - sizeof( uint16_t ) );
-    crc_data = *((uint16_t*)( data + pack_len - sizeof( uint16_t ) ));
-    if ( crc_calc != crc_data )
+    //КС всего пакета рассчитана при приеме, включая CRC пакета
+    if ( pack_len <= sizeof( uint16_t ) || RS485RecvCRC() )
         return MBUS_ANSWER_CRC; //КС не совпали
     //проверим флаг ошибки в пакете
     if ( data[MB_ANSWER_FUNC] & FUNC_ANSWER_ERROR )
@@ -454,7 +932,7 @@ ModbusFunc ModBusFunc( uint8_t func ) {
 
     //функции чтения нескольких регистров
     if ( func == FUNC_RD_COIL_STAT || func == FUNC_RD_DISC_INP || func == FUNC_RD_HOLD_REG || \
-         func == FUNC_RD_INP_REG || func == FUNC_RD_EXCP_STAT || func == FUNC_RD_DIAGNOSTIC )
+         func == FUNC_RD_INP_REG || func == FUNC_RD_EXCP_STAT || func == FUNC_RD_DIAGNOSTIC || func == FUNC_RDWR_MULT_REG )
         return MBUS_REGS_READ;
     //функции записи одного регистра
     if ( func == FUNC_WR_SING_COIL || func == FUNC_WR_SING_REG || func == FUNC_WR_MASK_REG )
@@ -480,37 +958,11 @@ ModbusAddrReg ModBusAddr( uint8_t func ) {
     if ( func == FUNC_RD_HOLD_REG || func == FUNC_RD_INP_REG || func == FUNC_WR_SING_REG || \
          func == FUNC_WR_MULT_REG || func == FUNC_WR_MASK_REG || func == FUNC_RD_FIFO_QUE || \
          func == FUNC_RD_FILE_REC || func == FUNC_WR_FILE_REC ||  func == FUNC_RD_EVENT_CNT || \
-          func == FUNC_RD_DIAGNOSTIC || func == FUNC_RD_EVENT_LOG )
+          func == FUNC_RD_DIAGNOSTIC || func == FUNC_RD_EVENT_LOG || func == FUNC_RDWR_MULT_REG )
         return MBUS_REG_16BIT;
     return MBUS_REG_OTHER;
  }
 
-//*************************************************************************************************
-// Вкл/Выкл логирования данных запрос/ответ
-// Mode mode        - вкл/выкл логирование запросов ответов уст-в в сети MODBUS
-// return = SUCCESS - логирование включено
-//        = ERROR   - логирование выключено
-//*************************************************************************************************
-Status ModbusLog( Mode mode ) {
-
-    if ( SDStatus() == ERROR )
-        return ERROR; //SD карты нет
-    if ( mode ) {
-        //открываем файл
-        modbus_log = fopen( "modbus_data.log", "a" );
-        if ( modbus_log != NULL )
-            return SUCCESS;
-        else return ERROR;
-       }
-    else {
-        if ( modbus_log != NULL ) {
-            fclose( modbus_log );
-            modbus_log = NULL;
-           }
-        return SUCCESS;
-       }
- }
-
 //*************************************************************************************************
 // Возвращает указатель на строку расшифровки результата выполнения запроса по протоколу MODBUS
 // ModBusError error - код ошибки обработки принятого ответа от уст-ва
@@ -528,9 +980,16 @@ char *ModBusErrDesc( ModBusError error ) {
 //*************************************************************************************************
 void ModBusErrClr( void ) {
 
+    uint8_t i;
+
     send_total = 0;
     memset( (uint8_t *)&error_cnt, 0x00, sizeof( error_cnt ) );
     memset( (uint8_t *)&error_dev, 0x00, sizeof( error_dev ) );
+    for ( i = 0; i < DEV_ERROR_CNT; i++ ) {
+        dev_link[i].rtt_max = 0;
+        dev_link[i].cnt_offline = 0;
+        dev_link[i].cnt_skip = 0;
+       }
  }
 
 //*************************************************************************************************
@@ -576,43 +1035,52 @@ char *ModBusErrCntDesc( ModBusError err_ind, char *str ) {
  }
 
 //*************************************************************************************************
-// Запись в протокол запросов и ответов протокола MODBUS
-// uint8_t *data      - указатель на данные
-// uint16_t len       - кол-во байт данных
-// DataLogMode mode   - тип источника данных: запрос/ответ
+// Возвращает расшифровку и значения параметров состояния связи с уст-вами
+// Формат строки соответствует ModBusErrCntDesc(), значения выводятся по адресам уст-в
+// MBusLinkStat ind - индекс параметра
+// char *str        - буфер для размещения строки
+// return           - указатель на строку, NULL - недопустимый индекс
 //*************************************************************************************************
-static void DataLog( uint8_t *data, uint16_t len, DataLogMode mode ) {
+char *ModBusLinkDesc( MBusLinkStat ind, char *str ) {
 
     uint8_t i;
-    char *ptr, str[180];
-    
-    if ( SDStatus() == ERROR )
-        return; //SD карты нет
-    if ( modbus_log == NULL )
-        return; //файл не открыт
-    //формируем строку с значения в формате 0xNN
-    if ( mode == DATA_LOG_REQUEST )
-        fprintf( modbus_log, "REQ: " );
-    if ( mode == DATA_LOG_ANSWER )
-        fprintf( modbus_log, "ANS: " );
-    if ( !len )
-        fprintf( modbus_log, "%s", ModBusErrDesc( MBUS_ANSWER_TIMEOUT ) );
+    char *ptr;
+    uint32_t value = 0;
+
+    if ( ind >= SIZE_ARRAY( link_descr ) )
+        return NULL;
     ptr = str;
-    memset( str, 0x00, sizeof( str ) );
-    for ( i = 0; i < len; i++ )
-        ptr += sprintf( ptr, "%02X ", *( data + i ) );
-    fprintf( modbus_log, "%s\r\n", str );
+    ptr += sprintf( ptr, "%s", link_descr[ind] );
+    ptr += AddDot( str, 40 );
+    ptr += sprintf( ptr, "%6s ", "" );
+    for ( i = 0; i < DEV_ERROR_CNT; i++ ) {
+        if ( ind == MBUS_LINK_SRTT )
+            value = dev_link[i].srtt >> 3;
+        if ( ind == MBUS_LINK_RTTVAR )
+            value = dev_link[i].rttvar >> 2;
+        if ( ind == MBUS_LINK_RTO )
+            value = LinkTimeout( &dev_link[i] );
+        if ( ind == MBUS_LINK_RTT_MAX )
+            value = dev_link[i].rtt_max;
+        if ( ind == MBUS_LINK_OFFLINE )
+            value = dev_link[i].cnt_offline;
+        if ( ind == MBUS_LINK_SKIP )
+            value = dev_link[i].cnt_skip;
+        if ( ind == MBUS_LINK_STATE )
+            value = dev_link[i].offline;
+        ptr += sprintf( ptr, "%6u ", value );
+       }
+    return str;
  }
 
 //*************************************************************************************************
 // Формирует в буфере расшифровку запроса и ответа данных MODBUS протокола
 // При кол-ве регистров > 10, выводиться только 10 регистров
-// Логирование в файл выполняется автоматически при включении логирования
 // MBUS_REQUEST *reqst - указатель на структуру с данными запроса/ответа
 // DataLogMode mode    - тип информации: запрос/ответ
 // return              - указатель на (str_log[]) расшифрованные данные
 //*************************************************************************************************
-char *ModBusDecode( MBUS_REQUEST *reqst, DataLogMode mode, DataLogFile log ) {
+char *ModBusDecode( MBUS_REQUEST *reqst, DataLogMode mode ) {
 
     char *ptr;
     uint8_t i, *ptr_reg8;
@@ -677,8 +1145,5 @@ char *ModBusDecode( MBUS_REQUEST *reqst, DataLogMode mode, DataLogFile log ) {
         if ( reqst->cnt_reg > 10 )
             ptr += sprintf( ptr, "..." );
       }
-    //автоматическое логирование в файл
-    if ( SDStatus() == SUCCESS && modbus_log != NULL && log == DATA_LOG_FILE )
-        fprintf( modbus_log, "%s\r\n", str_log );
     return str_log;
  }
@@ -13,19 +13,44 @@
 
 #define CNT_REPEAT_REQST        3       //кол-во попыток отправки запроса если уст-во не отвечает
 
+#define MBUS_MAX_RD_REGS        125     //максимальное кол-во регистров чтения в одном запросе (0x03)
+#define MBUS_MAX_WR_REGS        123     //максимальное кол-во регистров записи в одном запросе (0x10)
+#define MBUS_MAX_RDWR_REGS      121     //максимальное кол-во регистров записи в запросе 0x17
+
 //пересчет кол-ва бит в кол-во байт
 #define CALC_BYTE( bits )       ( bits%8 ? (bits/8)+1 : bits/8 )
 
-// Тип данных для логирования
+// Тип данных для расшифровки
 typedef enum {
-    DATA_LOG_REQUEST,                   //запрос (автоматическая запись в файл)
-    DATA_LOG_ANSWER                     //ответ (автоматическая запись в файл)
+    DATA_LOG_REQUEST,                   //запрос
+    DATA_LOG_ANSWER                     //ответ
  } DataLogMode;
 
+// Приоритет запроса в очереди уст-ва
+typedef enum {
+    MBUS_PRIO_HIGH,                     //команды управления (останов генератора и т.д.)
+    MBUS_PRIO_NORMAL,                   //запросы по умолчанию
+    MBUS_PRIO_LOW,                      //циклический опрос состояния уст-в
+    MBUS_PRIO_CNT                       //кол-во уровней приоритета
+ } MBusPrio;
+
+// Использование кэша регистров при чтении
+typedef enum {
+    MBUS_CACHE_USE,                     //допускается значение из кэша
+    MBUS_CACHE_FRESH                    //только чтение из уст-ва
+ } MBusCache;
+
+// Параметры состояния связи с уст-вом
 typedef enum {
-    DATA_LOG_NO_FILE,                   //без записи в файл
-    DATA_LOG_FILE                       //автоматическая запись в файл
- } DataLogFile;
+    MBUS_LINK_SRTT,                     //сглаженное время ответа
+    MBUS_LINK_RTTVAR,                   //отклонение времени ответа
+    MBUS_LINK_RTO,                      //текущее время ожидания ответа
+    MBUS_LINK_RTT_MAX,                  //максимальное время ответа
+    MBUS_LINK_OFFLINE,                  //кол-во переходов в состояние "нет связи"
+    MBUS_LINK_SKIP,                     //кол-во запросов отклоненных без передачи
+    MBUS_LINK_STATE,                    //текущее состояние связи
+    MBUS_LINK_CNT                       //кол-во параметров
+ } MBusLinkStat;
 
 #pragma pack( push, 1 )                 //выравнивание структуры по границе 1 байта
 
@@ -40,16 +65,28 @@ typedef struct {
     void     *ptr_data;                 //Указатель на буфер для размещения передаваемых данных 
                                         //регистров, после приема - указатель на принятые данные
     uint16_t *ptr_lendata;              //Указатель на переменную размера буфера для приема данных
-} MBUS_REQUEST;                         //после приема - кол-во принятых байт без служебной информации
+                                        //после приема - кол-во принятых байт без служебной информации
+    uint16_t wr_addr;                   //Адрес первого регистра записи (только для функции 0x17)
+    uint16_t wr_cnt;                    //Количество регистров записи (только для функции 0x17)
+    void     *ptr_wrdata;               //Указатель на данные регистров записи (только для функции 0x17)
+} MBUS_REQUEST;
 
 #pragma pack( pop )
 
+//*************************************************************************************************
+// Функция обратного вызова завершения асинхронного запроса, выполняется в контексте задачи
+// "Modbus", блокирующие вызовы (в т.ч. ModBusRequest()) из функции недопустимы
+// MBUS_REQUEST *reqst - параметры выполненного запроса
+// ModBusError status  - результат выполнения запроса
+// void *arg           - параметр переданный в ModBusSubmit()
+//*************************************************************************************************
+typedef void ( *MBusCallback )( MBUS_REQUEST *reqst, ModBusError status, void *arg );
+
 //*************************************************************************************************
 // Функции управления
 //*************************************************************************************************
 void ModBusInit( void );
 void ModBusDebug( void  );
-Status ModbusLog( Mode mode );
 void ModBusErrClr( void );
 
 //*************************************************************************************************
@@ -59,9 +96,13 @@ uint16_t PackSize( uint8_t *data );
 uint32_t ModBusErrCnt( ModBusError error );
 char *ModBusErrDesc( ModBusError error );
 char *ModBusErrCntDesc( ModBusError err_ind, char *str );
+char *ModBusLinkDesc( MBusLinkStat ind, char *str );
 ModbusFunc ModBusFunc( uint8_t func );
 ModbusAddrReg ModBusAddr( uint8_t func );
 ModBusError ModBusRequest( MBUS_REQUEST *reqst );
-char *ModBusDecode( MBUS_REQUEST *reqst, DataLogMode mode, DataLogFile log );
+ModBusError ModBusRequestPrio( MBUS_REQUEST *reqst, MBusPrio prio );
+ModBusError ModBusRequestCache( MBUS_REQUEST *reqst, MBusPrio prio, MBusCache cache );
+ModBusError ModBusSubmit( MBUS_REQUEST *reqst, MBusPrio prio, MBusCallback callback, void *arg );
+char *ModBusDecode( MBUS_REQUEST *reqst, DataLogMode mode );
 
 #endif
@@ -0,0 +1,232 @@
+
+//*************************************************************************************************
+//
+// Кэш значений регистров уст-в MODBUS
+// Значения регистров чтения (функция 0x03) сохраняются после успешного ответа и выдаются
+// без обращения к шине в течении времени актуальности (TTL), заданного для блока регистров.
+// Запись в регистры уст-ва делает недействительными значения регистров с теми же адресами,
+// если адреса регистров записи уст-ва не совпадают с регистрами чтения - весь блок уст-ва.
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "cmsis_os2.h"
+
+#include "device.h"
+
+#include "modbus.h"
+#include "modbus_def.h"
+#include "modbus_cache.h"
+#include "tracker_ext.h"
+#include "voice_ext.h"
+#include "gen_ext.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define CACHE_NONE              0xFF        //признак отсутствия блока регистров
+#define CACHE_REGS              ( EXTRC_REG_RD_MAX + EXVOI_REG_RD_MAX + EXGEN_REG_RD_MAX )
+#define CACHE_AREA_CNT          ( sizeof( cache_area )/sizeof( CACHE_AREA ) )
+
+//*************************************************************************************************
+// Блок кэшируемых регистров уст-ва
+//*************************************************************************************************
+typedef struct {
+    uint8_t  dev_addr;                  //адрес уст-ва
+    uint16_t addr_reg;                  //адрес первого регистра
+    uint16_t cnt_reg;                   //кол-во регистров
+    uint32_t ttl;                       //время актуальности значений (msec)
+    bool     shared;                    //адреса регистров записи совпадают с регистрами чтения
+ } CACHE_AREA;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+//время актуальности соответствует периоду циклического опроса уст-ва,
+//у всех уст-в регистры записи (команды, параметры) имеют собственные адреса
+static const CACHE_AREA cache_area[] = {
+    { MB_ID_DEV_TRACKER,    EXTRC_REG_RD_STAT,  EXTRC_REG_RD_MAX,   500,    false },
+    { MB_ID_DEV_VOICE,      EXVOI_REG_RD_STAT,  EXVOI_REG_RD_MAX,   1000,   false },
+    { MB_ID_DEV_GEN,        EXGEN_REG_RD_MODE,  EXGEN_REG_RD_MAX,   500,    false }
+ };
+
+static uint16_t cache_data[CACHE_REGS];                 //значения регистров
+static uint32_t cache_tick[CACHE_REGS];                 //время получения значений
+static bool cache_valid[CACHE_REGS];                    //значения действительны
+static uint32_t cache_stat[MBUS_CACHE_STALE + 1];       //счетчики обращений к кэшу
+
+static osMutexId_t mutex_cache;
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osMutexAttr_t mutex_attr = { .name = "ModbusCache", .attr_bits = osMutexPrioInherit };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static uint8_t CacheArea( uint8_t dev_addr, uint16_t addr_reg, uint16_t cnt_reg, uint16_t *offset );
+
+//*************************************************************************************************
+// Инициализация кэша
+//*************************************************************************************************
+void ModBusCacheInit( void ) {
+
+    memset( cache_valid, 0x00, sizeof( cache_valid ) );
+    memset( cache_stat, 0x00, sizeof( cache_stat ) );
+    mutex_cache = osMutexNew( &mutex_attr );
+ }
+
+//*************************************************************************************************
+// Выполнение запроса чтения регистров из кэша
+// Если значения всех регистров запроса действительны и актуальны, они копируются в буфер
+// MBUS_REQUEST->ptr_data, в MBUS_REQUEST->ptr_lendata возвращается кол-во байт
+// MBUS_REQUEST *reqst - указатель на структуры с параметрами запроса
+// return = true       - запрос выполнен из кэша
+//        = false      - запрос необходимо выполнить по шине
+//*************************************************************************************************
+bool ModBusCacheRead( MBUS_REQUEST *reqst ) {
+
+    bool stale = false;
+    uint8_t area;
+    uint16_t i, offset, len;
+    uint32_t tick;
+
+    if ( reqst->ptr_data == NULL || reqst->ptr_lendata == NULL || reqst->function != FUNC_RD_HOLD_REG )
+        return false;
+    area = CacheArea( reqst->dev_addr, reqst->addr_reg, reqst->cnt_reg, &offset );
+    if ( area == CACHE_NONE )
+        return false; //регистры не кэшируются
+    tick = osKernelGetTickCount();
+    osMutexAcquire( mutex_cache, osWaitForever );
+    for ( i = offset; i < offset + reqst->cnt_reg; i++ ) {
+        if ( cache_valid[i] == false ) {
+            cache_stat[MBUS_CACHE_MISS]++;
+            osMutexRelease( mutex_cache );
+            return false;
+           }
+        if ( tick - cache_tick[i] >= cache_area[area].ttl )
+            stale = true;
+       }
+    if ( stale == true ) {
+        cache_stat[MBUS_CACHE_STALE]++;
+        osMutexRelease( mutex_cache );
+        return false;
+       }
+    len = reqst->cnt_reg * sizeof( uint16_t );
+    if ( len > *reqst->ptr_lendata )
+        len = *reqst->ptr_lendata; //размер буфера меньше, копируем только часть
+    memcpy( (uint8_t *)reqst->ptr_data, (uint8_t *)&cache_data[offset], len );
+    *reqst->ptr_lendata = len;
+    cache_stat[MBUS_CACHE_HIT]++;
+    osMutexRelease( mutex_cache );
+    return true;
+ }
+
+//*************************************************************************************************
+// Сохранение в кэше значений регистров после успешного выполнения запроса чтения
+// MBUS_REQUEST *reqst - указатель на структуры с параметрами выполненного запроса
+//*************************************************************************************************
+void ModBusCacheStore( MBUS_REQUEST *reqst ) {
+
+    uint8_t area;
+    uint16_t i, offset, cnt;
+    uint32_t tick;
+
+    if ( reqst->function != FUNC_RD_HOLD_REG )
+        return;
+    area = CacheArea( reqst->dev_addr, reqst->addr_reg, reqst->cnt_reg, &offset );
+    if ( area == CACHE_NONE )
+        return;
+    //кол-во фактически принятых регистров
+    cnt = *reqst->ptr_lendata / sizeof( uint16_t );
+    if ( cnt > reqst->cnt_reg )
+        cnt = reqst->cnt_reg;
+    tick = osKernelGetTickCount();
+    osMutexAcquire( mutex_cache, osWaitForever );
+    memcpy( (uint8_t *)&cache_data[offset], (uint8_t *)reqst->ptr_data, cnt * sizeof( uint16_t ) );
+    for ( i = offset; i < offset + cnt; i++ ) {
+        cache_tick[i] = tick;
+        cache_valid[i] = true;
+       }
+    osMutexRelease( mutex_cache );
+ }
+
+//*************************************************************************************************
+// Сброс значений регистров уст-ва пересекающихся с диапазоном записи
+// uint8_t dev_addr  - адрес уст-ва
+// uint16_t addr_reg - адрес первого регистра записи
+// uint16_t cnt_reg  - кол-во регистров записи
+//*************************************************************************************************
+void ModBusCacheInvalid( uint8_t dev_addr, uint16_t addr_reg, uint16_t cnt_reg ) {
+
+    uint8_t area;
+    uint16_t i, offset = 0, beg, end;
+
+    osMutexAcquire( mutex_cache, osWaitForever );
+    for ( area = 0; area < CACHE_AREA_CNT; offset += cache_area[area].cnt_reg, area++ ) {
+        if ( cache_area[area].dev_addr != dev_addr )
+            continue;
+        if ( cache_area[area].shared == false ) {
+            //запись влияет на неизвестные регистры чтения, сброс всего блока
+            memset( &cache_valid[offset], 0x00, cache_area[area].cnt_reg * sizeof( bool ) );
+            continue;
+           }
+        //пересечение диапазона записи с блоком регистров
+        beg = addr_reg > cache_area[area].addr_reg ? addr_reg : cache_area[area].addr_reg;
+        end = addr_reg + cnt_reg;
+        if ( end > cache_area[area].addr_reg + cache_area[area].cnt_reg )
+            end = cache_area[area].addr_reg + cache_area[area].cnt_reg;
+        for ( i = beg; i < end; i++ )
+            cache_valid[offset + i - cache_area[area].addr_reg] = false;
+       }
+    osMutexRelease( mutex_cache );
+ }
+
+//*************************************************************************************************
+// Обнуляет счетчики обращений к кэшу
+//*************************************************************************************************
+void ModBusCacheClr( void ) {
+
+    memset( cache_stat, 0x00, sizeof( cache_stat ) );
+ }
+
+//*************************************************************************************************
+// Возвращает значение счетчика обращений к кэшу
+// MBusCacheStat type - тип счетчика
+// return uint32_t    - значение счетчика
+//*************************************************************************************************
+uint32_t ModBusCacheStat( MBusCacheStat type ) {
+
+    if ( type > MBUS_CACHE_STALE )
+        return 0;
+    return cache_stat[type];
+ }
+
+//*************************************************************************************************
+// Поиск блока кэшируемых регистров содержащего весь диапазон запроса
+// uint8_t dev_addr  - адрес уст-ва
+// uint16_t addr_reg - адрес первого регистра
+// uint16_t cnt_reg  - кол-во регистров
+// uint16_t *offset  - индекс первого регистра запроса в кэше
+// return            - индекс блока, CACHE_NONE - регистры не кэшируются
+//*************************************************************************************************
+static uint8_t CacheArea( uint8_t dev_addr, uint16_t addr_reg, uint16_t cnt_reg, uint16_t *offset ) {
+
+    uint8_t area;
+    uint16_t base = 0;
+
+    if ( !cnt_reg )
+        return CACHE_NONE;
+    for ( area = 0; area < CACHE_AREA_CNT; base += cache_area[area].cnt_reg, area++ ) {
+        if ( cache_area[area].dev_addr != dev_addr || addr_reg < cache_area[area].addr_reg )
+            continue;
+        if ( addr_reg + cnt_reg > cache_area[area].addr_reg + cache_area[area].cnt_reg )
+            continue;
+        *offset = base + addr_reg - cache_area[area].addr_reg;
+        return area;
+       }
+    return CACHE_NONE;
+ }
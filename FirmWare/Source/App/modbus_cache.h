@@ -0,0 +1,32 @@
+
+#ifndef __MODBUS_CACHE_H
+#define __MODBUS_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "device.h"
+#include "modbus.h"
+
+// Счетчики кэша регистров
+typedef enum {
+    MBUS_CACHE_HIT,                     //запрос выполнен из кэша
+    MBUS_CACHE_MISS,                    //значения регистров в кэше отсутствуют
+    MBUS_CACHE_STALE                    //истекло время актуальности значений
+ } MBusCacheStat;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void ModBusCacheInit( void );
+void ModBusCacheStore( MBUS_REQUEST *reqst );
+void ModBusCacheInvalid( uint8_t dev_addr, uint16_t addr_reg, uint16_t cnt_reg );
+void ModBusCacheClr( void );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+bool ModBusCacheRead( MBUS_REQUEST *reqst );
+uint32_t ModBusCacheStat( MBusCacheStat type );
+
+#endif
@@ -0,0 +1,310 @@
+
+//*************************************************************************************************
+//
+// Захват кадров обмена по MODBUS
+// Передаваемые и принимаемые кадры сохраняются в кольцевом буфере в виде двоичных записей
+// фиксированного размера {время, направление, уст-во, функция, длина, результат, задержка},
+// при включенном логировании задача с низким приоритетом сохраняет записи на SD карту
+// блоками по CAP_BLOCK записей, расшифровка выполняется только по команде из консоли
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "rl_fs.h"
+#include "cmsis_os2.h"
+
+#include "device.h"
+
+#include "modbus.h"
+#include "modbus_cap.h"
+#include "sdcard.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define CAP_RING                64          //кол-во записей в кольцевом буфере
+#define CAP_BLOCK               16          //кол-во записей сохраняемых на SD карту за одну запись
+#define CAP_FLUSH_TIME          1000        //максимальное время хранения записей до сохранения (msec)
+#define CAP_FLAG_FLUSH          0x00000001  //флаг задачи: накоплен блок записей
+
+#define CAP_FILE_NAME           "modbus_cap.bin"
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static MBUS_CAP_REC cap_ring[CAP_RING];                 //кольцевой буфер записей
+static MBUS_CAP_REC cap_block[CAP_BLOCK];               //блок записей для сохранения
+static uint32_t cap_head = 0;                           //кол-во добавленных записей
+static uint32_t cap_flush = 0;                          //кол-во обработанных задачей записей
+static uint32_t cap_lost = 0;                           //кол-во записей не сохраненных в файле
+static FILE *cap_file = NULL;
+
+static osMutexId_t mutex_cap, mutex_file;
+static osThreadId_t cap_thread;
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osThreadAttr_t cap_attr = {
+    .name = "ModbusCap",
+    .stack_size = 1024,
+    .priority = osPriorityBelowNormal
+ };
+
+static const osMutexAttr_t mutex_attr = { .name = "ModbusCap", .attr_bits = osMutexPrioInherit };
+static const osMutexAttr_t mutex_fattr = { .name = "ModbusCapFile", .attr_bits = osMutexPrioInherit };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void CapCommit( void );
+static uint16_t CapFile( uint16_t back, MBUS_CAP_REC *rec, uint16_t cnt, uint32_t *total );
+static void TaskCap( void *pvParameters );
+
+//*************************************************************************************************
+// Инициализация захвата кадров
+//*************************************************************************************************
+void ModBusCapInit( void ) {
+
+    memset( cap_ring, 0x00, sizeof( cap_ring ) );
+    mutex_cap = osMutexNew( &mutex_attr );
+    mutex_file = osMutexNew( &mutex_fattr );
+    cap_thread = osThreadNew( TaskCap, NULL, &cap_attr );
+ }
+
+//*************************************************************************************************
+// Задача сохранения записей на SD карту
+//*************************************************************************************************
+static void TaskCap( void *pvParameters ) {
+
+    uint16_t i, cnt;
+
+    for ( ;; ) {
+        osThreadFlagsWait( CAP_FLAG_FLUSH, osFlagsWaitAny, CAP_FLUSH_TIME );
+        do {
+            osMutexAcquire( mutex_file, osWaitForever );
+            //копируем блок записей, буфер блокируется только на время копирования
+            osMutexAcquire( mutex_cap, osWaitForever );
+            cnt = cap_head - cap_flush;
+            if ( cnt > CAP_BLOCK )
+                cnt = CAP_BLOCK;
+            for ( i = 0; i < cnt; i++, cap_flush++ )
+                memcpy( &cap_block[i], &cap_ring[cap_flush % CAP_RING], sizeof( MBUS_CAP_REC ) );
+            osMutexRelease( mutex_cap );
+            if ( cnt && cap_file != NULL ) {
+                if ( fwrite( cap_block, sizeof( MBUS_CAP_REC ), cnt, cap_file ) != cnt )
+                    cap_lost += cnt;
+                fflush( cap_file );
+               }
+            osMutexRelease( mutex_file );
+           } while ( cnt == CAP_BLOCK );
+       }
+ }
+
+//*************************************************************************************************
+// Добавление записи кадра, вызывается только из задачи "Modbus"
+// Запись ответа добавляется в буфер после установки результата обработки ModBusCapStatus()
+// MBusCapDir dir      - направление передачи кадра
+// MBUS_REQUEST *reqst - параметры запроса (адрес уст-ва, код функции)
+// uint8_t *data       - данные кадра
+// uint16_t len        - кол-во байт кадра, 0 - ответ не получен
+// uint32_t latency    - время от передачи запроса (msec)
+//*************************************************************************************************
+void ModBusCapture( MBusCapDir dir, MBUS_REQUEST *reqst, uint8_t *data, uint16_t len, uint32_t latency ) {
+
+    MBUS_CAP_REC *rec;
+
+    osMutexAcquire( mutex_cap, osWaitForever );
+    if ( cap_head - cap_flush >= CAP_RING ) {
+        //буфер заполнен, самая старая запись не сохранена
+        if ( cap_file != NULL )
+            cap_lost++;
+        cap_flush++;
+       }
+    rec = &cap_ring[cap_head % CAP_RING];
+    rec->tick = osKernelGetTickCount();
+    rec->latency = latency > UINT16_MAX ? UINT16_MAX : latency;
+    rec->dir = dir;
+    rec->dev_addr = reqst->dev_addr;
+    rec->function = reqst->function;
+    rec->status = MBUS_ANSWER_OK;
+    rec->len = len > UINT8_MAX ? UINT8_MAX : len;
+    rec->res = 0;
+    if ( data != NULL && len )
+        memcpy( rec->data, data, len > MBUS_CAP_DATA ? MBUS_CAP_DATA : len );
+    if ( dir == MBUS_CAP_REQST )
+        CapCommit();
+    osMutexRelease( mutex_cap );
+ }
+
+//*************************************************************************************************
+// Установка результата обработки ответа и добавление записи ответа в буфер
+// ModBusError status - результат обработки ответа
+//*************************************************************************************************
+void ModBusCapStatus( ModBusError status ) {
+
+    osMutexAcquire( mutex_cap, osWaitForever );
+    cap_ring[cap_head % CAP_RING].status = status;
+    CapCommit();
+    osMutexRelease( mutex_cap );
+ }
+
+//*************************************************************************************************
+// Добавление подготовленной записи, при накоплении блока записей - запуск сохранения
+// Вызывается при заблокированном буфере
+//*************************************************************************************************
+static void CapCommit( void ) {
+
+    cap_head++;
+    if ( cap_file != NULL && cap_head - cap_flush >= CAP_BLOCK )
+        osThreadFlagsSet( cap_thread, CAP_FLAG_FLUSH );
+ }
+
+//*************************************************************************************************
+// Вкл/Выкл сохранения записей кадров в файл на SD карте
+// Mode mode        - вкл/выкл логирование запросов ответов уст-в в сети MODBUS
+// return = SUCCESS - логирование включено
+//        = ERROR   - логирование выключено
+//*************************************************************************************************
+Status ModbusLog( Mode mode ) {
+
+    Status result = SUCCESS;
+
+    if ( SDStatus() == ERROR )
+        return ERROR; //SD карты нет
+    osMutexAcquire( mutex_file, osWaitForever );
+    if ( mode && cap_file == NULL ) {
+        //открываем файл, в файл сохраняются записи начиная с текущей
+        osMutexAcquire( mutex_cap, osWaitForever );
+        cap_flush = cap_head;
+        osMutexRelease( mutex_cap );
+        cap_file = fopen( CAP_FILE_NAME, "ab" );
+        if ( cap_file == NULL )
+            result = ERROR;
+       }
+    if ( !mode && cap_file != NULL ) {
+        fclose( cap_file );
+        cap_file = NULL;
+       }
+    osMutexRelease( mutex_file );
+    return result;
+ }
+
+//*************************************************************************************************
+// Возвращает кол-во записей не сохраненных в файле (переполнение буфера, ошибка записи)
+//*************************************************************************************************
+uint32_t ModBusCapLost( void ) {
+
+    return cap_lost;
+ }
+
+//*************************************************************************************************
+// Возвращает кол-во записей кадров доступных для чтения
+// MBusCapSrc src     - источник записей: буфер/файл на SD карте
+// return uint32_t    - кол-во записей
+//*************************************************************************************************
+uint32_t ModBusCapCnt( MBusCapSrc src ) {
+
+    uint32_t total = 0;
+
+    if ( src == MBUS_CAP_FILE ) {
+        CapFile( 0, NULL, 0, &total );
+        return total;
+       }
+    return cap_head < CAP_RING ? cap_head : CAP_RING;
+ }
+
+//*************************************************************************************************
+// Чтение последовательных записей кадров
+// MBusCapSrc src     - источник записей: буфер/файл на SD карте
+// uint16_t back      - номер первой записи от конца (1 - последняя запись)
+// MBUS_CAP_REC *rec  - буфер для записей
+// uint16_t cnt       - кол-во записей
+// return uint16_t    - кол-во прочитанных записей
+//*************************************************************************************************
+uint16_t ModBusCapRead( MBusCapSrc src, uint16_t back, MBUS_CAP_REC *rec, uint16_t cnt ) {
+
+    uint16_t i;
+    uint32_t total;
+
+    if ( src == MBUS_CAP_FILE )
+        return CapFile( back, rec, cnt, &total );
+    osMutexAcquire( mutex_cap, osWaitForever );
+    total = cap_head < CAP_RING ? cap_head : CAP_RING;
+    if ( back > total )
+        back = total;
+    if ( cnt > back )
+        cnt = back;
+    for ( i = 0; i < cnt; i++ )
+        memcpy( &rec[i], &cap_ring[( cap_head - back + i ) % CAP_RING], sizeof( MBUS_CAP_REC ) );
+    osMutexRelease( mutex_cap );
+    return cnt;
+ }
+
+//*************************************************************************************************
+// Чтение последовательных записей кадров из файла на SD карте
+// На время чтения файл записи закрывается
+// uint16_t back      - номер первой записи от конца файла (1 - последняя запись)
+// MBUS_CAP_REC *rec  - буфер для записей
+// uint16_t cnt       - кол-во записей
+// uint32_t *total    - кол-во записей в файле
+// return uint16_t    - кол-во прочитанных записей
+//*************************************************************************************************
+static uint16_t CapFile( uint16_t back, MBUS_CAP_REC *rec, uint16_t cnt, uint32_t *total ) {
+
+    FILE *file;
+
+    *total = 0;
+    if ( SDStatus() == ERROR )
+        return 0;
+    osMutexAcquire( mutex_file, osWaitForever );
+    if ( cap_file != NULL )
+        fclose( cap_file );
+    file = fopen( CAP_FILE_NAME, "rb" );
+    if ( file != NULL ) {
+        fseek( file, 0, SEEK_END );
+        *total = ftell( file ) / sizeof( MBUS_CAP_REC );
+        if ( back > *total )
+            back = *total;
+        if ( cnt > back )
+            cnt = back;
+        if ( cnt ) {
+            fseek( file, ( *total - back ) * sizeof( MBUS_CAP_REC ), SEEK_SET );
+            cnt = fread( rec, sizeof( MBUS_CAP_REC ), cnt, file );
+           }
+        fclose( file );
+       }
+    else cnt = 0;
+    if ( cap_file != NULL )
+        cap_file = fopen( CAP_FILE_NAME, "ab" );
+    osMutexRelease( mutex_file );
+    return cnt;
+ }
+
+//*************************************************************************************************
+// Формирует строку расшифровки записи кадра
+// MBUS_CAP_REC *rec - запись кадра
+// char *str         - буфер размером MBUS_CAP_STR для размещения строки
+// return            - указатель на строку
+//*************************************************************************************************
+char *ModBusCapDecode( MBUS_CAP_REC *rec, char *str ) {
+
+    char *ptr;
+    uint8_t i, len;
+
+    ptr = str;
+    ptr += sprintf( ptr, "%10u %s %3u 0x%02X %3u %5u  ", rec->tick, rec->dir == MBUS_CAP_REQST ? "REQ" : "ANS",
+                    rec->dev_addr, rec->function, rec->len, rec->latency );
+    len = rec->len > MBUS_CAP_DATA ? MBUS_CAP_DATA : rec->len;
+    for ( i = 0; i < len; i++ )
+        ptr += sprintf( ptr, "%02X ", rec->data[i] );
+    if ( rec->len > MBUS_CAP_DATA )
+        ptr += sprintf( ptr, "... " );
+    if ( rec->dir == MBUS_CAP_ANSWER && ModBusErrDesc( (ModBusError)rec->status ) != NULL )
+        ptr += sprintf( ptr, "%s", ModBusErrDesc( (ModBusError)rec->status ) );
+    sprintf( ptr, "\r\n" );
+    return str;
+ }
@@ -0,0 +1,61 @@
+
+#ifndef __MODBUS_CAP_H
+#define __MODBUS_CAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "device.h"
+#include "modbus.h"
+
+#define MBUS_CAP_DATA           36      //кол-во сохраняемых байт кадра
+#define MBUS_CAP_STR            200     //размер буфера для расшифровки записи
+
+// Направление передачи кадра
+typedef enum {
+    MBUS_CAP_REQST,                     //запрос
+    MBUS_CAP_ANSWER                     //ответ
+ } MBusCapDir;
+
+// Источник данных для расшифровки
+typedef enum {
+    MBUS_CAP_RAM,                       //последние кадры из буфера
+    MBUS_CAP_FILE                       //файл захвата на SD карте
+ } MBusCapSrc;
+
+#pragma pack( push, 1 )                 //выравнивание структуры по границе 1 байта
+
+//*************************************************************************************************
+// Запись захвата кадра MODBUS (48 байт)
+//*************************************************************************************************
+typedef struct {
+    uint32_t tick;                      //время получения/передачи кадра (msec)
+    uint16_t latency;                   //время от передачи запроса до приема ответа (msec)
+    uint8_t  dir;                       //направление MBusCapDir
+    uint8_t  dev_addr;                  //адрес уст-ва
+    uint8_t  function;                  //код функции
+    uint8_t  status;                    //результат обработки ответа ModBusError (КС, таймаут)
+    uint8_t  len;                       //кол-во байт кадра
+    uint8_t  res;                       //резерв
+    uint8_t  data[MBUS_CAP_DATA];       //первые MBUS_CAP_DATA байт кадра
+ } MBUS_CAP_REC;
+
+#pragma pack( pop )
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void ModBusCapInit( void );
+void ModBusCapture( MBusCapDir dir, MBUS_REQUEST *reqst, uint8_t *data, uint16_t len, uint32_t latency );
+void ModBusCapStatus( ModBusError status );
+Status ModbusLog( Mode mode );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t ModBusCapLost( void );
+uint32_t ModBusCapCnt( MBusCapSrc src );
+uint16_t ModBusCapRead( MBusCapSrc src, uint16_t back, MBUS_CAP_REC *rec, uint16_t cnt );
+char *ModBusCapDecode( MBUS_CAP_REC *rec, char *str );
+
+#endif
@@ -0,0 +1,379 @@
+
+//*************************************************************************************************
+//
+// Планирование обмена данными по MODBUS: объединение операций чтения/записи
+// регистров одного уст-ва в минимальное кол-во запросов
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdbool.h>
+
+#include "device.h"
+
+#include "modbus.h"
+#include "modbus_def.h"
+#include "modbus_plan.h"
+#include "tracker_ext.h"
+#include "voice_ext.h"
+#include "gen_ext.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define REGMAP_CNT  ( sizeof( regmap )/sizeof( MBUS_REGMAP ) )
+
+//*************************************************************************************************
+// Карта регистров уст-ва
+//*************************************************************************************************
+typedef struct {
+    uint8_t  dev_addr;                  //адрес уст-ва
+    uint16_t rd_max;                    //кол-во регистров чтения
+    uint16_t wr_max;                    //кол-во регистров записи
+    bool     rdwr;                      //поддержка функции 0x17 (запись и чтение одним запросом)
+} MBUS_REGMAP;
+
+//*************************************************************************************************
+// Диапазон регистров объединенного запроса
+//*************************************************************************************************
+typedef struct {
+    uint16_t addr;                      //адрес первого регистра
+    uint16_t cnt;                       //кол-во регистров
+} MBUS_RANGE;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+//функция 0x17 в ведомых уст-вах пока не реализована
+static const MBUS_REGMAP regmap[] = {
+    { MB_ID_DEV_TRACKER,    EXTRC_REG_RD_MAX,   EXTRC_REG_WR_MAX,   false },
+    { MB_ID_DEV_VOICE,      EXVOI_REG_RD_MAX,   EXVOI_REG_WR_MAX,   false },
+    { MB_ID_DEV_GEN,        EXGEN_REG_RD_MAX,   EXGEN_REG_WR_MAX,   false }
+ };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static const MBUS_REGMAP *RegMap( uint8_t dev_addr );
+static Status PlanAdd( MBUS_PLAN *plan, MBusPlanOper oper, uint16_t addr, uint16_t cnt, uint16_t *data );
+static uint8_t PlanSort( MBUS_PLAN *plan, MBusPlanOper oper, uint8_t *ind, bool sort );
+static uint8_t RangeRead( MBUS_PLAN *plan, uint8_t *ind, uint8_t cnt, uint8_t beg, MBUS_RANGE *range );
+static uint8_t RangeWrite( MBUS_PLAN *plan, uint8_t *ind, uint8_t cnt, uint8_t beg, MBUS_RANGE *range, uint16_t *buff );
+static void RangeScatter( MBUS_PLAN *plan, uint8_t *ind, uint8_t beg, uint8_t end, MBUS_RANGE *range, uint16_t *buff );
+static ModBusError PlanRequest( MBUS_PLAN *plan, uint8_t func, MBUS_RANGE *rd, uint16_t *rd_buff, MBUS_RANGE *wr, uint16_t *wr_buff, MBusPrio prio );
+
+//*************************************************************************************************
+// Инициализация плана обмена данными с уст-вом
+// MBUS_PLAN *plan  - указатель на план
+// uint8_t dev_addr - адрес уст-ва
+// result ERROR     - для уст-ва нет карты регистров
+//        SUCCESS   - план инициализирован
+//*************************************************************************************************
+Status ModBusPlanInit( MBUS_PLAN *plan, uint8_t dev_addr ) {
+
+    memset( plan, 0x00, sizeof( MBUS_PLAN ) );
+    plan->dev_addr = dev_addr;
+    if ( RegMap( dev_addr ) == NULL )
+        return ERROR;
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Добавление в план операции чтения регистров
+// MBUS_PLAN *plan - указатель на план
+// uint16_t addr   - адрес первого регистра
+// uint16_t cnt    - кол-во регистров
+// uint16_t *data  - буфер для размещения прочитанных данных
+// result ERROR    - регистры вне карты уст-ва или план заполнен
+//        SUCCESS  - операция добавлена
+//*************************************************************************************************
+Status ModBusPlanRead( MBUS_PLAN *plan, uint16_t addr, uint16_t cnt, uint16_t *data ) {
+
+    return PlanAdd( plan, MBUS_PLAN_RD, addr, cnt, data );
+ }
+
+//*************************************************************************************************
+// Добавление в план операции записи регистров
+// MBUS_PLAN *plan - указатель на план
+// uint16_t addr   - адрес первого регистра
+// uint16_t cnt    - кол-во регистров
+// uint16_t *data  - данные для записи
+// result ERROR    - регистры вне карты уст-ва или план заполнен
+//        SUCCESS  - операция добавлена
+//*************************************************************************************************
+Status ModBusPlanWrite( MBUS_PLAN *plan, uint16_t addr, uint16_t cnt, uint16_t *data ) {
+
+    return PlanAdd( plan, MBUS_PLAN_WR, addr, cnt, data );
+ }
+
+//*************************************************************************************************
+// Выполнение плана обмена данными
+// Операции чтения сортируются по адресу и объединяются в один запрос, если разрыв между ними
+// не превышает MBUS_PLAN_GAP регистров. Операции записи выполняются в порядке добавления в план
+// (порядок записи может иметь значение для команд уст-ва: значение записывается до регистра
+// команды), объединяются только смежные по адресу операции, следующие друг за другом.
+// Если уст-во поддерживает функцию 0x17 и вся запись объединена в один диапазон, запись и
+// первый диапазон чтения выполняются одним запросом. Иначе сначала выполняется запись (0x10),
+// затем чтение (0x03). При ошибке выполнение плана прекращается.
+// Результат операций записи сохраняется в plan->status_wr (MBUS_ANSWER_OK - записи в плане нет)
+// MBUS_PLAN *plan - указатель на план
+// MBusPrio prio   - приоритет запросов в очереди уст-ва
+// result          - результат выполнения последнего запроса
+//*************************************************************************************************
+ModBusError ModBusPlanExec( MBUS_PLAN *plan, MBusPrio prio ) {
+
+    const MBUS_REGMAP *map;
+    MBUS_RANGE rd, wr;
+    ModBusError status = MBUS_ANSWER_OK;
+    uint8_t rd_ind[MBUS_PLAN_ITEMS], wr_ind[MBUS_PLAN_ITEMS];
+    uint8_t cnt_rd, cnt_wr, rd_beg, rd_end, wr_beg, wr_end;
+    uint16_t rd_buff[MBUS_PLAN_REGS], wr_buff[MBUS_PLAN_REGS];
+
+    plan->cnt_trans = 0;
+    plan->status_wr = MBUS_ANSWER_OK;
+    map = RegMap( plan->dev_addr );
+    if ( map == NULL ) {
+        plan->status_wr = MBUS_ERROR_PARAM;
+        return MBUS_ERROR_PARAM;
+       }
+    cnt_rd = PlanSort( plan, MBUS_PLAN_RD, rd_ind, true );
+    cnt_wr = PlanSort( plan, MBUS_PLAN_WR, wr_ind, false );
+    rd_beg = wr_beg = 0;
+    //запись и чтение одним запросом
+    if ( map->rdwr == true && cnt_rd && cnt_wr ) {
+        wr_end = RangeWrite( plan, wr_ind, cnt_wr, wr_beg, &wr, wr_buff );
+        if ( wr_end == cnt_wr ) {
+            rd_end = RangeRead( plan, rd_ind, cnt_rd, rd_beg, &rd );
+            status = PlanRequest( plan, FUNC_RDWR_MULT_REG, &rd, rd_buff, &wr, wr_buff, prio );
+            plan->status_wr = status;
+            if ( status == MBUS_ANSWER_OK )
+                RangeScatter( plan, rd_ind, rd_beg, rd_end, &rd, rd_buff );
+            wr_beg = wr_end;
+            rd_beg = rd_end;
+           }
+       }
+    //запись
+    while ( status == MBUS_ANSWER_OK && wr_beg < cnt_wr ) {
+        wr_end = RangeWrite( plan, wr_ind, cnt_wr, wr_beg, &wr, wr_buff );
+        status = PlanRequest( plan, FUNC_WR_MULT_REG, NULL, NULL, &wr, wr_buff, prio );
+        plan->status_wr = status;
+        wr_beg = wr_end;
+       }
+    //чтение
+    while ( status == MBUS_ANSWER_OK && rd_beg < cnt_rd ) {
+        rd_end = RangeRead( plan, rd_ind, cnt_rd, rd_beg, &rd );
+        status = PlanRequest( plan, FUNC_RD_HOLD_REG, &rd, rd_buff, NULL, NULL, prio );
+        if ( status == MBUS_ANSWER_OK )
+            RangeScatter( plan, rd_ind, rd_beg, rd_end, &rd, rd_buff );
+        rd_beg = rd_end;
+       }
+    return status;
+ }
+
+//*************************************************************************************************
+// Поиск карты регистров уст-ва
+// uint8_t dev_addr - адрес уст-ва
+// result           - указатель на карту регистров, NULL - карта не найдена
+//*************************************************************************************************
+static const MBUS_REGMAP *RegMap( uint8_t dev_addr ) {
+
+    uint8_t i;
+
+    for ( i = 0; i < REGMAP_CNT; i++ ) {
+        if ( regmap[i].dev_addr == dev_addr )
+            return &regmap[i];
+       }
+    return NULL;
+ }
+
+//*************************************************************************************************
+// Добавление операции в план с проверкой по карте регистров уст-ва
+// MBUS_PLAN *plan     - указатель на план
+// MBusPlanOper oper   - тип операции
+// uint16_t addr       - адрес первого регистра
+// uint16_t cnt        - кол-во регистров
+// uint16_t *data      - данные/буфер операции
+// result ERROR        - ошибка в параметрах или план заполнен
+//        SUCCESS      - операция добавлена
+//*************************************************************************************************
+static Status PlanAdd( MBUS_PLAN *plan, MBusPlanOper oper, uint16_t addr, uint16_t cnt, uint16_t *data ) {
+
+    uint16_t max;
+    const MBUS_REGMAP *map;
+
+    map = RegMap( plan->dev_addr );
+    if ( map == NULL || data == NULL || !cnt || cnt > MBUS_PLAN_REGS )
+        return ERROR;
+    if ( plan->cnt_item >= MBUS_PLAN_ITEMS )
+        return ERROR;
+    max = ( oper == MBUS_PLAN_RD ) ? map->rd_max : map->wr_max;
+    if ( addr + cnt > max )
+        return ERROR; //регистры вне карты уст-ва
+    plan->item[plan->cnt_item].oper = oper;
+    plan->item[plan->cnt_item].addr = addr;
+    plan->item[plan->cnt_item].cnt = cnt;
+    plan->item[plan->cnt_item].data = data;
+    plan->cnt_item++;
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Формирование списка индексов операций одного типа, отсортированного по адресу регистров
+// или в порядке добавления операций в план. Порядок операций с одинаковым адресом сохраняется
+// MBUS_PLAN *plan   - указатель на план
+// MBusPlanOper oper - тип операции
+// uint8_t *ind      - массив для размещения индексов
+// bool sort         - true - сортировка по адресу, false - порядок добавления
+// result            - кол-во операций
+//*************************************************************************************************
+static uint8_t PlanSort( MBUS_PLAN *plan, MBusPlanOper oper, uint8_t *ind, bool sort ) {
+
+    uint8_t i, j, cnt, tmp;
+
+    for ( i = 0, cnt = 0; i < plan->cnt_item; i++ ) {
+        if ( plan->item[i].oper != oper )
+            continue;
+        ind[cnt] = i;
+        //сортировка вставкой
+        for ( j = cnt; sort == true && j && plan->item[ind[j-1]].addr > plan->item[ind[j]].addr; j-- ) {
+            tmp = ind[j];
+            ind[j] = ind[j-1];
+            ind[j-1] = tmp;
+           }
+        cnt++;
+       }
+    return cnt;
+ }
+
+//*************************************************************************************************
+// Объединение операций чтения в один диапазон регистров начиная с операции beg
+// MBUS_PLAN *plan    - указатель на план
+// uint8_t *ind       - отсортированный список индексов операций чтения
+// uint8_t cnt        - кол-во операций чтения
+// uint8_t beg        - индекс первой операции в списке
+// MBUS_RANGE *range  - объединенный диапазон регистров
+// result             - индекс первой не вошедшей в диапазон операции
+//*************************************************************************************************
+static uint8_t RangeRead( MBUS_PLAN *plan, uint8_t *ind, uint8_t cnt, uint8_t beg, MBUS_RANGE *range ) {
+
+    uint8_t i;
+    uint16_t end, next;
+    MBUS_PLAN_ITEM *item;
+
+    item = &plan->item[ind[beg]];
+    range->addr = item->addr;
+    end = item->addr + item->cnt;
+    for ( i = beg + 1; i < cnt; i++ ) {
+        item = &plan->item[ind[i]];
+        if ( item->addr > end + MBUS_PLAN_GAP )
+            break; //слишком большой разрыв
+        next = item->addr + item->cnt;
+        if ( next < end )
+            next = end; //операция внутри диапазона
+        if ( next - range->addr > MBUS_PLAN_REGS )
+            break; //превышен размер буфера
+        end = next;
+       }
+    range->cnt = end - range->addr;
+    return i;
+ }
+
+//*************************************************************************************************
+// Объединение смежных операций записи в один диапазон регистров начиная с операции beg,
+// объединяются только операции следующие друг за другом в порядке добавления
+// MBUS_PLAN *plan    - указатель на план
+// uint8_t *ind       - список индексов операций записи в порядке добавления
+// uint8_t cnt        - кол-во операций записи
+// uint8_t beg        - индекс первой операции в списке
+// MBUS_RANGE *range  - объединенный диапазон регистров
+// uint16_t *buff     - буфер для размещения данных записи
+// result             - индекс первой не вошедшей в диапазон операции
+//*************************************************************************************************
+static uint8_t RangeWrite( MBUS_PLAN *plan, uint8_t *ind, uint8_t cnt, uint8_t beg, MBUS_RANGE *range, uint16_t *buff ) {
+
+    uint8_t i;
+    MBUS_PLAN_ITEM *item;
+
+    range->addr = plan->item[ind[beg]].addr;
+    range->cnt = 0;
+    for ( i = beg; i < cnt; i++ ) {
+        item = &plan->item[ind[i]];
+        if ( item->addr != range->addr + range->cnt )
+            break; //регистры не смежные
+        if ( range->cnt + item->cnt > MBUS_PLAN_REGS )
+            break; //превышен размер буфера
+        memcpy( buff + range->cnt, item->data, item->cnt * sizeof( uint16_t ) );
+        range->cnt += item->cnt;
+       }
+    return i;
+ }
+
+//*************************************************************************************************
+// Распределение прочитанных данных диапазона по буферам операций чтения
+// MBUS_PLAN *plan    - указатель на план
+// uint8_t *ind       - отсортированный список индексов операций чтения
+// uint8_t beg        - индекс первой операции диапазона
+// uint8_t end        - индекс первой не вошедшей в диапазон операции
+// MBUS_RANGE *range  - диапазон регистров
+// uint16_t *buff     - прочитанные данные диапазона
+//*************************************************************************************************
+static void RangeScatter( MBUS_PLAN *plan, uint8_t *ind, uint8_t beg, uint8_t end, MBUS_RANGE *range, uint16_t *buff ) {
+
+    uint8_t i;
+    MBUS_PLAN_ITEM *item;
+
+    for ( i = beg; i < end; i++ ) {
+        item = &plan->item[ind[i]];
+        memcpy( item->data, buff + ( item->addr - range->addr ), item->cnt * sizeof( uint16_t ) );
+       }
+ }
+
+//*************************************************************************************************
+// Выполнение одного запроса плана с повтором при ошибке КС или отсутствии ответа
+// MBUS_PLAN *plan     - указатель на план
+// uint8_t func        - код функции: FUNC_RD_HOLD_REG, FUNC_WR_MULT_REG, FUNC_RDWR_MULT_REG
+// MBUS_RANGE *rd      - диапазон регистров чтения
+// uint16_t *rd_buff   - буфер для прочитанных данных
+// MBUS_RANGE *wr      - диапазон регистров записи
+// uint16_t *wr_buff   - данные для записи
+// MBusPrio prio       - приоритет запроса в очереди уст-ва
+// result              - результат выполнения запроса
+//*************************************************************************************************
+static ModBusError PlanRequest( MBUS_PLAN *plan, uint8_t func, MBUS_RANGE *rd, uint16_t *rd_buff, MBUS_RANGE *wr, uint16_t *wr_buff, MBusPrio prio ) {
+
+    uint8_t cnt_rpt;
+    uint16_t len, size;
+    ModBusError status;
+    MBUS_REQUEST reqst;
+
+    memset( &reqst, 0x00, sizeof( reqst ) );
+    reqst.dev_addr = plan->dev_addr;
+    reqst.function = func;
+    reqst.ptr_lendata = &len;
+    if ( func == FUNC_WR_MULT_REG ) {
+        reqst.addr_reg = wr->addr;
+        reqst.cnt_reg = wr->cnt;
+        reqst.ptr_data = wr_buff;
+        size = wr->cnt * sizeof( uint16_t );
+       }
+    else {
+        reqst.addr_reg = rd->addr;
+        reqst.cnt_reg = rd->cnt;
+        reqst.ptr_data = rd_buff;
+        size = rd->cnt * sizeof( uint16_t );
+       }
+    if ( func == FUNC_RDWR_MULT_REG ) {
+        reqst.wr_addr = wr->addr;
+        reqst.wr_cnt = wr->cnt;
+        reqst.ptr_wrdata = wr_buff;
+       }
+    cnt_rpt = CNT_REPEAT_REQST;
+    do {
+        len = size;
+        status = ModBusRequestPrio( &reqst, prio );
+        plan->cnt_trans++;
+       } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+    if ( status == MBUS_ANSWER_OK && func != FUNC_WR_MULT_REG && len < size )
+        return MBUS_ERROR_DATA; //получено меньше данных чем запрошено
+    return status;
+ }
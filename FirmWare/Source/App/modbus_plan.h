@@ -0,0 +1,50 @@
+
+#ifndef __MODBUS_PLAN_H
+#define __MODBUS_PLAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "device.h"
+#include "modbus.h"
+
+#define MBUS_PLAN_ITEMS         8       //максимальное кол-во операций в одном плане
+#define MBUS_PLAN_REGS          32      //максимальное кол-во регистров в одном объединенном запросе
+#define MBUS_PLAN_GAP           2       //максимальный пропуск регистров при объединении чтения
+
+// Тип операции плана
+typedef enum {
+    MBUS_PLAN_RD,                       //чтение регистров
+    MBUS_PLAN_WR                        //запись регистров
+ } MBusPlanOper;
+
+//*************************************************************************************************
+// Операция плана: чтение/запись группы регистров
+//*************************************************************************************************
+typedef struct {
+    MBusPlanOper oper;                  //тип операции
+    uint16_t     addr;                  //адрес первого регистра
+    uint16_t     cnt;                   //кол-во регистров
+    uint16_t     *data;                 //данные для записи/буфер для прочитанных данных
+} MBUS_PLAN_ITEM;
+
+//*************************************************************************************************
+// План обмена данными с одним уст-вом
+//*************************************************************************************************
+typedef struct {
+    uint8_t        dev_addr;            //адрес уст-ва
+    uint8_t        cnt_item;            //кол-во операций в плане
+    uint8_t        cnt_trans;           //кол-во выполненных запросов (после выполнения плана)
+    ModBusError    status_wr;           //результат операций записи (после выполнения плана)
+    MBUS_PLAN_ITEM item[MBUS_PLAN_ITEMS];
+} MBUS_PLAN;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+Status ModBusPlanInit( MBUS_PLAN *plan, uint8_t dev_addr );
+Status ModBusPlanRead( MBUS_PLAN *plan, uint16_t addr, uint16_t cnt, uint16_t *data );
+Status ModBusPlanWrite( MBUS_PLAN *plan, uint16_t addr, uint16_t cnt, uint16_t *data );
+ModBusError ModBusPlanExec( MBUS_PLAN *plan, MBusPrio prio );
+
+#endif
@@ -0,0 +1,322 @@
+
+//*************************************************************************************************
+//
+// Планировщик циклического опроса уст-в по MODBUS
+// Модули уст-в регистрируют записи опроса {уст-во, блок регистров, период, срок, приоритет},
+// планировщик выполняет их по одной в порядке раннего срока выполнения (EDF), записи с
+// приоритетом MBUS_PRIO_LOW выполняются только в свободное от остальных записей время
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "cmsis_os2.h"
+
+#include "device.h"
+#include "config.h"
+
+#include "modbus.h"
+#include "modbus_def.h"
+#include "modbus_poll.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define POLL_NONE               0xFF        //признак отсутствия записи
+#define POLL_WAIT_MAX           1000        //максимальное время ожидания записи (msec)
+#define POLL_FLAG_ADD           0x00000001  //флаг события: добавлена запись опроса
+
+#define POLL_CHAR_TIME          ( ( 10 * 1000000UL ) / _RS485_BAUD ) //время передачи одного байта (usec)
+#define POLL_SIZE_REQST         8           //размер пакета запроса чтения регистров
+#define POLL_SIZE_ANSWER        5           //размер ответа без данных регистров
+#define POLL_SIZE_GAP           7           //интервалы тишины 3.5 байта после запроса и ответа
+#define POLL_TIME_SLAVE         5000        //пауза между пакетами и время обработки запроса (usec)
+
+//*************************************************************************************************
+// Состояние записи опроса
+//*************************************************************************************************
+typedef struct {
+    const MBUS_POLL *poll;              //параметры записи
+    uint32_t        release;            //время начала текущего периода
+    uint32_t        runs;               //кол-во выполненных опросов
+    uint32_t        errors;             //кол-во опросов с ошибкой
+    uint32_t        missed;             //кол-во опросов выполненных после срока
+    uint32_t        time_sum;           //суммарное время выполнения опросов (msec)
+    uint32_t        time_max;           //максимальное время выполнения опроса (msec)
+ } POLL_ENTRY;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static POLL_ENTRY poll_tab[MBUS_POLL_MAX];
+static uint8_t poll_cnt = 0;
+
+static uint16_t poll_buf[MBUS_POLL_REG_MAX];  //буфер приема данных, только для задачи "ModbusPoll"
+
+static osMutexId_t mutex_poll;
+static osThreadId_t poll_thread;
+static osEventFlagsId_t poll_event;
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osThreadAttr_t poll_attr = {
+    .name = "ModbusPoll",
+    .stack_size = 1024,
+    .priority = osPriorityNormal
+ };
+
+static const osMutexAttr_t mutex_attr = { .name = "ModbusPoll", .attr_bits = osMutexPrioInherit };
+static const osEventFlagsAttr_t evn_attr = { .name = "ModbusPoll" };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static uint32_t Deadline( const MBUS_POLL *poll );
+static uint8_t PollSelect( uint32_t *wait );
+static void PollExec( uint8_t ind );
+static void TaskPoll( void *pvParameters );
+
+//*************************************************************************************************
+// Инициализация планировщика опроса
+//*************************************************************************************************
+void ModBusPollInit( void ) {
+
+    memset( poll_tab, 0x00, sizeof( poll_tab ) );
+    mutex_poll = osMutexNew( &mutex_attr );
+    //флаги задачи не используются: флаг MBUS_FLAG_DONE запроса MODBUS имеет тот же бит
+    poll_event = osEventFlagsNew( &evn_attr );
+    poll_thread = osThreadNew( TaskPoll, NULL, &poll_attr );
+ }
+
+//*************************************************************************************************
+// Задача выполнения записей опроса
+//*************************************************************************************************
+static void TaskPoll( void *pvParameters ) {
+
+    uint8_t ind;
+    uint32_t wait;
+
+    for ( ;; ) {
+        ind = PollSelect( &wait );
+        if ( ind == POLL_NONE ) {
+            //ждем начала периода ближайшей записи или добавления новой
+            osEventFlagsWait( poll_event, POLL_FLAG_ADD, osFlagsWaitAny, wait );
+            continue;
+           }
+        PollExec( ind );
+       }
+ }
+
+//*************************************************************************************************
+// Регистрация записи опроса, первый опрос выполняется сразу после регистрации
+// const MBUS_POLL *poll - параметры записи, структура должна оставаться доступной
+// result ERROR          - ошибка в параметрах или таблица опроса заполнена
+//        SUCCESS        - запись добавлена
+//*************************************************************************************************
+Status ModBusPollAdd( const MBUS_POLL *poll ) {
+
+    if ( poll == NULL || poll->data == NULL || !poll->cnt_reg || poll->cnt_reg > MBUS_POLL_REG_MAX ||
+         !poll->period || poll->prio >= MBUS_PRIO_CNT )
+        return ERROR;
+    osMutexAcquire( mutex_poll, osWaitForever );
+    if ( poll_cnt >= MBUS_POLL_MAX ) {
+        osMutexRelease( mutex_poll );
+        return ERROR;
+       }
+    memset( &poll_tab[poll_cnt], 0x00, sizeof( POLL_ENTRY ) );
+    poll_tab[poll_cnt].poll = poll;
+    poll_tab[poll_cnt].release = osKernelGetTickCount();
+    poll_cnt++;
+    osMutexRelease( mutex_poll );
+    osEventFlagsSet( poll_event, POLL_FLAG_ADD );
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Копирует данные последнего успешного опроса записи
+// Вызывается из задачи уст-ва после получения результата опроса (callback)
+// const MBUS_POLL *poll - параметры записи
+// uint16_t *data        - буфер для данных, размер не менее poll->cnt_reg регистров
+//*************************************************************************************************
+void ModBusPollData( const MBUS_POLL *poll, uint16_t *data ) {
+
+    osMutexAcquire( mutex_poll, osWaitForever );
+    memcpy( data, poll->data, poll->cnt_reg * sizeof( uint16_t ) );
+    osMutexRelease( mutex_poll );
+ }
+
+//*************************************************************************************************
+// Обнуляет счетчики записей опроса
+//*************************************************************************************************
+void ModBusPollClr( void ) {
+
+    uint8_t i;
+
+    osMutexAcquire( mutex_poll, osWaitForever );
+    for ( i = 0; i < poll_cnt; i++ ) {
+        poll_tab[i].runs = 0;
+        poll_tab[i].errors = 0;
+        poll_tab[i].missed = 0;
+        poll_tab[i].time_sum = 0;
+        poll_tab[i].time_max = 0;
+       }
+    osMutexRelease( mutex_poll );
+ }
+
+//*************************************************************************************************
+// Выбор записи для выполнения: из записей, период которых начался, выбирается запись с более
+// высоким приоритетом, для одного приоритета - с ранним сроком выполнения
+// uint32_t *wait - время до начала периода ближайшей записи (msec), если запись не выбрана
+// return         - индекс записи, POLL_NONE - нет записей для выполнения
+//*************************************************************************************************
+static uint8_t PollSelect( uint32_t *wait ) {
+
+    uint8_t i, ind = POLL_NONE;
+    int32_t delta, wait_min = POLL_WAIT_MAX;
+    uint32_t now, deadline, deadline_sel = 0;
+    const MBUS_POLL *poll;
+
+    now = osKernelGetTickCount();
+    osMutexAcquire( mutex_poll, osWaitForever );
+    for ( i = 0; i < poll_cnt; i++ ) {
+        poll = poll_tab[i].poll;
+        delta = (int32_t)( poll_tab[i].release - now );
+        if ( delta > 0 ) {
+            //период записи еще не начался
+            if ( delta < wait_min )
+                wait_min = delta;
+            continue;
+           }
+        deadline = poll_tab[i].release + Deadline( poll );
+        if ( ind == POLL_NONE || poll->prio < poll_tab[ind].poll->prio ||
+           ( poll->prio == poll_tab[ind].poll->prio && (int32_t)( deadline - deadline_sel ) < 0 ) ) {
+            ind = i;
+            deadline_sel = deadline;
+           }
+       }
+    osMutexRelease( mutex_poll );
+    *wait = wait_min;
+    return ind;
+ }
+
+//*************************************************************************************************
+// Выполнение записи опроса с повтором при ошибке КС или отсутствии ответа
+// Данные принимаются в локальный буфер и копируются в буфер записи под mutex_poll,
+// задачи уст-в читают буфер записи только через ModBusPollData()
+// uint8_t ind - индекс записи
+//*************************************************************************************************
+static void PollExec( uint8_t ind ) {
+
+    uint8_t cnt_rpt;
+    uint16_t len;
+    uint32_t tick, time;
+    ModBusError status;
+    MBUS_REQUEST reqst;
+    POLL_ENTRY *entry;
+    const MBUS_POLL *poll;
+
+    entry = &poll_tab[ind];
+    poll = entry->poll;
+    memset( &reqst, 0x00, sizeof( reqst ) );
+    reqst.dev_addr = poll->dev_addr;
+    reqst.function = FUNC_RD_HOLD_REG;
+    reqst.addr_reg = poll->addr_reg;
+    reqst.cnt_reg = poll->cnt_reg;
+    reqst.ptr_data = poll_buf;
+    reqst.ptr_lendata = &len;
+    tick = osKernelGetTickCount();
+    cnt_rpt = CNT_REPEAT_REQST;
+    do {
+        len = poll->cnt_reg * sizeof( uint16_t );
+        status = ModBusRequestCache( &reqst, poll->prio, MBUS_CACHE_FRESH );
+       } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+    time = osKernelGetTickCount() - tick;
+    osMutexAcquire( mutex_poll, osWaitForever );
+    if ( status == MBUS_ANSWER_OK )
+        memcpy( poll->data, poll_buf, poll->cnt_reg * sizeof( uint16_t ) );
+    entry->runs++;
+    entry->time_sum += time;
+    if ( time > entry->time_max )
+        entry->time_max = time;
+    if ( status != MBUS_ANSWER_OK )
+        entry->errors++;
+    if ( (int32_t)( osKernelGetTickCount() - ( entry->release + Deadline( poll ) ) ) > 0 )
+        entry->missed++;
+    //начало следующего периода, при перегрузке шины пропущенные периоды не выполняются
+    entry->release += poll->period;
+    if ( (int32_t)( osKernelGetTickCount() - entry->release ) > 0 )
+        entry->release = osKernelGetTickCount();
+    osMutexRelease( mutex_poll );
+    if ( poll->callback != NULL )
+        poll->callback( status, poll->arg );
+ }
+
+//*************************************************************************************************
+// Возвращает допустимое время выполнения записи от начала периода
+// const MBUS_POLL *poll - параметры записи
+// return uint32_t       - время (msec)
+//*************************************************************************************************
+static uint32_t Deadline( const MBUS_POLL *poll ) {
+
+    if ( !poll->deadline || poll->deadline > poll->period )
+        return poll->period;
+    return poll->deadline;
+ }
+
+//*************************************************************************************************
+// Возвращает кол-во зарегистрированных записей опроса
+//*************************************************************************************************
+uint8_t ModBusPollCnt( void ) {
+
+    return poll_cnt;
+ }
+
+//*************************************************************************************************
+// Возвращает загрузку шины циклическим опросом
+// MBusPollLoad type - тип расчета: по размеру пакетов/по измеренному времени выполнения
+// return uint32_t   - загрузка шины (0.1%)
+//*************************************************************************************************
+uint32_t ModBusPollLoad( MBusPollLoad type ) {
+
+    uint8_t i;
+    uint32_t load = 0, time;
+    const MBUS_POLL *poll;
+
+    osMutexAcquire( mutex_poll, osWaitForever );
+    for ( i = 0; i < poll_cnt; i++ ) {
+        poll = poll_tab[i].poll;
+        if ( type == MBUS_POLL_LOAD_CALC ) {
+            //время передачи запроса и ответа (usec)
+            time = ( POLL_SIZE_REQST + POLL_SIZE_ANSWER + poll->cnt_reg * 2 + POLL_SIZE_GAP ) * POLL_CHAR_TIME + POLL_TIME_SLAVE;
+            load += time / poll->period;
+           }
+        else if ( poll_tab[i].runs )
+            load += ( poll_tab[i].time_sum * 1000 ) / ( poll_tab[i].runs * poll->period );
+       }
+    osMutexRelease( mutex_poll );
+    return load;
+ }
+
+//*************************************************************************************************
+// Возвращает строку параметров и статистики записи опроса
+// uint8_t ind - индекс записи
+// char *str   - буфер для размещения строки
+// return      - указатель на строку, NULL - недопустимый индекс
+//*************************************************************************************************
+char *ModBusPollDesc( uint8_t ind, char *str ) {
+
+    POLL_ENTRY *entry;
+    const MBUS_POLL *poll;
+
+    if ( ind >= poll_cnt )
+        return NULL;
+    entry = &poll_tab[ind];
+    poll = entry->poll;
+    sprintf( str, "%3u  0x%04X %3u  %6u %6u   %u  %8u %6u %6u %5u %5u\r\n", poll->dev_addr, poll->addr_reg,
+             poll->cnt_reg, poll->period, Deadline( poll ), poll->prio, entry->runs, entry->errors, entry->missed,
+             entry->runs ? entry->time_sum / entry->runs : 0, entry->time_max );
+    return str;
+ }
@@ -0,0 +1,60 @@
+
+#ifndef __MODBUS_POLL_H
+#define __MODBUS_POLL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "device.h"
+#include "modbus.h"
+
+#define MBUS_POLL_MAX           8       //максимальное кол-во записей опроса
+#define MBUS_POLL_REG_MAX       32      //максимальное кол-во регистров записи опроса
+
+// Тип расчета загрузки шины
+typedef enum {
+    MBUS_POLL_LOAD_CALC,                //расчетная загрузка по размеру пакетов
+    MBUS_POLL_LOAD_MEAS                 //загрузка по измеренному времени выполнения
+ } MBusPollLoad;
+
+//*************************************************************************************************
+// Функция обратного вызова завершения опроса, выполняется в контексте задачи "ModbusPoll"
+// Функция должна только передать результат в задачу модуля уст-ва, блокирующие вызовы недопустимы
+// ModBusError status - результат выполнения запроса
+// void *arg          - параметр записи опроса
+//*************************************************************************************************
+typedef void ( *MBusPollCallback )( ModBusError status, void *arg );
+
+//*************************************************************************************************
+// Запись циклического опроса блока регистров уст-ва
+//*************************************************************************************************
+typedef struct {
+    uint8_t          dev_addr;          //адрес уст-ва
+    uint16_t         addr_reg;          //адрес первого регистра
+    uint16_t         cnt_reg;           //кол-во регистров
+    uint16_t         *data;             //буфер данных последнего успешного опроса,
+                                        //чтение только через ModBusPollData()
+    uint32_t         period;            //период опроса (msec)
+    uint32_t         deadline;          //допустимое время выполнения от начала периода (msec),
+                                        //0 - равен периоду опроса
+    MBusPrio         prio;              //приоритет, MBUS_PRIO_LOW - только в свободное время шины
+    MBusPollCallback callback;          //функция вызываемая по завершению опроса
+    void             *arg;              //параметр функции callback
+ } MBUS_POLL;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void ModBusPollInit( void );
+Status ModBusPollAdd( const MBUS_POLL *poll );
+void ModBusPollClr( void );
+void ModBusPollData( const MBUS_POLL *poll, uint16_t *data );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint8_t ModBusPollCnt( void );
+uint32_t ModBusPollLoad( MBusPollLoad type );
+char *ModBusPollDesc( uint8_t ind, char *str );
+
+#endif
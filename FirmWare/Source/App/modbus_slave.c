@@ -0,0 +1,428 @@
+
+//*************************************************************************************************
+//
+// Ведомое уст-во MODBUS RTU на консоли UART0
+// Данные уст-в контроллера доступны как регистры ввода (функция 0x04), параметры настроек как
+// регистры хранения (функция 0x03). Таблица адресов формируется при инициализации по описанию
+// параметров DevParam: каждый параметр занимает два регистра (int32, старшее слово первое)
+// по адресу: ID уст-ва * MBUS_SLAVE_BLOCK + индекс параметра * MBUS_SLAVE_PARAM, для параметров
+// настроек - индекс параметра * MBUS_SLAVE_PARAM. Дробные значения передаются целыми числами,
+// множитель 10^N, где N - кол-во знаков после запятой в формате вывода параметра.
+// Строковые параметры и даты в таблицу не включаются, их адреса остаются свободными.
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <stdbool.h>
+
+#include "cmsis_os2.h"
+
+#include "device.h"
+#include "dev_param.h"
+#include "config.h"
+
+#include "uart.h"
+#include "crc16.h"
+#include "message.h"
+#include "modbus_def.h"
+#include "modbus_slave.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define SLAVE_RECV_MAX          256         //максимальный размер пакета
+#define SLAVE_MAP_INPUT         256         //максимальное кол-во параметров регистров ввода
+#define SLAVE_MAP_HOLD          64          //максимальное кол-во параметров регистров хранения
+#define SLAVE_REGS_MAX          125         //максимальное кол-во регистров в одном запросе
+#define SLAVE_SIZE_REQST        8           //размер пакета запроса чтения регистров
+#define SLAVE_SCALE_MAX         6           //максимальная степень множителя дробных значений
+#define SLAVE_SCALE_DEF         2           //степень множителя если кол-во знаков не указано
+#define SLAVE_GAP               2           //интервал тишины окончания пакета (msec)
+#define SLAVE_FLAG_RECV         0x00000001  //флаг задачи: принят байт
+
+#define SLAVE_NONE              0xFFFF      //признак отсутствия параметра
+
+//*************************************************************************************************
+// Преобразование значения параметра в целое
+//*************************************************************************************************
+typedef enum {
+    CONV_UINT,                          //целое без знака
+    CONV_INT8,                          //целое со знаком (8 бит)
+    CONV_FLOAT                          //дробное, умножается на 10^scale
+ } SlaveConv;
+
+//*************************************************************************************************
+// Элемент таблицы адресов: регистры одного параметра
+//*************************************************************************************************
+typedef struct {
+    uint16_t addr;                      //адрес первого регистра
+    uint8_t  dev;                       //ID уст-ва
+    uint8_t  param;                     //ID параметра
+    uint8_t  conv;                      //тип преобразования SlaveConv
+    uint8_t  scale;                     //степень множителя дробного значения
+ } SLAVE_REG;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+//уст-ва, параметры которых доступны как регистры ввода
+static const Device slave_dev[] = {
+    ID_DEV_PORTS, ID_DEV_BATMON, ID_DEV_MPPT, ID_DEV_PV, ID_DEV_CHARGER, ID_DEV_INV1, ID_DEV_INV2,
+    ID_DEV_ALT, ID_DEV_GEN, ID_DEV_TRC, ID_DEV_SPA, ID_DEV_VOICE
+ };
+
+static const uint32_t scale_mul[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+//имена параметров портов (описания DevParam нет)
+static char * const port_name[] = { "FUSE_24VDC", "BAT_CONNECT", "STAT_CTRL", "CPU_MODE", "PORTS_ALL" };
+
+//расшифровка типа преобразования значения
+static char * const conv_name[] = { "uint", "int", "float" };
+
+static SLAVE_REG map_input[SLAVE_MAP_INPUT];            //таблица адресов регистров ввода
+static SLAVE_REG map_hold[SLAVE_MAP_HOLD];              //таблица адресов регистров хранения
+static uint16_t map_cnt[MBUS_SLAVE_HOLD + 1];           //кол-во параметров в таблицах
+
+static uint8_t recv_buff[SLAVE_RECV_MAX];
+static uint8_t send_buff[SLAVE_RECV_MAX];
+static volatile uint16_t recv_ind = 0;
+static volatile uint16_t recv_crc = CRC16_INIT;         //CRC принятых байт, рассчитывается по мере приема
+static uint32_t slave_stat[MBUS_SLAVE_CNT];
+
+static osThreadId_t slave_thread;
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osThreadAttr_t slave_attr = {
+    .name = "ModbusSlave",
+    .stack_size = 512,
+    .priority = osPriorityNormal
+ };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void MapAdd( MBusSlaveMap map, uint16_t addr, Device dev, uint8_t param, const DevParam *dp );
+static uint16_t MapFind( SLAVE_REG *ptr, uint16_t cnt, uint16_t addr );
+static int32_t RegValue( SLAVE_REG *reg );
+static uint16_t ReadRegs( MBusSlaveMap map, uint16_t addr, uint16_t cnt, uint8_t *data );
+static uint16_t Request( uint8_t *data, uint16_t len );
+static uint16_t Exception( uint8_t *data, ModBusError error );
+static void TaskSlave( void *pvParameters );
+
+//*************************************************************************************************
+// Инициализация ведомого уст-ва, формирование таблицы адресов регистров
+//*************************************************************************************************
+void ModBusSlaveInit( void ) {
+
+    uint8_t i, param, cnt;
+    const DevParam *dp;
+
+    memset( map_cnt, 0x00, sizeof( map_cnt ) );
+    memset( slave_stat, 0x00, sizeof( slave_stat ) );
+    //регистры ввода, уст-ва в порядке возрастания ID, таблица упорядочена по адресам
+    for ( i = 0; i < SIZE_ARRAY( slave_dev ); i++ ) {
+        dp = DevParamPtr( slave_dev[i] );
+        //для портов описания параметров нет, значения - целые числа
+        cnt = dp == NULL ? PORTS_ALL + 1 : DevParamCnt( slave_dev[i], CNT_FULL );
+        for ( param = 0; param < cnt; param++ )
+            MapAdd( MBUS_SLAVE_INPUT, slave_dev[i] * MBUS_SLAVE_BLOCK + param * MBUS_SLAVE_PARAM, slave_dev[i],
+                    param, dp == NULL ? NULL : &dp[param] );
+       }
+    //регистры хранения - параметры настроек
+    dp = DevParamPtr( ID_CONFIG );
+    for ( param = 0; param < DevParamCnt( ID_CONFIG, CNT_FULL ); param++ )
+        MapAdd( MBUS_SLAVE_HOLD, param * MBUS_SLAVE_PARAM, ID_CONFIG, param, &dp[param] );
+    slave_thread = osThreadNew( TaskSlave, NULL, &slave_attr );
+ }
+
+//*************************************************************************************************
+// Задача обработки запросов
+// Окончание пакета определяется по интервалу тишины SLAVE_GAP, т.к. интервал 3.5 байта при
+// скорости консоли меньше периода системного таймера
+//*************************************************************************************************
+static void TaskSlave( void *pvParameters ) {
+
+    uint16_t len;
+    uint32_t flags;
+
+    for ( ;; ) {
+        flags = osThreadFlagsWait( SLAVE_FLAG_RECV, osFlagsWaitAny, recv_ind ? SLAVE_GAP : osWaitForever );
+        if ( !( flags & osFlagsError ) || !recv_ind )
+            continue; //прием пакета не завершен
+        len = recv_ind;
+        if ( len == 1 && recv_buff[0] == KEY_ESC ) {
+            //одиночный байт ESC - возврат в режим консоли
+            recv_crc = CRC16Init();
+            recv_ind = 0;
+            UartModbus( false );
+            UartSendStr( Message( CONS_MSG_OK ) );
+            UartSendStr( Message( CONS_MSG_PROMPT ) );
+            continue;
+           }
+        len = Request( recv_buff, len );
+        recv_crc = CRC16Init();
+        recv_ind = 0;
+        if ( len )
+            UartSendData( send_buff, len );
+       }
+ }
+
+//*************************************************************************************************
+// Перевод консоли UART0 в режим ведомого уст-ва MODBUS RTU
+// Возврат в режим консоли - передача одиночного байта ESC (0x1B)
+//*************************************************************************************************
+void ModBusSlaveStart( void ) {
+
+    recv_crc = CRC16Init();
+    recv_ind = 0;
+    UartModbus( true );
+ }
+
+//*************************************************************************************************
+// Прием байта пакета, вызывается из обработчика прерывания UART0
+// uint8_t data - принятый байт
+//*************************************************************************************************
+void ModBusSlaveRecv( uint8_t data ) {
+
+    if ( recv_ind < sizeof( recv_buff ) ) {
+        recv_buff[recv_ind++] = data;
+        recv_crc = CRC16Update( recv_crc, data );
+       }
+    osThreadFlagsSet( slave_thread, SLAVE_FLAG_RECV );
+ }
+
+//*************************************************************************************************
+// Обработка пакета запроса, формирование пакета ответа в send_buff
+// uint8_t *data   - пакет запроса
+// uint16_t len    - размер пакета
+// return uint16_t - размер пакета ответа, 0 - ответ не передается
+//*************************************************************************************************
+static uint16_t Request( uint8_t *data, uint16_t len ) {
+
+    uint16_t addr, cnt, crc;
+
+    if ( len < 4 || ( data[0] != _MBUS_SLAVE_ADDR ) )
+        return 0; //запрос другому уст-ву или broadcast, ответ не передается
+    //КС рассчитана при приеме, включая CRC пакета
+    if ( CRC16Final( recv_crc ) ) {
+        slave_stat[MBUS_SLAVE_CRC]++;
+        return 0;
+       }
+    slave_stat[MBUS_SLAVE_FRAMES]++;
+    send_buff[0] = data[0];
+    send_buff[1] = data[1];
+    if ( data[1] != FUNC_RD_HOLD_REG && data[1] != FUNC_RD_INP_REG )
+        return Exception( send_buff, MBUS_ERROR_FUNC );
+    if ( len != SLAVE_SIZE_REQST )
+        return Exception( send_buff, MBUS_ERROR_DATA );
+    addr = ( data[2] << 8 ) | data[3];
+    cnt = ( data[4] << 8 ) | data[5];
+    if ( !cnt || cnt > SLAVE_REGS_MAX )
+        return Exception( send_buff, MBUS_ERROR_DATA );
+    //значения регистров за один проход по таблице адресов
+    if ( !ReadRegs( data[1] == FUNC_RD_INP_REG ? MBUS_SLAVE_INPUT : MBUS_SLAVE_HOLD, addr, cnt, send_buff + 3 ) )
+        return Exception( send_buff, MBUS_ERROR_ADDR );
+    send_buff[2] = cnt * sizeof( uint16_t );
+    len = 3 + send_buff[2];
+    crc = CalcCRC16( send_buff, len );
+    memcpy( send_buff + len, &crc, sizeof( uint16_t ) );
+    return len + sizeof( uint16_t );
+ }
+
+//*************************************************************************************************
+// Формирование пакета ответа с кодом ошибки
+// uint8_t *data     - пакет ответа с заполненными адресом и кодом функции
+// ModBusError error - код ошибки
+// return uint16_t   - размер пакета ответа
+//*************************************************************************************************
+static uint16_t Exception( uint8_t *data, ModBusError error ) {
+
+    uint16_t crc;
+
+    slave_stat[MBUS_SLAVE_EXCEPT]++;
+    data[1] |= FUNC_ANSWER_ERROR;
+    data[2] = error;
+    crc = CalcCRC16( data, 3 );
+    memcpy( data + 3, &crc, sizeof( uint16_t ) );
+    return 3 + sizeof( uint16_t );
+ }
+
+//*************************************************************************************************
+// Чтение значений регистров по таблице адресов
+// Регистры без параметров в диапазоне запроса возвращаются со значением 0
+// MBusSlaveMap map - таблица адресов
+// uint16_t addr    - адрес первого регистра
+// uint16_t cnt     - кол-во регистров
+// uint8_t *data    - буфер для значений регистров (старший байт первый)
+// return uint16_t  - кол-во регистров имеющих параметр, 0 - в диапазоне нет параметров
+//*************************************************************************************************
+static uint16_t ReadRegs( MBusSlaveMap map, uint16_t addr, uint16_t cnt, uint8_t *data ) {
+
+    int32_t value = 0;
+    uint16_t ind, reg, word, found = 0, ind_val = SLAVE_NONE;
+    SLAVE_REG *ptr;
+
+    ptr = map == MBUS_SLAVE_INPUT ? map_input : map_hold;
+    ind = MapFind( ptr, map_cnt[map], addr );
+    for ( reg = addr; reg < addr + cnt; reg++, data += sizeof( uint16_t ) ) {
+        //пропускаем параметры адреса которых меньше текущего регистра
+        while ( ind < map_cnt[map] && ptr[ind].addr + MBUS_SLAVE_PARAM <= reg )
+            ind++;
+        if ( ind >= map_cnt[map] || ptr[ind].addr > reg ) {
+            data[0] = data[1] = 0;
+            continue;
+           }
+        //значение параметра читается один раз для обоих регистров
+        if ( ind != ind_val ) {
+            value = RegValue( &ptr[ind] );
+            ind_val = ind;
+           }
+        word = reg == ptr[ind].addr ? (uint32_t)value >> 16 : (uint32_t)value & 0xFFFF;
+        data[0] = word >> 8;
+        data[1] = word & 0xFF;
+        found++;
+       }
+    return found;
+ }
+
+//*************************************************************************************************
+// Поиск первого параметра содержащего регистр с адресом не меньше указанного
+// SLAVE_REG *ptr  - таблица адресов
+// uint16_t cnt    - кол-во параметров в таблице
+// uint16_t addr   - адрес регистра
+// return uint16_t - индекс параметра, cnt - параметров нет
+//*************************************************************************************************
+static uint16_t MapFind( SLAVE_REG *ptr, uint16_t cnt, uint16_t addr ) {
+
+    uint16_t beg = 0, end = cnt, mid;
+
+    while ( beg < end ) {
+        mid = ( beg + end ) / 2;
+        if ( ptr[mid].addr + MBUS_SLAVE_PARAM <= addr )
+            beg = mid + 1;
+        else end = mid;
+       }
+    return beg;
+ }
+
+//*************************************************************************************************
+// Возвращает значение параметра преобразованное в целое
+// SLAVE_REG *reg - элемент таблицы адресов
+// return int32_t - значение
+//*************************************************************************************************
+static int32_t RegValue( SLAVE_REG *reg ) {
+
+    float value;
+    ValueParam param;
+
+    param = ParamGetVal( (Device)reg->dev, reg->param );
+    if ( reg->conv == CONV_INT8 )
+        return param.int8;
+    if ( reg->conv == CONV_UINT )
+        return param.uint32;
+    value = param.flt * scale_mul[reg->scale];
+    return (int32_t)( value < 0 ? value - 0.5f : value + 0.5f );
+ }
+
+//*************************************************************************************************
+// Добавление параметра в таблицу адресов, тип преобразования и множитель определяются
+// по подтипу и формату вывода параметра
+// MBusSlaveMap map    - таблица адресов
+// uint16_t addr       - адрес первого регистра параметра
+// Device dev          - ID уст-ва
+// uint8_t param       - ID параметра
+// const DevParam *dp  - описание параметра, NULL - целое без знака
+//*************************************************************************************************
+static void MapAdd( MBusSlaveMap map, uint16_t addr, Device dev, uint8_t param, const DevParam *dp ) {
+
+    char *ptr;
+    SLAVE_REG *reg;
+
+    if ( map == MBUS_SLAVE_INPUT && map_cnt[map] >= SLAVE_MAP_INPUT )
+        return;
+    if ( map == MBUS_SLAVE_HOLD && map_cnt[map] >= SLAVE_MAP_HOLD )
+        return;
+    reg = map == MBUS_SLAVE_INPUT ? &map_input[map_cnt[map]] : &map_hold[map_cnt[map]];
+    reg->addr = addr;
+    reg->dev = dev;
+    reg->param = param;
+    reg->conv = CONV_UINT;
+    reg->scale = 0;
+    if ( dp != NULL ) {
+        //строки и даты в регистрах не передаются
+        if ( dp->subtype == STRING || dp->subtype == STRINT || dp->subtype == SDATE || dp->subtype == DATES ||
+             dp->subtype == DOUBLE || dp->subtype == TIMESTART || dp->subtype == NOTYPE )
+            return;
+        if ( dp->subtype == NUMSIGN )
+            reg->conv = CONV_INT8;
+        if ( dp->subtype == FLOAT || dp->subtype == TIME_SUN ) {
+            reg->conv = CONV_FLOAT;
+            //кол-во знаков после запятой из формата вывода
+            ptr = strchr( dp->frm, '.' );
+            if ( ptr != NULL && isdigit( ptr[1] ) )
+                reg->scale = ptr[1] - '0';
+            else reg->scale = SLAVE_SCALE_DEF;
+            if ( reg->scale > SLAVE_SCALE_MAX )
+                reg->scale = SLAVE_SCALE_MAX;
+           }
+       }
+    map_cnt[map]++;
+ }
+
+//*************************************************************************************************
+// Обнуляет счетчики обмена
+//*************************************************************************************************
+void ModBusSlaveClr( void ) {
+
+    memset( slave_stat, 0x00, sizeof( slave_stat ) );
+ }
+
+//*************************************************************************************************
+// Возвращает значение счетчика обмена
+// MBusSlaveStat type - тип счетчика
+// return uint32_t    - значение счетчика
+//*************************************************************************************************
+uint32_t ModBusSlaveStat( MBusSlaveStat type ) {
+
+    if ( type >= MBUS_SLAVE_CNT )
+        return 0;
+    return slave_stat[type];
+ }
+
+//*************************************************************************************************
+// Возвращает кол-во параметров в таблице адресов
+// MBusSlaveMap map - таблица адресов
+//*************************************************************************************************
+uint16_t ModBusSlaveCnt( MBusSlaveMap map ) {
+
+    if ( map > MBUS_SLAVE_HOLD )
+        return 0;
+    return map_cnt[map];
+ }
+
+//*************************************************************************************************
+// Возвращает строку описания параметра таблицы адресов
+// MBusSlaveMap map - таблица адресов
+// uint16_t ind     - индекс параметра
+// char *str        - буфер для размещения строки
+// return           - указатель на строку, NULL - недопустимый индекс
+//*************************************************************************************************
+char *ModBusSlaveDesc( MBusSlaveMap map, uint16_t ind, char *str ) {
+
+    char *name;
+    SLAVE_REG *reg;
+
+    if ( map > MBUS_SLAVE_HOLD || ind >= map_cnt[map] )
+        return NULL;
+    reg = map == MBUS_SLAVE_INPUT ? &map_input[ind] : &map_hold[ind];
+    if ( reg->dev == ID_DEV_PORTS )
+        name = reg->param < SIZE_ARRAY( port_name ) ? port_name[reg->param] : NULL;
+    else name = ParamGetName( (Device)reg->dev, reg->param );
+    sprintf( str, "0x%04X  %-8s %-24s %-5s x%u\r\n", reg->addr, DevName( (Device)reg->dev ), name != NULL ? name : "",
+             conv_name[reg->conv], scale_mul[reg->scale] );
+    return str;
+ }
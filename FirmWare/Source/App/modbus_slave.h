@@ -0,0 +1,42 @@
+
+#ifndef __MODBUS_SLAVE_H
+#define __MODBUS_SLAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "device.h"
+
+#define MBUS_SLAVE_BLOCK        0x80    //кол-во регистров в блоке одного уст-ва
+#define MBUS_SLAVE_PARAM        2       //кол-во регистров одного параметра (int32, старшее слово первое)
+
+// Счетчики обмена в режиме ведомого
+typedef enum {
+    MBUS_SLAVE_FRAMES,                  //обработано запросов
+    MBUS_SLAVE_CRC,                     //ошибка КС
+    MBUS_SLAVE_EXCEPT,                  //ответов с кодом ошибки
+    MBUS_SLAVE_CNT                      //кол-во счетчиков
+ } MBusSlaveStat;
+
+// Тип регистров таблицы адресов
+typedef enum {
+    MBUS_SLAVE_INPUT,                   //регистры ввода (функция 0x04), данные уст-в
+    MBUS_SLAVE_HOLD                     //регистры хранения (функция 0x03), параметры настроек
+ } MBusSlaveMap;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void ModBusSlaveInit( void );
+void ModBusSlaveStart( void );
+void ModBusSlaveRecv( uint8_t data );
+void ModBusSlaveClr( void );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t ModBusSlaveStat( MBusSlaveStat type );
+uint16_t ModBusSlaveCnt( MBusSlaveMap map );
+char *ModBusSlaveDesc( MBusSlaveMap map, uint16_t ind, char *str );
+
+#endif
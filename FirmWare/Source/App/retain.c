@@ -0,0 +1,474 @@
+
+//*************************************************************************************************
+//
+// Управление хранением протоколов на SD карте
+// Для каждого класса протоколов (каталога) задается срок хранения, максимальный объем и порог
+// свободного места на карте. Задача с низким приоритетом один раз за цикл проверяет каталог
+// класса (включая подкаталоги YYYYMM) и формирует список самых старых файлов, за один шаг
+// удаляется один файл из списка, файлы текущих суток/месяца не удаляются. Классы с большим
+// порогом свободного места удаляются раньше
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <ctype.h>
+
+#include "rl_fs.h"
+#include "cmsis_os2.h"
+
+#include "lpc177x_8x_rtc.h"
+
+#include "device.h"
+#include "config.h"
+#include "rtc.h"
+#include "sdcard.h"
+#include "logger.h"
+#include "message.h"
+#include "retain.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define RETAIN_STEP             200         //интервал между шагами проверки каталогов (msec)
+#define RETAIN_IDLE             60000       //интервал между циклами проверки всех каталогов (msec)
+#define RETAIN_MB               1048576     //размер мегабайта (байт)
+#define RETAIN_MONTH            32          //день в дате месячного файла (после всех суток месяца)
+#define RETAIN_CAND             8           //кол-во файлов в списке на удаление за один цикл проверки
+
+//*************************************************************************************************
+// Локальные типы данных
+//*************************************************************************************************
+//Политика хранения класса протоколов
+typedef struct {
+    char        *dir;                       //каталог протоколов
+    uint16_t    days;                       //срок хранения (дней), 0 - без ограничения
+    uint16_t    size;                       //максимальный объем (Мбайт), 0 - без ограничения
+    uint16_t    free;                       //порог свободного места на карте (Мбайт), 0 - нет
+ } RETAIN_POLICY;
+
+//Состояние класса по последней проверке
+typedef struct {
+    uint32_t    files;                      //кол-во файлов протоколов
+    uint32_t    kbytes;                     //объем файлов (Кбайт)
+    uint32_t    oldest;                     //дата самого старого файла YYYYMMDD, 0 - нет
+ } RETAIN_STAT;
+
+//Самый старый файл класса
+typedef struct {
+    char        name[LOG_NAME];             //имя файла с путем
+    uint32_t    date;                       //дата YYYYMMDD, 0 - файла нет
+    uint32_t    size;                       //размер файла (байт)
+ } RETAIN_FILE;
+
+//Причина удаления файла
+typedef enum {
+    RETAIN_AGE,                             //истек срок хранения
+    RETAIN_SIZE,                            //превышен объем класса
+    RETAIN_FREE                             //мало свободного места
+ } RetainReason;
+
+//Состояние свободного места
+typedef enum {
+    RETAIN_OK,                              //свободного места достаточно
+    RETAIN_LOW,                             //выполняется удаление протоколов
+    RETAIN_FULL                             //протоколов для удаления нет
+ } RetainState;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static const RETAIN_POLICY retain_policy[] = {
+    //каталог       срок (дней)             объем (Мбайт)       свободное место (Мбайт)
+    "\\batmon",     _RETAIN_DATA_DAYS,      _RETAIN_DATA_SIZE,  _RETAIN_FREE_MIN * 2,
+    "\\mppt",       _RETAIN_DATA_DAYS,      _RETAIN_DATA_SIZE,  _RETAIN_FREE_MIN * 2,
+    "\\inv",        _RETAIN_DATA_DAYS,      _RETAIN_DATA_SIZE,  _RETAIN_FREE_MIN * 2,
+    "\\charger",    _RETAIN_DATA_DAYS,      _RETAIN_DATA_SIZE,  _RETAIN_FREE_MIN * 2,
+    "\\gen",        _RETAIN_EVENT_DAYS,     0,                  _RETAIN_FREE_MIN,
+    "\\alt",        _RETAIN_EVENT_DAYS,     0,                  _RETAIN_FREE_MIN,
+    "\\trc",        _RETAIN_EVENT_DAYS,     0,                  _RETAIN_FREE_MIN,
+    "\\voice",      _RETAIN_EVENT_DAYS,     0,                  _RETAIN_FREE_MIN,
+    "\\execute",    _RETAIN_EVENT_DAYS,     0,                  _RETAIN_FREE_MIN,
+    "\\hmi",        _RETAIN_EVENT_DAYS,     0,                  _RETAIN_FREE_MIN,
+    "\\sdcard",     _RETAIN_EVENT_DAYS,     0,                  _RETAIN_FREE_MIN,
+    "\\rollup",     0,                      0,                  _RETAIN_FREE_MIN / 2
+ };
+
+static char * const reason_name[] = { "age", "size", "free" };
+static char * const state_name[] = { "OK", "LOW", "FULL" };
+
+static RETAIN_STAT retain_stat[SIZE_ARRAY( retain_policy )];
+static RetainState retain_state = RETAIN_OK;
+static uint32_t del_files = 0;                          //кол-во удаленных файлов
+static uint32_t del_kbytes = 0;                         //объем удаленных файлов (Кбайт)
+static fsFileInfo info, sub;                            //используются только задачей
+static RETAIN_FILE cand[RETAIN_CAND];                   //самые старые файлы класса по возрастанию даты
+static uint8_t cand_cnt = 0;                            //кол-во файлов в списке
+static uint8_t cand_pos = 0;                            //следующий файл списка для удаления
+static bool cand_more = false;                          //в каталоге есть старые файлы не вошедшие в список
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osThreadAttr_t retain_attr = {
+    .name = "Retain",
+    .stack_size = 1024,
+    .priority = osPriorityLow
+ };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void TaskRetain( void *pvParameters );
+static bool RetainStep( uint8_t cls, uint32_t today, int64_t avail );
+static void RetainCheck( bool deleted, int64_t avail );
+static void RetainEvent( LogMessId id );
+static void ClassScan( uint8_t cls, uint32_t today );
+static void FileCheck( char *dir, fsFileInfo *file, uint32_t today, uint64_t *bytes );
+static bool FileRemove( uint8_t cls, RETAIN_FILE *file, RetainReason reason );
+static uint32_t NameDate( char *name );
+static uint32_t DayNum( uint32_t date );
+static uint32_t Today( void );
+
+//*************************************************************************************************
+// Инициализация, создание задачи
+//*************************************************************************************************
+void RetainInit( void ) {
+
+    memset( retain_stat, 0x00, sizeof( retain_stat ) );
+    osThreadNew( TaskRetain, NULL, &retain_attr );
+ }
+
+//*************************************************************************************************
+// Вывод политик хранения и состояния протоколов по последней проверке
+// Source src - режим вывода информации в консоль
+//*************************************************************************************************
+void RetainShow( Source src ) {
+
+    uint8_t cls;
+    int64_t avail;
+    char str[100], tmp[32];
+
+    ConsoleSend( "Class      Days  Size MB  Free MB   Files    Size KB  Oldest\r\n", src );
+    for ( cls = 0; cls < SIZE_ARRAY( retain_policy ); cls++ ) {
+        sprintf( str, "%-10s %4u %8u %8u %7u %10u  ", retain_policy[cls].dir, retain_policy[cls].days,
+                 retain_policy[cls].size, retain_policy[cls].free, retain_stat[cls].files, retain_stat[cls].kbytes );
+        ConsoleSend( str, src );
+        if ( !retain_stat[cls].oldest )
+            strcpy( str, "-\r\n" );
+        else if ( retain_stat[cls].oldest % 100 == RETAIN_MONTH )
+            sprintf( str, "%02u.%04u\r\n", retain_stat[cls].oldest / 100 % 100, retain_stat[cls].oldest / 10000 );
+        else sprintf( str, "%02u.%02u.%04u\r\n", retain_stat[cls].oldest % 100, retain_stat[cls].oldest / 100 % 100,
+                      retain_stat[cls].oldest / 10000 );
+        ConsoleSend( str, src );
+       }
+    avail = SDStatus() == SUCCESS ? SDFree() : -1;
+    if ( avail >= 0 )
+        FormatDot( avail, tmp );
+    else strcpy( tmp, "-" );
+    sprintf( str, "Free: %s bytes state: %s deleted files: %u size: %u KB\r\n", tmp, state_name[retain_state],
+             del_files, del_kbytes );
+    ConsoleSend( str, src );
+ }
+
+//*************************************************************************************************
+// Задача проверки протоколов: каталог класса проверяется один раз за цикл, затем за один шаг
+// удаляется один файл из списка самых старых файлов класса, после удаления файлов по списку или
+// при отсутствии файлов для удаления выполняется переход к следующему классу, после проверки
+// всех каталогов - пауза RETAIN_IDLE
+//*************************************************************************************************
+static void TaskRetain( void *pvParameters ) {
+
+    uint8_t cls = 0;
+    int64_t avail;
+    uint32_t today = 0;
+    bool deleted = false, scan = true;
+
+    for ( ;; ) {
+        if ( SDStatus() == ERROR || ( avail = SDFree() ) < 0 ) {
+            cls = 0;
+            scan = true;
+            osDelay( RETAIN_IDLE );
+            continue; //карты нет
+           }
+        if ( scan == true ) {
+            today = Today();
+            ClassScan( cls, today );
+            scan = false;
+           }
+        if ( RetainStep( cls, today, avail ) == true ) {
+            deleted = true;
+            osDelay( RETAIN_STEP );
+            continue;
+           }
+        scan = true;
+        if ( ++cls < SIZE_ARRAY( retain_policy ) ) {
+            osDelay( RETAIN_STEP );
+            continue;
+           }
+        //цикл проверки всех каталогов завершен
+        RetainCheck( deleted, SDFree() );
+        cls = 0;
+        deleted = false;
+        osDelay( RETAIN_IDLE );
+       }
+ }
+
+//*************************************************************************************************
+// Удаление следующего файла из списка самых старых файлов класса по политике класса
+// Состояние класса (кол-во, объем, самый старый файл) корректируется без повторной проверки
+// каталога, файлы не вошедшие в список удаляются в следующем цикле проверки
+// uint8_t cls    - индекс класса протоколов
+// uint32_t today - текущая дата YYYYMMDD
+// int64_t avail   - свободное место на карте (байт)
+// return = true  - файл удален
+//*************************************************************************************************
+static bool RetainStep( uint8_t cls, uint32_t today, int64_t avail ) {
+
+    bool result;
+    RETAIN_FILE *old;
+    RetainReason reason;
+    RETAIN_STAT *stat;
+    const RETAIN_POLICY *policy;
+
+    if ( cand_pos >= cand_cnt )
+        return false; //удалять нечего
+    old = &cand[cand_pos];
+    stat = &retain_stat[cls];
+    policy = &retain_policy[cls];
+    if ( policy->days && DayNum( today ) - DayNum( old->date ) > policy->days )
+        reason = RETAIN_AGE;
+    else if ( policy->size && stat->kbytes > (uint32_t)policy->size * 1024 )
+        reason = RETAIN_SIZE;
+    else if ( policy->free && avail < (int64_t)policy->free * RETAIN_MB )
+        reason = RETAIN_FREE;
+    else return false;
+    if ( reason == RETAIN_FREE && retain_state == RETAIN_OK ) {
+        retain_state = RETAIN_LOW;
+        RetainEvent( LOG_MSG_SD_LOW );
+       }
+    result = FileRemove( cls, old, reason );
+    cand_pos++;
+    if ( result == false )
+        return false;
+    //состояние класса после удаления файла
+    stat->files--;
+    stat->kbytes -= stat->kbytes > old->size / 1024 ? old->size / 1024 : stat->kbytes;
+    if ( cand_pos < cand_cnt )
+        stat->oldest = cand[cand_pos].date;
+    else if ( cand_more == false )
+        stat->oldest = 0;
+    return true;
+ }
+
+//*************************************************************************************************
+// Проверка свободного места после цикла проверки всех каталогов
+// bool deleted  - в цикле проверки удалялись файлы
+// int64_t avail  - свободное место на карте (байт)
+//*************************************************************************************************
+static void RetainCheck( bool deleted, int64_t avail ) {
+
+    uint8_t cls;
+    int64_t low = 0, high = 0;
+
+    if ( avail < 0 )
+        return;
+    //минимальный и максимальный пороги свободного места
+    for ( cls = 0; cls < SIZE_ARRAY( retain_policy ); cls++ ) {
+        if ( !retain_policy[cls].free )
+            continue;
+        if ( !low || retain_policy[cls].free < low )
+            low = retain_policy[cls].free;
+        if ( retain_policy[cls].free > high )
+            high = retain_policy[cls].free;
+       }
+    if ( avail < low * RETAIN_MB && deleted == false && retain_state != RETAIN_FULL ) {
+        retain_state = RETAIN_FULL;
+        RetainEvent( LOG_MSG_SD_FULL );
+        return;
+       }
+    if ( avail >= high * RETAIN_MB && retain_state != RETAIN_OK ) {
+        retain_state = RETAIN_OK;
+        RetainEvent( LOG_MSG_SD_FREE );
+       }
+ }
+
+//*************************************************************************************************
+// Запись события в протокол SD карты и передача события в HMI
+// LogMessId id - ID сообщения
+//*************************************************************************************************
+static void RetainEvent( LogMessId id ) {
+
+    LogPrintf( LOG_SDCARD, "%s %s\r\n", RTCGetLog(), MessageLog( ID_DEV_SDCARD, id ) );
+ }
+
+//*************************************************************************************************
+// Проверка каталога класса и подкаталогов YYYYMM: кол-во и объем файлов, список самых старых
+// файлов класса (cand[])
+// uint8_t cls       - индекс класса протоколов
+// uint32_t today    - текущая дата YYYYMMDD
+//*************************************************************************************************
+static void ClassScan( uint8_t cls, uint32_t today ) {
+
+    uint64_t bytes = 0;
+    char path[LOG_NAME], dir[LOG_NAME];
+    RETAIN_STAT *stat;
+
+    stat = &retain_stat[cls];
+    stat->files = 0;
+    cand_cnt = cand_pos = 0;
+    cand_more = false;
+    sprintf( path, "%s\\*.*", retain_policy[cls].dir );
+    info.fileID = 0;
+    while ( ffind( path, &info ) == fsOK ) {
+        if ( !( info.attrib & FS_FAT_ATTR_DIRECTORY ) ) {
+            FileCheck( retain_policy[cls].dir, &info, today, &bytes );
+            stat->files++;
+            continue;
+           }
+        if ( strlen( info.name ) != 6 || !NameDate( info.name ) )
+            continue; //не каталог YYYYMM
+        sprintf( dir, "%s\\%s", retain_policy[cls].dir, info.name );
+        sprintf( path, "%s\\*.*", dir );
+        sub.fileID = 0;
+        while ( ffind( path, &sub ) == fsOK ) {
+            if ( sub.attrib & FS_FAT_ATTR_DIRECTORY )
+                continue;
+            FileCheck( dir, &sub, today, &bytes );
+            stat->files++;
+           }
+        sprintf( path, "%s\\*.*", retain_policy[cls].dir );
+       }
+    stat->kbytes = bytes / 1024;
+    stat->oldest = cand_cnt ? cand[0].date : 0;
+ }
+
+//*************************************************************************************************
+// Учет файла протокола, файл добавляется в список самых старых файлов класса по возрастанию
+// даты, при заполненном списке вытесняется файл с самой поздней датой
+// Файлы без даты в имени и файлы текущих суток/месяца не удаляются
+// char *dir         - каталог файла
+// fsFileInfo *file  - параметры файла
+// uint32_t today    - текущая дата YYYYMMDD
+// uint64_t *bytes   - объем файлов класса
+//*************************************************************************************************
+static void FileCheck( char *dir, fsFileInfo *file, uint32_t today, uint64_t *bytes ) {
+
+    uint8_t pos;
+    uint32_t date;
+
+    *bytes += file->size;
+    date = NameDate( file->name );
+    if ( !date || date >= today )
+        return;
+    if ( strlen( dir ) + strlen( file->name ) + 2 > sizeof( cand[0].name ) )
+        return;
+    if ( cand_cnt == RETAIN_CAND ) {
+        cand_more = true;
+        if ( date >= cand[RETAIN_CAND - 1].date )
+            return; //файл новее всех файлов списка
+       }
+    else cand_cnt++;
+    //сдвиг более новых файлов списка
+    for ( pos = cand_cnt - 1; pos && cand[pos - 1].date > date; pos-- )
+        memcpy( &cand[pos], &cand[pos - 1], sizeof( RETAIN_FILE ) );
+    sprintf( cand[pos].name, "%s\\%s", dir, file->name );
+    cand[pos].date = date;
+    cand[pos].size = file->size;
+ }
+
+//*************************************************************************************************
+// Удаление файла протокола, открытые файлы протоколов предварительно закрываются
+// Пустой подкаталог YYYYMM удаляется
+// uint8_t cls          - индекс класса протоколов
+// RETAIN_FILE *file    - удаляемый файл
+// RetainReason reason  - причина удаления
+// return = true        - файл удален
+//*************************************************************************************************
+static bool FileRemove( uint8_t cls, RETAIN_FILE *file, RetainReason reason ) {
+
+    char *sep;
+    fsStatus fstat;
+
+    LogLock();
+    fstat = fdelete( file->name, NULL );
+    sep = strrchr( file->name, '\\' );
+    if ( fstat == fsOK && sep != NULL && sep - file->name > strlen( retain_policy[cls].dir ) ) {
+        *sep = '\0';
+        frmdir( file->name, NULL ); //непустой каталог не удаляется
+        *sep = '\\';
+       }
+    LogUnlock();
+    if ( fstat != fsOK ) {
+        LogPrintf( LOG_SDCARD, "%s %s %s error: %u\r\n", RTCGetLog(), reason_name[reason], file->name, fstat );
+        return false;
+       }
+    del_files++;
+    del_kbytes += file->size / 1024;
+    LogPrintf( LOG_SDCARD, "%s %s %s %u\r\n", RTCGetLog(), reason_name[reason], file->name, file->size );
+    return true;
+ }
+
+//*************************************************************************************************
+// Возвращает дату по окончанию имени файла/каталога: ...YYYYMMDD.ext или ...YYYYMM.ext
+// char *name      - имя файла
+// return uint32_t - дата YYYYMMDD, для месячного файла YYYYMM32, 0 - даты в имени нет
+//*************************************************************************************************
+static uint32_t NameDate( char *name ) {
+
+    char *end;
+    uint8_t cnt = 0;
+    uint32_t date = 0, month;
+
+    end = strchr( name, '.' );
+    if ( end == NULL )
+        end = name + strlen( name );
+    while ( end > name && isdigit( *( end - 1 ) ) && cnt < 9 ) {
+        end--;
+        cnt++;
+       }
+    if ( cnt != 8 && cnt != 6 )
+        return 0;
+    for ( ; cnt; cnt-- )
+        date = date * 10 + *end++ - '0';
+    if ( date < 1000000 )
+        date = date * 100 + RETAIN_MONTH;
+    month = date / 100 % 100;
+    if ( month < 1 || month > 12 || date % 100 < 1 || date % 100 > RETAIN_MONTH )
+        return 0;
+    return date;
+ }
+
+//*************************************************************************************************
+// Возвращает порядковый номер дня для расчета разницы дат
+// uint32_t date   - дата YYYYMMDD
+// return uint32_t - номер дня
+//*************************************************************************************************
+static uint32_t DayNum( uint32_t date ) {
+
+    uint32_t year, month, day;
+
+    year = date / 10000;
+    month = date / 100 % 100;
+    day = date % 100;
+    if ( day > 31 )
+        day = 31; //месячный файл
+    if ( month <= 2 ) {
+        year--;
+        month += 12;
+       }
+    return 365 * year + year / 4 - year / 100 + year / 400 + ( 153 * ( month - 3 ) + 2 ) / 5 + day;
+ }
+
+//*************************************************************************************************
+// Возвращает текущую дату
+// return uint32_t - дата YYYYMMDD
+//*************************************************************************************************
+static uint32_t Today( void ) {
+
+    RTC_TIME_Type Time;
+
+    RTC_GetFullTime( LPC_RTC, &Time );
+    return Time.YEAR * 10000 + Time.MONTH * 100 + Time.DOM;
+ }
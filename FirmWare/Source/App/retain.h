@@ -0,0 +1,20 @@
+
+#ifndef __RETAIN_H
+#define __RETAIN_H
+
+#include <stdint.h>
+#include <lpc_types.h>
+
+#include "command.h"
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void RetainInit( void );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+void RetainShow( Source src );
+
+#endif
@@ -0,0 +1,440 @@
+
+//*************************************************************************************************
+//
+// Итоги значений параметров уст-в за минуту, час, сутки
+// Задачи уст-в добавляют значения параметров каждую секунду, итоги текущих периодов (кол-во,
+// мин, макс, сумма, интеграл по времени) накапливаются в RAM. При поступлении значения
+// следующего периода или по окончании периода (RollupTick(), каждую минуту от задачи часов,
+// в т.ч. при отсутствии данных уст-ва) итоги завершенного периода добавляются к итогам более
+// длинного периода и записываются в файл итогов через LogPut()
+//
+//*************************************************************************************************
+
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "rl_fs.h"
+#include "cmsis_os2.h"
+
+#include "lpc177x_8x_rtc.h"
+
+#include "device.h"
+#include "dev_param.h"
+
+#include "config.h"
+#include "logger.h"
+#include "message.h"
+#include "rollup.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define ROLL_NOPAR              0xFF        //множитель значения не используется
+#define ROLL_GAP_MAX            5000        //макс интервал между значениями для интеграла (msec)
+#define ROLL_ROW                128         //размер строки вывода итогов
+
+//*************************************************************************************************
+// Локальные типы данных
+//*************************************************************************************************
+//Описание значения
+typedef struct {
+    Device      dev;                        //ID уст-ва
+    uint8_t     param;                      //ID параметра
+    uint8_t     mult;                       //ID параметра множителя, ROLL_NOPAR - без множителя
+    char        *name;                      //имя значения
+ } ROLL_DEF;
+
+//Итоги периода
+typedef struct {
+    DATE        date;                       //дата начала периода
+    uint32_t    time;                       //время начала периода (сек от начала суток)
+    uint32_t    cnt;                        //кол-во значений, 0 - период не начат
+    float       min;                        //минимальное значение
+    float       max;                        //максимальное значение
+    float       sum;                        //сумма значений
+    float       integral;                   //интеграл значения по времени (значение * час)
+ } ROLL_ACC;
+
+//Итоги значения
+typedef struct {
+    ROLL_ACC    acc[ROLL_PERIODS];          //текущие периоды, итоги минуты добавляются к итогам
+                                            //часа при завершении минуты, часа - к суткам
+    ROLL_ACC    last[ROLL_PERIODS];         //последние завершенные периоды
+    uint32_t    tick;                       //время добавления последнего значения
+ } ROLL_DATA;
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+//Значения в порядке RollupId
+static const ROLL_DEF roll_def[] = {
+    //уст-во        параметр            множитель           имя
+    ID_DEV_BATMON,  MON_VOLTAGE,        ROLL_NOPAR,         "bat_v",
+    ID_DEV_BATMON,  MON_CURRENT,        ROLL_NOPAR,         "bat_i",
+    ID_DEV_MPPT,    MPPT_IN_VOLTAGE,    MPPT_IN_CURRENT,    "pv_w",
+    ID_DEV_MPPT,    MPPT_OUT_CURRENT,   ROLL_NOPAR,         "mppt_i",
+    ID_DEV_INV1,    INV_POWER_WATT,     ROLL_NOPAR,         "inv1_w",
+    ID_DEV_INV2,    INV_POWER_WATT,     ROLL_NOPAR,         "inv2_w",
+    ID_DEV_CHARGER, CHARGE_CURRENT,     ROLL_NOPAR,         "chrg_i"
+ };
+
+//Периоды в порядке RollupPeriod
+static const uint32_t roll_len[] = { 60, 3600, 86400 };                 //длительность (сек)
+static const LogId roll_log[] = { LOG_ROLL_MIN, LOG_ROLL_HOUR, LOG_ROLL_DAY };
+static char * const roll_name[] = { "min", "hour", "day" };
+
+static ROLL_DATA roll_data[SIZE_ARRAY( roll_def )];
+static osMutexId_t mutex_roll = NULL;
+static char roll_row[ROLL_ROW];                         //используется только из задачи консоли
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osMutexAttr_t mutex_attr = { .name = "Rollup", .attr_bits = osMutexPrioInherit };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static float RollValue( Device dev, uint8_t param );
+static uint32_t RollTime( DATE *date );
+static void RollClose( RollupId id, DATE *date, uint32_t time );
+static void RollAdd( RollupId id, DATE *date, uint32_t time, float value );
+static void AccMerge( ROLL_ACC *dst, ROLL_ACC *src, uint32_t len );
+static void AccRec( RollupId id, RollupPeriod period, ROLL_ACC *acc, ROLL_REC *rec );
+static bool AccPeriod( ROLL_ACC *acc, DATE *date, uint32_t time, uint32_t len );
+static void RecOut( ROLL_REC *rec, char *kind, Source src );
+
+//*************************************************************************************************
+// Инициализация итогов
+//*************************************************************************************************
+void RollupInit( void ) {
+
+    memset( roll_data, 0x00, sizeof( roll_data ) );
+    mutex_roll = osMutexNew( &mutex_attr );
+ }
+
+//*************************************************************************************************
+// Добавление текущих значений параметров уст-ва в итоги, вызывается задачей уст-ва каждую
+// секунду при наличии данных уст-ва
+// Device dev - ID уст-ва
+//*************************************************************************************************
+void RollupSave( Device dev ) {
+
+    uint8_t id;
+    float value;
+    DATE date;
+    uint32_t time;
+
+    if ( mutex_roll == NULL )
+        return;
+    time = RollTime( &date );
+    osMutexAcquire( mutex_roll, osWaitForever );
+    for ( id = 0; id < SIZE_ARRAY( roll_def ); id++ ) {
+        if ( roll_def[id].dev != dev )
+            continue;
+        value = RollValue( dev, roll_def[id].param );
+        if ( roll_def[id].mult != ROLL_NOPAR )
+            value *= RollValue( dev, roll_def[id].mult );
+        RollAdd( (RollupId)id, &date, time, value );
+       }
+    osMutexRelease( mutex_roll );
+ }
+
+//*************************************************************************************************
+// Завершение периодов по времени, вызывается задачей часов каждую минуту
+// Итоги периодов значений, данные уст-в которых не поступают, завершаются без ожидания
+// следующего значения
+//*************************************************************************************************
+void RollupTick( void ) {
+
+    uint8_t id;
+    DATE date;
+    uint32_t time;
+
+    if ( mutex_roll == NULL )
+        return;
+    time = RollTime( &date );
+    osMutexAcquire( mutex_roll, osWaitForever );
+    for ( id = 0; id < SIZE_ARRAY( roll_def ); id++ )
+        RollClose( (RollupId)id, &date, time );
+    osMutexRelease( mutex_roll );
+ }
+
+//*************************************************************************************************
+// Возвращает итоги значения за последний завершенный или текущий период
+// Итоги текущего периода включают итоги незавершенных более коротких периодов
+// RollupPeriod period - период
+// RollupId id         - ID значения
+// bool current        - true - текущий период, false - последний завершенный
+// ROLL_REC *rec       - итоги
+// return = ERROR      - недопустимые параметры
+//*************************************************************************************************
+Status RollupGet( RollupPeriod period, RollupId id, bool current, ROLL_REC *rec ) {
+
+    uint8_t prev;
+    ROLL_ACC acc;
+
+    if ( period >= ROLL_PERIODS || id >= ROLL_CNT || mutex_roll == NULL )
+        return ERROR;
+    osMutexAcquire( mutex_roll, osWaitForever );
+    if ( current == true ) {
+        acc = roll_data[id].acc[period];
+        for ( prev = 0; prev < period; prev++ )
+            AccMerge( &acc, &roll_data[id].acc[prev], roll_len[period] );
+       }
+    else acc = roll_data[id].last[period];
+    osMutexRelease( mutex_roll );
+    AccRec( id, period, &acc, rec );
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Вывод итогов в консоль: последние завершенные и текущие периоды или записи файла итогов
+// RollupPeriod period - период
+// DATE *date          - дата файла итогов, NULL - итоги из RAM
+// Source src          - режим вывода информации в консоль
+// return = ERROR      - файл итогов не открылся
+//*************************************************************************************************
+Status RollupShow( RollupPeriod period, DATE *date, Source src ) {
+
+    uint8_t id;
+    FILE *fin;
+    ROLL_REC rec;
+    uint32_t cnt = 0;
+    char name[LOG_NAME];
+
+    if ( period >= ROLL_PERIODS )
+        return ERROR;
+    ConsoleSend( "Name    Kind Date       Time   Count       Min       Max      Mean   Integral\r\n", src );
+    if ( date == NULL ) {
+        for ( id = 0; id < SIZE_ARRAY( roll_def ); id++ ) {
+            RollupGet( period, (RollupId)id, false, &rec );
+            RecOut( &rec, "last", src );
+            RollupGet( period, (RollupId)id, true, &rec );
+            RecOut( &rec, "curr", src );
+           }
+        return SUCCESS;
+       }
+    LogFlush(); //записи итогов из буферов записываются в файлы
+    LogFileName( roll_log[period], date, name );
+    fin = fopen( name, "rb" );
+    if ( fin == NULL )
+        return ERROR;
+    while ( fread( &rec, 1, sizeof( rec ), fin ) == sizeof( rec ) ) {
+        if ( rec.sign != ROLL_SIGN || rec.period != period || rec.id >= SIZE_ARRAY( roll_def ) )
+            continue;
+        RecOut( &rec, "file", src );
+        cnt++;
+       }
+    fclose( fin );
+    sprintf( roll_row, "Records: %u\r\n", cnt );
+    ConsoleSend( roll_row, src );
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Возвращает период итогов по имени: min/hour/day
+// char *name          - имя периода
+// return RollupPeriod - период, ROLL_PERIODS - период не найден
+//*************************************************************************************************
+RollupPeriod RollupGetPeriod( char *name ) {
+
+    uint8_t period;
+
+    for ( period = 0; period < SIZE_ARRAY( roll_name ); period++ )
+        if ( !strcasecmp( name, roll_name[period] ) )
+            return (RollupPeriod)period;
+    return ROLL_PERIODS;
+ }
+
+//*************************************************************************************************
+// Возвращает значение параметра уст-ва в формате float
+// Device dev    - ID уст-ва
+// uint8_t param - ID параметра
+//*************************************************************************************************
+static float RollValue( Device dev, uint8_t param ) {
+
+    ValueType type;
+    ValueParam value;
+
+    value = ParamGetVal( dev, param );
+    type = ParamGetType( dev, param );
+    if ( type == VALUE_FLOAT )
+        return value.flt;
+    if ( type == VALUE_UINT8 )
+        return value.uint8;
+    if ( type == VALUE_UINT16 )
+        return value.uint16;
+    if ( type == VALUE_UINT32 )
+        return value.uint32;
+    return 0;
+ }
+
+//*************************************************************************************************
+// Возвращает текущие дату и время часов
+// DATE *date      - текущая дата
+// return uint32_t - текущее время (сек от начала суток)
+//*************************************************************************************************
+static uint32_t RollTime( DATE *date ) {
+
+    RTC_TIME_Type Time;
+
+    RTC_GetFullTime( LPC_RTC, &Time );
+    date->day = Time.DOM;
+    date->month = Time.MONTH;
+    date->year = Time.YEAR;
+    return Time.HOUR * 3600 + Time.MIN * 60 + Time.SEC;
+ }
+
+//*************************************************************************************************
+// Завершение периодов, в которые не попадает указанное время, вызывается при заблокированных
+// итогах: итоги добавляются к итогам более длинного периода и записываются в файл итогов
+// RollupId id   - ID значения
+// DATE *date    - дата
+// uint32_t time - время (сек от начала суток)
+//*************************************************************************************************
+static void RollClose( RollupId id, DATE *date, uint32_t time ) {
+
+    uint8_t period;
+    ROLL_REC rec;
+    ROLL_ACC *acc;
+    ROLL_DATA *data;
+
+    data = &roll_data[id];
+    for ( period = 0; period < ROLL_PERIODS; period++ ) {
+        acc = &data->acc[period];
+        if ( !acc->cnt || AccPeriod( acc, date, time, roll_len[period] ) == true )
+            continue;
+        //период завершен
+        if ( period + 1 < ROLL_PERIODS )
+            AccMerge( &data->acc[period + 1], acc, roll_len[period + 1] );
+        data->last[period] = *acc;
+        #if _ROLLUP_LOG
+        if ( period != ROLL_MIN || _ROLLUP_LOG > 1 ) {
+            AccRec( id, (RollupPeriod)period, acc, &rec );
+            LogPut( roll_log[period], &acc->date, &rec, sizeof( rec ) );
+           }
+        #endif
+        acc->cnt = 0;
+       }
+ }
+
+//*************************************************************************************************
+// Добавление значения в итоги, вызывается при заблокированных итогах
+// Периоды, в которые значение не попадает, предварительно завершаются
+// RollupId id   - ID значения
+// DATE *date    - дата значения
+// uint32_t time - время значения (сек от начала суток)
+// float value   - значение
+//*************************************************************************************************
+static void RollAdd( RollupId id, DATE *date, uint32_t time, float value ) {
+
+    uint32_t tick, interval;
+    ROLL_ACC *acc;
+    ROLL_DATA *data;
+
+    data = &roll_data[id];
+    RollClose( id, date, time );
+    //интеграл по интервалу от предыдущего значения, после перерыва - за одну секунду
+    tick = osKernelGetTickCount();
+    interval = tick - data->tick;
+    if ( !data->tick || interval > ROLL_GAP_MAX )
+        interval = 1000;
+    data->tick = tick;
+    acc = &data->acc[ROLL_MIN];
+    if ( !acc->cnt ) {
+        acc->date = *date;
+        acc->time = time - time % roll_len[ROLL_MIN];
+        acc->min = acc->max = value;
+        acc->sum = acc->integral = 0;
+       }
+    acc->cnt++;
+    if ( value < acc->min )
+        acc->min = value;
+    if ( value > acc->max )
+        acc->max = value;
+    acc->sum += value;
+    acc->integral += value * interval / 3600000.0f;
+ }
+
+//*************************************************************************************************
+// Добавление итогов периода к итогам более длинного периода
+// ROLL_ACC *dst - итоги длинного периода
+// ROLL_ACC *src - итоги короткого периода
+// uint32_t len  - длительность длинного периода (сек)
+//*************************************************************************************************
+static void AccMerge( ROLL_ACC *dst, ROLL_ACC *src, uint32_t len ) {
+
+    if ( !src->cnt )
+        return;
+    if ( !dst->cnt ) {
+        *dst = *src;
+        dst->time = src->time - src->time % len;
+        return;
+       }
+    dst->cnt += src->cnt;
+    if ( src->min < dst->min )
+        dst->min = src->min;
+    if ( src->max > dst->max )
+        dst->max = src->max;
+    dst->sum += src->sum;
+    dst->integral += src->integral;
+ }
+
+//*************************************************************************************************
+// Формирование записи итогов
+// RollupId id         - ID значения
+// RollupPeriod period - период
+// ROLL_ACC *acc       - итоги периода
+// ROLL_REC *rec       - запись итогов
+//*************************************************************************************************
+static void AccRec( RollupId id, RollupPeriod period, ROLL_ACC *acc, ROLL_REC *rec ) {
+
+    memset( rec, 0x00, sizeof( ROLL_REC ) );
+    rec->sign = ROLL_SIGN;
+    rec->period = period;
+    rec->id = id;
+    if ( !acc->cnt )
+        return;
+    rec->day = acc->date.day;
+    rec->month = acc->date.month;
+    rec->year = acc->date.year;
+    rec->time = acc->time;
+    rec->cnt = acc->cnt;
+    rec->min = acc->min;
+    rec->max = acc->max;
+    rec->mean = acc->sum / acc->cnt;
+    rec->integral = acc->integral;
+ }
+
+//*************************************************************************************************
+// Проверка принадлежности времени периоду итогов
+// ROLL_ACC *acc - итоги периода
+// DATE *date    - дата
+// uint32_t time - время (сек от начала суток)
+// uint32_t len  - длительность периода (сек)
+// return = true - время в периоде итогов
+//*************************************************************************************************
+static bool AccPeriod( ROLL_ACC *acc, DATE *date, uint32_t time, uint32_t len ) {
+
+    if ( acc->date.day != date->day || acc->date.month != date->month || acc->date.year != date->year )
+        return false;
+    return acc->time == time - time % len ? true : false;
+ }
+
+//*************************************************************************************************
+// Вывод записи итогов в консоль
+// ROLL_REC *rec - запись итогов
+// char *kind    - вид итогов: last/curr/file
+// Source src    - режим вывода информации в консоль
+//*************************************************************************************************
+static void RecOut( ROLL_REC *rec, char *kind, Source src ) {
+
+    if ( !rec->cnt )
+        sprintf( roll_row, "%-7s %-4s -\r\n", roll_def[rec->id].name, kind );
+    else sprintf( roll_row, "%-7s %-4s %02u.%02u.%04u %02u:%02u %6u %9.2f %9.2f %9.2f %10.3f\r\n", roll_def[rec->id].name,
+                  kind, rec->day, rec->month, rec->year, rec->time / 3600, rec->time / 60 % 60, rec->cnt, rec->min,
+                  rec->max, rec->mean, rec->integral );
+    ConsoleSend( roll_row, src );
+ }
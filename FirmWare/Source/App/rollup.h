@@ -0,0 +1,76 @@
+
+#ifndef __ROLLUP_H
+#define __ROLLUP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lpc_types.h>
+
+#include "device.h"
+#include "dev_data.h"
+#include "command.h"
+
+//*************************************************************************************************
+// Итоги значений параметров уст-в за минуту, час, сутки (*.bin в каталоге \rollup)
+// Файл: [ROLL_REC][ROLL_REC]... записи завершенных периодов в порядке завершения
+// Числа записываются младшим байтом вперед, интеграл - значение * час (А*ч, Вт*ч)
+//*************************************************************************************************
+#define ROLL_SIGN               0x4C52      //сигнатура записи "RL"
+
+//Периоды итогов
+typedef enum {
+    ROLL_MIN,                               //минута: \rollup\YYYYMM\rm_YYYYMMDD.bin
+    ROLL_HOUR,                              //час: \rollup\YYYYMM\rh_YYYYMMDD.bin
+    ROLL_DAY,                               //сутки: \rollup\rd_YYYYMM.bin
+    ROLL_PERIODS                            //кол-во периодов
+ } RollupPeriod;
+
+//Значения для расчета итогов
+typedef enum {
+    ROLL_BAT_V,                             //напряжение АКБ (V)
+    ROLL_BAT_I,                             //ток АКБ (A)
+    ROLL_PV_W,                              //мощность солнечных панелей (W)
+    ROLL_MPPT_I,                            //выходной ток MPPT (A)
+    ROLL_INV1_W,                            //мощность инвертора TS-1000-224 (W)
+    ROLL_INV2_W,                            //мощность инвертора TS-3000-224 (W)
+    ROLL_CHARGE_I,                          //ток заряда PB-1000-224 (A)
+    ROLL_CNT                                //кол-во значений
+ } RollupId;
+
+#pragma pack( push, 1 )                     //выравнивание структуры по границе 1 байта
+
+//*************************************************************************************************
+// Итоги значения за период (32 байта), запись файла и ответа сервиса CAN_XFER_ROLLUP
+//*************************************************************************************************
+typedef struct {
+    uint16_t sign;                          //сигнатура записи ROLL_SIGN
+    uint8_t  period;                        //период RollupPeriod
+    uint8_t  id;                            //значение RollupId
+    uint8_t  day;                           //дата начала периода
+    uint8_t  month;
+    uint16_t year;
+    uint32_t time;                          //время начала периода (сек от начала суток)
+    uint32_t cnt;                           //кол-во значений, 0 - значений нет
+    float    min;                           //минимальное значение
+    float    max;                           //максимальное значение
+    float    mean;                          //среднее значение
+    float    integral;                      //интеграл значения по времени (значение * час)
+ } ROLL_REC;
+
+#pragma pack( pop )
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void RollupInit( void );
+void RollupSave( Device dev );
+void RollupTick( void );
+Status RollupShow( RollupPeriod period, DATE *date, Source src );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+Status RollupGet( RollupPeriod period, RollupId id, bool current, ROLL_REC *rec );
+RollupPeriod RollupGetPeriod( char *name );
+
+#endif
@@ -19,6 +19,7 @@
 #include "rtc.h"
 #include "command.h"
 #include "sdcard.h"
+#include "logger.h"
 #include "eeprom.h"
 #include "config.h"
 #include "scheduler.h"
@@ -150,8 +151,6 @@ static void TaskJob( void *pvParameters ) {
 //*************************************************************************************************
 static void TaskExec( void *pvParameters ) {
 
-    FILE *log;
-    char name[40];
     uint8_t id_job;
     JobExec result;
     osStatus_t status;
@@ -163,25 +162,18 @@ static void TaskExec( void *pvParameters ) {
             if ( id_job < SIZE_ARRAY( jobs ) ) {
                 memset( buffer, 0x00, sizeof( buffer ) );
                 strcpy( buffer, jobs[id_job].command );
-                sprintf( name, "\\execute\\job_%s.log", RTCFileName() );
-                log = fopen( name, "a" );
-                if ( log != NULL )
-                    fprintf( log, "%s %s ... ", RTCGetDateTime( NULL ), buffer );
+                LogPrintf( LOG_JOB, "%s %s ... ", RTCGetDateTime( NULL ), buffer );
                 //выполняем задание
                 result = ExecuteJob( buffer );
-                if ( log != NULL ) {
-                    if ( result == JOB_OK )         //команда из планировщика выполнена
-                        fprintf( log, "%s", Message( CONS_MSG_OK ) );
-                    if ( result == JOB_NO_COMMAND ) //команда не указана
-                        fprintf( log, "%s", Message( CONS_MSG_ERR_CMND ) );
-                    if ( result == JOB_NO_ACCESS )  //команду нельзя выполнять из планировщика
-                        fprintf( log, "%s", Message( CONS_MSG_ERR_NOJOB ) );
-                    if ( result == JOB_NOT_FOUND )  //команда не найдена в списке
-                        fprintf( log, "%s", Message( CONS_MSG_ERR_CMND ) );
-                   }
+                if ( result == JOB_OK )         //команда из планировщика выполнена
+                    LogPrintf( LOG_JOB, "%s", Message( CONS_MSG_OK ) );
+                if ( result == JOB_NO_COMMAND ) //команда не указана
+                    LogPrintf( LOG_JOB, "%s", Message( CONS_MSG_ERR_CMND ) );
+                if ( result == JOB_NO_ACCESS )  //команду нельзя выполнять из планировщика
+                    LogPrintf( LOG_JOB, "%s", Message( CONS_MSG_ERR_NOJOB ) );
+                if ( result == JOB_NOT_FOUND )  //команда не найдена в списке
+                    LogPrintf( LOG_JOB, "%s", Message( CONS_MSG_ERR_CMND ) );
                }
-            if ( log != NULL )
-                fclose( log );
            }
        }
  }
@@ -34,16 +34,20 @@
 #include "inverter.h"
 #include "main.h"
 #include "message.h"
+#include "crc_hw.h"
+#include "logger.h"
 
 //*************************************************************************************************
 // Локальные константы
 //*************************************************************************************************
 #define SD_DRIVE            "M0:"
+#define CRC_BUFF_SIZE       2048            //размер буфера чтения файла для расчета CRC
 
 //*************************************************************************************************
 // Локальные переменные
 //*************************************************************************************************
 static Status sd_mount = ERROR;
+static uint8_t crc_buff[CRC_BUFF_SIZE];
 
 //*************************************************************************************************
 // Прототипы локальных функций
@@ -130,6 +134,7 @@ Status SDUnMount( void ) {
         ConsoleSend( MessageSd( MSG_SD_UNMOUNT_EXEC ), CONS_NORMAL );
         return SUCCESS;
        }
+    LogFlush(); //запись и закрытие файлов протоколов
     fstat = funmount( SD_DRIVE );
     if ( fstat == fsOK ) {
         sd_mount = ERROR;
@@ -173,6 +178,15 @@ Status SDStatus( void ) {
     return SUCCESS;
  }
 
+//*************************************************************************************************
+// Возвращает объем свободного места на SD карте
+// return int64_t - свободное место (байт), < 0 - ошибка доступа к карте
+//*************************************************************************************************
+int64_t SDFree( void ) {
+
+    return ffree( SD_DRIVE );
+ }
+
 //*************************************************************************************************
 // Вывод информации о SD карте
 //*************************************************************************************************
@@ -222,6 +236,8 @@ static void CheckMkDir( void ) {
     fmkdir( "\\hmi" );
     fmkdir( "\\voice" );
     fmkdir( "\\execute" );
+    fmkdir( "\\rollup" );
+    fmkdir( "\\sdcard" );
  }
 
 //*************************************************************************************************
@@ -239,6 +255,7 @@ Status FileDelete( char *fname ) {
 
     if ( fname == NULL )
         return ERROR; //имя не указано
+    LogFlush(); //открытые файлы протоколов не удаляются
     //проверим наличие маски в имени файла/каталога
     if ( strchr( fname, '*' ) == NULL ) {
         //удаление одиночного файла
@@ -299,6 +316,7 @@ Status DirDelete( char *dir_name ) {
 
     if ( dir_name == NULL )
         return ERROR; //имя не указано
+    LogFlush();
     fstat = frmdir( dir_name, NULL );
     if ( fstat == fsOK ) {
         ConsoleSend( MessageSd( MSG_DIR_DEL ), CONS_NORMAL );
@@ -322,6 +340,7 @@ Status DirDelete( char *dir_name ) {
 //*************************************************************************************************
 Status FileRename( char *fname, char *new_name ) {
 
+    LogFlush();
     if ( frename( fname, new_name ) == fsOK ) {
         ConsoleSend( MessageSd( MSG_FILE_RENAME ), CONS_NORMAL );
         return SUCCESS;
@@ -426,6 +445,7 @@ void FileType( char *fname ) {
 
     if ( fname == NULL || !strlen( fname ) )
         return;
+    LogFlush(); //строки протоколов из буферов записываются в файлы
     ftype = fopen( fname, "r" );               
     if ( ftype == NULL ) {
         sprintf( str, MessageSd( MSG_FT_NOT_OPEN ), fname );
@@ -459,6 +479,7 @@ void FileHex( char *fname ) {
 
     if ( fname == NULL || !strlen( fname ) )
         return;
+    LogFlush();
     fhex = fopen( fname, "r" );               
     if ( fhex == NULL ) {
         sprintf( str, MessageSd( MSG_FT_NOT_OPEN ), fname );
@@ -481,6 +502,35 @@ void FileHex( char *fname ) {
     ConsoleSend( Message( CONS_MSG_HEADER ), CONS_NORMAL );
  }
 
+//*************************************************************************************************
+// Расчет контрольной суммы файла, вызывается только из задачи консоли
+// char *fname    - имя файла
+// CrcType type   - тип контрольной суммы
+// uint32_t *crc  - контрольная сумма
+// uint32_t *size - размер файла
+// return = SUCCESS - контрольная сумма рассчитана
+//        = ERROR   - ошибка открытия файла или передачи данных в блок CRC
+//*************************************************************************************************
+Status FileCrc( char *fname, CrcType type, uint32_t *crc, uint32_t *size ) {
+
+    FILE *fcrc;
+    uint32_t cnt;
+    CRC_HW_CTX ctx;
+
+    if ( fname == NULL || !strlen( fname ) )
+        return ERROR;
+    LogFlush();
+    fcrc = fopen( fname, "r" );
+    if ( fcrc == NULL )
+        return ERROR;
+    CrcHwStart( &ctx, type );
+    while ( ( cnt = fread( crc_buff, sizeof( uint8_t ), sizeof( crc_buff ), fcrc ) ) != 0 )
+        CrcHwAdd( &ctx, crc_buff, cnt );
+    fclose( fcrc );
+    *size = ctx.size;
+    return CrcHwEnd( &ctx, crc );
+ }
+
 //*************************************************************************************************
 // Выводит блок данных в формате HEX дампа
 // Вывод выполняется всего блока *data, по одной строке
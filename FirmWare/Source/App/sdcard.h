@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <lpc_types.h>
 
+#include "crc_model.h"
+
 //*************************************************************************************************
 // Функции управления
 //*************************************************************************************************
@@ -20,10 +22,12 @@ Status DirDelete( char *dir_name );
 Status FileRename( char *fname, char *new_name );
 void FileType( char *fname );
 void FileHex( char *fname );
+Status FileCrc( char *fname, CrcType type, uint32_t *crc, uint32_t *size );
 
 //*************************************************************************************************
 // Функции статуса/состояния
 //*************************************************************************************************
+int64_t SDFree( void );
 void FormatDot( uint64_t value, char *dest );
 
 #endif 
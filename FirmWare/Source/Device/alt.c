@@ -21,6 +21,7 @@
 #include "eeprom.h"
 #include "config.h"
 #include "sdcard.h"
+#include "logger.h"
 #include "batmon.h"
 #include "charger.h"
 #include "informing.h"
@@ -352,21 +353,8 @@ AltPower AltPowerStat( void ) {
 //*************************************************************************************************
 static void EventLog( char *msg ) {
 
-    char name[80];
-    FILE *log;
-    
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     if ( !config.log_enable_alt )
         return; //логирование выключено
-    //формируем имя файла
-    if ( !config.mode_logging )
-        sprintf( name, "\\alt\\alt_%s.log", RTCFileName() );
-    else sprintf( name, "\\alt\\%s\\alt_%s.log", RTCFileShort(), RTCFileName() );
-    log = fopen( name, "a" );
-    if ( log == NULL )
-        return;
     //запись в протокол текстовой строки
-    fprintf( log, "%s %s\r\n", RTCGetLog(), msg );
-    fclose( log );
+    LogPrintf( LOG_ALT, "%s %s\r\n", RTCGetLog(), msg );
  }
@@ -31,6 +31,9 @@
 #include "eeprom.h"
 #include "charger.h"
 #include "sdcard.h"
+#include "logger.h"
+#include "datalog.h"
+#include "rollup.h"
 #include "message.h"
 #include "ports.h"
 #include "informing.h"
@@ -174,6 +177,8 @@ static void TaskBatmon( void *pvParameters ) {
            }
         if ( event & EVN_RTC_SECONDS ) {
             DayLog(); //сохранение суточных данных
+            if ( batmon.link == LINK_CONN_OK )
+                RollupSave( ID_DEV_BATMON ); //итоги по данным монитора АКБ
             if ( batmon.link == LINK_CONN_NO ) {
                 send = ID_DEV_BATMON; //передача данных в HMI
                 osMessageQueuePut( hmi_msg, &send, 0, 0 );
@@ -314,38 +319,24 @@ static void DataClear( void ) {
  }
 
 //*************************************************************************************************
-// Добавляет в протокол "bm_yyyymmdd.csv" данные монитора АКБ
+// Добавляет в протокол "bm_yyyymmdd.csv" ("bm_yyyymmdd.bin" при _LOG_BINARY = 1) данные монитора АКБ
 // Логирование ведется при включенном параметре "log_enable_bmon" 
 // с интервалом времени по параметру "datlog_upd_bmon"
 //*************************************************************************************************
 static void SaveLog( void ) {
 
-    uint32_t pos;
-    char name[80];
-    FILE *bm_log;
-
     if ( batmon.link == LINK_CONN_NO )
         return; //данных нет
     if ( !config.log_enable_bmon )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    //открываем файл
-    if ( !config.mode_logging )
-        sprintf( name, "\\batmon\\bm_%s.csv", RTCFileName() );
-    else sprintf( name, "\\batmon\\%s\\bm_%s.csv", RTCFileShort(), RTCFileName() );
-    bm_log = fopen( name, "a" );
-    if ( bm_log == NULL )
-        return; //файл не открылся
-    pos = ftell( bm_log );
-    //запишем наименование полей
-    if ( !pos )
-        fprintf( bm_log, "Date;Time;Bat_V(V);Bat_I(A);Energy from BAT(Ah);SOC(%%);TTGo;Total energy from BAT(Ah);Alarm;Relay;Last discharge(Ah);Medium discharge(Ah)\r\n" );
-    //запишем данные
-    fprintf( bm_log, "%s;%s;%.2f;%+.2f;%+.2f;%.1f;%3d:%02d;%.2f;%u;%u;%5.2f;%5.2f\r\n", RTCGetDate( NULL ), RTCGetTime( NULL ), 
+    #if _LOG_BINARY
+    DataLogSave( DLOG_BATMON );
+    #else
+    //запишем данные, наименование полей добавляется в новый файл
+    LogPrintf( LOG_BATMON, "%s;%s;%.2f;%+.2f;%+.2f;%.1f;%3d:%02d;%.2f;%u;%u;%5.2f;%5.2f\r\n", RTCGetDate( NULL ), RTCGetTime( NULL ), 
             batmon.voltage, batmon.current, batmon.cons_energy, batmon.soc, BatMonTTG( BATMON_TTG_HOUR ), BatMonTTG( BATMON_TTG_MIN ), batmon.h6,
             batmon.alarm, batmon.relay, batmon.h2, batmon.h3 ); 
-    fclose( bm_log );
+    #endif
  }
 
 //*************************************************************************************************
@@ -353,29 +344,15 @@ static void SaveLog( void ) {
 //*************************************************************************************************
 static void DayLog( void ) {
 
-    uint32_t pos;
-    char name[80];
-    FILE *time_log;
     RTC_TIME_Type Time;
 
     if ( !config.log_enable_bmon )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     RTC_GetFullTime( LPC_RTC, &Time );
     if ( Time.HOUR != 23 || Time.MIN != 59 || Time.SEC != 59 )
         return;
-    //формируем имя файла
-    sprintf( name, "\\batmon\\bm_%s.csv", RTCFileShort() );
-    time_log = fopen( name, "a" );
-    if ( time_log == NULL )
-        return; //файл не открылся
-    pos = ftell( time_log );
-    if ( !pos )
-        fprintf( time_log, "Date;Bat_V(V);Energy(Ah);SOC(%%);H6(Ah)\r\n" ); //запишем наименование полей
     //запишем данные
-    fprintf( time_log, "%s;%.2f;%+.2f;%.1f;%.2f\r\n", RTCGetDate( NULL ), batmon.voltage, batmon.cons_energy, batmon.soc, batmon.h6 ); 
-    fclose( time_log );
+    LogPrintf( LOG_BATDAY, "%s;%.2f;%+.2f;%.1f;%.2f\r\n", RTCGetDate( NULL ), batmon.voltage, batmon.cons_energy, batmon.soc, batmon.h6 ); 
  }
 
 //*************************************************************************************************
@@ -24,6 +24,9 @@
 #include "charger.h"
 #include "command.h"
 #include "sdcard.h"
+#include "logger.h"
+#include "datalog.h"
+#include "rollup.h"
 #include "config.h"
 #include "informing.h"
 #include "priority.h"
@@ -151,6 +154,8 @@ static void TaskCharger( void *pvParameters ) {
             charger.current = ChargeCurrent();
             CalcCurrent();  //расчет тока зарядки
             CheckCharge();  //проверяем завершение зарядки
+            if ( charger.connect_ac == POWER_AC_ON )
+                RollupSave( ID_DEV_CHARGER ); //итоги при подключенном к сети AC уст-ве
             send = ID_DEV_CHARGER; //передача данных в HMI
             osMessageQueuePut( hmi_msg, &send, 0, 0 );
            }
@@ -415,37 +420,25 @@ void EventLogPB( char *text ) {
  }
 
 //*************************************************************************************************
-// Добавляет в протокол "pb_yyyymmdd.csv" данные заряда
+// Добавляет в протокол "pb_yyyymmdd.csv" ("pb_yyyymmdd.bin" при _LOG_BINARY = 1) данные заряда
 //*************************************************************************************************
 static void SaveLog( void ) {
 
-    uint32_t pos;
-    char name[80];
-    FILE *bp_log;
-
     if ( !config.log_enable_chrg )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     if ( ChargeGetMode() == CHARGE_OFF )
         return; //зарядка выкл
-    if ( !config.mode_logging )
-        sprintf( name, "\\charger\\pb_%s.csv", RTCFileName() );
-    else sprintf( name, "\\charger\\%s\\pb_%s.csv", RTCFileShort(), RTCFileName() );
-    bp_log = fopen( name, "a" );
-    if ( bp_log == NULL )
-        return; //файл не открылся
-    pos = ftell( bp_log );
-    if ( !pos )
-        fprintf( bp_log, "Date;Time;AC;Dev;Mode;Stat;SOC(%%);I(A);V\r\n" ); //запишем наименование полей
-    //запишем данные
-    fprintf( bp_log, "%s;%s;%s;%s;%d;%s;%.1f;%4.1f;%.2f\r\n", RTCGetDate( NULL ), RTCGetTime( NULL ),
+    #if _LOG_BINARY
+    DataLogSave( DLOG_CHARGER );
+    #else
+    //запишем данные, наименование полей добавляется в новый файл
+    LogPrintf( LOG_CHARGER, "%s;%s;%s;%s;%d;%s;%.1f;%4.1f;%.2f\r\n", RTCGetDate( NULL ), RTCGetTime( NULL ),
         ParamGetDesc( ID_DEV_CHARGER, CHARGE_CONN_AC ),
         ParamGetDesc( ID_DEV_CHARGER, CHARGE_DEV_STAT ),
         ChargeGetMode(), 
         ParamGetDesc( ID_DEV_CHARGER, CHARGE_BANK_STAT ),
         batmon.soc, ChargeCurrent(), batmon.voltage );
-    fclose( bp_log );
+    #endif
  }
 
 //*************************************************************************************************
@@ -455,23 +448,11 @@ static void SaveLog( void ) {
 //*************************************************************************************************
 static void EventLog( char *text, ChargeError error ) {
 
-    char name[80];
-    FILE *log;
-    
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     if ( text == NULL )
         return;
-    if ( !config.mode_logging )
-        sprintf( name, "\\charger\\pb_%s.log", RTCFileName() );
-    else sprintf( name, "\\charger\\%s\\pb_%s.log", RTCFileShort(), RTCFileName() );
-    log = fopen( name, "a" );
-    if ( log == NULL )
-        return;
     if ( error )
-        fprintf( log, "%s %s %s\r\n", RTCGetLog(), text, ErrorDescr( ID_DEV_CHARGER, 0, error ) );
-    else fprintf( log, "%s %s\r\n", RTCGetLog(), text );
-    fclose( log );
+        LogPrintf( LOG_CHARGER_EVN, "%s %s %s\r\n", RTCGetLog(), text, ErrorDescr( ID_DEV_CHARGER, 0, error ) );
+    else LogPrintf( LOG_CHARGER_EVN, "%s %s\r\n", RTCGetLog(), text );
  }
 
 //*************************************************************************************************
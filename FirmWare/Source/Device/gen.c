@@ -26,6 +26,7 @@
 #include "command.h"
 #include "message.h"
 #include "sdcard.h"
+#include "logger.h"
 #include "ports.h"
 #include "rs485.h"
 #include "eeprom.h"
@@ -33,6 +34,8 @@
 #include "dev_data.h"
 #include "modbus.h"
 #include "modbus_def.h"
+#include "modbus_poll.h"
+#include "modbus_plan.h"
 #include "gen_ext.h"
 #include "events.h"
 
@@ -57,7 +60,8 @@ osEventFlagsId_t gen_event = NULL;
 #define TIMER_INC_STOP          TIMER_SEC_MAX
 #define TIMER_DEC_STOP          0
 
-#define TIMEOUT_WAIT_EVENT_GEN  500         //время ожидания события (msec)
+#define GEN_POLL_PERIOD         500         //период опроса состояния генератора по MODBUS (msec)
+#define GEN_POLL_DEADLINE       250         //допустимая задержка опроса от начала периода (msec)
 
 //Маски выборки для генератора подключенного удаленно по MODBUS
 #define GEN_RMT_ONLY_MODE       0x000F      //маска для выборки режима работы
@@ -101,6 +105,8 @@ static uint8_t cycle_run = 0, auto_once = 0;
 static uint16_t rmt_mode = 0, rmt_stat = 0, rmt_cycle1 = 0;
 static GenStartStep step_start = GEN_STEP_STOP;
 static osTimerId_t timer1, timer2;
+static ModBusError gen_poll_stat = MBUS_ANSWER_OK;
+static uint16_t gen_poll_data[EXGEN_REG_RD_MAX_BASE];
 
 //*************************************************************************************************
 // Атрибуты объектов RTOS
@@ -130,12 +136,18 @@ static void GenStatusCheck( void );
 static void GenAcLost( void );
 static void GenAcRest( void );
 static void NextStep( GenStartStep step, uint32_t time );
+static ModBusError GenRmtCmd( uint16_t cmd );
 static void SaveDate( void );
 static void EventLog( void );
 static void ConsoleLog( void );
 static void Timer1Callback( void *arg );
 static void Timer2Callback( void *arg );
 static void TaskGen( void *pvParameters );
+static void GenPollDone( ModBusError status, void *arg );
+
+//запись циклического опроса состояния генератора
+static const MBUS_POLL gen_poll = { MB_ID_DEV_GEN, EXGEN_REG_RD_MODE, EXGEN_REG_RD_MAX_BASE, gen_poll_data, 
+                                    GEN_POLL_PERIOD, GEN_POLL_DEADLINE, MBUS_PRIO_NORMAL, GenPollDone, NULL };
 
 //*************************************************************************************************
 // Инициализация портов управления
@@ -170,6 +182,8 @@ void GenInit( void ) {
     timer2 = osTimerNew( Timer2Callback, osTimerOnce, NULL, &timer2_attr );
     //создаем задачу
     osThreadNew( TaskGen, NULL, &gen_attr );
+    //циклический опрос состояния генератора по MODBUS
+    ModBusPollAdd( &gen_poll );
  }
 
 //*************************************************************************************************
@@ -184,14 +198,13 @@ static void TaskGen( void *pvParameters ) {
         //запуск таймера схемы контроля генератора
         if ( !osTimerIsRunning( timer1 ) )
             osTimerStart( timer1, TIME_OFF_AFTER_WORK * SEC_TO_TICK );
-        //ждем события, не более TIMEOUT_WAIT_EVENT_GEN
-        event = osEventFlagsWait( gen_event, EVN_GEN_MASK, osFlagsWaitAny, TIMEOUT_WAIT_EVENT_GEN );
-        if ( event == osErrorTimeout ) {
+        event = osEventFlagsWait( gen_event, EVN_GEN_MASK, osFlagsWaitAny, osWaitForever );
+        if ( event & EVN_GEN_POLL ) {
             GenRemoteStat();   //проверка подключения генератора по MODBUS
             send = ID_DEV_GEN; //передача данных в HMI
             osMessageQueuePut( hmi_msg, &send, 0, 0 );
            }
-        else {
+        if ( event & ~EVN_GEN_POLL ) {
             GenStatusCheck(); //проверка состояния генератора
             GenWorkSleep();   //управление цикличностью работы генератора
             GenCheckTimer();  //контроль таймеров
@@ -244,24 +257,24 @@ static void Timer2Callback( void *arg ) {
     osEventFlagsSet( gen_event, EVN_GEN_CYCLE_NEXT );
  }
 
+//*************************************************************************************************
+// Функция обратного вызова планировщика опроса - состояние генератора прочитано
+//*************************************************************************************************
+static void GenPollDone( ModBusError status, void *arg ) {
+
+    gen_poll_stat = status;
+    osEventFlagsSet( gen_event, EVN_GEN_POLL );
+ }
+
 //*************************************************************************************************
 // Запуск генератора
 //*************************************************************************************************
 void GenStart( void ) {
 
-    uint8_t cnt_rpt;
-    ModBusError status;
-    uint16_t regs_data = EXGEN_CMD_START;
-    uint16_t len = sizeof( regs_data );
-    MBUS_REQUEST reqst = { MB_ID_DEV_GEN, FUNC_WR_MULT_REG, EXGEN_REG_WR_CMD, 1, &regs_data, &len };
     
     if ( gen_rmt.remote ) {
         //запуск генератора (контроллер подключен по MODBUS)
-        cnt_rpt = CNT_REPEAT_REQST;
-        do {
-            len = sizeof( regs_data );
-            status = ModBusRequest( &reqst );
-           } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+        GenRmtCmd( EXGEN_CMD_START );
         return;
        }
     if ( step_start != GEN_STEP_STOP )
@@ -276,19 +289,10 @@ void GenStart( void ) {
 //*************************************************************************************************
 void GenTest( void ) {
 
-    uint8_t cnt_rpt;
-    ModBusError status;
-    uint16_t regt_data = EXGEN_CMD_TEST;
-    uint16_t len = sizeof( regt_data );
-    MBUS_REQUEST reqst = { MB_ID_DEV_GEN, FUNC_WR_MULT_REG, EXGEN_REG_WR_CMD, 1, &regt_data, &len };
     
     if ( gen_rmt.remote ) {
         //тестовый запуск генератора (контроллер подключен по MODBUS)
-        cnt_rpt = CNT_REPEAT_REQST;
-        do {
-            len = sizeof( regt_data );
-            status = ModBusRequest( &reqst );
-           } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+        GenRmtCmd( EXGEN_CMD_TEST );
         return;
        }
     if ( step_start != GEN_STEP_STOP )
@@ -303,19 +307,10 @@ void GenTest( void ) {
 //*************************************************************************************************
 void GenStop( void ) {
 
-    uint8_t cnt_rpt;
-    ModBusError status;
-    uint16_t regp_data = EXGEN_CMD_STOP;
-    uint16_t len = sizeof( regp_data );
-    MBUS_REQUEST reqst = { MB_ID_DEV_GEN, FUNC_WR_MULT_REG, EXGEN_REG_WR_CMD, 1, &regp_data, &len };
     
     if ( gen_rmt.remote ) {
         //выключение генератора (контроллер подключен по MODBUS)
-        cnt_rpt = CNT_REPEAT_REQST;
-        do {
-            len = sizeof( regp_data );
-            status = ModBusRequest( &reqst );
-           } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+        GenRmtCmd( EXGEN_CMD_STOP );
         return;
        }
     auto_once = 0;
@@ -323,8 +318,8 @@ void GenStop( void ) {
  }
 
 //*************************************************************************************************
-// Чтение состояние генератора подключенного по MODBUS
-// Вызов из TaskGen() с интервалом 500 ms
+// Обработка состояния генератора подключенного по MODBUS, прочитанного планировщиком опроса
+// Вызов из TaskGen() с интервалом GEN_POLL_PERIOD
 // регистр EXGEN_REG_RD_MODE - режим работы
 //                    0x000X - режим
 //                    0x0X00 - источник сброса
@@ -337,18 +332,10 @@ void GenStop( void ) {
 static void GenRemoteStat( void ) {
 
     char *ptr_mode, *ptr_stat;
-    uint8_t cnt_rpt;
-    ModBusError status;
     uint16_t gen_data[EXGEN_REG_RD_MAX_BASE];
-    uint16_t len = sizeof( gen_data );
-    MBUS_REQUEST reqst = { MB_ID_DEV_GEN, FUNC_RD_HOLD_REG, EXGEN_REG_RD_MODE, EXGEN_REG_RD_MAX_BASE, &gen_data, &len };
     
-    cnt_rpt = CNT_REPEAT_REQST;
-    do {
-        len = sizeof( gen_data );
-        status = ModBusRequest( &reqst );
-       } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
-    if ( status != MBUS_ANSWER_OK ) {
+    ModBusPollData( &gen_poll, gen_data );
+    if ( gen_poll_stat != MBUS_ANSWER_OK ) {
         //генератор не подключен по MODBUS шине - подключен локально
         //источник данных для передачи по CAN шине берем из "gen_loc"
         gen_ptr = &gen_loc;
@@ -417,20 +404,11 @@ static void GenStartInit( GenCmdSrc source ) {
 //*************************************************************************************************
 static void GenStopPrc( GenCmdSrc source ) {
 
-    uint8_t cnt_rpt;
-    ModBusError status;
     uint32_t prev_stat, prev_relay;
-    uint16_t reg_data = EXGEN_CMD_STOP;
-    uint16_t len = sizeof( reg_data );
-    MBUS_REQUEST reqst = { MB_ID_DEV_GEN, FUNC_WR_MULT_REG, EXGEN_REG_WR_CMD, 1, &reg_data, &len };
     
     if ( gen_rmt.remote ) {
         //выключение генератора (контроллер подключен по MODBUS)
-        cnt_rpt = CNT_REPEAT_REQST;
-        do {
-            len = sizeof( reg_data );
-            status = ModBusRequest( &reqst );
-           } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+        GenRmtCmd( EXGEN_CMD_STOP );
         Informing( VOICE_GEN_OFF, NULL );
         osEventFlagsSet( gen_event, EVN_GEN_LOG );
         return;
@@ -859,26 +837,16 @@ void GenAutoOnce( void ) {
 //*************************************************************************************************
 static void EventLog( void ) {
 
-    FILE *log;
-    char name[40], prnval[40];
+    char prnval[40];
     
     if ( !config.log_enable_gen )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    if ( !config.mode_logging )
-        sprintf( name, "\\gen\\gen_%s.log", RTCFileName() );
-    else sprintf( name, "\\gen\\%s\\gen_%s.log", RTCFileShort(), RTCFileName() );
-    log = fopen( name, "a" );
-    if ( log == NULL )
-        return;
     if ( gen_ptr->stat == GEN_STAT_STEP_START ) //только для одного параметра подставляем значения
         sprintf( prnval, ParamGetDesc( ID_DEV_GEN, GEN_PAR_STAT ), gen_ptr->cycle1 + 1, gen_ptr->cycle2 ); 
     else sprintf( prnval, "%s", ParamGetDesc( ID_DEV_GEN, GEN_PAR_STAT ) );
     if ( gen_loc.error )
-        fprintf( log, "%s %s %s\r\n", RTCGetLog(), ParamGetDesc( ID_DEV_GEN, GEN_PAR_MODE ), ErrorDescr( ID_DEV_GEN, gen_ptr->error, 0 ) );
-    else fprintf( log, "%s %s %s\r\n", RTCGetLog(), ParamGetDesc( ID_DEV_GEN, GEN_PAR_MODE ), prnval );
-    fclose( log );
+        LogPrintf( LOG_GEN, "%s %s %s\r\n", RTCGetLog(), ParamGetDesc( ID_DEV_GEN, GEN_PAR_MODE ), ErrorDescr( ID_DEV_GEN, gen_ptr->error, 0 ) );
+    else LogPrintf( LOG_GEN, "%s %s %s\r\n", RTCGetLog(), ParamGetDesc( ID_DEV_GEN, GEN_PAR_MODE ), prnval );
  }
 
 //*************************************************************************************************
@@ -955,3 +923,18 @@ static void TimerCount( void ) {
     if ( gen_loc.timer_rest_acmain )
         gen_loc.timer_rest_acmain--;
  }
+
+//*************************************************************************************************
+// Передача команды в контроллер генератора (контроллер подключен по MODBUS)
+// Повтор запроса при ошибке выполняется планом обмена
+// uint16_t cmd       - код команды EXGEN_CMD_*
+// return ModBusError - результат выполнения
+//*************************************************************************************************
+static ModBusError GenRmtCmd( uint16_t cmd ) {
+
+    MBUS_PLAN plan;
+    
+    ModBusPlanInit( &plan, MB_ID_DEV_GEN );
+    ModBusPlanWrite( &plan, EXGEN_REG_WR_CMD, 1, &cmd );
+    return ModBusPlanExec( &plan, MBUS_PRIO_HIGH );
+ }
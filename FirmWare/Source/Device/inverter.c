@@ -19,11 +19,15 @@
 #include "dev_data.h"
 
 #include "main.h"
+#include "config.h"
 #include "rtc.h"
 #include "ports.h"
 #include "eeprom.h"
 #include "sound.h"
 #include "sdcard.h"
+#include "logger.h"
+#include "datalog.h"
+#include "rollup.h"
 #include "command.h"
 #include "informing.h"
 #include "priority.h"
@@ -265,6 +269,8 @@ static void TaskInv1( void *pvParameters ) {
         //проверка вкл/выкл инвертора в ручном режиме
         if ( event & EVN_RTC_SECONDS ) {
             InvCheckManual( ID_DEV_INV1 );
+            if ( inv1.act_status )
+                RollupSave( ID_DEV_INV1 ); //итоги по актуальным данным статуса инвертора
             if ( !osTimerIsRunning( timer_status1 ) ) {
                 send = ID_DEV_INV1; //передача данных в HMI
                 osMessageQueuePut( hmi_msg, &send, 0, 0 );
@@ -314,12 +320,15 @@ static void TaskInv2( void *pvParameters ) {
         if ( event & EVN_INV_RECV )
             Inv2CheckAnswer();
         //проверка вкл/выкл инвертора в ручном режиме
-        if ( event & EVN_RTC_SECONDS )
+        if ( event & EVN_RTC_SECONDS ) {
             InvCheckManual( ID_DEV_INV2 );
+            if ( inv2.act_status )
+                RollupSave( ID_DEV_INV2 ); //итоги по актуальным данным статуса инвертора
             if ( !osTimerIsRunning( timer_status2 ) ) {
                 send = ID_DEV_INV2; //передача данных в HMI
                 osMessageQueuePut( hmi_msg, &send, 0, 0 );
                }
+           }
        }
  }
 
@@ -1570,28 +1579,15 @@ static void Inv2ResulOut( void ) {
 //*************************************************************************************************
 static void EventLog1( char *text, InvCtrlError error ) {
 
-    FILE *log;
-    char name[40];
-    
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     if ( !config.log_enable_inv )
         return;
-    if ( !config.mode_logging )
-        sprintf( name, "\\inv\\inv1_%s.log", RTCFileName() );
-    else sprintf( name, "\\inv\\%s\\inv1_%s.log", RTCFileShort(), RTCFileName() );
-    log = fopen( name, "a" );
-    if ( log == NULL )
-        return;
     if ( error ) {
         //указан код ошибки
-        fprintf( log, "%s Шаг: %d код ошибки: %u %s\r\n", RTCGetLog(), inv1.cycle_step, error, ErrorDescr( ID_DEV_INV1, 0, error ) );
-        fclose( log );
+        LogPrintf( LOG_INV1, "%s Шаг: %d код ошибки: %u %s\r\n", RTCGetLog(), inv1.cycle_step, error, ErrorDescr( ID_DEV_INV1, 0, error ) );
         return;
        }
     //запись только текста сообщения
-    fprintf( log, "%s %s\r\n", RTCGetLog(), text );
-    fclose( log );
+    LogPrintf( LOG_INV1, "%s %s\r\n", RTCGetLog(), text );
  }
 
 //*************************************************************************************************
@@ -1604,59 +1600,32 @@ static void EventLog1( char *text, InvCtrlError error ) {
 //*************************************************************************************************
 static void EventLog2( char *text, InvCtrlError error ) {
 
-    FILE *log;
-    char name[40];
-    
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     if ( !config.log_enable_inv )
         return;
-    //открываем файл
-    if ( !config.mode_logging )
-        sprintf( name, "\\inv\\inv2_%s.log", RTCFileName() );
-    else sprintf( name, "\\inv\\%s\\inv2_%s.log", RTCFileShort(), RTCFileName() );
-    log = fopen( name, "a" );
-    if ( log == NULL )
-        return;
     if ( error ) {
         //указан код ошибки
-        fprintf( log, "%s Шаг: %d код ошибки: %u %s\r\n", RTCGetLog(), inv2.cycle_step, error, ErrorDescr( ID_DEV_INV1, 0, error ) );
-        fclose( log );
+        LogPrintf( LOG_INV2, "%s Шаг: %d код ошибки: %u %s\r\n", RTCGetLog(), inv2.cycle_step, error, ErrorDescr( ID_DEV_INV1, 0, error ) );
         return;
        }
     //запись только текста сообщения
-    fprintf( log, "%s %s\r\n", RTCGetLog(), text );
-    fclose( log );
+    LogPrintf( LOG_INV2, "%s %s\r\n", RTCGetLog(), text );
  }
 
 //*************************************************************************************************
-// Пишет в протокол "inv_yyyymmdd.csv" данные по обоим инверторам
+// Пишет в протокол "inv_yyyymmdd.csv" ("inv_yyyymmdd.bin" при _LOG_BINARY = 1) данные по обоим инверторам
 // Вызов из TSCheckAnswer после разбор данных
 //*************************************************************************************************
 static void InvSaveLog( void ) {
 
-    uint32_t pos;
-    char name[40];
-    FILE *ts_log;
-
     if ( !config.log_enable_inv )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     if ( inv1.mode != INV_MODE_ON && inv2.mode != INV_MODE_ON )
         return; //оба инвертора выключены
-    //открываем файл
-    if ( !config.mode_logging )
-        sprintf( name, "\\inv\\inv_%s.csv", RTCFileName() );
-    else sprintf( name, "\\inv\\%s\\inv_%s.csv", RTCFileShort(), RTCFileName() );
-    ts_log = fopen( name, "a" );
-    if ( ts_log == NULL )
-        return; //файл не открылся
-    pos = ftell( ts_log );
-    if ( !pos )
-        fputs( "Date;Time;Pwr1(%);Pwr1(W);Temp1(C);Conn1;Mode1;Error1;Pwr3(%);Pwr3(W);Temp3(C);Conn3;Mode3;Error3;\r\n", ts_log ); //запишем наименование полей
-    //запишем данные
-    fprintf( ts_log, "%s;%s;%d;%d;%4.1f;%s;%s;%s;%d;%d;%4.1f;%s;%s;%s\r\n", 
+    #if _LOG_BINARY
+    DataLogSave( DLOG_INV );
+    #else
+    //запишем данные, наименование полей добавляется в новый файл
+    LogPrintf( LOG_INV, "%s;%s;%d;%d;%4.1f;%s;%s;%s;%d;%d;%4.1f;%s;%s;%s\r\n", 
         RTCGetDate( NULL ), RTCGetTime( NULL ), 
         inv1.power_perc, inv1.power_watt, inv1.temperature, 
         inv1.dc_conn == INV_CTRL_ON ? "Да " : "Нет", 
@@ -1666,5 +1635,5 @@ static void InvSaveLog( void ) {
         inv2.dc_conn == INV_CTRL_ON ? "Да " : "Нет", 
         ParamGetDesc( ID_DEV_INV2, INV_MODE ),
         ErrorDescr( ID_DEV_INV2, inv2.dev_error, 0 ) ); 
-    fclose( ts_log );
+    #endif
  }
@@ -19,10 +19,14 @@
 #include "dev_data.h"
 
 #include "main.h"
+#include "config.h"
 #include "outinfo.h"
 #include "ports.h"
 #include "eeprom.h"
 #include "sdcard.h"
+#include "logger.h"
+#include "datalog.h"
+#include "rollup.h"
 #include "message.h"
 #include "command.h"
 #include "pv.h"
@@ -213,6 +217,8 @@ static void TaskMppt( void *pvParameters ) {
             mppt.connect = MpptCheckConn();
             mppt.pv_stat = PvGetStat();
             mppt.pv_mode = PvGetMode();
+            if ( mppt.link == LINK_CONN_OK )
+                RollupSave( ID_DEV_MPPT ); //итоги по данным контроллера MPPT
             if ( mppt.link == LINK_CONN_NO ) {
                 send = ID_DEV_MPPT; //передача данных в HMI
                 osMessageQueuePut( hmi_msg, &send, 0, 0 ); 
@@ -336,60 +342,31 @@ static void DataClear( void ) {
  }
 
 //*************************************************************************************************
-// Добавляет в протокол "mppt_yyyymmdd.csv" данные контроллера заряда MPPT
+// Добавляет в протокол "mppt_yyyymmdd.csv" ("mppt_yyyymmdd.bin" при _LOG_BINARY = 1) данные
+// контроллера заряда MPPT
 //*************************************************************************************************
 static void SaveLog( void ) {
 
     uint8_t *data;
-    uint32_t ind, pos;
-    char name_csv[80], name_hex[80];
-    FILE *mppt_log;
+    uint32_t ind;
+    static char hex[sizeof( pack ) * 3 + 1];
 
     if ( mppt.link == LINK_CONN_NO )
         return; //данных нет
     if ( !config.log_enable_mppt )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    //открываем файл для записи данных
-    if ( !config.mode_logging ) {
-        sprintf( name_csv, "\\mppt\\mppt_%s.csv", RTCFileName() );
-        sprintf( name_hex, "\\mppt\\mppt_%s.hex", RTCFileName() );
-       }
-    else {
-        sprintf( name_csv, "\\mppt\\%s\\mppt_%s.csv", RTCFileShort(), RTCFileName() );
-        sprintf( name_hex, "\\mppt\\%s\\mppt_%s.hex", RTCFileShort(), RTCFileName() );
-       }
-    mppt_log = fopen( name_csv, "a" );
-    if ( mppt_log == NULL )
-        return; //файл не открылся
-    pos = ftell( mppt_log );
-    if ( !pos )
-        fprintf( mppt_log, "Date;Time;PV_V(V);PV_I(A);OUT_V(V);OUT_I(A);WHr;AHr;Float;ModeCharge;SOC(%%);Bat_I(A);PVOn;PVMode\r\n" ); //запишем наименование полей
-    //запишем данные
-    fprintf( mppt_log, "%s;%s;%.1f;%.1f;%.1f;%.1f;%d;%d;%d;%s;%03d;%+.1f;%s;%s\r\n", RTCGetDate( NULL ), RTCGetTime( NULL ),
+    #if _LOG_BINARY
+    DataLogSave( DLOG_MPPT );
+    #else
+    //запишем данные, наименование полей добавляется в новый файл
+    LogPrintf( LOG_MPPT, "%s;%s;%.1f;%.1f;%.1f;%.1f;%d;%d;%d;%s;%03d;%+.1f;%s;%s\r\n", RTCGetDate( NULL ), RTCGetTime( NULL ),
         mppt.u01_in_voltage, mppt.u02_in_current, mppt.u03_out_voltage, mppt.u04_out_current, mppt.u05_energy1,
         mppt.u05_energy2, mppt.u07_time_flt, ParamGetDesc( ID_DEV_MPPT, MPPT_CHARGE_MODE ),
         mppt.u12_soc, mppt.u13_bat_current, ParamGetDesc( ID_DEV_MPPT, MPPT_PVON ), ParamGetDesc( ID_DEV_MPPT, MPPT_PVMODE ) ); 
-    fclose( mppt_log );
-    //запись всех данных пакета MPPT в HEX формате
-    mppt_log = fopen( name_hex, "a" );
-    if ( mppt_log == NULL )
-        return; //файл не открылся
-    pos = ftell( mppt_log );
-    if ( !pos ) {
-        //запишем шапку для данных
-        fputs( Message( CONS_MSG_MPPT_HEADER1 ), mppt_log );
-        fputs( Message( CONS_MSG_MPPT_HEADER2 ), mppt_log );
-        fputs( Message( CONS_MSG_MPPT_HEADER3 ), mppt_log );
-        fputs( Message( CONS_MSG_MPPT_HEADER4 ), mppt_log );
-        fputs( Message( CONS_MSG_MPPT_HEADER5 ), mppt_log );
-       }
-    //запишем данные в HEX формате
-    fprintf( mppt_log, "%s %s ", RTCGetDate( NULL ), RTCGetTime( NULL ) );
+    #endif
+    //запись всех данных пакета MPPT в HEX формате, шапка добавляется в новый файл
     data = (uint8_t *)&pack;
     for ( ind = 0; ind < sizeof( pack ); ind++ )
-        fprintf( mppt_log, "%02X ", *( data + ind ) );
-    fputs( Message( CONS_MSG_CRLF ), mppt_log );
-    fclose( mppt_log );
+        sprintf( hex + ind * 3, "%02X ", *( data + ind ) );
+    LogPrintf( LOG_MPPT_HEX, "%s %s %s%s", RTCGetDate( NULL ), RTCGetTime( NULL ), hex, Message( CONS_MSG_CRLF ) );
  }
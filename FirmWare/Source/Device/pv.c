@@ -27,6 +27,7 @@
 #include "rtc.h"
 #include "mppt.h"
 #include "sdcard.h"
+#include "logger.h"
 #include "spa_calc.h"
 #include "informing.h"
 #include "message.h"
@@ -279,21 +280,8 @@ PvStatus PvGetStat( void ) {
 //*************************************************************************************************
 static void EventLog( char *text ) {
 
-    char name[40];
-    FILE *pv_log;
-
     if ( !config.log_enable_pv )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    //формируем имя файла
-    if ( !config.mode_logging )
-        sprintf( name, "\\mppt\\pv_%s.log", RTCFileName() );
-    else sprintf( name, "\\mppt\\%s\\pv_%s.log", RTCFileShort(), RTCFileName() );
-    pv_log = fopen( name, "a" );
-    if ( pv_log == NULL )
-        return;
     //запись строки
-    fprintf( pv_log, "%s %s\r\n", RTCGetLog(), text );
-    fclose( pv_log );
+    LogPrintf( LOG_PV, "%s %s\r\n", RTCGetLog(), text );
  }
@@ -23,12 +23,15 @@
 #include "mppt.h"
 #include "eeprom.h"
 #include "sdcard.h"
+#include "logger.h"
 #include "tracker.h"
 #include "trc_calc.h"
 #include "can_def.h"
 #include "command.h"
 #include "modbus.h"
 #include "modbus_def.h"
+#include "modbus_plan.h"
+#include "modbus_poll.h"
 #include "spa_calc.h"
 #include "informing.h"
 #include "tracker_ext.h"
@@ -44,12 +47,15 @@ osEventFlagsId_t trc_event = NULL;
 //*************************************************************************************************
 // Локальные константы
 //*************************************************************************************************
-#define TIMEOUT_WAIT_EVENT_TRC  500         //время ожидания события (msec)
+#define TRC_POLL_PERIOD         500         //период опроса состояния контроллера (msec)
+#define TRC_LOG_REGS            8           //макс. кол-во регистров команды в протоколе
 
 //*************************************************************************************************
 // Локальные переменные
 //*************************************************************************************************
 static osTimerId_t timer_on, timer_off, timer_log;
+static ModBusError trc_poll_stat = MBUS_ANSWER_OK;
+static uint16_t trc_poll_data[EXTRC_REG_RD_MAX];
 
 //тип логирования данных
 typedef enum {
@@ -62,7 +68,7 @@ typedef enum {
 //*************************************************************************************************
 static const osThreadAttr_t trc_attr = {
     .name = "Tracker", 
-    .stack_size = 864,
+    .stack_size = 1024,
     .priority = osPriorityNormal
  };
 
@@ -75,6 +81,8 @@ static const osTimerAttr_t timer3_attr = { .name = "TrcLog" };
 // Прототипы локальных функций
 //*************************************************************************************************
 static void TrackerStatus( void );
+static void TrackerPorts( void );
+static void TrackerData( ModBusError status, uint16_t *trc_data );
 static void TracerCtrlAct( void );
 static void TracerCtrlMain( void );
 static void TracerCtrlPos( void );
@@ -86,6 +94,11 @@ static void Timer2Callback( void *arg );
 static void Timer3Callback( void *arg );
 static void TaskTracker( void *pvParameters );
 static void TrcCmdLog( MBUS_REQUEST *reqst );
+static void TrcPollDone( ModBusError status, void *arg );
+
+//запись циклического опроса состояния контроллера трекера
+static const MBUS_POLL trc_poll = { MB_ID_DEV_TRACKER, EXTRC_REG_RD_STAT, EXTRC_REG_RD_MAX, trc_poll_data, 
+                                    TRC_POLL_PERIOD, TRC_POLL_PERIOD, MBUS_PRIO_LOW, TrcPollDone, NULL };
 
 //*************************************************************************************************
 // Инициализация портов
@@ -104,6 +117,8 @@ void TrackerInit( void ) {
     timer_log = osTimerNew( Timer3Callback, osTimerOnce, NULL, &timer3_attr );
     //создаем задачу
     osThreadNew( TaskTracker, NULL, &trc_attr );
+    //циклический опрос состояния контроллера
+    ModBusPollAdd( &trc_poll );
  }
 
 //*************************************************************************************************
@@ -113,20 +128,23 @@ static void TaskTracker( void *pvParameters ) {
     
     uint32_t send;
     int32_t event;
+    uint16_t trc_data[EXTRC_REG_RD_MAX];
     
     for ( ;; ) {
         //запуск таймера интервальной записи данных
         if ( !osTimerIsRunning( timer_log ) )
             osTimerStart( timer_log, config.datlog_upd_trc * SEC_TO_TICK );
-        //ждем события но не более TIMEOUT_WAIT_EVENT_TRC
-        event = osEventFlagsWait( trc_event, EVN_TRC_MASK, osFlagsWaitAny, TIMEOUT_WAIT_EVENT_TRC );
-        if ( event == osErrorTimeout ) {
-            TrackerStatus();     //чтение состояния контроллера трекера
+        event = osEventFlagsWait( trc_event, EVN_TRC_MASK, osFlagsWaitAny, osWaitForever );
+        if ( event & EVN_TRC_POLL ) {
+            //состояние контроллера трекера прочитано планировщиком опроса
+            TrackerPorts();
+            ModBusPollData( &trc_poll, trc_data );
+            TrackerData( trc_poll_stat, trc_data );
             //TracerCtrlMain(); //управления режимом работы контроллера трекера: сенсор/командный
             send = ID_DEV_TRC;   //передача данных в HMI
             osMessageQueuePut( hmi_msg, &send, 0, 0 );
            }
-        else {
+        if ( event & ~EVN_TRC_POLL ) {
             if ( event & EVN_RTC_5MINUTES ) {
                 //управления работой реле питания актуаторов трекера
                 TracerCtrlAct();
@@ -185,6 +203,15 @@ static void Timer3Callback( void *arg ) {
     osEventFlagsSet( trc_event, EVN_TRC_LOG );
  }
 
+//*************************************************************************************************
+// Функция обратного вызова планировщика опроса - состояние контроллера прочитано
+//*************************************************************************************************
+static void TrcPollDone( ModBusError status, void *arg ) {
+
+    trc_poll_stat = status;
+    osEventFlagsSet( trc_event, EVN_TRC_POLL );
+ }
+
 //*************************************************************************************************
 // Запрос состояния контроллера трекера
 //*************************************************************************************************
@@ -196,14 +223,32 @@ static void TrackerStatus( void ) {
     uint16_t len = sizeof( trc_data );
     MBUS_REQUEST reqst = { MB_ID_DEV_TRACKER, FUNC_RD_HOLD_REG, EXTRC_REG_RD_STAT, EXTRC_REG_RD_MAX, &trc_data, &len };
 
-    tracker.pwr_trc = GetDataPort( TRC_PWR ) ? POWER_ON : POWER_OFF;
-    tracker.pwr_act = GPIO_PinRead( TRC_PORT, TRC_ON ) ? TRC_ACT_ON : TRC_ACT_OFF;
-    tracker.pwr_fuse = GetDataPort( TRC_FUSE ) ? PROTECT_WORK : PROTECT_OFF;
+    TrackerPorts();
     cnt_rpt = CNT_REPEAT_REQST;
     do {
         len = sizeof( trc_data );
-        status = ModBusRequest( &reqst );
+        status = ModBusRequestCache( &reqst, MBUS_PRIO_LOW, MBUS_CACHE_USE );
        } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+    TrackerData( status, trc_data );
+ }
+
+//*************************************************************************************************
+// Чтение состояния цепей питания трекера
+//*************************************************************************************************
+static void TrackerPorts( void ) {
+
+    tracker.pwr_trc = GetDataPort( TRC_PWR ) ? POWER_ON : POWER_OFF;
+    tracker.pwr_act = GPIO_PinRead( TRC_PORT, TRC_ON ) ? TRC_ACT_ON : TRC_ACT_OFF;
+    tracker.pwr_fuse = GetDataPort( TRC_FUSE ) ? PROTECT_WORK : PROTECT_OFF;
+ }
+
+//*************************************************************************************************
+// Обновление состояния контроллера трекера по результату чтения регистров
+// ModBusError status - результат чтения регистров
+// uint16_t *trc_data - значения регистров чтения EXTRC_REG_RD_STAT ... EXTRC_REG_RD_TIMEON
+//*************************************************************************************************
+static void TrackerData( ModBusError status, uint16_t *trc_data ) {
+
     if ( status != MBUS_ANSWER_OK ) {
         tracker.link = LINK_CONN_NO;
         tracker.stat = 0;
@@ -405,10 +450,10 @@ TrackerPosErr TrackerSetPos( TrackerAct type_act, TrackerPos type_value, float v
 //*************************************************************************************************
 Status TrackerCmd( uint16_t cmnd, uint16_t param1, uint16_t param2 ) {
 
-    uint8_t cnt_rpt;
     uint32_t send, msg;
+    MBUS_PLAN plan;
     ModBusError status;
-    uint16_t trc_data[EXTRC_REG_WR_MAX];
+    uint16_t trc_data[EXTRC_REG_WR_MAX], trc_stat[EXTRC_REG_RD_MAX];
     uint16_t len = sizeof( trc_data );
     MBUS_REQUEST reqst = { MB_ID_DEV_TRACKER, FUNC_WR_MULT_REG, EXTRC_REG_WR_CMD, EXTRC_REG_WR_MAX, &trc_data, &len };
 
@@ -424,11 +469,17 @@ Status TrackerCmd( uint16_t cmnd, uint16_t param1, uint16_t param2 ) {
     if ( cmnd & EXTRC_HORZ || cmnd & EXTRC_HORZ_VAL )
         reqst.cnt_reg = 3; //т.к. значение горизонтального актуатора передается всегда в 3-м регистре
     TrcCmdLog( &reqst );
-    cnt_rpt = CNT_REPEAT_REQST;
-    do {
-        len = sizeof( trc_data );
-        status = ModBusRequest( &reqst );
-       } while ( cnt_rpt-- && ( status == MBUS_ANSWER_CRC || status == MBUS_ANSWER_TIMEOUT ) );
+    //передача команды и чтение состояния контроллера в одном плане
+    ModBusPlanInit( &plan, MB_ID_DEV_TRACKER );
+    ModBusPlanWrite( &plan, EXTRC_REG_WR_CMD, reqst.cnt_reg, trc_data );
+    ModBusPlanRead( &plan, EXTRC_REG_RD_STAT, EXTRC_REG_RD_MAX, trc_stat );
+    status = ModBusPlanExec( &plan, MBUS_PRIO_NORMAL );
+    //ошибка чтения состояния на результат команды не влияет, состояние
+    //будет прочитано планировщиком опроса
+    if ( status == MBUS_ANSWER_OK )
+        TrackerData( status, trc_stat );
+    //результат выполнения команды - результат записи
+    status = plan.status_wr;
     if ( status == MBUS_ANSWER_OK ) {
         send = ID_DEV_TRC;   //передача данных в HMI
         osMessageQueuePut( hmi_msg, &send, 0, 0 );
@@ -504,26 +555,13 @@ static void TrcSavePos( void ) {
 //*************************************************************************************************
 static void TrcLogging( void ) {
 
-    char name[64];
-    FILE *trc_log;
-
     if ( !config.log_enable_trc )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
     if ( !tracker.link ) 
         return; //трекер не подключен по интерфейсу RS-485
-    if ( !config.mode_logging )
-        sprintf( name, "\\trc\\trc_%s.log", RTCFileName() );
-    else sprintf( name, "\\trc\\%s\\trc_%s.log", RTCFileShort(), RTCFileName() );
-    //пишем в конец файла
-    trc_log = fopen( name, "a" );
-    if ( trc_log == NULL )
-        return; //файл не открылся
-    fprintf( trc_log, "%s STAT: 0x%04X %s VER=%03d/%.1f° HRZ=%03d/%.1f°\r\n", RTCGetLog(), tracker.stat, 
+    LogPrintf( LOG_TRC, "%s STAT: 0x%04X %s VER=%03d/%.1f° HRZ=%03d/%.1f°\r\n", RTCGetLog(), tracker.stat, 
         ParamGetDesc( ID_DEV_TRC, TRC_MODE ), tracker.act_pos_vert, 
         AngleVert( tracker.act_pos_vert ), tracker.act_pos_horz, AngleHorz( tracker.act_pos_horz ) ); 
-    fclose( trc_log );
  }
 
 //*************************************************************************************************
@@ -534,27 +572,16 @@ static void TrcCmdLog( MBUS_REQUEST *reqst ) {
 
     uint8_t i;
     uint16_t *reg;
-    char name[64];
-    FILE *trc_log;
+    char data[TRC_LOG_REGS * 7 + 1];
 
     if ( !config.log_enable_trc )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    if ( !config.mode_logging )
-        sprintf( name, "\\trc\\trc_%s.log", RTCFileName() );
-    else sprintf( name, "\\trc\\%s\\trc_%s.log", RTCFileShort(), RTCFileName() );
-    //пишем в конец файла
-    trc_log = fopen( name, "a" );
-    if ( trc_log == NULL )
-        return; //файл не открылся
-    fprintf( trc_log, "%s ", RTCGetLog() );
-    fprintf( trc_log, "ADDR=0x%04X REGS=0x%04X DATA=", reqst->addr_reg, reqst->cnt_reg );
+    //значения регистров
+    data[0] = '\0';
     reg = (uint16_t *)reqst->ptr_data;
-    for ( i = 0; i < reqst->cnt_reg; i++, reg++ )
-        fprintf( trc_log, "0x%04X ", *reg );
-    fprintf( trc_log, "\r\n" ); 
-    fclose( trc_log );
+    for ( i = 0; i < reqst->cnt_reg && i < TRC_LOG_REGS; i++, reg++ )
+        sprintf( data + i * 7, "0x%04X ", *reg );
+    LogPrintf( LOG_TRC, "%s ADDR=0x%04X REGS=0x%04X DATA=%s\r\n", RTCGetLog(), reqst->addr_reg, reqst->cnt_reg, data ); 
  }
 
 //*************************************************************************************************
@@ -563,24 +590,11 @@ static void TrcCmdLog( MBUS_REQUEST *reqst ) {
 //*************************************************************************************************
 static void EventLog( char *text, EventType evn ) {
 
-    char name[64];
-    FILE *trc_log;
-
     if ( !config.log_enable_trc )
         return; //логирование выключено
-    if ( SDStatus() == ERROR )
-        return; //карты нет
-    //определение имени файла
-    if ( !config.mode_logging )
-        sprintf( name, "\\trc\\trc_%s.log", RTCFileName() );
-    else sprintf( name, "\\trc\\%s\\trc_%s.log", RTCFileShort(), RTCFileName() );
-    trc_log = fopen( name, "a" );
-    if ( trc_log == NULL )
-        return;
     //запись строки
     if ( evn == EVENT_LOG )
-        fprintf( trc_log, "%s EVENT: %s\r\n", RTCGetLog(), text );
+        LogPrintf( LOG_TRC, "%s EVENT: %s\r\n", RTCGetLog(), text );
     if ( evn == ERROR_LOG )
-        fprintf( trc_log, "%s ERROR: %s\r\n", RTCGetLog(), text );
-    fclose( trc_log );
+        LogPrintf( LOG_TRC, "%s ERROR: %s\r\n", RTCGetLog(), text );
  }
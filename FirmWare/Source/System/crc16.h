@@ -5,10 +5,16 @@
 #include <stdio.h>
 #include <stdint.h>
 
+#define CRC16_INIT          0xFFFF          //начальное значение CRC протокола MODBUS
+
 //*************************************************************************************************
 // Функции управления
 //*************************************************************************************************
 uint16_t CalcCRC16( uint8_t *buf, uint16_t len );
+uint16_t CRC16Init( void );
+uint16_t CRC16Update( uint16_t crc, uint8_t data );
+uint16_t CRC16Block( uint16_t crc, uint8_t *buf, uint16_t len );
+uint16_t CRC16Final( uint16_t crc );
 
 #endif
 
@@ -0,0 +1,285 @@
+
+//*************************************************************************************************
+//
+// Расчет контрольных сумм аппаратным блоком CRC
+// Блок CRC один на все задачи, доступ к нему выполняется через мьютекс на время всего расчета.
+// Блоки данных от CRC_DMA_MIN байт передаются в блок CRC каналом GPDMA (память -> регистр
+// CRC_WR_DATA), процессор на время передачи освобождается. Короткие блоки и блоки при занятом
+// другой задачей блоке CRC рассчитываются программно (модель блока CRC, таблица CRC16)
+//
+//*************************************************************************************************
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "cmsis_os2.h"
+#include "GPDMA_LPC17xx.h"
+
+#include "lpc177x_8x_crc.h"
+
+#include "crc_hw.h"
+#include "crc_model.h"
+#include "crc16.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define CRC_HW_MIN              32          //минимальный размер блока для аппаратного расчета
+#define CRC_SOFT_MAX            1024        //макс размер блока для программного расчета
+                                            //при занятом блоке CRC
+#define CRC_DMA_MIN             128         //минимальный размер блока для передачи через DMA
+#define CRC_DMA_CHUNK           4095        //макс кол-во байт одной передачи GPDMA
+#define CRC_DMA_CHANNEL         7           //канал GPDMA (1/2 - консоль, 5/6 - HMI)
+#define CRC_DMA_TIMEOUT         100         //время ожидания завершения передачи (msec)
+
+#define CRC_EVN_DONE            0x00000001  //передача DMA завершена
+#define CRC_EVN_ERROR           0x00000002  //ошибка передачи DMA
+#define CRC_EVN_MASK            ( CRC_EVN_DONE | CRC_EVN_ERROR )
+
+//Параметры канала DMA: побайтовая передача, адрес источника увеличивается, адрес приемника
+//(регистр CRC_WR_DATA) не изменяется
+#define CRC_DMA_CONTROL         ( GPDMA_CH_CONTROL_SI | GPDMA_CH_CONTROL_I | \
+                                ( GPDMA_WIDTH_BYTE << GPDMA_CH_CONTROL_SWIDTH_POS ) | \
+                                ( GPDMA_WIDTH_BYTE << GPDMA_CH_CONTROL_DWIDTH_POS ) | \
+                                ( GPDMA_BSIZE_1 << GPDMA_CH_CONTROL_SBSIZE_POS ) | \
+                                ( GPDMA_BSIZE_1 << GPDMA_CH_CONTROL_DBSIZE_POS ) )
+#define CRC_DMA_CONFIG          ( GPDMA_TRANSFER_M2M_CTRL_DMA | GPDMA_CH_CONFIG_IE | \
+                                  GPDMA_CH_CONFIG_ITC | GPDMA_CH_CONFIG_E )
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static osMutexId_t mutex_crc = NULL;
+static osEventFlagsId_t crc_event = NULL;
+static bool dma_ok = false;                             //канал DMA доступен
+static uint32_t crc_stat[CRC_STAT_CNT];
+
+//Тип полинома драйвера CRC для каждого типа CrcType
+static const CRC_Type crc_poly[] = { CRC_POLY_CRCCCITT, CRC_POLY_CRC16, CRC_POLY_CRC16, CRC_POLY_CRC32 };
+
+static char * const crc_name[] = { "CCITT", "CRC16", "MODBUS", "CRC32" };
+
+//*************************************************************************************************
+// Атрибуты объектов RTOS
+//*************************************************************************************************
+static const osMutexAttr_t mutex_attr = { .name = "CrcHw", .attr_bits = osMutexPrioInherit };
+static const osEventFlagsAttr_t evn_attr = { .name = "CrcHw" };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void CrcStart( CRC_HW_CTX *ctx, CrcType type, bool engine );
+static void CrcDma( CRC_HW_CTX *ctx, uint8_t *buf, uint32_t len );
+static void CrcDmaEvent( uint32_t event );
+
+//*************************************************************************************************
+// Инициализация блока CRC и канала DMA
+//*************************************************************************************************
+void CrcHwInit( void ) {
+
+    mutex_crc = osMutexNew( &mutex_attr );
+    crc_event = osEventFlagsNew( &evn_attr );
+    if ( GPDMA_Initialize() == 0 && crc_event != NULL )
+        dma_ok = true;
+ }
+
+//*************************************************************************************************
+// Начало потокового расчета контрольной суммы
+// Блок CRC занимается до вызова CrcHwEnd(), при отсутствии мьютекса расчет выполняется программно
+// CRC_HW_CTX *ctx - состояние расчета
+// CrcType type    - тип контрольной суммы
+//*************************************************************************************************
+void CrcHwStart( CRC_HW_CTX *ctx, CrcType type ) {
+
+    if ( mutex_crc != NULL && osMutexAcquire( mutex_crc, osWaitForever ) == osOK )
+        CrcStart( ctx, type, true );
+    else CrcStart( ctx, type, false );
+ }
+
+//*************************************************************************************************
+// Добавление блока данных в расчет контрольной суммы
+// CRC_HW_CTX *ctx - состояние расчета
+// uint8_t *buf    - адрес буфера с данными
+// uint32_t len    - размер данных
+//*************************************************************************************************
+void CrcHwAdd( CRC_HW_CTX *ctx, uint8_t *buf, uint32_t len ) {
+
+    uint16_t part;
+
+    if ( buf == NULL || !len )
+        return;
+    ctx->size += len;
+    if ( ctx->engine == true ) {
+        if ( dma_ok == true && len >= CRC_DMA_MIN )
+            CrcDma( ctx, buf, len );
+        else CRC_CalcBlockChecksum( buf, len, CRC_WR_8BIT );
+        return;
+       }
+    if ( ctx->type != CRC_TYPE_MODBUS ) {
+        CrcModelBlock( &ctx->model, buf, len );
+        return;
+       }
+    //для MODBUS используется табличный расчет, размер блока CRC16Block() ограничен 16 битами
+    for ( ; len; len -= part, buf += part ) {
+        part = len > 0xFFFF ? 0xFFFF : len;
+        ctx->modbus = CRC16Block( ctx->modbus, buf, part );
+       }
+ }
+
+//*************************************************************************************************
+// Завершение потокового расчета, освобождение блока CRC
+// CRC_HW_CTX *ctx - состояние расчета
+// uint32_t *crc   - контрольная сумма
+// return = SUCCESS - контрольная сумма рассчитана
+//        = ERROR   - ошибка передачи данных через DMA, значение недостоверно
+//*************************************************************************************************
+Status CrcHwEnd( CRC_HW_CTX *ctx, uint32_t *crc ) {
+
+    uint32_t sum;
+
+    if ( ctx->engine == true ) {
+        sum = LPC_CRC->SUM;
+        if ( ctx->type != CRC_TYPE_32 )
+            sum &= 0xFFFF;
+        ctx->engine = false;
+        osMutexRelease( mutex_crc );
+       }
+    else if ( ctx->type == CRC_TYPE_MODBUS )
+        sum = CRC16Final( ctx->modbus );
+    else sum = CrcModelSum( &ctx->model );
+    if ( crc != NULL )
+        *crc = sum;
+    if ( ctx->error == true )
+        return ERROR;
+    return SUCCESS;
+ }
+
+//*************************************************************************************************
+// Расчет контрольной суммы блока данных
+// Блоки меньше CRC_HW_MIN байт, а так же блоки до CRC_SOFT_MAX байт при занятом блоке CRC
+// рассчитываются программно, остальные - блоком CRC. Захваченный мьютекс блока CRC передается
+// в расчет без освобождения, блок не может быть занят другой задачей между проверкой и расчетом
+// CrcType type    - тип контрольной суммы
+// uint8_t *buf    - адрес буфера с данными
+// uint32_t len    - размер данных
+// return uint32_t - контрольная сумма
+//*************************************************************************************************
+uint32_t CrcHwCalc( CrcType type, uint8_t *buf, uint32_t len ) {
+
+    uint32_t crc;
+    CRC_HW_CTX ctx;
+
+    if ( type >= CRC_TYPE_CNT )
+        type = CRC_TYPE_CCITT;
+    if ( len >= CRC_HW_MIN && mutex_crc != NULL ) {
+        //блоки до CRC_SOFT_MAX байт не ожидают освобождения блока CRC
+        if ( osMutexAcquire( mutex_crc, len > CRC_SOFT_MAX ? osWaitForever : 0 ) == osOK ) {
+            CrcStart( &ctx, type, true );
+            CrcHwAdd( &ctx, buf, len );
+            if ( CrcHwEnd( &ctx, &crc ) == SUCCESS )
+                return crc;
+           }
+       }
+    //программный расчет
+    crc_stat[CRC_STAT_SOFT]++;
+    if ( type == CRC_TYPE_MODBUS && len <= 0xFFFF )
+        return CalcCRC16( buf, len );
+    CrcModelInit( &ctx.model, type );
+    CrcModelBlock( &ctx.model, buf, len );
+    return CrcModelSum( &ctx.model );
+ }
+
+//*************************************************************************************************
+// Возвращает значение счетчика расчетов
+// CrcStat type   - тип счетчика
+// return uint32_t - значение счетчика
+//*************************************************************************************************
+uint32_t CrcHwStat( CrcStat type ) {
+
+    if ( type >= CRC_STAT_CNT )
+        return 0;
+    return crc_stat[type];
+ }
+
+//*************************************************************************************************
+// Возвращает наименование типа контрольной суммы
+// CrcType type - тип контрольной суммы
+// return       - указатель на строку с наименованием
+//*************************************************************************************************
+char *CrcHwName( CrcType type ) {
+
+    if ( type >= CRC_TYPE_CNT )
+        return "";
+    return crc_name[type];
+ }
+
+//*************************************************************************************************
+// Начало расчета контрольной суммы
+// CRC_HW_CTX *ctx - состояние расчета
+// CrcType type    - тип контрольной суммы
+// bool engine     - true - мьютекс блока CRC уже захвачен, расчет выполняется блоком CRC
+//                   false - программный расчет
+//*************************************************************************************************
+static void CrcStart( CRC_HW_CTX *ctx, CrcType type, bool engine ) {
+
+    if ( type >= CRC_TYPE_CNT )
+        type = CRC_TYPE_CCITT;
+    ctx->type = type;
+    ctx->error = false;
+    ctx->size = 0;
+    ctx->engine = engine;
+    if ( ctx->engine == true ) {
+        crc_stat[CRC_STAT_ENGINE]++;
+        CRC_Init( crc_poly[type] );
+        //начальное значение MODBUS отличается от CRC-16 драйвера, порядок бит тот же
+        LPC_CRC->SEED = CrcModelInitVal( type );
+        return;
+       }
+    crc_stat[CRC_STAT_SOFT]++;
+    ctx->modbus = CRC16Init();
+    CrcModelInit( &ctx->model, type );
+ }
+
+//*************************************************************************************************
+// Передача блока данных в блок CRC через DMA, блок передается частями по CRC_DMA_CHUNK байт
+// Если канал DMA занят, оставшиеся данные записываются в блок CRC процессором
+// CRC_HW_CTX *ctx - состояние расчета
+// uint8_t *buf    - адрес буфера с данными
+// uint32_t len    - размер данных
+//*************************************************************************************************
+static void CrcDma( CRC_HW_CTX *ctx, uint8_t *buf, uint32_t len ) {
+
+    uint32_t size, event;
+
+    for ( ; len; len -= size, buf += size ) {
+        size = len > CRC_DMA_CHUNK ? CRC_DMA_CHUNK : len;
+        osEventFlagsClear( crc_event, CRC_EVN_MASK );
+        if ( GPDMA_ChannelConfigure( CRC_DMA_CHANNEL, (uint32_t)buf, (uint32_t)&LPC_CRC->SUM, size,
+                                     CRC_DMA_CONTROL, CRC_DMA_CONFIG, CrcDmaEvent ) != 0 ) {
+            //канал занят, передача не начата
+            CRC_CalcBlockChecksum( buf, len, CRC_WR_8BIT );
+            return;
+           }
+        crc_stat[CRC_STAT_DMA]++;
+        event = osEventFlagsWait( crc_event, CRC_EVN_MASK, osFlagsWaitAny, CRC_DMA_TIMEOUT );
+        if ( event != CRC_EVN_DONE ) {
+            //ошибка или таймаут, кол-во переданных в блок CRC байт неизвестно
+            GPDMA_ChannelDisable( CRC_DMA_CHANNEL );
+            crc_stat[CRC_STAT_ERROR]++;
+            ctx->error = true;
+            return;
+           }
+       }
+ }
+
+//*************************************************************************************************
+// Функция обратного вызова драйвера GPDMA, вызывается из прерывания
+// uint32_t event - события канала DMA
+//*************************************************************************************************
+static void CrcDmaEvent( uint32_t event ) {
+
+    if ( event & GPDMA_EVENT_ERROR )
+        osEventFlagsSet( crc_event, CRC_EVN_ERROR );
+    else if ( event & GPDMA_EVENT_TERMINAL_COUNT_REQUEST )
+        osEventFlagsSet( crc_event, CRC_EVN_DONE );
+ }
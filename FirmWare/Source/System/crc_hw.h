@@ -0,0 +1,45 @@
+
+#ifndef __CRC_HW_H
+#define __CRC_HW_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <lpc_types.h>
+
+#include "crc_model.h"
+
+//Счетчики расчетов контрольных сумм
+typedef enum {
+    CRC_STAT_ENGINE,                        //кол-во расчетов аппаратным блоком
+    CRC_STAT_DMA,                           //кол-во блоков переданных в блок CRC через DMA
+    CRC_STAT_SOFT,                          //кол-во программных расчетов
+    CRC_STAT_ERROR,                         //кол-во ошибок DMA
+    CRC_STAT_CNT                            //кол-во счетчиков
+ } CrcStat;
+
+//Состояние потокового расчета контрольной суммы
+typedef struct {
+    CrcType   type;                         //тип контрольной суммы
+    bool      engine;                       //расчет выполняется аппаратным блоком
+    bool      error;                        //ошибка передачи данных через DMA
+    uint32_t  size;                         //кол-во обработанных байт
+    uint16_t  modbus;                       //текущее значение при программном расчете MODBUS
+    CRC_MODEL model;                        //состояние при программном расчете
+ } CRC_HW_CTX;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void CrcHwInit( void );
+void CrcHwStart( CRC_HW_CTX *ctx, CrcType type );
+void CrcHwAdd( CRC_HW_CTX *ctx, uint8_t *buf, uint32_t len );
+Status CrcHwEnd( CRC_HW_CTX *ctx, uint32_t *crc );
+uint32_t CrcHwCalc( CrcType type, uint8_t *buf, uint32_t len );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t CrcHwStat( CrcStat type );
+char *CrcHwName( CrcType type );
+
+#endif
@@ -0,0 +1,159 @@
+
+//*************************************************************************************************
+//
+// Программная модель аппаратного блока CRC LPC177x
+// Модель повторяет регистры CRC_MODE/CRC_SEED/CRC_SUM блока: побайтовая запись данных с
+// инверсией и обратным порядком бит, сдвиговый регистр со старшего разряда, обработка
+// результата. Используется для программного расчета при занятом блоке и для проверки
+// результатов аппаратного расчета, модуль не зависит от RTOS и периферии
+//
+//*************************************************************************************************
+
+#include <stdint.h>
+
+#include "crc_model.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+//Параметры полиномов: значение полинома, разрядность
+static const uint32_t poly_val[] = { 0x1021, 0x8005, 0x04C11DB7 };
+static const uint8_t poly_bits[] = { 16, 16, 32 };
+
+//Режим CRC_MODE для каждого типа CrcType
+static const uint32_t crc_mode[] = {
+    CRC_MODEL_POLY_CCITT,
+    CRC_MODEL_POLY_16 | CRC_MODEL_RVS_WR | CRC_MODEL_RVS_SUM,
+    CRC_MODEL_POLY_16 | CRC_MODEL_RVS_WR | CRC_MODEL_RVS_SUM,
+    CRC_MODEL_POLY_32 | CRC_MODEL_RVS_WR | CRC_MODEL_RVS_SUM | CRC_MODEL_CMPL_SUM
+ };
+
+//Начальное значение CRC_SEED для каждого типа CrcType
+static const uint32_t crc_seed[] = { 0xFFFF, 0x0000, 0xFFFF, 0xFFFFFFFF };
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static uint32_t Reverse( uint32_t value, uint8_t bits );
+
+//*************************************************************************************************
+// Инициализация модели для расчета контрольной суммы
+// CRC_MODEL *crc - состояние модели
+// CrcType type   - тип контрольной суммы
+//*************************************************************************************************
+void CrcModelInit( CRC_MODEL *crc, CrcType type ) {
+
+    if ( type >= CRC_TYPE_CNT )
+        type = CRC_TYPE_CCITT;
+    crc->mode = crc_mode[type];
+    CrcModelSeed( crc, crc_seed[type] );
+ }
+
+//*************************************************************************************************
+// Установка начального значения, аналог записи в регистр CRC_SEED
+// CRC_MODEL *crc - состояние модели
+// uint32_t seed  - начальное значение
+//*************************************************************************************************
+void CrcModelSeed( CRC_MODEL *crc, uint32_t seed ) {
+
+    uint8_t bits;
+
+    bits = poly_bits[crc->mode & CRC_MODEL_POLY_MASK];
+    crc->sum = seed & ( 0xFFFFFFFF >> ( 32 - bits ) );
+ }
+
+//*************************************************************************************************
+// Добавление одного байта, аналог 8-битной записи в регистр CRC_WR_DATA
+// CRC_MODEL *crc - состояние модели
+// uint8_t data   - байт данных
+//*************************************************************************************************
+void CrcModelByte( CRC_MODEL *crc, uint8_t data ) {
+
+    uint8_t bit, bits;
+    uint32_t poly, sum;
+
+    poly = poly_val[crc->mode & CRC_MODEL_POLY_MASK];
+    bits = poly_bits[crc->mode & CRC_MODEL_POLY_MASK];
+    if ( crc->mode & CRC_MODEL_CMPL_WR )
+        data = ~data;
+    if ( crc->mode & CRC_MODEL_RVS_WR )
+        data = Reverse( data, 8 );
+    sum = crc->sum;
+    for ( bit = 0; bit < 8; bit++, data <<= 1 ) {
+        if ( ( ( sum >> ( bits - 1 ) ) ^ ( data >> 7 ) ) & 0x01 )
+            sum = ( sum << 1 ) ^ poly;
+        else sum <<= 1;
+       }
+    crc->sum = sum & ( 0xFFFFFFFF >> ( 32 - bits ) );
+ }
+
+//*************************************************************************************************
+// Добавление блока данных
+// CRC_MODEL *crc - состояние модели
+// uint8_t *buf   - адрес буфера с данными
+// uint32_t len   - размер данных
+//*************************************************************************************************
+void CrcModelBlock( CRC_MODEL *crc, uint8_t *buf, uint32_t len ) {
+
+    while ( len-- )
+        CrcModelByte( crc, *buf++ );
+ }
+
+//*************************************************************************************************
+// Значение контрольной суммы, аналог чтения регистра CRC_SUM
+// CRC_MODEL *crc  - состояние модели
+// return uint32_t - контрольная сумма
+//*************************************************************************************************
+uint32_t CrcModelSum( CRC_MODEL *crc ) {
+
+    uint8_t bits;
+    uint32_t sum;
+
+    bits = poly_bits[crc->mode & CRC_MODEL_POLY_MASK];
+    sum = crc->sum;
+    if ( crc->mode & CRC_MODEL_RVS_SUM )
+        sum = Reverse( sum, bits );
+    if ( crc->mode & CRC_MODEL_CMPL_SUM )
+        sum = ~sum;
+    return sum & ( 0xFFFFFFFF >> ( 32 - bits ) );
+ }
+
+//*************************************************************************************************
+// Значение регистра режима CRC_MODE для типа контрольной суммы
+// CrcType type    - тип контрольной суммы
+// return uint32_t - значение CRC_MODE
+//*************************************************************************************************
+uint32_t CrcModelMode( CrcType type ) {
+
+    if ( type >= CRC_TYPE_CNT )
+        return crc_mode[CRC_TYPE_CCITT];
+    return crc_mode[type];
+ }
+
+//*************************************************************************************************
+// Начальное значение регистра CRC_SEED для типа контрольной суммы
+// CrcType type    - тип контрольной суммы
+// return uint32_t - значение CRC_SEED
+//*************************************************************************************************
+uint32_t CrcModelInitVal( CrcType type ) {
+
+    if ( type >= CRC_TYPE_CNT )
+        return crc_seed[CRC_TYPE_CCITT];
+    return crc_seed[type];
+ }
+
+//*************************************************************************************************
+// Изменение порядка бит на обратный
+// uint32_t value  - исходное значение
+// uint8_t bits    - кол-во младших разрядов для обработки
+// return uint32_t - значение с обратным порядком бит
+//*************************************************************************************************
+static uint32_t Reverse( uint32_t value, uint8_t bits ) {
+
+    uint8_t i;
+    uint32_t result = 0;
+
+    for ( i = 0; i < bits; i++, value >>= 1 )
+        result = ( result << 1 ) | ( value & 0x01 );
+    return result;
+ }
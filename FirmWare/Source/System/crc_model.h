@@ -0,0 +1,47 @@
+
+#ifndef __CRC_MODEL_H
+#define __CRC_MODEL_H
+
+#include <stdint.h>
+
+//Биты регистра режима CRC_MODE (совпадают с аппаратным блоком CRC LPC177x)
+#define CRC_MODEL_POLY_CCITT    0x00        //полином 0x1021
+#define CRC_MODEL_POLY_16       0x01        //полином 0x8005
+#define CRC_MODEL_POLY_32       0x02        //полином 0x04C11DB7
+#define CRC_MODEL_POLY_MASK     0x03        //маска выбора полинома
+#define CRC_MODEL_RVS_WR        0x04        //обратный порядок бит записываемого байта
+#define CRC_MODEL_CMPL_WR       0x08        //инверсия записываемого байта
+#define CRC_MODEL_RVS_SUM       0x10        //обратный порядок бит контрольной суммы
+#define CRC_MODEL_CMPL_SUM      0x20        //инверсия контрольной суммы
+
+//Типы контрольных сумм
+typedef enum {
+    CRC_TYPE_CCITT,                         //CRC-16/CCITT (0x1021, начальное 0xFFFF)
+    CRC_TYPE_16,                            //CRC-16 (0x8005, отраженный, начальное 0x0000)
+    CRC_TYPE_MODBUS,                        //CRC-16 MODBUS (0x8005, отраженный, начальное 0xFFFF)
+    CRC_TYPE_32,                            //CRC-32 (0x04C11DB7, отраженный, инверсия результата)
+    CRC_TYPE_CNT                            //кол-во типов
+ } CrcType;
+
+//Состояние программной модели блока CRC
+typedef struct {
+    uint32_t mode;                          //режим, аналог регистра CRC_MODE
+    uint32_t sum;                           //внутренний регистр сдвига
+ } CRC_MODEL;
+
+//*************************************************************************************************
+// Функции управления
+//*************************************************************************************************
+void CrcModelInit( CRC_MODEL *crc, CrcType type );
+void CrcModelSeed( CRC_MODEL *crc, uint32_t seed );
+void CrcModelByte( CRC_MODEL *crc, uint8_t data );
+void CrcModelBlock( CRC_MODEL *crc, uint8_t *buf, uint32_t len );
+uint32_t CrcModelSum( CRC_MODEL *crc );
+
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t CrcModelMode( CrcType type );
+uint32_t CrcModelInitVal( CrcType type );
+
+#endif
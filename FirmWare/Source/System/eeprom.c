@@ -21,12 +21,14 @@
 #include "rtc.h"
 #include "scheduler.h"
 #include "outinfo.h"
+#include "crc_hw.h"
 
 //*************************************************************************************************
 // Локальные константы
 //*************************************************************************************************
 #define EEPROM_PAGE_PIN         0           //номер блока для хранения состояния выходов управления
 #define EEPROM_PAGE_CFG         1           //номер блока для хранения настроек
+#define EEPROM_PAGE_CRC         4           //кол-во блоков читаемых за один раз при расчете CRC
 
 //кол-во блоков для хранения настроек
 #define CFG_BLOCK               (uint16_t)( ( sizeof( CONFIG ) / EEPROM_PAGE_SIZE ) + 1 )
@@ -43,11 +45,14 @@ static uint8_t ee_flg = false;              //признак изменения
                                             //еще не выполнено
 static uint8_t cfg_buff[CFG_SIZE];          //буфер параметров настройки
 static uint8_t ee_value[EEPROM_PAGE_SIZE];  //буфер параметров выходов управления
+static uint32_t cfg_gen = 0;                //номер версии настроек, увеличивается при изменении
+static uint32_t cfg_hash = 0;               //контрольная сумма настроек (CRC32)
 
 //*************************************************************************************************
 // Прототипы локальных функций
 //*************************************************************************************************
 static void ConfigSaveFile( void );
+static void ConfigVersion( void );
 
 //*************************************************************************************************
 // Инициализация EEPROM памяти, чтение состояния выходов и настроек
@@ -64,6 +69,7 @@ void EepromInit( void ) {
     ConfigClear();
     EEPROM_Read( 0, EEPROM_PAGE_CFG, (uint8_t*)&cfg_buff, MODE_8_BIT, CFG_SIZE );
     memcpy( (uint8_t *)&config, cfg_buff, sizeof( CONFIG ) ); 
+    ConfigVersion();
  }
 
 //*************************************************************************************************
@@ -110,6 +116,26 @@ void EepromClear( uint8_t page ) {
        }
  }
 
+//*************************************************************************************************
+// Расчет контрольной суммы всей памяти EEPROM
+// CrcType type    - тип контрольной суммы
+// return uint32_t - контрольная сумма
+//*************************************************************************************************
+uint32_t EepromCrc( CrcType type ) {
+
+    uint8_t page, data[EEPROM_PAGE_SIZE * EEPROM_PAGE_CRC];
+    uint32_t crc;
+    CRC_HW_CTX ctx;
+
+    CrcHwStart( &ctx, type );
+    for ( page = 0; page < EEPROM_PAGE_NUM; page += EEPROM_PAGE_CRC ) {
+        EEPROM_Read( 0, page, (uint8_t*)&data, MODE_8_BIT, sizeof( data ) );
+        CrcHwAdd( &ctx, data, sizeof( data ) );
+       }
+    CrcHwEnd( &ctx, &crc );
+    return crc;
+ }
+
 //*************************************************************************************************
 // Обнуление значений всех настроек в RAM
 //*************************************************************************************************
@@ -117,6 +143,7 @@ void ConfigClear( void ) {
 
     memset( cfg_buff, 0x00, sizeof( cfg_buff ) ); 
     memcpy( &config, cfg_buff, sizeof( CONFIG ) ); 
+    ConfigVersion();
  }
 
 //*************************************************************************************************
@@ -128,6 +155,8 @@ void ConfigSave( void ) {
     memcpy( cfg_buff, &config, sizeof( CONFIG ) ); 
     EEPROM_Write( 0, EEPROM_PAGE_CFG, (uint8_t*)&cfg_buff, MODE_8_BIT, CFG_SIZE );
     ConfigSaveFile();
+    //настройки могут изменяться без ConfigSet()
+    ConfigVersion();
  }
 
 //*************************************************************************************************
@@ -291,6 +320,7 @@ void ConfigSet( ConfigParam id_par, ConfigValSet *value ) {
     //режим логирования файлов 0/1 - [каталог\файл]/[\каталог\YYYYMM\файл]
     if ( id_par == CFG_MODE_LOGGING )
         config.mode_logging = value->uint8;
+    ConfigVersion();
  }
 
 //*************************************************************************************************
@@ -339,4 +369,37 @@ void ConfigLoad( void ) {
     config.spa_temperature   = 12;
     config.spa_slope         = 0;
     config.spa_azm_rotation  = 0;
+    ConfigVersion();
+ }
+
+//*************************************************************************************************
+// Возвращает номер версии настроек
+// return uint32_t - номер версии, увеличивается при каждом изменении значений настроек
+//*************************************************************************************************
+uint32_t ConfigGen( void ) {
+
+    return cfg_gen;
+ }
+
+//*************************************************************************************************
+// Возвращает контрольную сумму значений настроек
+// return uint32_t - контрольная сумма CRC32 структуры настроек
+//*************************************************************************************************
+uint32_t ConfigHash( void ) {
+
+    return cfg_hash;
+ }
+
+//*************************************************************************************************
+// Расчет контрольной суммы настроек, при изменении контрольной суммы увеличивается номер версии
+//*************************************************************************************************
+static void ConfigVersion( void ) {
+
+    uint32_t hash;
+
+    hash = CrcHwCalc( CRC_TYPE_32, (uint8_t *)&config, sizeof( CONFIG ) );
+    if ( hash == cfg_hash && cfg_gen )
+        return;
+    cfg_hash = hash;
+    cfg_gen++;
  }
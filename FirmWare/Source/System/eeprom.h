@@ -8,6 +8,7 @@
 
 #include "device.h"
 #include "dev_param.h"
+#include "crc_model.h"
 
 //режим сохранения/восстановления параметра
 typedef enum {
@@ -34,6 +35,7 @@ typedef enum {
 void EepromInit( void );
 void EepromSave( void );
 void EepromClear( uint8_t page );
+uint32_t EepromCrc( CrcType type );
 uint8_t EepromLoad( EepromParam id_param );
 void EepromUpdate( EepromParam id_param, uint8_t value );
 void ConfigClear( void );
@@ -41,4 +43,10 @@ void ConfigLoad( void );
 void ConfigSet( ConfigParam id_par, ConfigValSet *value );
 void ConfigSave( void );
 
+//*************************************************************************************************
+// Функции статуса/состояния
+//*************************************************************************************************
+uint32_t ConfigGen( void );
+uint32_t ConfigHash( void );
+
 #endif
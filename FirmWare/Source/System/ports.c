@@ -43,7 +43,7 @@ typedef enum {
 // Локальные переменные
 //*************************************************************************************************
 PORTS ports;
-static uint8_t step = 0, wait = 0;
+static uint8_t step = 0;
 static uint32_t result_scan, scan1, scan2;
 static uint16_t led_mode, led_divide;
 
@@ -95,20 +95,11 @@ void PortsInit( void ) {
 //*************************************************************************************************
 static void TaskPorts( void *pvParameters ) {
 
-    uint32_t msg;
-    
     for ( ;; ) {
         ScanData(); //сканирования портов ввода
         WDTReset(); //перезапуск WDT
         LedBlink(); //контрольный индикатор
-        if ( wait++ > 10 ) {
-            wait = 0;
-            //отправка данных с интервалом 200 msec
-            //при изменении интервала, в модуле HMI необходимо
-            //изменить время отсутствия CAN пакетов
-            msg = ID_DEV_PORTS;
-            osMessageQueuePut( hmi_msg, &msg, 0, 0 ); 
-           }
+        //данные портов передаются в HMI периодически по подписке (can_data.c)
         osDelay( 20 );
        }
  }
@@ -5,8 +5,8 @@
 //CMSIS NXP
 #define PRIORITY_TIMER          1
 
-#define SUB_PRIORITY_TIMER0     0
-#define SUB_PRIORITY_TIMER1     1
+#define SUB_PRIORITY_TIMER0     0       //задержка переключения RTS RS485 (MAX3100)
+#define SUB_PRIORITY_TIMER1     1       //интервалы тишины 1.5/3.5 байта RS485 (MODBUS RTU)
 #define SUB_PRIORITY_TIMER2     2       //прерывание через 125 usec, F = 4 KHz, T = 250 usec
 
 //CMSIS NXP
@@ -15,14 +15,17 @@
 
 #include "ssp_lpc17xx.h"
 #include "lpc177x_8x_gpio.h"
+#include "lpc177x_8x_timer.h"
 
 #include "rtc.h"
 #include "rs485.h"
+#include "crc16.h"
 #include "max3100.h"
 #include "ports.h"
 #include "command.h"
 #include "modbus.h"
 #include "priority.h"
+#include "config.h"
 #include "events.h"
 
 //*************************************************************************************************
@@ -35,8 +38,33 @@ extern ARM_DRIVER_SPI Driver_SPI1;
 //*************************************************************************************************
 #define BUFFER_SIZE         256             //размер приемного/передающего буфера
 
-#define DELAY_RTS           600U            //задержка выкл сигнала RTS после начала передачи
-                                            //последнего байта (usec)
+//код скорости обмена MAX3100
+#if _RS485_BAUD == 9600
+    #define RS485_BAUD_CFG  BAUD_9600
+#elif _RS485_BAUD == 19200
+    #define RS485_BAUD_CFG  BAUD_19200
+#elif _RS485_BAUD == 38400
+    #define RS485_BAUD_CFG  BAUD_38400
+#elif _RS485_BAUD == 57600
+    #define RS485_BAUD_CFG  BAUD_57600
+#elif _RS485_BAUD == 115200
+    #define RS485_BAUD_CFG  BAUD_115200
+#else
+    #error "RS485: недопустимое значение _RS485_BAUD"
+#endif
+
+#define CHAR_TIME           ( ( 10 * 1000000UL ) / _RS485_BAUD )  //время передачи одного байта (usec)
+
+//интервалы тишины MODBUS RTU, для скоростей выше 19200 используются фиксированные значения
+#if _RS485_BAUD > 19200
+    #define SILENCE_T15     750UL           //1.5 байта - максимальный интервал внутри пакета (usec)
+    #define SILENCE_T35     1750UL          //3.5 байта - признак окончания пакета (usec)
+#else
+    #define SILENCE_T15     ( ( CHAR_TIME * 3 ) / 2 )
+    #define SILENCE_T35     ( ( CHAR_TIME * 7 ) / 2 )
+#endif
+#define DELAY_RTS           ( ( _RS485_RTS_BITS * 1000000UL ) / _RS485_BAUD ) //задержка выкл сигнала RTS
+                                            //после начала передачи последнего байта (usec)
 
 #define IRQ_485_PIN         18              //номер бита прерывания от MAX3100
 #define IRQ_485_MASK        (1 << 18)       //маска бита прерывания от MAX3100
@@ -48,9 +76,17 @@ extern ARM_DRIVER_SPI Driver_SPI1;
 ARM_DRIVER_SPI *SpiDrv1;
 
 static bool flg_rts = false;
+static volatile bool frame_done = false, frame_gap15 = false;
 static uint16_t len_send, recv_ind, send_ind, pack_len = 0;
+static uint16_t send_len = 0;           //размер пакета для передачи, передача запускается задачей
+static uint16_t send_seq = 0;           //номер запроса пакета для передачи
+static uint16_t recv_seq = 0;           //номер запроса на который принимается ответ
+static uint16_t recv_crc = CRC16_INIT;  //CRC принятых байт, рассчитывается по мере приема
 static uint8_t recv_buffer[BUFFER_SIZE];
 static uint8_t send_buffer[BUFFER_SIZE];
+static uint32_t recv_burst = 0, recv_event = 0; //кол-во принятых байт и событий приема
+static uint32_t rts_last = 0, rts_min = UINT32_MAX, rts_max = 0; //время переключения RTS (usec)
+static uint32_t frame_hint = 0, frame_silence = 0, frame_err15 = 0; //статистика приема пакетов
 static osEventFlagsId_t rs485_event;
 
 //*************************************************************************************************
@@ -70,6 +106,9 @@ static const osEventFlagsAttr_t evn_attr = { .name = "Rs485" };
 static void ClearSend( void );
 static void SendConfig( uint16_t data );
 static void Mode485Recv( void );
+static void RtsOff( void );
+static void FrameDone( void );
+static void SendStart( void );
 static void IRQ_RS485( void );
 static uint16_t RecvData( void );
 static void SendData( uint8_t data );
@@ -81,6 +120,10 @@ static void TaskRs485( void *pvParameters );
 //*************************************************************************************************
 void RS485Init( void ) {
 
+    TIM_TIMERCFG_Type TimerCfg0;
+    TIM_MATCHCFG_Type TimerMath0;
+    TIM_MATCHCFG_Type TimerMath1;
+
     ClearSend();
     ClearRecv();
     //очередь сообщений
@@ -100,13 +143,78 @@ void RS485Init( void ) {
     //настройка прерывания
     NVIC_SetPriority( GPIO_IRQn, NVIC_EncodePriority( NVIC_GetPriorityGrouping(), PRIORITY_GPIO, 0 ) );
     NVIC_EnableIRQ( GPIO_IRQn );
+    //инициализация таймера "0", задержка переключения RTS, счет в микросекундах
+    //таймер запускается по прерыванию IRQ_MASK_T после загрузки последнего байта
+    TimerCfg0.PrescaleOption = TIM_PRESCALE_USVAL;
+    TimerCfg0.PrescaleValue = 1;
+    TimerMath0.MatchChannel = 0;
+    TimerMath0.MatchValue = DELAY_RTS;
+    TimerMath0.IntOnMatch = ENABLE;
+    TimerMath0.StopOnMatch = DISABLE;   //счет продолжается для измерения фактического 
+    TimerMath0.ResetOnMatch = DISABLE;  //времени переключения RTS
+    TimerMath0.ExtMatchOutputType = TIM_EXTMATCH_NOTHING;
+    TIM_Init( LPC_TIM0, TIM_TIMER_MODE, &TimerCfg0 );
+    TIM_ConfigMatch( LPC_TIM0, &TimerMath0 );
+    NVIC_SetPriority( TIMER0_IRQn, NVIC_EncodePriority( NVIC_GetPriorityGrouping(), PRIORITY_TIMER, SUB_PRIORITY_TIMER0 ) );
+    NVIC_EnableIRQ( TIMER0_IRQn );
+    //инициализация таймера "1", контроль интервалов тишины между байтами принимаемого 
+    //пакета, таймер перезапускается при приеме каждого байта
+    //MR0 - 3.5 байта - пакет принят, MR1 - 1.5 байта - пакет не должен продолжаться
+    TIM_Init( LPC_TIM1, TIM_TIMER_MODE, &TimerCfg0 );
+    TimerMath1.MatchChannel = 0;
+    TimerMath1.MatchValue = SILENCE_T35;
+    TimerMath1.IntOnMatch = ENABLE;
+    TimerMath1.StopOnMatch = ENABLE;
+    TimerMath1.ResetOnMatch = DISABLE;
+    TimerMath1.ExtMatchOutputType = TIM_EXTMATCH_NOTHING;
+    TIM_ConfigMatch( LPC_TIM1, &TimerMath1 );
+    TimerMath1.MatchChannel = 1;
+    TimerMath1.MatchValue = SILENCE_T15;
+    TimerMath1.StopOnMatch = DISABLE;
+    TIM_ConfigMatch( LPC_TIM1, &TimerMath1 );
+    NVIC_SetPriority( TIMER1_IRQn, NVIC_EncodePriority( NVIC_GetPriorityGrouping(), PRIORITY_TIMER, SUB_PRIORITY_TIMER1 ) );
+    NVIC_EnableIRQ( TIMER1_IRQn );
     //включаем режим приема MAX3100, RTS=0
     Mode485Recv();                  
     //конфигурирование MAX3100, UART=19200 bps(bod*sec) 
     //19200/10 = 1920 byte*sec, 1 byte = 1/1920 = 520 us
-    //Завершение передачи - отсутствие передачи данных в течении 1,5
-    //времени передачи одного байта данных 520 * 1.5 = 780 us
-    SendConfig( BAUD_19200 | IRQ_TM | IRQ_RM | FIFO_ENABLE );
+    SendConfig( RS485_BAUD_CFG | IRQ_TM | IRQ_RM | FIFO_ENABLE );
+ }
+
+//*************************************************************************************************
+// Обработка прерывания от таймера T0 - вышло время задержки переключения RTS
+// Переключение RTS выполняется в задаче "Rs485", т.к. порт SPI1 используется задачей
+//*************************************************************************************************
+void TIMER0_IRQHandler( void ) {
+
+    if ( TIM_GetIntStatus( LPC_TIM0, TIM_MR0_INT ) == SET )
+        TIM_ClearIntPending( LPC_TIM0, TIM_MR0_INT );
+    osEventFlagsSet( rs485_event, EVN_RS485_RTS );
+ }
+
+//*************************************************************************************************
+// Обработка прерывания от таймера T1 - интервалы тишины на линии после приема последнего байта
+// MR1 - прошло 1.5 байта, прием следующего байта пакета является ошибкой
+// MR0 - прошло 3.5 байта, пакет принят полностью
+//*************************************************************************************************
+void TIMER1_IRQHandler( void ) {
+
+    uint32_t msg;
+
+    if ( TIM_GetIntStatus( LPC_TIM1, TIM_MR1_INT ) == SET ) {
+        TIM_ClearIntPending( LPC_TIM1, TIM_MR1_INT );
+        frame_gap15 = true;
+       }
+    if ( TIM_GetIntStatus( LPC_TIM1, TIM_MR0_INT ) == SET ) {
+        TIM_ClearIntPending( LPC_TIM1, TIM_MR0_INT );
+        TIM_Cmd( LPC_TIM1, DISABLE );
+        if ( frame_done == false && recv_ind ) {
+            frame_done = true;
+            frame_silence++;
+            msg = MSG_MODBUS_RECV | recv_seq; //пакет получен полностью
+            osMessageQueuePut( modbus_queue, &msg, 0, 0 );
+           }
+       }
  }
 
 //*************************************************************************************************
@@ -132,26 +240,50 @@ static void TaskRs485( void *pvParameters ) {
     for ( ;; ) {
         //ждем события от прерывания
         event = osEventFlagsWait( rs485_event, EVN_RS485_MASK, osFlagsWaitAny, osWaitForever );
-        if ( event == EVN_RS485_IRQ )
+        if ( event & osFlagsError )
+            continue;
+        if ( event & EVN_RS485_RTS )
+            RtsOff();
+        if ( event & EVN_RS485_SEND )
+            SendStart();
+        if ( event & EVN_RS485_IRQ )
             IRQ_RS485();
        }
  }
 
+//*************************************************************************************************
+// Запуск передачи пакета подготовленного RS485Send(), выполняется задачей "Rs485", т.к. все
+// обращения к MAX3100 через порт SPI1 выполняются только задачей
+// Первый байт сразу переходит в сдвиговый регистр передатчика, буфер передатчика освобождается
+// (флаг T) и по прерыванию IRQ_MASK_T загружается следующий байт до окончания передачи первого,
+// далее по одному байту на каждое прерывание IRQ_MASK_T
+//*************************************************************************************************
+static void SendStart( void ) {
+
+    if ( !send_len )
+        return;
+    ClearRecv();
+    recv_seq = send_seq;                    //принимаемые данные относятся к этому запросу
+    send_ind = 0;
+    len_send = send_len - 1;                //первый байт передаем сразу
+    flg_rts = true;                         //признак запуска передачи
+    SendData( send_buffer[send_ind++] );    //инициируем начало передачи данных
+ }
+
 //*************************************************************************************************
 // Обработка внешнего прерывания IRQ_485 от MAX3100
 //*************************************************************************************************
 static void IRQ_RS485( void ) {
 
-    uint16_t stat;
-    uint32_t msg, tick, timeout;
+    uint16_t stat, cnt;
+    uint32_t msg;
 
     stat = RecvData();
-    timeout = DELAY_RTS * ( osKernelGetSysTimerFreq() / 960000U );
     //проверим наличие флагов прерывания MAX3100
     if ( stat & IRQ_MASK_T ) {
         //передача одного байта завершена, прерывание формируется сразу после передачи 
         //байта в буфер передатчика, т.е. в начале передачи. Переключение сигнала RTS 
-        //(переход на прием) надо выполнить с задержкой DELAY_RTS после появления IRQ
+        //(переход на прием) выполняется по таймеру T0 с задержкой DELAY_RTS после появления IRQ
         if ( len_send ) {
             len_send--; //есть еще данные для передачи
             SendData( send_buffer[send_ind++] ); //передача следующего байта
@@ -160,29 +292,57 @@ static void IRQ_RS485( void ) {
             //снимем флаг flg_rts, для исключения повторного входа сюда, т.к. 
             //IRQ_MASK_T (буфер передатчика пуст) остается активным после завершения передачи 
             flg_rts = false;
-            osKernelLock(); //начало критической секция кода
-            //задержка на переключение сигнала RTS после передачи последнего байта
-            tick = osKernelGetSysTimerCount();
-            while ( ( osKernelGetSysTimerCount() - tick ) < timeout );
-            Mode485Recv(); //RTS=0 - переход на прием
-            osKernelUnlock(); //окончание критической секция кода
+            //запуск таймера задержки переключения сигнала RTS
+            TIM_ResetCounter( LPC_TIM0 );
+            TIM_Cmd( LPC_TIM0, ENABLE );
            }
        }
-    if ( stat & IRQ_MASK_R ) {
-        //прием одного байта, сброс прерывания
-        if ( recv_ind < BUFFER_SIZE )
+    //прием данных, за одно событие вычитываем весь FIFO MAX3100, чтение выполняется
+    //пока флаг R=1, каждое чтение возвращает следующий байт из FIFO
+    //окончание пакета определяется по расчетному размеру (PackSize), если размер не 
+    //определен (неизвестный код функции) - по интервалу тишины 3.5 байта (таймер T1)
+    if ( ( stat & IRQ_MASK_R ) && frame_gap15 == true && recv_ind )
+        frame_err15++; //интервал между байтами пакета больше 1.5 байта
+    frame_gap15 = false;
+    for ( cnt = 0; ( stat & IRQ_MASK_R ) && cnt < BUFFER_SIZE; cnt++ ) {
+        if ( recv_ind < BUFFER_SIZE ) {
             recv_buffer[recv_ind++] = (uint8_t)( 0x00FF & stat );
+            recv_crc = CRC16Update( recv_crc, (uint8_t)( 0x00FF & stat ) );
+           }
         else ClearRecv(); //переполнение буфера
         if ( recv_ind == CNT_RECV_CHECK ) {
             pack_len = PackSize( recv_buffer ); //расчет размера пакета с ответом
-            msg = MSG_MODBUS_CHECK; //перезапуск таймера TIMEOUT_ANSWER ответа
+            msg = MSG_MODBUS_CHECK | recv_seq; //перезапуск таймера TIMEOUT_ANSWER ответа
             osMessageQueuePut( modbus_queue, &msg, 0, 0 ); 
            }
-        if ( recv_ind == pack_len ) {
-            msg = MSG_MODBUS_RECV; //пакет получен полностью
-            osMessageQueuePut( modbus_queue, &msg, 0, 0 );  
+        if ( recv_ind == pack_len && frame_done == false ) {
+            FrameDone(); //пакет получен полностью
+            frame_hint++;
            }
+        stat = RecvData(); //следующий байт из FIFO
+       }
+    if ( cnt && frame_done == false ) {
+        //перезапуск таймера контроля интервалов тишины
+        TIM_Cmd( LPC_TIM1, DISABLE );
+        TIM_ResetCounter( LPC_TIM1 );
+        TIM_Cmd( LPC_TIM1, ENABLE );
        }
+    recv_burst += cnt;
+    if ( cnt )
+        recv_event++;
+ }
+
+//*************************************************************************************************
+// Завершение приема пакета по расчетному размеру, таймер интервалов тишины останавливается
+//*************************************************************************************************
+static void FrameDone( void ) {
+
+    uint32_t msg;
+
+    TIM_Cmd( LPC_TIM1, DISABLE );
+    frame_done = true;
+    msg = MSG_MODBUS_RECV | recv_seq;
+    osMessageQueuePut( modbus_queue, &msg, 0, 0 );
  }
 
 //*************************************************************************************************
@@ -200,7 +360,12 @@ static void ClearSend( void ) {
 //*************************************************************************************************
 void ClearRecv( void ) {
 
+    TIM_Cmd( LPC_TIM1, DISABLE );
+    frame_done = false;
+    frame_gap15 = false;
+    pack_len = 0;
     recv_ind = 0;
+    recv_crc = CRC16Init();
     memset( recv_buffer, 0x00, sizeof( recv_buffer ) );
  }
 
@@ -233,6 +398,24 @@ static void Mode485Recv( void ) {
     SpiDrv1->Control( ARM_SPI_CONTROL_SS, ARM_SPI_SS_INACTIVE );
  }
 
+//*************************************************************************************************
+// Выключение режима передачи по таймеру T0, фиксация фактического времени переключения RTS
+//*************************************************************************************************
+static void RtsOff( void ) {
+
+    uint32_t time;
+
+    Mode485Recv(); //RTS=0 - переход на прием
+    //время от начала передачи последнего байта
+    time = LPC_TIM0->TC;
+    TIM_Cmd( LPC_TIM0, DISABLE );
+    rts_last = time;
+    if ( time < rts_min )
+        rts_min = time;
+    if ( time > rts_max )
+        rts_max = time;
+ }
+
 //*************************************************************************************************
 // Передача 1 байта данных в MAX3100
 // uint8_t data - данные для передачи
@@ -268,8 +451,9 @@ static uint16_t RecvData( void ) {
 // uint8_t *data  - адрес блока данных для передачи
 // uint16_t len   - размер передаваемых данных для двоичного режима
 // RS485Mode mode - режим передачи данных текстовый/двоичный
+// uint16_t seq   - номер запроса, передается в сообщениях задаче "Modbus" о приеме ответа
 //*************************************************************************************************
-RS485StatSend RS485Send( uint8_t *data, uint16_t len, RS485Mode mode ) {
+RS485StatSend RS485Send( uint8_t *data, uint16_t len, RS485Mode mode, uint16_t seq ) {
 
     if ( data == NULL )
         return RS485_SEND_ERR;          //не указан размер данных для передачи
@@ -279,13 +463,12 @@ RS485StatSend RS485Send( uint8_t *data, uint16_t len, RS485Mode mode ) {
         len = strlen( (char *)data );   //только для текстового режима
     if ( len >= BUFFER_SIZE )
         return RS485_SEND_FULL;         //превышение размера буфера
-    //включаем режим передачи
-    ClearSend();
-    ClearRecv();
-    memcpy( send_buffer, data, len );    //буфер пустой, передаем "0" в кол-ве len
-    flg_rts = true;                      //признак запуска передачи  
-    len_send = len-1;                    //первый байт уже передали
-    SendData( send_buffer[send_ind++] ); //инициируем начало передачи данных
+    //подготовка буфера, передачу запускает задача "Rs485", счетчики передачи
+    //изменяются только задачей
+    memcpy( send_buffer, data, len );
+    send_len = len;
+    send_seq = seq;
+    osEventFlagsSet( rs485_event, EVN_RS485_SEND );
     return RS485_SEND_OK;
  }
 
@@ -305,3 +488,71 @@ uint8_t *RS485Recv( uint16_t *len ) {
     *len = recv_ind;
     return recv_buffer;
  }
+
+//*************************************************************************************************
+// Возвращает результат проверки КС принятого пакета, CRC рассчитывается по мере приема байт
+// включая два байта CRC пакета, для пакета без ошибок результат равен 0
+// return uint16_t - остаток CRC, 0 - КС пакета совпадает
+//*************************************************************************************************
+uint16_t RS485RecvCRC( void ) {
+
+    return CRC16Final( recv_crc );
+ }
+
+//*************************************************************************************************
+// Возвращает среднее кол-во байт принятых за одно событие прерывания от MAX3100
+// return uint32_t - среднее кол-во байт * 100
+//*************************************************************************************************
+uint32_t RS485RecvBurst( void ) {
+
+    if ( !recv_event )
+        return 0;
+    return ( recv_burst * 100 ) / recv_event;
+ }
+
+//*************************************************************************************************
+// Возвращает параметры времени переключения RTS (переход на прием) отсчитываемого от начала 
+// передачи последнего байта пакета. Шина освобождена своевременно если время переключения 
+// не превышает удвоенного времени передачи одного байта
+// RS485Turn type  - тип параметра
+// return uint32_t - значение в микросекундах
+//*************************************************************************************************
+uint32_t RS485Turnaround( RS485Turn type ) {
+
+    if ( type == RS485_TURN_LAST )
+        return rts_last;
+    if ( type == RS485_TURN_MIN )
+        return rts_min == UINT32_MAX ? 0 : rts_min;
+    if ( type == RS485_TURN_MAX )
+        return rts_max;
+    if ( type == RS485_TURN_CHAR )
+        return CHAR_TIME;
+    return 0;
+ }
+
+//*************************************************************************************************
+// Возвращает статистику определения окончания принимаемых пакетов
+// RS485Frame type - тип параметра
+// return uint32_t - значение счетчика
+//*************************************************************************************************
+uint32_t RS485FrameStat( RS485Frame type ) {
+
+    if ( type == RS485_FRAME_HINT )
+        return frame_hint;
+    if ( type == RS485_FRAME_SILENCE )
+        return frame_silence;
+    if ( type == RS485_FRAME_GAP15 )
+        return frame_err15;
+    return 0;
+ }
+
+//*************************************************************************************************
+// Обнуление статистики приема и переключения RTS
+//*************************************************************************************************
+void RS485StatClr( void ) {
+
+    recv_burst = recv_event = 0;
+    frame_hint = frame_silence = frame_err15 = 0;
+    rts_last = rts_max = 0;
+    rts_min = UINT32_MAX;
+ }
@@ -12,6 +12,21 @@ typedef enum {
     RS485_SEND_ASCII                        //режим текстовый передачи
  } RS485Mode;
 
+//Параметры времени переключения RTS
+typedef enum {
+    RS485_TURN_LAST,                        //последнее измеренное значение
+    RS485_TURN_MIN,                         //минимальное значение
+    RS485_TURN_MAX,                         //максимальное значение
+    RS485_TURN_CHAR                         //время передачи одного байта
+ } RS485Turn;
+
+//Статистика приема пакетов
+typedef enum {
+    RS485_FRAME_HINT,                       //кол-во пакетов завершенных по расчетному размеру
+    RS485_FRAME_SILENCE,                    //кол-во пакетов завершенных по интервалу тишины 3.5 байта
+    RS485_FRAME_GAP15                       //кол-во нарушений интервала 1.5 байта внутри пакета
+ } RS485Frame;
+
 //Коды возврата функции "RS485Send"
 typedef enum {
     RS485_SEND_OK,                          //Функция выполнена
@@ -25,7 +40,12 @@ typedef enum {
 //*************************************************************************************************
 void RS485Init( void );
 void ClearRecv( void );
-RS485StatSend RS485Send( uint8_t *data, uint16_t len, RS485Mode mode );
+void RS485StatClr( void );
+RS485StatSend RS485Send( uint8_t *data, uint16_t len, RS485Mode mode, uint16_t seq );
 uint8_t *RS485Recv( uint16_t *len );
+uint16_t RS485RecvCRC( void );
+uint32_t RS485RecvBurst( void );
+uint32_t RS485Turnaround( RS485Turn type );
+uint32_t RS485FrameStat( RS485Frame type );
 
 #endif
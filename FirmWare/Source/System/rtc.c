@@ -28,6 +28,7 @@
 #include "informing.h"
 #include "priority.h"
 #include "hmi_can.h"
+#include "rollup.h"
 #include "events.h"
 
 //*************************************************************************************************
@@ -43,7 +44,7 @@ static char * const dows_short[] = { "Вск", "Пон", "Втр", "Срд", "Ч
 //*************************************************************************************************
 static const osThreadAttr_t rtc_attr = {
     .name = "Rtc",
-    .stack_size = 256,
+    .stack_size = 512,
     .priority = osPriorityNormal
  };
          
@@ -91,7 +92,6 @@ void RTC_IRQHandler( void ) {
 //*************************************************************************************************
 static void TaskRtc( void *pvParameters ) {
 
-    uint32_t msg;
     RTC_TIME_Type Time;
 
     for ( ;; ) {
@@ -124,24 +124,18 @@ static void TaskRtc( void *pvParameters ) {
             osEventFlagsSet( out_event, EVN_RTC_SECONDS );          //вывод данных устройств по шаблону на консоль
         if ( charge_event != NULL )
             osEventFlagsSet( charge_event, EVN_RTC_SECONDS );       //передача данных, контроль тока заряда
-        if ( info_event != NULL )
-            osEventFlagsSet( info_event, EVN_RTC_SECONDS );         //запрос состояния голосового информатора 
         if ( inv1_event != NULL )                                   //проверка ручного режима вкл/выкл инвертора TS-1000-224
             osEventFlagsSet( inv1_event, EVN_RTC_SECONDS );         //передача данных в HMI
         if ( inv2_event != NULL )                                   //проверка ручного режима вкл/выкл инвертора TS-3000-224
             osEventFlagsSet( inv2_event, EVN_RTC_SECONDS );         //передача данных в HMI
-        msg = ID_DEV_RTC;
-        if ( hmi_msg != NULL )                                      //передача данных часов в HMI
-            osMessageQueuePut( hmi_msg, &msg, 0, 0 );
-        msg = ID_DEV_VOICE;
-        if ( hmi_msg != NULL )                                      //передача состояния голосового информатора
-            osMessageQueuePut( hmi_msg, &msg, 0, 0 );
+        //данные часов и голосового информатора передаются в HMI периодически по подписке (can_data.c)
         if ( !Time.SEC ) {
             //передача событий задачам управления с интервалом 1 минута
             if ( trc_event != NULL )
                 osEventFlagsSet( trc_event, EVN_RTC_1MINUTES );     //управление контроллером трекера
             if ( soc_event != NULL )
                 osEventFlagsSet( soc_event, EVN_RTC_1MINUTES );     //Контролирует минимальный уровень заряда АКБ (SOC)
+            RollupTick();                                           //завершение периодов итогов
            }
         if ( !Time.SEC && !( Time.MIN % 5 ) ) {
             //передача событий задачам управления с интервалом 5 минут
@@ -251,32 +245,9 @@ char *RTCGetLog( void ) {
 //*************************************************************************************************
 Status RTCSetTime( char *param ) {
 
-    uint8_t hour, min, sec, idx, chk = 0;
-    char *mask = NULL, mask1[] = "NN:NN", mask2[] = "NN:NN:NN";
+    uint8_t hour, min, sec;
 
-    //тип формата
-    if ( strlen( param ) == 5 )
-        mask = mask1;
-    if ( strlen( param ) == 8 )
-        mask = mask2;
-    if ( mask == NULL )
-        return ERROR;
-    //проверка формата
-    for ( idx = 0; idx < strlen( mask ); idx++ ) {
-        if ( mask[idx] == 'N' && isdigit( *(param+idx) ) )
-            chk++;
-        if ( mask[idx] == ':' && ispunct( *(param+idx) ) )
-            chk++;
-       } 
-    if ( chk != strlen( mask ) )
-        return ERROR;
-    //проверка значений
-    hour = atoi( param );
-    min = atoi( param + 3 );
-    if ( strlen( param ) == 8 )
-        sec = atoi( param + 6 );
-    else sec = 0;
-    if ( hour > 23 || min > 59 || sec > 59 )
+    if ( CheckTime( param, &hour, &min, &sec ) == ERROR )
         return ERROR;
     RTC_SetTime( LPC_RTC, RTC_TIMETYPE_HOUR, hour );
     RTC_SetTime( LPC_RTC, RTC_TIMETYPE_MINUTE, min );
@@ -433,6 +404,45 @@ static uint16_t DayOfYear( int day, int month, int year ) {
     return day;
  }
 
+//*************************************************************************************************
+// Проверяет формат времени в "value" по маске HH:MM или HH:MM:SS (00-23:00-59:00-59)
+// return = SUCCESS - формат соответствует маске, данные заносятся в переменные: hour,min,sec
+//        = ERROR   - формат не соответствует маске
+//*************************************************************************************************
+Status CheckTime( char *value, uint8_t *hour, uint8_t *min, uint8_t *sec ) {
+
+    uint8_t idx, ch_hour, ch_min, ch_sec = 0, chk = 0;
+    char *mask = NULL, mask1[] = "NN:NN", mask2[] = "NN:NN:NN";
+
+    //тип формата
+    if ( strlen( value ) == 5 )
+        mask = mask1;
+    if ( strlen( value ) == 8 )
+        mask = mask2;
+    if ( mask == NULL )
+        return ERROR;
+    //проверка формата
+    for ( idx = 0; idx < strlen( mask ); idx++ ) {
+        if ( mask[idx] == 'N' && isdigit( *(value+idx) ) )
+            chk++;
+        if ( mask[idx] == ':' && ispunct( *(value+idx) ) )
+            chk++;
+       } 
+    if ( chk != strlen( mask ) )
+        return ERROR;
+    //проверка значений
+    ch_hour = atoi( value );
+    ch_min = atoi( value + 3 );
+    if ( strlen( value ) == 8 )
+        ch_sec = atoi( value + 6 );
+    if ( ch_hour > 23 || ch_min > 59 || ch_sec > 59 )
+        return ERROR;
+    *hour = ch_hour;
+    *min = ch_min;
+    *sec = ch_sec;
+    return SUCCESS;
+ }
+
 //*************************************************************************************************
 // Проверяет формат даты в "value" по маске DD.MM.YYYY (01-31.01-12.2000-2099)
 // return = ERROR   - формат соответствует маске, данные заносятся в переменные: day,month,year
@@ -40,5 +40,6 @@ char *RTCGetLog( void );
 char *RTCFileName( void );
 char *RTCFileShort( void );
 Status CheckDate( char *value, uint8_t *day, uint8_t *month, uint16_t *year );
+Status CheckTime( char *value, uint8_t *hour, uint8_t *min, uint8_t *sec );
 
 #endif
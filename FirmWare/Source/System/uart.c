@@ -21,6 +21,7 @@
 #include "uart.h"
 #include "ring_uart.h"
 #include "events.h"
+#include "modbus_slave.h"
 
 //*************************************************************************************************
 // Внешние переменные
@@ -36,11 +37,13 @@ osSemaphoreId_t uart_semaphore = NULL;
 // Локальные константы
 //*************************************************************************************************
 #define RECV_BUFF               200         //размер приемного буфера
+#define TIME_DRAIN_RING         100         //время вывода данных из кольцевого буфера (msec)
 
 //*************************************************************************************************
 // Локальные переменные
 //*************************************************************************************************
 static uint16_t recv_ind;
+static bool uart_modbus = false;
 static ARM_DRIVER_USART *USARTdrv;
 static char recv_ch, recv_buffer[RECV_BUFF];
 
@@ -107,6 +110,12 @@ static void CallBackUart( uint32_t event ) {
 
     char ch;
     
+    if ( event & ARM_USART_EVENT_RECEIVE_COMPLETE && uart_modbus == true ) {
+        //режим MODBUS, байт передаем в обработку пакета без анализа
+        ModBusSlaveRecv( recv_ch );
+        USARTdrv->Receive( &recv_ch, 1 );
+        return;
+       }
     if ( event & ARM_USART_EVENT_RECEIVE_COMPLETE ) {
         //принят один байт
         if ( recv_ch != KEY_ESC ) {
@@ -136,7 +145,7 @@ static void CallBackUart( uint32_t event ) {
             USARTdrv->Receive( &recv_ch, 1 );
            } 
         }
-    if ( event & ARM_USART_EVENT_SEND_COMPLETE ) {
+    if ( event & ARM_USART_EVENT_SEND_COMPLETE && uart_modbus == false ) {
         //передача завершена
         if ( RingGetChar( &ch ) ) {
             USARTdrv->Send( &ch, 1 );
@@ -154,7 +163,7 @@ void UartSendStr( char *str ) {
     uint16_t ind_str = 0, buf_len, str_len, tmp_len;
     
     //вывод в последовательный порт
-    if ( str == NULL || !strlen( str ) )
+    if ( str == NULL || !strlen( str ) || uart_modbus == true )
         return;
     //проверка на превышение размера буфера
     str_len = strlen( str );
@@ -190,6 +199,33 @@ void UartSendStr( char *str ) {
        }
  }
 //*************************************************************************************************
+// Передача блока двоичных данных в режиме MODBUS, данные передаются без кольцевого буфера
+// uint8_t *data - указатель на данные, буфер должен быть доступен до окончания передачи
+// uint16_t len  - кол-во байт
+//*************************************************************************************************
+void UartSendData( uint8_t *data, uint16_t len ) {
+
+    if ( uart_modbus == false || !len )
+        return;
+    USARTdrv->Send( data, len );
+ }
+
+//*************************************************************************************************
+// Переключение режима UART: консоль/ведомое уст-во MODBUS RTU
+// При включении режима MODBUS выполняется ожидание вывода данных из кольцевого буфера,
+// оставшиеся данные удаляются
+// bool mode - true - режим MODBUS, false - режим консоли
+//*************************************************************************************************
+void UartModbus( bool mode ) {
+
+    if ( mode == true )
+        osDelay( TIME_DRAIN_RING );
+    RingClear();
+    UartRecvClear();
+    uart_modbus = mode;
+ }
+
+//*************************************************************************************************
 // Возвращает адрес приемного буфера 
 // return char* - указатель на буфер
 //*************************************************************************************************
@@ -216,6 +252,8 @@ void UartSendStart( void ) {
     char ch;
     ARM_USART_STATUS stat;
     
+    if ( uart_modbus == true )
+        return; //режим MODBUS, вывод консоли не выполняется
     stat = USARTdrv->GetStatus();
     if ( stat.tx_busy ) {
         //UART занят, установим сигнал EVN_UART_BUSY
@@ -16,6 +16,8 @@
 void UartInit( void );
 void UartSendStr( char *buff );
 void UartRecvClear( void );
+void UartSendData( uint8_t *data, uint16_t len );
+void UartModbus( bool mode );
 
 //*************************************************************************************************
 // Функции статуса/состояния
@@ -0,0 +1,391 @@
+
+//*************************************************************************************************
+//
+// Проверка выбора обработчика команд HMI (FirmWare/Source/App/hmi_can.c) на host компьютере
+// Пакеты команд всех уст-в, ID параметров и ID дополнительных пакетов выполняются через
+// табличный выбор обработчика (ExecCommand()) и через прежнюю цепочку проверок (ExecCommandOld()),
+// последовательности вызовов функций уст-в должны совпадать
+// Допустимые отличия:
+// - пакеты с размером данных меньше заданного в can_cmd[] табличным выбором не выполняются
+// - команда ID_DEV_HMI/CAN_HMI_CONFIG и передача пакетов настроек после изменения параметра
+//   добавлены после перехода на таблицу, в сравнении не участвуют
+//
+//*************************************************************************************************
+
+#include <stdarg.h>
+
+#include "hmi_can.c"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define TRACE_MAX               32          //максимальное кол-во записей вызовов
+#define TRACE_LEN               48          //максимальный размер записи вызова
+#define TEST_DEV_MAX            ( ID_DEV_XFER + 2 ) //кол-во проверяемых ID уст-в
+#define TEST_PARAM_MAX          8           //кол-во проверяемых ID параметров
+#define TEST_CODE_MAX           16          //кол-во значений первого байта данных
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static char trace[TRACE_MAX][TRACE_LEN];    //вызовы функций уст-в
+static uint8_t trace_cnt;
+static uint32_t cfg_hash;                   //контрольная сумма настроек
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void ExecCommandOld( MSGQUEUE_CAN *que_cmd );
+static void Trace( const char *format, ... );
+static void StateClear( void );
+static uint8_t Replay( MSGQUEUE_CAN *seq, uint8_t cnt, bool old, char out[][TRACE_LEN] );
+static bool Compare( MSGQUEUE_CAN *seq, uint8_t cnt, bool skip_new, uint32_t *error );
+
+//*************************************************************************************************
+// Проверка всех команд
+// return = 0 - ошибок нет
+//*************************************************************************************************
+int main( void ) {
+
+    uint8_t len, dev, param, sub, code, i, min;
+    uint32_t cnt = 0, error = 0, skip = 0;
+    MSGQUEUE_CAN seq[4];
+
+    CanCmdBuild();
+    //одиночные пакеты: все уст-ва, ID параметров, ID дополнительных пакетов, размеры данных
+    for ( dev = 0; dev < TEST_DEV_MAX; dev++ ) {
+        for ( param = 0; param < TEST_PARAM_MAX; param++ ) {
+            for ( sub = 0; sub < 3; sub++ ) {
+                for ( len = 0; len <= CAN_DATA_MAX; len++ ) {
+                    for ( code = 0; code < TEST_CODE_MAX; code++ ) {
+                        memset( &seq[0], 0x00, sizeof( MSGQUEUE_CAN ) );
+                        seq[0].dev_id = (Device)dev;
+                        seq[0].param_id = (ConfigParam)param;
+                        seq[0].sub_pack_id = sub == 2 ? CAN_CONFIG_SAVE : sub;
+                        seq[0].len_data = len;
+                        for ( i = 0; i < CAN_DATA_MAX; i++ )
+                            seq[0].data[i] = i ? (uint8_t)( code * 17 + i ) : code;
+                        //для запросов MODBUS - размер данных запроса (пакет без продолжения)
+                        if ( dev == ID_DEV_MODBUS_REQ )
+                            seq[0].data[0] = len;
+                        cnt++;
+                        //команда добавленная после перехода на таблицу
+                        if ( dev == ID_DEV_HMI && param == CAN_HMI_CONFIG ) {
+                            skip++;
+                            continue;
+                           }
+                        //пакеты меньше заданного размера табличным выбором не выполняются
+                        min = 0;
+                        if ( dev <= ID_DEV_XFER && cmd_tab[dev][param < CAN_CMD_PARAM ? param : CAN_CMD_PARAM] )
+                            min = can_cmd[cmd_tab[dev][param < CAN_CMD_PARAM ? param : CAN_CMD_PARAM] - 1].len_min;
+                        if ( len < min )
+                            skip++;
+                        Compare( seq, 1, len < min, &error );
+                       }
+                   }
+               }
+           }
+       }
+    //запрос MODBUS из трех пакетов: 8 + 8 + 4 байта
+    memset( seq, 0x00, sizeof( seq ) );
+    for ( i = 0; i < 3; i++ ) {
+        seq[i].dev_id = ID_DEV_MODBUS_REQ;
+        seq[i].sub_pack_id = i;
+        seq[i].len_data = i < 2 ? CAN_DATA_MAX : 4;
+        memset( seq[i].data, 0x11 * ( i + 1 ), CAN_DATA_MAX );
+       }
+    seq[0].data[0] = 20;
+    cnt++;
+    Compare( seq, 3, false, &error );
+    //параметры настроек из двух пакетов
+    for ( param = CFG_SCR_FILE; param <= CFG_JOB_TEST; param++ ) {
+        if ( param != CFG_SCR_FILE && param != CFG_JOB_FILE && param != CFG_JOB_TEST )
+            continue;
+        for ( code = 0; code < 2; code++ ) {
+            memset( seq, 0x00, sizeof( seq ) );
+            for ( i = 0; i < 2; i++ ) {
+                seq[i].dev_id = ID_CONFIG;
+                seq[i].param_id = (ConfigParam)param;
+                seq[i].sub_pack_id = i;
+                seq[i].len_data = CAN_DATA_MAX;
+                memcpy( seq[i].data, i ? "TEST.TXT" : "JOB_FILE", CAN_DATA_MAX );
+               }
+            seq[1].data[0] += code;
+            cnt++;
+            Compare( seq, 2, false, &error );
+           }
+       }
+    printf( "CAN commands: %u sequences, %u not compared, %u errors\r\n", cnt, skip, error );
+    return error ? 1 : 0;
+ }
+
+//*************************************************************************************************
+// Выполнение последовательности пакетов прежним и табличным выбором с одинаковым начальным
+// состоянием и сравнение вызовов функций уст-в
+// MSGQUEUE_CAN *seq - пакеты
+// uint8_t cnt       - кол-во пакетов
+// bool skip_new     - табличный выбор не выполняет пакеты, вызовов быть не должно
+// uint32_t *error   - счетчик ошибок
+// return = true     - вызовы совпадают
+//*************************************************************************************************
+static bool Compare( MSGQUEUE_CAN *seq, uint8_t cnt, bool skip_new, uint32_t *error ) {
+
+    uint8_t i, cnt_old, cnt_new;
+    static char out_old[TRACE_MAX][TRACE_LEN], out_new[TRACE_MAX][TRACE_LEN];
+
+    cnt_old = Replay( seq, cnt, true, out_old );
+    cnt_new = Replay( seq, cnt, false, out_new );
+    if ( skip_new == true )
+        cnt_old = 0;
+    if ( cnt_old == cnt_new ) {
+        for ( i = 0; i < cnt_old; i++ )
+            if ( strcmp( out_old[i], out_new[i] ) )
+                break;
+        if ( i == cnt_old )
+            return true;
+       }
+    if ( ( *error )++ < 10 ) {
+        printf( "DEV=0x%02X PAR=0x%02X SUB=0x%02X LEN=%u DATA=0x%02X\r\n", seq[0].dev_id, seq[0].param_id,
+                seq[0].sub_pack_id, seq[0].len_data, seq[0].data[0] );
+        for ( i = 0; i < cnt_old || i < cnt_new; i++ )
+            printf( "  %-40s %s\r\n", i < cnt_old ? out_old[i] : "", i < cnt_new ? out_new[i] : "" );
+       }
+    return false;
+ }
+
+//*************************************************************************************************
+// Выполнение последовательности пакетов
+// MSGQUEUE_CAN *seq - пакеты
+// uint8_t cnt       - кол-во пакетов
+// bool old          - выбор обработчика: true - прежний, false - табличный
+// char out[][]      - вызовы функций уст-в
+// return uint8_t    - кол-во вызовов
+//*************************************************************************************************
+static uint8_t Replay( MSGQUEUE_CAN *seq, uint8_t cnt, bool old, char out[][TRACE_LEN] ) {
+
+    uint8_t i;
+    MSGQUEUE_CAN que_cmd;
+
+    StateClear();
+    for ( i = 0; i < cnt; i++ ) {
+        //обработчики могут изменять пакет
+        memcpy( &que_cmd, &seq[i], sizeof( que_cmd ) );
+        if ( old == true )
+            ExecCommandOld( &que_cmd );
+        else ExecCommand( &que_cmd );
+       }
+    memcpy( out, trace, sizeof( trace ) );
+    return trace_cnt;
+ }
+
+//*************************************************************************************************
+// Начальное состояние модуля перед выполнением последовательности пакетов
+//*************************************************************************************************
+static void StateClear( void ) {
+
+    trace_cnt = 0;
+    memset( trace, 0x00, sizeof( trace ) );
+    memset( str_val, 0x00, sizeof( str_val ) );
+    memset( &can_modbus, 0x00, sizeof( can_modbus ) );
+    memset( &reqst, 0x00, sizeof( reqst ) );
+    can_mbus_addr = (uint8_t *)&can_modbus;
+    can_mbus_rest = 0;
+    len_mbus_data = 0;
+ }
+
+//*************************************************************************************************
+// Добавление записи вызова функции уст-ва
+//*************************************************************************************************
+static void Trace( const char *format, ... ) {
+
+    va_list arg;
+
+    if ( trace_cnt >= TRACE_MAX )
+        return;
+    va_start( arg, format );
+    vsnprintf( trace[trace_cnt++], TRACE_LEN, format, arg );
+    va_end( arg );
+ }
+
+//*************************************************************************************************
+// Прежний выбор обработчика команды (hmi_can.c до перехода на таблицу can_cmd[])
+//*************************************************************************************************
+static void ExecCommandOld( MSGQUEUE_CAN *que_cmd ) {
+
+    uint32_t msg;
+    CAN_PV *can_pv;
+    uint8_t cnt_rpt;
+    CAN_INFO *can_info;
+    CAN_RELAY *can_rel;
+    CAN_EXT *can_ext;
+    RTC *datetime;
+    CAN_TRC *can_trc;
+    ConfigValSet cfg_set;
+
+    //Установка часов/календаря
+    if ( que_cmd->dev_id == ID_DEV_RTC && !que_cmd->param_id ) {
+        datetime = (RTC *)que_cmd->data;
+        RTCSet( datetime );
+       }
+    //Подписка HMI на данные уст-в
+    if ( que_cmd->dev_id == ID_DEV_HMI && !que_cmd->param_id && que_cmd->len_data >= sizeof( CAN_SUBSCR ) )
+        CanDataSubscr( (CAN_SUBSCR *)que_cmd->data );
+    //Управление коммутацией солнечных панелей
+    if ( que_cmd->dev_id == ID_DEV_PV && !que_cmd->param_id ) {
+        can_pv = (CAN_PV *)que_cmd->data;
+        if ( can_pv->ctrl & CAN_PV_CTRL )
+            PvControl( can_pv->ctrl, EEPROM_SAVE );
+        if ( can_pv->ctrl & CAN_PV_MODE )
+            PvSetMode( can_pv->mode, EEPROM_SAVE );
+       }
+    //Управление контроллером заряда PB-1000-224
+    if ( que_cmd->dev_id == ID_DEV_CHARGER && !que_cmd->param_id )
+        Charger( (ChargeMode)*que_cmd->data, EEPROM_SAVE );
+    //Управление инверторами TS-1000-224, TS-3000-224
+    if ( que_cmd->dev_id == ID_DEV_INV1 && !que_cmd->param_id )
+        InvCtrl( ID_DEV_INV1, (InvCtrlCmnd)*que_cmd->data );
+    if ( que_cmd->dev_id == ID_DEV_INV2 && !que_cmd->param_id )
+        InvCtrl( ID_DEV_INV2, (InvCtrlCmnd)*que_cmd->data );
+    //Управление блоком АВР
+    if ( que_cmd->dev_id == ID_DEV_ALT && !que_cmd->param_id ) {
+        if ( (CanCtrlAlt)*que_cmd->data == CAN_ALT_DC )
+            AltPowerDC();
+        if ( (CanCtrlAlt)*que_cmd->data == CAN_ALT_AC )
+            AltPowerAC();
+       }
+    //Управление генератором
+    if ( que_cmd->dev_id == ID_DEV_GEN && !que_cmd->param_id ) {
+        if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_STOP )
+            GenStop();
+        if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_START )
+            GenStart();
+        if ( (CanCtrlGen)*que_cmd->data == CAN_GEN_TEST )
+            GenTest();
+       }
+    //Управление контроллером солнечного трекера
+    if ( que_cmd->dev_id == ID_DEV_TRC && !que_cmd->param_id ) {
+        can_trc = (CAN_TRC *)que_cmd->data;
+        if ( can_trc->ctrl == CAN_TRC_POWER )
+            TRCMode( can_trc->power_act, EEPROM_SAVE );
+        if ( can_trc->ctrl == CAN_TRC_POS )
+            TrackerSetPos( can_trc->type_act, can_trc->type_value, can_trc->value );
+        if ( can_trc->ctrl == CAN_TRC_STOP )
+            TrackerCmd( EXTRC_STOP, 0, 0 );
+        if ( can_trc->ctrl == CAN_TRC_CMD )
+            TrackerCmd( EXTRC_CMD_ON, 0, 0 );
+        if ( can_trc->ctrl == CAN_TRC_INT )
+            TrackerCmd( EXTRC_CMD_OFF, 0, 0 );
+        if ( can_trc->ctrl == CAN_TRC_INIT )
+            TrackerCmd( EXTRC_VERT | EXTRC_HORZ, 0, 0 );
+        if ( can_trc->ctrl == CAN_TRC_SAVE )
+            TrackerCmd( EXTRC_SEEP, 0, 0 );
+        if ( can_trc->ctrl == CAN_TRC_REST )
+            TrackerCmd( EXTRC_REEP, 0, 0 );
+        if ( can_trc->ctrl == CAN_TRC_RESET )
+            TrackerCmd( EXTRC_RESET, 0, 0 );
+       }
+    //Управление голосовым/звуковым информатором
+    if ( que_cmd->dev_id == ID_DEV_VOICE && !que_cmd->param_id ) {
+        can_info = (CAN_INFO *)que_cmd->data;
+        if ( can_info->ctrl & CAN_VOICE )
+            Informing( can_info->voice, NULL );
+        if ( can_info->ctrl & CAN_VOLUME )
+            SetVolume( can_info->volume );
+        if ( can_info->ctrl & CAN_SOUND )
+            SoundPlay( can_info->sound, NULL );
+       }
+    //Управление дополнительными реле
+    if ( que_cmd->dev_id == ID_DEV_RESERV && !que_cmd->param_id ) {
+        can_rel = (CAN_RELAY *)que_cmd->data;
+        ReservCmnd( can_rel->relay, can_rel->mode );
+       }
+    //Управление дополнительными выходами
+    if ( que_cmd->dev_id == ID_DEV_EXTOUT && !que_cmd->param_id ) {
+        can_ext = (CAN_EXT *)que_cmd->data;
+        ExtOut( can_ext->relay, can_ext->mode );
+       }
+    //Обмен CAN -> MODBUS
+    //Прием первого пакета с данными
+    if ( que_cmd->dev_id == ID_DEV_MODBUS_REQ && !que_cmd->sub_pack_id ) {
+        can_mbus_addr = (uint8_t *)&can_modbus;
+        memset( (uint8_t *)&can_modbus, 0x00, sizeof( CAN_MODBUS ) );
+        memcpy( (uint8_t *)&can_modbus, que_cmd->data, CAN_DATA_MAX );
+        if ( can_modbus.length )
+            can_mbus_rest = can_modbus.length - que_cmd->len_data;
+        if ( !can_mbus_rest )
+            que_cmd->sub_pack_id = 1;
+        else can_mbus_addr += que_cmd->len_data;
+       }
+    //Прием следующих пакетов с данными
+    if ( que_cmd->dev_id == ID_DEV_MODBUS_REQ && que_cmd->sub_pack_id ) {
+        if ( can_mbus_rest ) {
+            memcpy( can_mbus_addr, que_cmd->data, que_cmd->len_data );
+            can_mbus_rest -= que_cmd->len_data;
+            can_mbus_addr += que_cmd->len_data;
+           }
+        if ( !can_mbus_rest ) {
+            reqst.dev_addr = can_modbus.dev_addr;
+            reqst.function = can_modbus.function;
+            reqst.addr_reg = can_modbus.addr_reg;
+            reqst.cnt_reg = can_modbus.cnt_reg;
+            reqst.ptr_data = can_modbus.mbus_data;
+            reqst.ptr_lendata = &len_mbus_data;
+            cnt_rpt = CNT_REPEAT_REQST;
+            do {
+                len_mbus_data = sizeof( can_modbus.mbus_data );
+                can_modbus.answer = ModBusRequest( &reqst );
+               } while ( cnt_rpt-- && ( can_modbus.answer == MBUS_ANSWER_CRC || can_modbus.answer == MBUS_ANSWER_TIMEOUT ) );
+            can_modbus.length = len_mbus_data + CAN_DATA_MBUS_MIN;
+            msg = ID_DEV_MODBUS_ANS;
+            osMessageQueuePut( hmi_msg, &msg, 0, 0 );
+           }
+       }
+    //сохраним команду в лог файле
+    CmdSaveLog( que_cmd );
+    //Установка значения параметра настройки
+    if ( que_cmd->dev_id == ID_CONFIG ) {
+        memset( &cfg_set, 0x00, sizeof( cfg_set ) );
+        memcpy( &cfg_set, que_cmd->data, que_cmd->len_data );
+        if ( ( que_cmd->param_id == CFG_SCR_FILE || que_cmd->param_id == CFG_JOB_FILE || que_cmd->param_id == CFG_JOB_TEST ) && que_cmd->sub_pack_id == 0 ) {
+            memset( str_val, 0x00, sizeof( str_val ) );
+            memcpy( str_val, cfg_set.uint8_array, sizeof( cfg_set.uint8_array ) );
+            return;
+           }
+        if ( ( que_cmd->param_id == CFG_SCR_FILE || que_cmd->param_id == CFG_JOB_FILE || que_cmd->param_id == CFG_JOB_TEST ) && que_cmd->sub_pack_id == 1 ) {
+            memcpy( str_val + 8, cfg_set.uint8_array, sizeof( cfg_set.uint8_array ) );
+            cfg_set.ptr = str_val;
+            if ( ConfigChkVal( que_cmd->param_id, cfg_set ) == SUCCESS ) {
+                ConfigSaveLog( que_cmd->param_id, cfg_set, SUCCESS );
+                ConfigSet( que_cmd->param_id, &cfg_set );
+               }
+            else ConfigSaveLog( que_cmd->param_id, cfg_set, ERROR );
+            return;
+           }
+        if ( !que_cmd->sub_pack_id && que_cmd->len_data ) {
+            if ( ConfigChkVal( que_cmd->param_id, cfg_set ) == SUCCESS ) {
+                ConfigSaveLog( que_cmd->param_id, cfg_set, SUCCESS );
+                ConfigSet( que_cmd->param_id, &cfg_set );
+               }
+            else ConfigSaveLog( que_cmd->param_id, cfg_set, ERROR );
+           }
+        if ( que_cmd->sub_pack_id == CAN_CONFIG_SAVE )
+            ConfigSave();
+       }
+ }
+
+//*************************************************************************************************
+// Внешние функции модуля зависящие от проверки
+//*************************************************************************************************
+uint32_t ConfigHash( void ) { return cfg_hash; }
+osStatus_t osMessageQueuePut( osMessageQueueId_t mq_id, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout ) {
+    //передача пакетов настроек после изменения параметра в сравнении не участвует
+    if ( *(uint32_t *)msg_ptr != ( ID_CONFIG | CAN_DATA_PERIOD ) )
+        Trace( "Send(%08X)", *(uint32_t *)msg_ptr );
+    return osOK;
+ }
+ARM_DRIVER_CAN Driver_CAN2;
+void CanAfClear( CAN_AF_TABLE *af ) { memset( af, 0x00, sizeof( CAN_AF_TABLE ) ); }
+bool CanAfAddExact( CAN_AF_TABLE *af, uint32_t id ) { return true; }
+bool CanAfAddGroup( CAN_AF_TABLE *af, uint32_t lower, uint32_t upper ) { return true; }
+
+#include "hmi_can_stub.c"
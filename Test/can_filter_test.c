@@ -0,0 +1,261 @@
+
+//*************************************************************************************************
+//
+// Проверка таблицы фильтра приема пакетов CAN (FirmWare/Source/App/hmi_can.c, can_filter.c)
+// на host компьютере
+// Таблица фильтра формируется из описания команд can_cmd[] и ID уст-в и загружается в модель
+// аппаратного фильтра (заглушка драйвера CAN). Для ID на границах диапазонов команд и ID уст-в
+// прием пакета моделью фильтра и поиском по таблице (CanAfMatch()) сравнивается с ожидаемым
+// результатом, вычисленным по полям ID пакета. Проверяется повторная загрузка таблицы при
+// включении/выключении приема команд уст-в и переход на прием всех пакетов при переполнении
+// аппаратного фильтра
+//
+//*************************************************************************************************
+
+#include <stdarg.h>
+
+#include "hmi_can.c"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define TEST_DEV_MAX            ( ID_DEV_XFER + 2 ) //кол-во проверяемых ID уст-в
+#define HW_ENTRY_MAX            64          //кол-во записей модели аппаратного фильтра
+#define HW_ENTRY_LOW            2           //кол-во записей при проверке переполнения фильтра
+
+//*************************************************************************************************
+// Локальные переменные
+//*************************************************************************************************
+static uint8_t hw_max = HW_ENTRY_MAX;       //допустимое кол-во записей модели фильтра
+static uint8_t hw_exact_cnt, hw_group_cnt;  //кол-во отдельных ID и диапазонов модели фильтра
+static uint32_t hw_exact[HW_ENTRY_MAX];     //отдельные ID модели фильтра
+static uint32_t hw_lower[HW_ENTRY_MAX];     //нижние границы диапазонов модели фильтра
+static uint32_t hw_upper[HW_ENTRY_MAX];     //верхние границы диапазонов модели фильтра
+static uint32_t cnt_chk, cnt_err;           //кол-во проверок и ошибок
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static void Check( const char *step, bool accept_all );
+static void CheckId( const char *step, uint32_t id, bool accept_all );
+static bool Expected( uint32_t id );
+static bool HwMatch( uint32_t id );
+static int32_t HwSetFilter( uint32_t obj_idx, int operation, uint32_t id, uint32_t arg );
+static void Trace( const char *format, ... );
+
+//*************************************************************************************************
+// Проверка фильтра при всех состояниях приема команд уст-в
+// return = 0 - ошибок нет
+//*************************************************************************************************
+int main( void ) {
+
+    uint8_t dev;
+    Status stat;
+    char step[32];
+
+    Driver_CAN2.ObjectSetFilter = HwSetFilter;
+    CanDrv = &Driver_CAN2;
+    rx_obj_idx = 0;
+    mutex_flt = (osMutexId_t)&mutex_flt;
+    //прием команд всех уст-в
+    if ( CanFilterApply() != SUCCESS )
+        cnt_err++;
+    Check( "all on", false );
+    //последовательное выключение приема команд уст-в
+    for ( dev = 0; dev <= ID_DEV_XFER; dev++ ) {
+        sprintf( step, "dev %u off", dev );
+        if ( CANFilterDev( (Device)dev, false ) != SUCCESS )
+            cnt_err++;
+        Check( step, false );
+       }
+    //последовательное включение приема команд уст-в
+    for ( dev = 0; dev <= ID_DEV_XFER; dev++ ) {
+        sprintf( step, "dev %u on", dev );
+        if ( CANFilterDev( (Device)dev, true ) != SUCCESS )
+            cnt_err++;
+        Check( step, false );
+       }
+    //переполнение аппаратного фильтра при добавлении записей: прием всех пакетов
+    if ( CANFilterDev( ID_DEV_GEN, false ) != SUCCESS )
+        cnt_err++;
+    hw_max = HW_ENTRY_LOW;
+    stat = CANFilterDev( ID_DEV_GEN, true );
+    if ( stat != ERROR || CANFilterTable() != NULL || hw_exact_cnt || hw_group_cnt != 1 )
+        cnt_err++;
+    Check( "overflow", true );
+    //восстановление таблицы фильтра после переполнения
+    hw_max = HW_ENTRY_MAX;
+    if ( CANFilterDev( ID_DEV_GEN, true ) != SUCCESS || CANFilterTable() == NULL )
+        cnt_err++;
+    Check( "restore", false );
+    printf( "CAN filter: %u checks, %u errors\r\n", cnt_chk, cnt_err );
+    return cnt_err ? 1 : 0;
+ }
+
+//*************************************************************************************************
+// Проверка приема пакетов с ID на границах диапазонов команд и ID уст-в
+// const char *step - наименование шага проверки
+// bool accept_all  - фильтр должен принимать все пакеты
+//*************************************************************************************************
+static void Check( const char *step, bool accept_all ) {
+
+    uint8_t ind, dev, param;
+    uint32_t lower, upper;
+
+    //границы диапазонов команд
+    for ( ind = 0; ind < SIZE_ARRAY( can_cmd ); ind++ ) {
+        lower = CAN_DEV_ID( (uint32_t)can_cmd[ind].dev_id );
+        if ( can_cmd[ind].param_id == CAN_CMD_ANY )
+            upper = lower | CAN_RANGE_DEV;
+        else {
+            lower |= CAN_PARAM_ID( (uint32_t)can_cmd[ind].param_id );
+            upper = lower | CAN_RANGE_CMD;
+           }
+        CheckId( step, lower - 1, accept_all );
+        CheckId( step, lower, accept_all );
+        CheckId( step, upper, accept_all );
+        CheckId( step, upper + 1, accept_all );
+       }
+    //ID уст-в (запрос RTR) и границы ID параметров
+    for ( dev = 0; dev < TEST_DEV_MAX; dev++ ) {
+        lower = CAN_DEV_ID( (uint32_t)dev );
+        CheckId( step, lower, accept_all );
+        CheckId( step, lower + 1, accept_all );
+        CheckId( step, lower | CAN_RANGE_DEV, accept_all );
+        for ( param = 0; param <= CAN_CMD_PARAM; param++ ) {
+            CheckId( step, lower | CAN_PARAM_ID( (uint32_t)param ), accept_all );
+            CheckId( step, lower | CAN_PARAM_ID( (uint32_t)param ) | CAN_RANGE_CMD, accept_all );
+           }
+       }
+    //границы диапазона ID
+    CheckId( step, 0, accept_all );
+    CheckId( step, CAN_FILTER_RANGE, accept_all );
+ }
+
+//*************************************************************************************************
+// Проверка приема пакета моделью аппаратного фильтра и поиском по таблице фильтра
+// const char *step - наименование шага проверки
+// uint32_t id      - ID пакета
+// bool accept_all  - фильтр должен принимать все пакеты
+//*************************************************************************************************
+static void CheckId( const char *step, uint32_t id, bool accept_all ) {
+
+    bool exp, hw, tab;
+
+    cnt_chk++;
+    exp = accept_all == true ? true : Expected( id );
+    hw = HwMatch( id );
+    //при приеме всех пакетов таблица фильтра не загружена
+    tab = CANFilterTable() == NULL ? accept_all : CanAfMatch( CANFilterTable(), id );
+    if ( hw == exp && tab == exp )
+        return;
+    if ( cnt_err++ < 10 )
+        printf( "%s: ID=0x%08X expected=%u filter=%u table=%u\r\n", step, id, exp, hw, tab );
+ }
+
+//*************************************************************************************************
+// Ожидаемый результат приема пакета по полям ID пакета
+// uint32_t id   - ID пакета
+// return = true - пакет должен приниматься
+//*************************************************************************************************
+static bool Expected( uint32_t id ) {
+
+    uint8_t ind;
+    uint32_t dev, param;
+
+    if ( id > CAN_FILTER_RANGE )
+        return false;
+    dev = CAN_GET_DEV_ID( id );
+    param = CAN_GET_PARAM_ID( id ) & 0xFF;
+    //запрос RTR данных уст-ва принимается всегда
+    if ( dev <= ID_DEV_LOG && !( id & ( CAN_MASK_PARAM_ID | CAN_MASK_PACK_ID ) ) )
+        return true;
+    if ( dev > ID_DEV_XFER || rx_off[dev] == true )
+        return false;
+    for ( ind = 0; ind < SIZE_ARRAY( can_cmd ); ind++ )
+        if ( can_cmd[ind].dev_id == dev && ( can_cmd[ind].param_id == CAN_CMD_ANY || can_cmd[ind].param_id == param ) )
+            return true;
+    return false;
+ }
+
+//*************************************************************************************************
+// Прием пакета моделью аппаратного фильтра
+// uint32_t id   - ID пакета
+// return = true - пакет принимается
+//*************************************************************************************************
+static bool HwMatch( uint32_t id ) {
+
+    uint8_t ind;
+
+    for ( ind = 0; ind < hw_exact_cnt; ind++ )
+        if ( hw_exact[ind] == id )
+            return true;
+    for ( ind = 0; ind < hw_group_cnt; ind++ )
+        if ( id >= hw_lower[ind] && id <= hw_upper[ind] )
+            return true;
+    return false;
+ }
+
+//*************************************************************************************************
+// Модель аппаратного фильтра: добавление/удаление записей (ObjectSetFilter драйвера CAN)
+// Запись не добавляется если общее кол-во записей достигло hw_max
+// uint32_t obj_idx - индекс объекта приема
+// int operation    - операция ARM_CAN_FILTER_ID_*
+// uint32_t id      - ID пакета или нижняя граница диапазона
+// uint32_t arg     - верхняя граница диапазона
+// return int32_t   - ARM_DRIVER_OK или ARM_DRIVER_ERROR при ошибке
+//*************************************************************************************************
+static int32_t HwSetFilter( uint32_t obj_idx, int operation, uint32_t id, uint32_t arg ) {
+
+    uint8_t ind;
+
+    id &= ~ARM_CAN_ID_IDE_Msk;
+    if ( obj_idx != rx_obj_idx )
+        return ARM_DRIVER_ERROR;
+    if ( operation == ARM_CAN_FILTER_ID_EXACT_ADD || operation == ARM_CAN_FILTER_ID_RANGE_ADD ) {
+        if ( hw_exact_cnt + hw_group_cnt >= hw_max )
+            return ARM_DRIVER_ERROR;
+        if ( operation == ARM_CAN_FILTER_ID_EXACT_ADD )
+            hw_exact[hw_exact_cnt++] = id;
+        else {
+            hw_lower[hw_group_cnt] = id;
+            hw_upper[hw_group_cnt++] = arg;
+           }
+        return ARM_DRIVER_OK;
+       }
+    if ( operation == ARM_CAN_FILTER_ID_EXACT_REMOVE ) {
+        for ( ind = 0; ind < hw_exact_cnt; ind++ ) {
+            if ( hw_exact[ind] != id )
+                continue;
+            hw_exact[ind] = hw_exact[--hw_exact_cnt];
+            return ARM_DRIVER_OK;
+           }
+        return ARM_DRIVER_ERROR;
+       }
+    if ( operation == ARM_CAN_FILTER_ID_RANGE_REMOVE ) {
+        for ( ind = 0; ind < hw_group_cnt; ind++ ) {
+            if ( hw_lower[ind] != id || hw_upper[ind] != arg )
+                continue;
+            hw_group_cnt--;
+            hw_lower[ind] = hw_lower[hw_group_cnt];
+            hw_upper[ind] = hw_upper[hw_group_cnt];
+            return ARM_DRIVER_OK;
+           }
+        return ARM_DRIVER_ERROR;
+       }
+    return ARM_DRIVER_ERROR;
+ }
+
+//*************************************************************************************************
+// Вызовы функций уст-в в проверке не используются
+//*************************************************************************************************
+static void Trace( const char *format, ... ) { }
+
+//*************************************************************************************************
+// Внешние функции модуля зависящие от проверки
+//*************************************************************************************************
+uint32_t ConfigHash( void ) { return 0; }
+osStatus_t osMessageQueuePut( osMessageQueueId_t mq_id, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout ) { return osOK; }
+ARM_DRIVER_CAN Driver_CAN2;
+
+#include "hmi_can_stub.c"
@@ -0,0 +1,125 @@
+
+//*************************************************************************************************
+//
+// Проверка расчета CRC16 (FirmWare/Source/System/crc16.c) на host компьютере
+// Результат табличного расчета сравнивается с побитовым расчетом по полиному 0xA001 для
+// случайных данных размером 0..CRC_LEN_MAX при всех смещениях буфера, выводится время расчета
+//
+//*************************************************************************************************
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "crc16.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define CRC_LEN_MAX             256         //максимальный размер данных
+#define CRC_ALIGN               4           //кол-во проверяемых смещений буфера
+#define CRC_PASS                100         //кол-во проходов со случайными данными
+#define CRC_BENCH_LEN           256         //размер данных для измерения времени
+#define CRC_BENCH_CNT           200000      //кол-во расчетов для измерения времени
+
+//*************************************************************************************************
+// Прототипы локальных функций
+//*************************************************************************************************
+static uint16_t CRC16Bit( uint8_t *buf, uint16_t len );
+static double Bench( uint16_t ( *func )( uint8_t *buf, uint16_t len ), uint8_t *buf, uint16_t len );
+
+//*************************************************************************************************
+// Проверка и измерение времени расчета
+// return = 0 - ошибок нет
+//*************************************************************************************************
+int main( void ) {
+
+    uint8_t buf[CRC_LEN_MAX + CRC_ALIGN + 2];
+    uint16_t i, len, ofs, pass, crc, ref;
+    uint32_t cnt = 0, error = 0;
+    double time_bit, time_tab;
+
+    srand( (unsigned)time( NULL ) );
+    for ( pass = 0; pass < CRC_PASS; pass++ ) {
+        for ( i = 0; i < sizeof( buf ); i++ )
+            buf[i] = (uint8_t)rand();
+        for ( ofs = 0; ofs < CRC_ALIGN; ofs++ ) {
+            for ( len = 0; len <= CRC_LEN_MAX; len++ ) {
+                cnt++;
+                ref = CRC16Bit( buf + ofs, len );
+                //расчет блоком
+                if ( CalcCRC16( buf + ofs, len ) != ref ) {
+                    if ( error++ < 10 )
+                        printf( "CalcCRC16: len = %u ofs = %u crc = 0x%04X ref = 0x%04X\r\n", len, ofs,
+                                CalcCRC16( buf + ofs, len ), ref );
+                    continue;
+                   }
+                //потоковый расчет по одному байту
+                crc = CRC16Init();
+                for ( i = 0; i < len; i++ )
+                    crc = CRC16Update( crc, buf[ofs + i] );
+                if ( CRC16Final( crc ) != ref ) {
+                    if ( error++ < 10 )
+                        printf( "CRC16Update: len = %u ofs = %u\r\n", len, ofs );
+                    continue;
+                   }
+                //пакет с CRC (младший байт первый) дает остаток 0
+                buf[ofs + len] = (uint8_t)ref;
+                buf[ofs + len + 1] = (uint8_t)( ref >> 8 );
+                if ( CalcCRC16( buf + ofs, len + 2 ) != 0 ) {
+                    if ( error++ < 10 )
+                        printf( "CRC remainder: len = %u ofs = %u\r\n", len, ofs );
+                   }
+               }
+           }
+       }
+    printf( "CRC16: %u checks, %u errors\r\n", cnt, error );
+    for ( i = 0; i < CRC_BENCH_LEN; i++ )
+        buf[i] = (uint8_t)rand();
+    time_bit = Bench( CRC16Bit, buf, CRC_BENCH_LEN );
+    time_tab = Bench( CalcCRC16, buf, CRC_BENCH_LEN );
+    printf( "CRC16 %u bytes: bitwise %.3f usec, table %.3f usec, x%.1f\r\n", CRC_BENCH_LEN,
+            time_bit, time_tab, time_tab > 0 ? time_bit / time_tab : 0 );
+    return error ? 1 : 0;
+ }
+
+//*************************************************************************************************
+// Побитовый расчет контрольной суммы MODBUS (эталон)
+// uint8_t *buf    - адрес буфера с данными
+// uint16_t len    - размер данных
+// return uint16_t - контрольная сумма
+//*************************************************************************************************
+static uint16_t CRC16Bit( uint8_t *buf, uint16_t len ) {
+
+    uint8_t bit;
+    uint16_t crc = 0xFFFF;
+
+    while ( len-- ) {
+        crc ^= *buf++;
+        for ( bit = 0; bit < 8; bit++ )
+            crc = ( crc & 0x0001 ) ? ( crc >> 1 ) ^ 0xA001 : crc >> 1;
+       }
+    return crc;
+ }
+
+//*************************************************************************************************
+// Измерение среднего времени расчета контрольной суммы
+// func          - функция расчета
+// uint8_t *buf  - адрес буфера с данными
+// uint16_t len  - размер данных
+// return double - время одного расчета (usec)
+//*************************************************************************************************
+static double Bench( uint16_t ( *func )( uint8_t *buf, uint16_t len ), uint8_t *buf, uint16_t len ) {
+
+    uint32_t i;
+    clock_t start;
+    volatile uint16_t crc = 0;
+
+    start = clock();
+    for ( i = 0; i < CRC_BENCH_CNT; i++ ) {
+        buf[0] = (uint8_t)crc;
+        crc = func( buf, len );
+       }
+    return ( (double)( clock() - start ) * 1000000.0 / CLOCKS_PER_SEC ) / CRC_BENCH_CNT;
+ }
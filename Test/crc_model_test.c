@@ -0,0 +1,71 @@
+
+//*************************************************************************************************
+//
+// Проверка программной модели блока CRC (FirmWare/Source/System/crc_model.c) на host компьютере
+// Контрольные суммы строки "123456789" сравниваются с контрольными значениями (check) типов
+// CRC-16/CCITT-FALSE, CRC-16/ARC, CRC-16/MODBUS и CRC-32. Расчет по частям при всех
+// позициях разбиения должен совпадать с расчетом блоком, результат MODBUS - с CalcCRC16()
+//
+//*************************************************************************************************
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "crc_model.h"
+#include "crc16.h"
+
+//*************************************************************************************************
+// Локальные константы
+//*************************************************************************************************
+#define CRC_CHECK_STR           "123456789" //строка для расчета контрольных значений
+
+//Контрольные значения для строки CRC_CHECK_STR по типам CrcType
+static const uint32_t crc_check[] = { 0x29B1, 0xBB3D, 0x4B37, 0xCBF43926 };
+
+static const char * const crc_name[] = { "CRC-16/CCITT-FALSE", "CRC-16/ARC", "CRC-16/MODBUS", "CRC-32" };
+
+//*************************************************************************************************
+// Проверка контрольных значений и расчета по частям
+// return = 0 - ошибок нет
+//*************************************************************************************************
+int main( void ) {
+
+    uint8_t buf[] = CRC_CHECK_STR;
+    uint32_t len, part, sum, cnt = 0, error = 0;
+    CRC_MODEL crc;
+    CrcType type;
+
+    len = strlen( CRC_CHECK_STR );
+    for ( type = CRC_TYPE_CCITT; type < CRC_TYPE_CNT; type++ ) {
+        //расчет блоком
+        cnt++;
+        CrcModelInit( &crc, type );
+        CrcModelBlock( &crc, buf, len );
+        sum = CrcModelSum( &crc );
+        if ( sum != crc_check[type] ) {
+            error++;
+            printf( "%s: crc = 0x%08X check = 0x%08X\r\n", crc_name[type], sum, crc_check[type] );
+           }
+        //расчет по частям с установкой начального значения через CrcModelSeed()
+        for ( part = 0; part <= len; part++ ) {
+            cnt++;
+            CrcModelInit( &crc, type );
+            CrcModelSeed( &crc, CrcModelInitVal( type ) );
+            CrcModelBlock( &crc, buf, part );
+            CrcModelBlock( &crc, buf + part, len - part );
+            if ( CrcModelSum( &crc ) != crc_check[type] ) {
+                error++;
+                printf( "%s: part = %u crc = 0x%08X\r\n", crc_name[type], part, CrcModelSum( &crc ) );
+               }
+           }
+       }
+    //табличный расчет MODBUS
+    cnt++;
+    if ( CalcCRC16( buf, len ) != crc_check[CRC_TYPE_MODBUS] ) {
+        error++;
+        printf( "CalcCRC16: crc = 0x%04X\r\n", CalcCRC16( buf, len ) );
+       }
+    printf( "CRC model: %u checks, %u errors\r\n", cnt, error );
+    return error ? 1 : 0;
+ }
@@ -0,0 +1,63 @@
+//*************************************************************************************************
+//
+// Заглушка заголовка LPC177x_8x для сборки модулей на host компьютере
+//
+//*************************************************************************************************
+
+#ifndef __LPC177x_8x_H__
+#define __LPC177x_8x_H__
+#include <stdint.h>
+#define __I volatile const
+#define __O volatile
+#define __IO volatile
+typedef enum { WDT_IRQn=0, TIMER0_IRQn=1, TIMER1_IRQn=2, TIMER2_IRQn=3, TIMER3_IRQn=4, UART0_IRQn=5, UART1_IRQn=6, UART2_IRQn=7, UART3_IRQn=8,
+ SSP0_IRQn=14, SSP1_IRQn=15, RTC_IRQn=17, CAN_IRQn=25, DMA_IRQn=26, GPIO_IRQn=38, UART4_IRQn=35, CRC_IRQn=39 } IRQn_Type;
+typedef struct { __IO uint32_t IR, TCR, TC, PR, PC, MCR, MR0, MR1, MR2, MR3, CCR; __I uint32_t CR0, CR1; uint32_t RESERVED0[2]; __IO uint32_t EMR; uint32_t RESERVED1[12]; __IO uint32_t CTCR; } LPC_TIM_TypeDef;
+typedef struct { __IO uint32_t DIR; uint32_t RESERVED0[3]; __IO uint32_t MASK, PIN, SET; __O uint32_t CLR; } LPC_GPIO_TypeDef;
+typedef struct { __IO uint32_t CR0, CR1, DR; __I uint32_t SR; __IO uint32_t CPSR, IMSC, RIS, MIS, ICR, DMACR; } LPC_SSP_TypeDef;
+typedef struct { __IO uint32_t ILR, CCR, CIIR, AMR; __I uint32_t CTIME0, CTIME1, CTIME2; __IO uint32_t SEC, MIN, HOUR, DOM, DOW, DOY, MONTH, YEAR, CALIBRATION, GPREG0, GPREG1, GPREG2, GPREG3, GPREG4, RTC_AUXEN, RTC_AUX, ALSEC, ALMIN, ALHOUR, ALDOM, ALDOW, ALDOY, ALMON, ALYEAR, ERSTATUS, ERCONTROL, ERCOUNTERS; } LPC_RTC_TypeDef;
+typedef struct { __IO uint32_t CR, CTRL, CNTVAL; } LPC_DAC_TypeDef;
+typedef struct { __IO uint32_t MODE, SEED; union { __I uint32_t SUM; __O uint32_t WR_DATA_DWORD; __O uint16_t WR_DATA_WORD; __O uint8_t WR_DATA_BYTE; }; } LPC_CRC_TypeDef;
+typedef struct { __IO uint32_t CMD, ADDR, WDATA, RDATA, WSTATE, CLKDIV, PWRDWN; uint32_t R[975]; __IO uint32_t INT_CLR_ENABLE, INT_SET_ENABLE, INT_STATUS, INT_ENABLE, INT_CLR_STATUS, INT_SET_STATUS; } LPC_EEPROM_TypeDef;
+typedef struct { __IO uint32_t MOD, TC, FEED, TV, WARNINT, WINDOW; } LPC_WDT_TypeDef;
+typedef struct { __I uint32_t IntStatus, IO0IntStatR, IO0IntStatF; __O uint32_t IO0IntClr; __IO uint32_t IO0IntEnR, IO0IntEnF; uint32_t R[3]; __I uint32_t IO2IntStatR, IO2IntStatF; __O uint32_t IO2IntClr; __IO uint32_t IO2IntEnR, IO2IntEnF; } LPC_GPIOINT_TypeDef;
+typedef struct { __IO uint32_t FLASHCFG; uint32_t R0[31]; __IO uint32_t PLL0CON, PLL0CFG; __I uint32_t PLL0STAT; __O uint32_t PLL0FEED; uint32_t R1[4]; __IO uint32_t PLL1CON, PLL1CFG; __I uint32_t PLL1STAT; __O uint32_t PLL1FEED; uint32_t R2[4]; __IO uint32_t PCON, PCONP, PCONP1; uint32_t R3[13]; __IO uint32_t EMCCLKSEL, CCLKSEL, USBCLKSEL, CLKSRCSEL, CANSLEEPCLR, CANWAKEFLAGS; uint32_t R4[10]; __IO uint32_t EXTINT, R5, EXTMODE, EXTPOLAR; uint32_t R6[12]; __IO uint32_t RSID; uint32_t R7[7]; __IO uint32_t SCS, IRCTRIM, PCLKSEL; uint32_t R8; __IO uint32_t PBOOST, SPIFICLKSEL, LCD_CFG; uint32_t R9; __IO uint32_t USBIntSt, DMAREQSEL, CLKOUTCFG, RSTCON0, RSTCON1; } LPC_SC_TypeDef;
+#define LPC_GPIO0_BASE 0x20098000UL
+#define LPC_GPIO1_BASE 0x20098020UL
+#define LPC_GPIO2_BASE 0x20098040UL
+#define LPC_GPIO3_BASE 0x20098060UL
+#define LPC_GPIO4_BASE 0x20098080UL
+#define LPC_GPIO5_BASE 0x200980A0UL
+#define LPC_IOCON_BASE 0x4002C000UL
+#define LPC_TIM0 ((LPC_TIM_TypeDef *)0x40004000UL)
+#define LPC_TIM1 ((LPC_TIM_TypeDef *)0x40008000UL)
+#define LPC_TIM2 ((LPC_TIM_TypeDef *)0x40090000UL)
+#define LPC_TIM3 ((LPC_TIM_TypeDef *)0x40094000UL)
+#define LPC_GPIO0 ((LPC_GPIO_TypeDef *)LPC_GPIO0_BASE)
+#define LPC_GPIO1 ((LPC_GPIO_TypeDef *)LPC_GPIO1_BASE)
+#define LPC_GPIO2 ((LPC_GPIO_TypeDef *)LPC_GPIO2_BASE)
+#define LPC_GPIO3 ((LPC_GPIO_TypeDef *)LPC_GPIO3_BASE)
+#define LPC_GPIO4 ((LPC_GPIO_TypeDef *)LPC_GPIO4_BASE)
+#define LPC_GPIO5 ((LPC_GPIO_TypeDef *)LPC_GPIO5_BASE)
+#define LPC_SSP0 ((LPC_SSP_TypeDef *)0x40088000UL)
+#define LPC_SSP1 ((LPC_SSP_TypeDef *)0x40030000UL)
+#define LPC_RTC ((LPC_RTC_TypeDef *)0x40024000UL)
+#define LPC_DAC ((LPC_DAC_TypeDef *)0x4008C000UL)
+#define LPC_CRC ((LPC_CRC_TypeDef *)0x20090000UL)
+#define LPC_EEPROM ((LPC_EEPROM_TypeDef *)0x00200080UL)
+#define LPC_WDT ((LPC_WDT_TypeDef *)0x40000000UL)
+#define LPC_GPIOINT ((LPC_GPIOINT_TypeDef *)0x40028080UL)
+#define LPC_SC ((LPC_SC_TypeDef *)0x400FC000UL)
+static inline uint32_t __REV(uint32_t v){return __builtin_bswap32(v);}
+static inline int32_t __REVSH(int32_t v){return (int16_t)__builtin_bswap16((uint16_t)v);}
+static inline uint32_t __REV16(uint32_t v){return ((v&0xFF00FF00u)>>8)|((v&0x00FF00FFu)<<8);}
+static inline void __NOP(void){}
+static inline void __disable_irq(void){}
+static inline void __enable_irq(void){}
+static inline uint32_t __get_PRIMASK(void){return 0;}
+static inline void __set_PRIMASK(uint32_t v){(void)v;}
+void NVIC_SetPriority(IRQn_Type, uint32_t); void NVIC_EnableIRQ(IRQn_Type); void NVIC_DisableIRQ(IRQn_Type); void NVIC_ClearPendingIRQ(IRQn_Type);
+uint32_t NVIC_GetPriorityGrouping(void); uint32_t NVIC_EncodePriority(uint32_t, uint32_t, uint32_t); void NVIC_SystemReset(void);
+extern uint32_t SystemCoreClock, PeripheralClock;
+#define __weak __attribute__((weak))
+#endif
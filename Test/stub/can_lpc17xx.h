@@ -0,0 +1,55 @@
+//*************************************************************************************************
+//
+// Заглушка драйвера CAN (CMSIS Driver) для сборки модулей на host компьютере
+//
+//*************************************************************************************************
+
+#ifndef __CAN_LPC17XX_H
+#define __CAN_LPC17XX_H
+
+#include <stdint.h>
+typedef struct { uint32_t id; uint32_t rtr:1; uint32_t edl:1; uint32_t brs:1; uint32_t esi:1; uint32_t dlc:4; uint32_t reserved:24; } ARM_CAN_MSG_INFO;
+typedef struct { uint32_t tx:1; uint32_t rx:1; uint32_t rx_rtr_reply:1; uint32_t tx_rtr_request:1; uint32_t reserved:28; } ARM_CAN_OBJ_CAPABILITIES;
+typedef struct { uint32_t num_objects:8; uint32_t reentrant_operation:1; uint32_t fd_mode:1; uint32_t restricted_mode:1; uint32_t monitor_mode:1; uint32_t internal_loopback:1; uint32_t external_loopback:1; uint32_t reserved:18; } ARM_CAN_CAPABILITIES;
+typedef struct { uint32_t unit_state:4; uint32_t last_error_code:4; uint32_t tx_error_count:8; uint32_t rx_error_count:8; uint32_t reserved:8; } ARM_CAN_STATUS;
+typedef void (*ARM_CAN_SignalUnitEvent_t)(uint32_t event); typedef void (*ARM_CAN_SignalObjectEvent_t)(uint32_t obj_idx, uint32_t event);
+typedef struct { int32_t (*Initialize)(ARM_CAN_SignalUnitEvent_t, ARM_CAN_SignalObjectEvent_t); int32_t (*Uninitialize)(void); int32_t (*PowerControl)(int);
+ uint32_t (*GetClock)(void); int32_t (*SetBitrate)(int, uint32_t, uint32_t); int32_t (*SetMode)(int); ARM_CAN_OBJ_CAPABILITIES (*ObjectGetCapabilities)(uint32_t);
+ int32_t (*ObjectSetFilter)(uint32_t, int, uint32_t, uint32_t); int32_t (*ObjectConfigure)(uint32_t, int); int32_t (*MessageSend)(uint32_t, ARM_CAN_MSG_INFO *, const uint8_t *, uint8_t);
+ int32_t (*MessageRead)(uint32_t, ARM_CAN_MSG_INFO *, uint8_t *, uint8_t); int32_t (*Control)(uint32_t, uint32_t); ARM_CAN_STATUS (*GetStatus)(void); ARM_CAN_CAPABILITIES (*GetCapabilities)(void); } ARM_DRIVER_CAN;
+#define ARM_CAN_BITRATE_NOMINAL 0
+#define ARM_CAN_BIT_PROP_SEG(x) ((x)<<0)
+#define ARM_CAN_BIT_PHASE_SEG1(x) ((x)<<8)
+#define ARM_CAN_BIT_PHASE_SEG2(x) ((x)<<16)
+#define ARM_CAN_BIT_SJW(x) ((x)<<24)
+#define ARM_CAN_MODE_INITIALIZATION 0
+#define ARM_CAN_MODE_NORMAL 1
+#define ARM_CAN_FILTER_ID_EXACT_ADD 1
+#define ARM_CAN_FILTER_ID_EXACT_REMOVE 2
+#define ARM_CAN_FILTER_ID_RANGE_ADD 3
+#define ARM_CAN_FILTER_ID_RANGE_REMOVE 4
+#define ARM_CAN_FILTER_ID_MASKABLE_ADD 5
+#define ARM_CAN_OBJ_INACTIVE 0
+#define ARM_CAN_OBJ_TX 1
+#define ARM_CAN_OBJ_RX 2
+#define ARM_CAN_OBJ_RX_RTR_TX_DATA 3
+#define ARM_CAN_OBJ_TX_RTR_RX_DATA 4
+#define ARM_CAN_ID_IDE_Msk 0x80000000UL
+#define ARM_CAN_EXTENDED_ID(id) ((id)|ARM_CAN_ID_IDE_Msk)
+#define ARM_CAN_STANDARD_ID(id) ((id)&0x7FFUL)
+#define ARM_CAN_EVENT_SEND_COMPLETE 1u
+#define ARM_CAN_EVENT_RECEIVE 2u
+#define ARM_CAN_EVENT_RECEIVE_OVERRUN 4u
+#define ARM_CAN_EVENT_UNIT_ACTIVE 1u
+#define ARM_CAN_EVENT_UNIT_WARNING 2u
+#define ARM_CAN_EVENT_UNIT_PASSIVE 3u
+#define ARM_CAN_EVENT_UNIT_BUS_OFF 4u
+#define ARM_CAN_SET_TRANSCEIVER_DELAY 1
+#define ARM_CAN_ABORT_MESSAGE_SEND 2
+#define ARM_CAN_CONTROL_RETRANSMISSION 3
+#define ARM_CAN_SET_FD_MODE 4
+#define ARM_DRIVER_OK 0
+#define ARM_DRIVER_ERROR -1
+#define ARM_POWER_FULL 2
+
+#endif
@@ -0,0 +1,89 @@
+//*************************************************************************************************
+//
+// Заглушка CMSIS-RTOS2 для сборки модулей на host компьютере: только типы и прототипы,
+// реализация функций выполняется в файле проверки
+//
+//*************************************************************************************************
+
+#ifndef CMSIS_OS2_H_
+#define CMSIS_OS2_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef enum { osOK = 0, osError = -1, osErrorTimeout = -2, osErrorResource = -3, osErrorParameter = -4 } osStatus_t;
+typedef enum { osPriorityNone = 0, osPriorityIdle = 1, osPriorityLow = 8, osPriorityBelowNormal = 16,
+               osPriorityNormal = 24, osPriorityAboveNormal = 32, osPriorityHigh = 40, osPriorityRealtime = 48 } osPriority_t;
+typedef enum { osTimerOnce = 0, osTimerPeriodic = 1 } osTimerType_t;
+
+#define osWaitForever           0xFFFFFFFFU
+#define osFlagsWaitAny          0x00000000U
+#define osFlagsWaitAll          0x00000001U
+#define osFlagsNoClear          0x00000002U
+#define osFlagsError            0x80000000U
+#define osMutexRecursive        0x00000001U
+#define osMutexPrioInherit      0x00000002U
+
+typedef void *osThreadId_t;
+typedef void *osTimerId_t;
+typedef void *osEventFlagsId_t;
+typedef void *osMutexId_t;
+typedef void *osSemaphoreId_t;
+typedef void *osMessageQueueId_t;
+typedef void ( *osThreadFunc_t )( void *argument );
+typedef void ( *osTimerFunc_t )( void *argument );
+
+typedef struct {
+    const char   *name;
+    uint32_t     attr_bits;
+    void         *cb_mem;
+    uint32_t     cb_size;
+    void         *stack_mem;
+    uint32_t     stack_size;
+    osPriority_t priority;
+    uint32_t     tz_module;
+    uint32_t     reserved;
+ } osThreadAttr_t;
+
+typedef struct {
+    const char   *name;
+    uint32_t     attr_bits;
+    void         *cb_mem;
+    uint32_t     cb_size;
+ } osTimerAttr_t, osEventFlagsAttr_t, osMutexAttr_t, osSemaphoreAttr_t;
+
+typedef struct {
+    const char   *name;
+    uint32_t     attr_bits;
+    void         *cb_mem;
+    uint32_t     cb_size;
+    void         *mq_mem;
+    uint32_t     mq_size;
+ } osMessageQueueAttr_t;
+
+uint32_t osKernelGetTickCount( void );
+osThreadId_t osThreadNew( osThreadFunc_t func, void *argument, const osThreadAttr_t *attr );
+osThreadId_t osThreadGetId( void );
+uint32_t osThreadFlagsSet( osThreadId_t thread_id, uint32_t flags );
+uint32_t osThreadFlagsClear( uint32_t flags );
+uint32_t osThreadFlagsWait( uint32_t flags, uint32_t options, uint32_t timeout );
+osStatus_t osDelay( uint32_t ticks );
+osTimerId_t osTimerNew( osTimerFunc_t func, osTimerType_t type, void *argument, const osTimerAttr_t *attr );
+osStatus_t osTimerStart( osTimerId_t timer_id, uint32_t ticks );
+osStatus_t osTimerStop( osTimerId_t timer_id );
+uint32_t osTimerIsRunning( osTimerId_t timer_id );
+osEventFlagsId_t osEventFlagsNew( const osEventFlagsAttr_t *attr );
+uint32_t osEventFlagsSet( osEventFlagsId_t ef_id, uint32_t flags );
+uint32_t osEventFlagsClear( osEventFlagsId_t ef_id, uint32_t flags );
+uint32_t osEventFlagsWait( osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout );
+osMutexId_t osMutexNew( const osMutexAttr_t *attr );
+osStatus_t osMutexAcquire( osMutexId_t mutex_id, uint32_t timeout );
+osStatus_t osMutexRelease( osMutexId_t mutex_id );
+osSemaphoreId_t osSemaphoreNew( uint32_t max_count, uint32_t initial_count, const osSemaphoreAttr_t *attr );
+osStatus_t osSemaphoreAcquire( osSemaphoreId_t semaphore_id, uint32_t timeout );
+osStatus_t osSemaphoreRelease( osSemaphoreId_t semaphore_id );
+osMessageQueueId_t osMessageQueueNew( uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t *attr );
+osStatus_t osMessageQueuePut( osMessageQueueId_t mq_id, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout );
+osStatus_t osMessageQueueGet( osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout );
+
+#endif
@@ -0,0 +1,81 @@
+//*************************************************************************************************
+//
+// Заглушки внешних функций модуля FirmWare/Source/App/hmi_can.c для проверок на host компьютере
+// Файл включается в конце файла проверки после hmi_can.c, функции уст-в записывают вызов
+// с параметрами через функцию Trace() файла проверки
+// В файле проверки задаются: Trace(), ConfigHash(), osMessageQueuePut(), драйвер Driver_CAN2
+// и функции таблицы фильтра CanAf*() (заглушки или модуль can_filter.c)
+//
+//*************************************************************************************************
+
+//*************************************************************************************************
+// Функции уст-в: записывают вызов с параметрами
+//*************************************************************************************************
+void RTCSet( RTC *datetime ) { Trace( "RTCSet(%02X%02X%02X%02X)", ( (uint8_t *)datetime )[0], ( (uint8_t *)datetime )[1], ( (uint8_t *)datetime )[2], ( (uint8_t *)datetime )[3] ); }
+void CanDataSubscr( CAN_SUBSCR *subscr ) { Trace( "CanDataSubscr(%u,%u)", subscr->dev_id, subscr->flags ); }
+PvError PvControl( PvCtrl ctrl, EepromMode restore ) { Trace( "PvControl(%u,%u)", ctrl, restore ); return 0; }
+void PvSetMode( PvMode mode, EepromMode restore ) { Trace( "PvSetMode(%u,%u)", mode, restore ); }
+ChargeError Charger( ChargeMode charge, EepromMode restore ) { Trace( "Charger(%u,%u)", charge, restore ); return 0; }
+void InvCtrl( Device dev, InvCtrlCmnd mode ) { Trace( "InvCtrl(%u,%u)", dev, mode ); }
+AltError AltPowerAC( void ) { Trace( "AltPowerAC" ); return 0; }
+AltError AltPowerDC( void ) { Trace( "AltPowerDC" ); return 0; }
+void GenStart( void ) { Trace( "GenStart" ); }
+void GenStop( void ) { Trace( "GenStop" ); }
+void GenTest( void ) { Trace( "GenTest" ); }
+void TRCMode( PowerAct mode, EepromMode restore ) { Trace( "TRCMode(%u,%u)", mode, restore ); }
+TrackerPosErr TrackerSetPos( TrackerAct pos, TrackerPos param, float value ) { Trace( "TrackerSetPos(%u,%u,%g)", pos, param, value ); return 0; }
+Status TrackerCmd( uint16_t cmnd, uint16_t param1, uint16_t param2 ) { Trace( "TrackerCmd(%04X,%u,%u)", cmnd, param1, param2 ); return SUCCESS; }
+ModBusError Informing( VoiceId id_info, char *name_info ) { Trace( "Informing(%u)", id_info ); return MBUS_ANSWER_OK; }
+ModBusError SetVolume( Volume volume ) { Trace( "SetVolume(%u)", volume ); return MBUS_ANSWER_OK; }
+Status SoundPlay( SoundId sound, char *name ) { Trace( "SoundPlay(%u)", sound ); return SUCCESS; }
+void ReservCmnd( RelayRes id, RelayCmnd cmnd ) { Trace( "ReservCmnd(%u,%u)", id, cmnd ); }
+void ExtOut( RelayOut id, RelayCmnd cmnd ) { Trace( "ExtOut(%u,%u)", id, cmnd ); }
+ModBusError ModBusRequest( MBUS_REQUEST *reqst ) {
+    Trace( "ModBusRequest(%u,%u,%04X,%u)", reqst->dev_addr, reqst->function, reqst->addr_reg, reqst->cnt_reg );
+    *reqst->ptr_lendata = 4;
+    return MBUS_ANSWER_OK;
+ }
+//запрос с использованием кэша регистров равнозначен запросу ModBusRequest()
+ModBusError ModBusRequestCache( MBUS_REQUEST *reqst, MBusPrio prio, MBusCache cache ) { return ModBusRequest( reqst ); }
+Status ConfigChkVal( ConfigParam id_par, ConfigValSet cfg_set ) {
+    Trace( "ConfigChkVal(%u)", id_par );
+    return ( id_par == CFG_SCR_FILE || id_par == CFG_JOB_FILE || id_par == CFG_JOB_TEST ) ?
+           ( cfg_set.ptr[8] == 'T' ? SUCCESS : ERROR ) : ( cfg_set.uint8 & 0x01 ? ERROR : SUCCESS );
+ }
+void ConfigSet( ConfigParam id_par, ConfigValSet *value ) {
+    if ( id_par == CFG_SCR_FILE || id_par == CFG_JOB_FILE || id_par == CFG_JOB_TEST )
+        Trace( "ConfigSet(%u,%.16s)", id_par, value->ptr );
+    else Trace( "ConfigSet(%u,%08X)", id_par, value->uint32 );
+ }
+void ConfigSave( void ) { Trace( "ConfigSave" ); }
+
+//*************************************************************************************************
+// Остальные внешние функции модуля, в проверках не используются
+//*************************************************************************************************
+void LogPrintf( LogId id, const char *format, ... ) { }
+char *RTCGetLog( void ) { return ""; }
+char *DevName( Device dev ) { return ""; }
+char *ConfigName( ConfigParam param ) { return ""; }
+char *Message( ConsMessage id_mess ) { return ""; }
+const DevParam *DevParamPtr( Device dev ) { static const DevParam param[256]; return param; }
+char *ParamGetForm( Device dev, uint32_t param, ParamMode mode ) { return ""; }
+void CanDataInit( void ) { }
+void CanDataPublish( void ) { }
+uint32_t CanDataWait( void ) { return osWaitForever; }
+void DevDataSend( uint32_t dev_id ) { }
+void CanXferRecv( uint32_t can_id, uint8_t *data, uint8_t len ) { }
+void NVIC_SetPriority( IRQn_Type irq, uint32_t prio ) { }
+void NVIC_EnableIRQ( IRQn_Type irq ) { }
+void NVIC_DisableIRQ( IRQn_Type irq ) { }
+uint32_t NVIC_GetPriorityGrouping( void ) { return 0; }
+uint32_t NVIC_EncodePriority( uint32_t group, uint32_t prio, uint32_t sub ) { return 0; }
+osThreadId_t osThreadNew( osThreadFunc_t func, void *argument, const osThreadAttr_t *attr ) { return NULL; }
+osEventFlagsId_t osEventFlagsNew( const osEventFlagsAttr_t *attr ) { return NULL; }
+uint32_t osEventFlagsSet( osEventFlagsId_t ef_id, uint32_t flags ) { return 0; }
+uint32_t osEventFlagsClear( osEventFlagsId_t ef_id, uint32_t flags ) { return 0; }
+uint32_t osEventFlagsWait( osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout ) { return 0; }
+osMutexId_t osMutexNew( const osMutexAttr_t *attr ) { return NULL; }
+osStatus_t osMutexAcquire( osMutexId_t mutex_id, uint32_t timeout ) { return osOK; }
+osStatus_t osMutexRelease( osMutexId_t mutex_id ) { return osOK; }
+osMessageQueueId_t osMessageQueueNew( uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t *attr ) { return NULL; }
+osStatus_t osMessageQueueGet( osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout ) { return osError; }
@@ -0,0 +1,2 @@
+//Заглушка для сборки на host компьютере
+#include "LPC177x_8x.h"